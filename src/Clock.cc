@@ -0,0 +1,178 @@
+/*
+ Clock.cc
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "Clock.h"
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+
+static MonotonicClock monotonic_clock;
+static ClockSource*   clock_source = &monotonic_clock;
+
+uint64_t MonotonicClock::now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+time_t MonotonicClock::wall_time()
+{
+    return ::time(NULL);
+}
+
+void MonotonicClock::sleep_until(uint64_t t)
+{
+    struct timespec ts;
+    ts.tv_sec = t / NSEC_PER_SEC;
+    ts.tv_nsec = t % NSEC_PER_SEC;
+
+    // Absolute sleep is not extended by signal interruptions
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+    }
+}
+
+int MonotonicClock::wait_readable(int fd, uint64_t timeout)
+{
+    struct pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+
+    int rv = ::poll(&pfd, 1, (int)((timeout + NSEC_PER_MSEC - 1) / NSEC_PER_MSEC));
+
+    if (rv < 0) {
+        return errno == EINTR ? 0 : -1;
+    }
+
+    return rv > 0 ? 1 : 0;
+}
+
+SimulatedClock::SimulatedClock(uint64_t start) :
+    time(start), epoch(::time(NULL) - (time_t)(start / NSEC_PER_SEC))
+{
+}
+
+uint64_t SimulatedClock::now()
+{
+    return time;
+}
+
+time_t SimulatedClock::wall_time()
+{
+    return epoch + (time_t)(time / NSEC_PER_SEC);
+}
+
+void SimulatedClock::sleep_until(uint64_t t)
+{
+    if (t > time) {
+        time = t;
+    }
+}
+
+int SimulatedClock::wait_readable(int fd, uint64_t timeout)
+{
+    struct pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+
+    int rv = ::poll(&pfd, 1, 0);
+
+    if (rv < 0) {
+        return -1;
+    }
+
+    if (rv == 0) {
+        time += timeout;
+        return 0;
+    }
+
+    return 1;
+}
+
+void SimulatedClock::advance(uint64_t ns)
+{
+    time += ns;
+}
+
+void SimulatedClock::set_wall_time(time_t t)
+{
+    epoch = t - (time_t)(time / NSEC_PER_SEC);
+}
+
+ScaledClock::ScaledClock(double factor) :
+    clock(), factor(factor > 0 ? factor : 1), start_time(clock.now()), start_wall_time(::time(NULL))
+{
+}
+
+uint64_t ScaledClock::now()
+{
+    return start_time + (uint64_t)((clock.now() - start_time) * factor);
+}
+
+time_t ScaledClock::wall_time()
+{
+    return start_wall_time + (time_t)((now() - start_time) / NSEC_PER_SEC);
+}
+
+void ScaledClock::sleep_until(uint64_t t)
+{
+    if (t > start_time) {
+        clock.sleep_until(start_time + (uint64_t)((t - start_time) / factor));
+    }
+}
+
+int ScaledClock::wait_readable(int fd, uint64_t timeout)
+{
+    return clock.wait_readable(fd, (uint64_t)(timeout / factor));
+}
+
+uint64_t Clock::now()
+{
+    return clock_source->now();
+}
+
+time_t Clock::wall_time()
+{
+    return clock_source->wall_time();
+}
+
+void Clock::sleep(uint64_t ns)
+{
+    clock_source->sleep_until(clock_source->now() + ns);
+}
+
+void Clock::sleep_until(uint64_t t)
+{
+    clock_source->sleep_until(t);
+}
+
+int Clock::wait_readable(int fd, uint64_t timeout)
+{
+    return clock_source->wait_readable(fd, timeout);
+}
+
+void Clock::set_source(ClockSource* source)
+{
+    clock_source = source != NULL ? source : &monotonic_clock;
+}
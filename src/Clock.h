@@ -0,0 +1,194 @@
+/*
+ Clock.h
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef CLOCK_H_
+#define CLOCK_H_
+
+#include <stdint.h>
+#include <time.h>
+
+#define NSEC_PER_SEC    1000000000ULL
+#define NSEC_PER_MSEC   1000000ULL
+#define NSEC_PER_USEC   1000ULL
+
+/**
+ * Source of time used by Clock.
+ */
+class ClockSource {
+public:
+    virtual ~ClockSource() {};
+
+    /**
+     * Returns the current time in nanoseconds.
+     */
+    virtual uint64_t now() = 0;
+
+    /**
+     * Returns the current UTC time in seconds since the epoch.
+     */
+    virtual time_t wall_time() = 0;
+
+    /**
+     * Suspends the calling thread until the specified time.
+     */
+    virtual void sleep_until(uint64_t t) = 0;
+
+    /**
+     * Waits up to the specified number of nanoseconds for the file descriptor
+     * to become readable.
+     *
+     * Returns 1 if the descriptor is readable, 0 on timeout, or -1 on error.
+     */
+    virtual int wait_readable(int fd, uint64_t timeout) = 0;
+};
+
+/**
+ * Monotonic system clock with nanosecond resolution.
+ *
+ * The clock is not affected by NTP or GPS corrections of the system time.
+ */
+class MonotonicClock : public ClockSource {
+public:
+    uint64_t now();
+    time_t wall_time();
+    void sleep_until(uint64_t t);
+    int wait_readable(int fd, uint64_t timeout);
+};
+
+/**
+ * Simulated clock for deterministic tests.
+ *
+ * The time changes only when it is advanced explicitly or when a thread
+ * sleeps or waits, in which case the time jumps to the end of the sleep
+ * immediately. A wait for a file descriptor returns right away if the
+ * descriptor is readable, otherwise the full timeout is consumed.
+ *
+ * The wall time starts at the system time the clock was constructed at and
+ * advances with the simulated time.
+ */
+class SimulatedClock : public ClockSource {
+
+    uint64_t time;
+    time_t   epoch;     // wall time at simulated time 0
+
+public:
+    SimulatedClock(uint64_t start = 0);
+
+    uint64_t now();
+    time_t wall_time();
+    void sleep_until(uint64_t t);
+    int wait_readable(int fd, uint64_t timeout);
+
+    /**
+     * Moves the time forward by the specified number of nanoseconds.
+     */
+    void advance(uint64_t ns);
+
+    /**
+     * Sets the wall time at the current simulated time.
+     */
+    void set_wall_time(time_t t);
+};
+
+/**
+ * Monotonic clock running the specified number of times faster than real time.
+ *
+ * Used to replay recorded telemetry at a multiple of the recorded speed with
+ * all the report periods and timeouts scaled accordingly. The wall time
+ * starts at the system time the clock was constructed at and runs at the
+ * same multiple.
+ */
+class ScaledClock : public ClockSource {
+
+    MonotonicClock clock;
+    double         factor;
+    uint64_t       start_time;
+    time_t         start_wall_time;
+
+public:
+    ScaledClock(double factor);
+
+    uint64_t now();
+    time_t wall_time();
+    void sleep_until(uint64_t t);
+    int wait_readable(int fd, uint64_t timeout);
+};
+
+/**
+ * Clock used by the application to measure all time intervals and timeouts
+ * and to sleep.
+ *
+ * By default the time is read from MonotonicClock. The source can be
+ * replaced with SimulatedClock, so scenarios spanning hours of timeouts
+ * and report periods run in milliseconds.
+ */
+class Clock {
+public:
+    /**
+     * Returns the current time in nanoseconds since an arbitrary point in the past.
+     */
+    static uint64_t now();
+
+    /**
+     * Returns the current UTC time in seconds since the epoch. The wall time
+     * of simulated and scaled clocks advances with their time, so calendar
+     * windows such as the credit budgets follow the simulated time.
+     */
+    static time_t wall_time();
+
+    /**
+     * Suspends the calling thread for the specified number of nanoseconds.
+     */
+    static void sleep(uint64_t ns);
+
+    /**
+     * Suspends the calling thread until the specified time returned by now().
+     */
+    static void sleep_until(uint64_t t);
+
+    /**
+     * Waits up to the specified number of nanoseconds for the file descriptor
+     * to become readable.
+     *
+     * Returns 1 if the descriptor is readable, 0 on timeout, or -1 on error.
+     */
+    static int wait_readable(int fd, uint64_t timeout);
+
+    /**
+     * Replaces the source of time. NULL restores the monotonic system clock.
+     *
+     * The source must outlive its use by the clock.
+     */
+    static void set_source(ClockSource* source);
+
+    /**
+     * Converts seconds to nanoseconds.
+     */
+    static inline uint64_t from_seconds(double seconds) { return seconds > 0 ? (uint64_t)(seconds * NSEC_PER_SEC) : 0; }
+
+    /**
+     * Converts nanoseconds to seconds.
+     */
+    static inline double to_seconds(uint64_t ns) { return (double)ns / NSEC_PER_SEC; }
+};
+
+#endif /* CLOCK_H_ */
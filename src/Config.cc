@@ -22,9 +22,87 @@
 
 #include "Config.h"
 #include "INIReader.h"
+#include <stdlib.h>
+#include <algorithm>
 
 Config config;
 
+TCPEndpointConfig::TCPEndpointConfig() :
+    enabled(DEFAULT_TCP_ENABLED),
+    host(DEFAULT_TCP_HOST),
+    port(DEFAULT_TCP_PORT),
+    report_period(DEFAULT_TCP_REPORT_PERIOD),
+    messages()
+{
+}
+
+bool TCPEndpointConfig::accepts(int msgid) const
+{
+    return messages.empty() ||
+           std::find(messages.begin(), messages.end(), msgid) != messages.end();
+}
+
+/*
+ * Parses comma-separated list of message IDs.
+ */
+static std::vector<int> parse_message_ids(const std::string& s)
+{
+    std::vector<int> ids;
+    const char* p = s.c_str();
+
+    while (*p) {
+        char* end;
+        long id = strtol(p, &end, 0);
+
+        if (end == p) {
+            p++;
+            continue;
+        }
+
+        ids.push_back((int)id);
+        p = end;
+    }
+
+    return ids;
+}
+
+static std::vector<std::string> parse_names(const std::string& s)
+{
+    std::vector<std::string> names;
+    size_t start = 0;
+
+    while (start < s.size()) {
+        size_t end = s.find(',', start);
+
+        if (end == std::string::npos) {
+            end = s.size();
+        }
+
+        size_t first = s.find_first_not_of(" \t", start);
+        size_t last = s.find_last_not_of(" \t", end - 1);
+
+        if (first != std::string::npos && first < end && last >= first) {
+            names.push_back(s.substr(first, last - first + 1));
+        }
+
+        start = end + 1;
+    }
+
+    return names;
+}
+
+static void read_logging_section(INIReader& conf, Config& config)
+{
+    config.set_debug_messages(parse_message_ids(conf.Get(LOGGING_CONFIG_SECTION,
+                                                         LOGGING_DEBUG_MESSAGES_PROPERTY, "")));
+
+    config.set_debug_categories(parse_names(conf.Get(LOGGING_CONFIG_SECTION,
+                                                     LOGGING_DEBUG_CATEGORIES_PROPERTY, "")));
+
+    config.set_quiet_messages(parse_message_ids(conf.Get(LOGGING_CONFIG_SECTION,
+                                                         LOGGING_QUIET_MESSAGES_PROPERTY, "")));
+}
+
 Config::Config() :
     autopilot_serial(DEFAULT_AUTOPILOT_SERIAL),
     autopilot_serial_speed(AUTOPILOT_SERIAL_BAUD_RATE),
@@ -34,10 +112,30 @@ Config::Config() :
     isbd_serial(DEFAULT_ISBD_SERIAL),
     isbd_serial_speed(ISBD_SERIAL_BAUD_RATE),
     isbd_report_period(DEFAULT_ISBD_REPORT_PERIOD),
-    tcp_enabled(DEFAULT_TCP_ENABLED),
-    tcp_host(DEFAULT_TCP_HOST),
-    tcp_port(DEFAULT_TCP_PORT),
-    tcp_report_period(DEFAULT_TCP_REPORT_PERIOD)
+    isbd_report_keyframe_interval(DEFAULT_ISBD_REPORT_KEYFRAME_INTERVAL),
+    isbd_track_sample_period(DEFAULT_ISBD_TRACK_SAMPLE_PERIOD),
+    isbd_hourly_credits(DEFAULT_ISBD_CREDIT_BUDGET),
+    isbd_daily_credits(DEFAULT_ISBD_CREDIT_BUDGET),
+    isbd_monthly_credits(DEFAULT_ISBD_CREDIT_BUDGET),
+    isbd_credit_file(DEFAULT_ISBD_CREDIT_FILE),
+    tcp_endpoints(1),
+    router_enabled(DEFAULT_ROUTER_ENABLED),
+    router_address(DEFAULT_ROUTER_ADDRESS),
+    router_tcp_port(DEFAULT_ROUTER_TCP_PORT),
+    router_udp_port(DEFAULT_ROUTER_UDP_PORT),
+    router_unix_socket(DEFAULT_ROUTER_UNIX_SOCKET),
+    tlog_enabled(DEFAULT_TLOG_ENABLED),
+    tlog_path(DEFAULT_TLOG_PATH),
+    tlog_max_file_size(DEFAULT_TLOG_MAX_FILE_SIZE),
+    tlog_max_files(DEFAULT_TLOG_MAX_FILES),
+    tlog_flush_interval(DEFAULT_TLOG_FLUSH_INTERVAL),
+    tlog_sync_interval(DEFAULT_TLOG_SYNC_INTERVAL),
+    metrics_file(DEFAULT_METRICS_FILE),
+    metrics_unix_socket(DEFAULT_METRICS_UNIX_SOCKET),
+    metrics_interval(DEFAULT_METRICS_INTERVAL),
+    debug_messages(),
+    debug_categories(),
+    quiet_messages()
 {
 }
 
@@ -86,23 +184,142 @@ int Config::init(const std::string& config_file)
                                         REPORT_PERIOD_PROPERTY,
                                         DEFAULT_ISBD_REPORT_PERIOD));
 
-    /* [tcp] config section */
+    set_isbd_report_keyframe_interval(conf.GetInteger(ISBD_CONFIG_SECTION,
+                                                      ISBD_REPORT_KEYFRAME_INTERVAL_PROPERTY,
+                                                      DEFAULT_ISBD_REPORT_KEYFRAME_INTERVAL));
+
+    set_isbd_track_sample_period(conf.GetReal(ISBD_CONFIG_SECTION,
+                                              ISBD_TRACK_SAMPLE_PERIOD_PROPERTY,
+                                              DEFAULT_ISBD_TRACK_SAMPLE_PERIOD));
+
+    set_isbd_hourly_credits(conf.GetInteger(ISBD_CONFIG_SECTION,
+                                            ISBD_HOURLY_CREDITS_PROPERTY,
+                                            DEFAULT_ISBD_CREDIT_BUDGET));
+
+    set_isbd_daily_credits(conf.GetInteger(ISBD_CONFIG_SECTION,
+                                           ISBD_DAILY_CREDITS_PROPERTY,
+                                           DEFAULT_ISBD_CREDIT_BUDGET));
+
+    set_isbd_monthly_credits(conf.GetInteger(ISBD_CONFIG_SECTION,
+                                             ISBD_MONTHLY_CREDITS_PROPERTY,
+                                             DEFAULT_ISBD_CREDIT_BUDGET));
+
+    set_isbd_credit_file(conf.Get(ISBD_CONFIG_SECTION,
+                                  ISBD_CREDIT_FILE_PROPERTY,
+                                  DEFAULT_ISBD_CREDIT_FILE));
+
+    /* [tcp], [tcp2], ... config sections */
+
+    tcp_endpoints.clear();
+
+    for (int i = 1; i <= MAX_TCP_ENDPOINTS; i++) {
+        std::string section = TCP_CONFIG_SECTION;
+
+        if (i > 1) {
+            section += std::to_string(i);
+        }
+
+        TCPEndpointConfig endpoint;
+
+        endpoint.enabled = conf.GetBoolean(section, TCP_ENABLED_PROPERTY,
+                                           i == 1 ? DEFAULT_TCP_ENABLED : false);
+
+        endpoint.host = conf.Get(section, TCP_HOST_PROPERTY, DEFAULT_TCP_HOST);
+
+        endpoint.port = conf.GetInteger(section, TCP_PORT_PROPERTY, DEFAULT_TCP_PORT);
+
+        endpoint.report_period = conf.GetReal(section, REPORT_PERIOD_PROPERTY,
+                                              DEFAULT_TCP_REPORT_PERIOD);
+
+        endpoint.messages = parse_message_ids(conf.Get(section, TCP_MESSAGES_PROPERTY, ""));
+
+        // The first endpoint is always present to keep [tcp] defaults.
+        if (i == 1 || endpoint.enabled) {
+            tcp_endpoints.push_back(endpoint);
+        }
+    }
+
+    /* [router] config section */
+
+    set_router_enabled(conf.GetBoolean(ROUTER_CONFIG_SECTION,
+                                       ROUTER_ENABLED_PROPERTY,
+                                       DEFAULT_ROUTER_ENABLED));
+
+    set_router_address(conf.Get(ROUTER_CONFIG_SECTION,
+                                ROUTER_ADDRESS_PROPERTY,
+                                DEFAULT_ROUTER_ADDRESS));
+
+    set_router_tcp_port(conf.GetInteger(ROUTER_CONFIG_SECTION,
+                                        ROUTER_TCP_PORT_PROPERTY,
+                                        DEFAULT_ROUTER_TCP_PORT));
+
+    set_router_udp_port(conf.GetInteger(ROUTER_CONFIG_SECTION,
+                                        ROUTER_UDP_PORT_PROPERTY,
+                                        DEFAULT_ROUTER_UDP_PORT));
+
+    set_router_unix_socket(conf.Get(ROUTER_CONFIG_SECTION,
+                                    ROUTER_UNIX_SOCKET_PROPERTY,
+                                    DEFAULT_ROUTER_UNIX_SOCKET));
 
-    set_tcp_enabled(conf.GetBoolean(TCP_CONFIG_SECTION,
-                                    TCP_ENABLED_PROPERTY,
-                                    DEFAULT_TCP_ENABLED));
+    /* [tlog] config section */
 
-    set_tcp_host(conf.Get(TCP_CONFIG_SECTION,
-                          TCP_HOST_PROPERTY,
-                          DEFAULT_TCP_HOST));
+    set_tlog_enabled(conf.GetBoolean(TLOG_CONFIG_SECTION,
+                                     TLOG_ENABLED_PROPERTY,
+                                     DEFAULT_TLOG_ENABLED));
 
-    set_tcp_port(conf.GetInteger(TCP_CONFIG_SECTION,
-                                 TCP_PORT_PROPERTY,
-                                 DEFAULT_TCP_PORT));
+    set_tlog_path(conf.Get(TLOG_CONFIG_SECTION,
+                           TLOG_PATH_PROPERTY,
+                           DEFAULT_TLOG_PATH));
+
+    set_tlog_max_file_size(conf.GetInteger(TLOG_CONFIG_SECTION,
+                                           TLOG_MAX_FILE_SIZE_PROPERTY,
+                                           DEFAULT_TLOG_MAX_FILE_SIZE));
+
+    set_tlog_max_files(conf.GetInteger(TLOG_CONFIG_SECTION,
+                                       TLOG_MAX_FILES_PROPERTY,
+                                       DEFAULT_TLOG_MAX_FILES));
+
+    set_tlog_flush_interval(conf.GetReal(TLOG_CONFIG_SECTION,
+                                         TLOG_FLUSH_INTERVAL_PROPERTY,
+                                         DEFAULT_TLOG_FLUSH_INTERVAL));
+
+    set_tlog_sync_interval(conf.GetReal(TLOG_CONFIG_SECTION,
+                                        TLOG_SYNC_INTERVAL_PROPERTY,
+                                        DEFAULT_TLOG_SYNC_INTERVAL));
+
+    /* [metrics] config section */
+
+    set_metrics_file(conf.Get(METRICS_CONFIG_SECTION,
+                              METRICS_FILE_PROPERTY,
+                              DEFAULT_METRICS_FILE));
+
+    set_metrics_unix_socket(conf.Get(METRICS_CONFIG_SECTION,
+                                     METRICS_UNIX_SOCKET_PROPERTY,
+                                     DEFAULT_METRICS_UNIX_SOCKET));
+
+    set_metrics_interval(conf.GetReal(METRICS_CONFIG_SECTION,
+                                      METRICS_INTERVAL_PROPERTY,
+                                      DEFAULT_METRICS_INTERVAL));
+
+    /* [logging] config section */
+
+    read_logging_section(conf, *this);
+
+    return 0;
+}
+
+int Config::reload_logging(const std::string& config_file)
+{
+    INIReader conf(config_file);
+
+    int ret = conf.ParseError();
+
+    if (ret < 0) {
+        return ret;
+    }
+
+    read_logging_section(conf, *this);
 
-    set_tcp_report_period(conf.GetReal(TCP_CONFIG_SECTION,
-                                       REPORT_PERIOD_PROPERTY,
-                                       DEFAULT_TCP_REPORT_PERIOD));
     return 0;
 }
 
@@ -186,40 +403,280 @@ void Config::set_isbd_report_period(double period)
     isbd_report_period = period;
 }
 
+int Config::get_isbd_report_keyframe_interval() const
+{
+    return isbd_report_keyframe_interval;
+}
+
+void Config::set_isbd_report_keyframe_interval(int interval)
+{
+    isbd_report_keyframe_interval = interval;
+}
+
+double Config::get_isbd_track_sample_period() const
+{
+    return isbd_track_sample_period;
+}
+
+void Config::set_isbd_track_sample_period(double period)
+{
+    isbd_track_sample_period = period;
+}
+
+int Config::get_isbd_hourly_credits() const
+{
+    return isbd_hourly_credits;
+}
+
+void Config::set_isbd_hourly_credits(int credits)
+{
+    isbd_hourly_credits = credits;
+}
+
+int Config::get_isbd_daily_credits() const
+{
+    return isbd_daily_credits;
+}
+
+void Config::set_isbd_daily_credits(int credits)
+{
+    isbd_daily_credits = credits;
+}
+
+int Config::get_isbd_monthly_credits() const
+{
+    return isbd_monthly_credits;
+}
+
+void Config::set_isbd_monthly_credits(int credits)
+{
+    isbd_monthly_credits = credits;
+}
+
+std::string Config::get_isbd_credit_file() const
+{
+    return isbd_credit_file;
+}
+
+void Config::set_isbd_credit_file(const std::string& path)
+{
+    isbd_credit_file = path;
+}
+
 bool Config::get_tcp_enabled() const
 {
-    return tcp_enabled;
+    for (size_t i = 0; i < tcp_endpoints.size(); i++) {
+        if (tcp_endpoints[i].enabled) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+size_t Config::get_tcp_endpoint_count() const
+{
+    return tcp_endpoints.size();
+}
+
+const TCPEndpointConfig& Config::get_tcp_endpoint(size_t i) const
+{
+    return tcp_endpoints[i];
+}
+
+TCPEndpointConfig& Config::get_tcp_endpoint(size_t i)
+{
+    return tcp_endpoints[i];
+}
+
+double Config::get_tcp_report_period() const
+{
+    double period = DEFAULT_TCP_REPORT_PERIOD;
+    bool found = false;
+
+    for (size_t i = 0; i < tcp_endpoints.size(); i++) {
+        if (tcp_endpoints[i].enabled && (!found || tcp_endpoints[i].report_period < period)) {
+            period = tcp_endpoints[i].report_period;
+            found = true;
+        }
+    }
+
+    return period;
+}
+
+void Config::set_tcp_report_period(double period)
+{
+    for (size_t i = 0; i < tcp_endpoints.size(); i++) {
+        tcp_endpoints[i].report_period = period;
+    }
+}
+
+bool Config::get_router_enabled() const
+{
+    return router_enabled;
+}
+
+void Config::set_router_enabled(bool enabled)
+{
+    router_enabled = enabled;
+}
+
+std::string Config::get_router_address() const
+{
+    return router_address;
+}
+
+void Config::set_router_address(const std::string& address)
+{
+    router_address = address;
+}
+
+int Config::get_router_tcp_port() const
+{
+    return router_tcp_port;
+}
+
+void Config::set_router_tcp_port(int port)
+{
+    router_tcp_port = port;
+}
+
+int Config::get_router_udp_port() const
+{
+    return router_udp_port;
+}
+
+void Config::set_router_udp_port(int port)
+{
+    router_udp_port = port;
+}
+
+std::string Config::get_router_unix_socket() const
+{
+    return router_unix_socket;
+}
+
+void Config::set_router_unix_socket(const std::string& path)
+{
+    router_unix_socket = path;
+}
+
+bool Config::get_tlog_enabled() const
+{
+    return tlog_enabled;
+}
+
+void Config::set_tlog_enabled(bool enabled)
+{
+    tlog_enabled = enabled;
+}
+
+std::string Config::get_tlog_path() const
+{
+    return tlog_path;
+}
+
+void Config::set_tlog_path(const std::string& path)
+{
+    tlog_path = path;
+}
+
+int Config::get_tlog_max_file_size() const
+{
+    return tlog_max_file_size;
+}
+
+void Config::set_tlog_max_file_size(int size)
+{
+    tlog_max_file_size = size;
+}
+
+int Config::get_tlog_max_files() const
+{
+    return tlog_max_files;
+}
+
+void Config::set_tlog_max_files(int count)
+{
+    tlog_max_files = count;
+}
+
+double Config::get_tlog_flush_interval() const
+{
+    return tlog_flush_interval;
+}
+
+void Config::set_tlog_flush_interval(double interval)
+{
+    tlog_flush_interval = interval;
+}
+
+double Config::get_tlog_sync_interval() const
+{
+    return tlog_sync_interval;
 }
 
-void Config::set_tcp_enabled(bool enabled)
+void Config::set_tlog_sync_interval(double interval)
 {
-    tcp_enabled = enabled;
+    tlog_sync_interval = interval;
 }
 
-std::string Config::get_tcp_host() const
+std::string Config::get_metrics_file() const
 {
-    return tcp_host;
+    return metrics_file;
 }
 
-void Config::set_tcp_host(const std::string& host)
+void Config::set_metrics_file(const std::string& path)
 {
-    tcp_host = host;
+    metrics_file = path;
 }
 
-int Config::get_tcp_port() const
+std::string Config::get_metrics_unix_socket() const
 {
-    return tcp_port;
+    return metrics_unix_socket;
 }
 
-void Config::set_tcp_port(int port)
+void Config::set_metrics_unix_socket(const std::string& path)
 {
-    tcp_port = port;
+    metrics_unix_socket = path;
 }
 
-double Config::get_tcp_report_period() const {
-    return tcp_report_period;
+double Config::get_metrics_interval() const
+{
+    return metrics_interval;
+}
+
+void Config::set_metrics_interval(double interval)
+{
+    metrics_interval = interval;
+}
+
+const std::vector<int>& Config::get_debug_messages() const
+{
+    return debug_messages;
 }
 
-void Config::set_tcp_report_period(double period) {
-    tcp_report_period = period;
+void Config::set_debug_messages(const std::vector<int>& ids)
+{
+    debug_messages = ids;
+}
+
+const std::vector<std::string>& Config::get_debug_categories() const
+{
+    return debug_categories;
+}
+
+void Config::set_debug_categories(const std::vector<std::string>& categories)
+{
+    debug_categories = categories;
+}
+
+const std::vector<int>& Config::get_quiet_messages() const
+{
+    return quiet_messages;
+}
+
+void Config::set_quiet_messages(const std::vector<int>& ids)
+{
+    quiet_messages = ids;
 }
@@ -19,7 +19,12 @@
  License along with this library; if not, write to the Free Software
  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
  */
+
+#ifndef CONFIG_H_
+#define CONFIG_H_
+
 #include <string>
+#include <vector>
 
 #define DEFAULT_CONFIG_FILE         "/etc/radioroom.conf"
 
@@ -33,8 +38,28 @@
 #define DEFAULT_TCP_ENABLED         false
 #define DEFAULT_TCP_HOST            ""
 #define DEFAULT_TCP_PORT            5060
+#define MAX_TCP_ENDPOINTS           4
+
+#define DEFAULT_ROUTER_ENABLED      false
+#define DEFAULT_ROUTER_ADDRESS      "127.0.0.1"
+#define DEFAULT_ROUTER_TCP_PORT     5760
+#define DEFAULT_ROUTER_UDP_PORT     14555
+#define DEFAULT_ROUTER_UNIX_SOCKET  ""
+#define DEFAULT_TLOG_ENABLED        false
+#define DEFAULT_TLOG_PATH           "/var/log/radioroom"
+#define DEFAULT_TLOG_MAX_FILE_SIZE  16384   // KiB
+#define DEFAULT_TLOG_MAX_FILES      10
+#define DEFAULT_TLOG_FLUSH_INTERVAL 5.0     // seconds
+#define DEFAULT_TLOG_SYNC_INTERVAL  60.0    // seconds
+#define DEFAULT_METRICS_FILE        ""
+#define DEFAULT_METRICS_UNIX_SOCKET ""
+#define DEFAULT_METRICS_INTERVAL    15.0    // seconds
 
 #define DEFAULT_ISBD_REPORT_PERIOD  300.0 // 5 minutes
+#define DEFAULT_ISBD_REPORT_KEYFRAME_INTERVAL 0 // report deltas disabled
+#define DEFAULT_ISBD_TRACK_SAMPLE_PERIOD 0.0 // track disabled
+#define DEFAULT_ISBD_CREDIT_BUDGET  0     // credits not limited
+#define DEFAULT_ISBD_CREDIT_FILE    "/var/lib/radioroom/isbd_credits"
 #define DEFAULT_TCP_REPORT_PERIOD   60.0 // 1 minute
 
 // radioroom.conf properties
@@ -50,11 +75,64 @@
 #define ISBD_ENABLED_PROPERTY           "enabled"
 #define ISBD_SERIAL_PROPERTY            "serial"
 #define ISBD_SERIAL_SPEED_PROPERTY      "serial_speed"
+#define ISBD_REPORT_KEYFRAME_INTERVAL_PROPERTY "report_keyframe_interval"
+#define ISBD_TRACK_SAMPLE_PERIOD_PROPERTY "track_sample_period"
+#define ISBD_HOURLY_CREDITS_PROPERTY    "hourly_credits"
+#define ISBD_DAILY_CREDITS_PROPERTY     "daily_credits"
+#define ISBD_MONTHLY_CREDITS_PROPERTY   "monthly_credits"
+#define ISBD_CREDIT_FILE_PROPERTY       "credit_file"
 
 #define TCP_CONFIG_SECTION              "tcp"
 #define TCP_ENABLED_PROPERTY            "enabled"
 #define TCP_HOST_PROPERTY               "host"
 #define TCP_PORT_PROPERTY               "port"
+#define TCP_MESSAGES_PROPERTY           "messages"
+
+#define ROUTER_CONFIG_SECTION           "router"
+#define ROUTER_ENABLED_PROPERTY         "enabled"
+#define ROUTER_ADDRESS_PROPERTY         "address"
+#define ROUTER_TCP_PORT_PROPERTY        "tcp_port"
+#define ROUTER_UDP_PORT_PROPERTY        "udp_port"
+#define ROUTER_UNIX_SOCKET_PROPERTY     "unix_socket"
+
+#define TLOG_CONFIG_SECTION             "tlog"
+#define TLOG_ENABLED_PROPERTY           "enabled"
+#define TLOG_PATH_PROPERTY              "path"
+#define TLOG_MAX_FILE_SIZE_PROPERTY     "max_file_size"
+#define TLOG_MAX_FILES_PROPERTY         "max_files"
+#define TLOG_FLUSH_INTERVAL_PROPERTY    "flush_interval"
+#define TLOG_SYNC_INTERVAL_PROPERTY     "sync_interval"
+
+#define METRICS_CONFIG_SECTION          "metrics"
+#define METRICS_FILE_PROPERTY           "file"
+#define METRICS_UNIX_SOCKET_PROPERTY    "unix_socket"
+#define METRICS_INTERVAL_PROPERTY       "interval"
+
+#define LOGGING_CONFIG_SECTION          "logging"
+#define LOGGING_DEBUG_MESSAGES_PROPERTY "debug_messages"
+#define LOGGING_DEBUG_CATEGORIES_PROPERTY "debug_categories"
+#define LOGGING_QUIET_MESSAGES_PROPERTY "quiet_messages"
+
+/**
+ * Configuration of a single TCP/IP endpoint.
+ *
+ * The first endpoint is configured in [tcp] section, additional endpoints
+ * in [tcp2], [tcp3], ... sections.
+ */
+struct TCPEndpointConfig {
+    bool             enabled;
+    std::string      host;
+    int              port;
+    double           report_period;
+    std::vector<int> messages; // IDs of messages reported to the endpoint, all if empty
+
+    TCPEndpointConfig();
+
+    /**
+     * Returns true if messages with the specified ID pass the endpoint's message filter.
+     */
+    bool accepts(int msgid) const;
+};
 
 /**
  * RadioRoom configuration properties.
@@ -71,11 +149,35 @@ class Config {
     std::string   isbd_serial;
     int           isbd_serial_speed;
     unsigned long isbd_report_period;
-
-    bool          tcp_enabled;
-    std::string   tcp_host;
-    int           tcp_port;
-    unsigned long tcp_report_period;
+    int           isbd_report_keyframe_interval;
+    double        isbd_track_sample_period;
+    int           isbd_hourly_credits;
+    int           isbd_daily_credits;
+    int           isbd_monthly_credits;
+    std::string   isbd_credit_file;
+
+    std::vector<TCPEndpointConfig> tcp_endpoints;
+
+    bool          router_enabled;
+    std::string   router_address;
+    int           router_tcp_port;
+    int           router_udp_port;
+    std::string   router_unix_socket;
+
+    bool          tlog_enabled;
+    std::string   tlog_path;
+    int           tlog_max_file_size;
+    int           tlog_max_files;
+    double        tlog_flush_interval;
+    double        tlog_sync_interval;
+
+    std::string   metrics_file;
+    std::string   metrics_unix_socket;
+    double        metrics_interval;
+
+    std::vector<int>         debug_messages;
+    std::vector<std::string> debug_categories;
+    std::vector<int>         quiet_messages;
 
 public:
     Config();
@@ -117,19 +219,152 @@ public:
     double get_isbd_report_period() const;
     void set_isbd_report_period(double period);
 
+    int  get_isbd_report_keyframe_interval() const;
+    void set_isbd_report_keyframe_interval(int interval);
+
+    double get_isbd_track_sample_period() const;
+    void set_isbd_track_sample_period(double period);
+
+    /**
+     * Credit budgets of the UTC hour, day and month. 0 does not limit the credits.
+     */
+    int  get_isbd_hourly_credits() const;
+    void set_isbd_hourly_credits(int credits);
+
+    int  get_isbd_daily_credits() const;
+    void set_isbd_daily_credits(int credits);
+
+    int  get_isbd_monthly_credits() const;
+    void set_isbd_monthly_credits(int credits);
+
+    /**
+     * Path of the file the credits spent in the budget windows are kept in.
+     */
+    std::string get_isbd_credit_file() const;
+    void set_isbd_credit_file(const std::string& path);
+
     /* TCP/IP comm link configuration properties */
 
+    /*
+     * Returns true if at least one TCP endpoint is enabled.
+     */
     bool get_tcp_enabled() const;
-    void set_tcp_enabled(bool enabled);
 
-    std::string get_tcp_host() const;
-    void set_tcp_host(const std::string& host);
-
-    int get_tcp_port() const;
-    void set_tcp_port(int port);
+    size_t get_tcp_endpoint_count() const;
+    const TCPEndpointConfig& get_tcp_endpoint(size_t i) const;
+    TCPEndpointConfig& get_tcp_endpoint(size_t i);
 
+    /*
+     * Returns the shortest report period of the enabled TCP endpoints.
+     */
     double get_tcp_report_period() const;
+
+    /*
+     * Sets report period of all TCP endpoints.
+     */
     void set_tcp_report_period(double period);
+
+    /* Local MAVLink router configuration properties */
+
+    bool get_router_enabled() const;
+    void set_router_enabled(bool enabled);
+
+    std::string get_router_address() const;
+    void set_router_address(const std::string& address);
+
+    int  get_router_tcp_port() const;
+    void set_router_tcp_port(int port);
+
+    int  get_router_udp_port() const;
+    void set_router_udp_port(int port);
+
+    std::string get_router_unix_socket() const;
+    void set_router_unix_socket(const std::string& path);
+
+    /* Telemetry log configuration properties */
+
+    bool get_tlog_enabled() const;
+    void set_tlog_enabled(bool enabled);
+
+    /**
+     * Directory of the .tlog files.
+     */
+    std::string get_tlog_path() const;
+    void set_tlog_path(const std::string& path);
+
+    /**
+     * Maximum size of a .tlog file in KiB.
+     */
+    int  get_tlog_max_file_size() const;
+    void set_tlog_max_file_size(int size);
+
+    /**
+     * Maximum number of .tlog files kept in the directory.
+     */
+    int  get_tlog_max_files() const;
+    void set_tlog_max_files(int count);
+
+    /**
+     * Maximum time in seconds the frames are buffered in memory.
+     */
+    double get_tlog_flush_interval() const;
+    void   set_tlog_flush_interval(double interval);
+
+    /**
+     * Minimum time in seconds between fdatasync() calls.
+     */
+    double get_tlog_sync_interval() const;
+    void   set_tlog_sync_interval(double interval);
+
+    /* Metrics configuration properties */
+
+    /**
+     * Path of the file metrics are written to in Prometheus text format.
+     */
+    std::string get_metrics_file() const;
+    void set_metrics_file(const std::string& path);
+
+    /**
+     * Path of the Unix socket metrics are served on in Prometheus text format.
+     */
+    std::string get_metrics_unix_socket() const;
+    void set_metrics_unix_socket(const std::string& path);
+
+    /**
+     * Interval in seconds between writes of the metrics file.
+     */
+    double get_metrics_interval() const;
+    void   set_metrics_interval(double interval);
+
+    /* Logging configuration properties */
+
+    /**
+     * Reloads only [logging] section of the configuration file.
+     * Can be used to change logging settings at runtime.
+     *
+     * Returns 0 in case of success, or INIReader parse error.
+     */
+    int reload_logging(const std::string& config_file);
+
+    /**
+     * IDs of MAVLink messages logged at debug level.
+     */
+    const std::vector<int>& get_debug_messages() const;
+    void set_debug_messages(const std::vector<int>& ids);
+
+    /**
+     * Log categories (prefixes such as MAV, SBD, TCP) logged at debug level.
+     */
+    const std::vector<std::string>& get_debug_categories() const;
+    void set_debug_categories(const std::vector<std::string>& categories);
+
+    /**
+     * IDs of MAVLink messages that are not logged.
+     */
+    const std::vector<int>& get_quiet_messages() const;
+    void set_quiet_messages(const std::vector<int>& ids);
 };
 
 extern Config config;
+
+#endif /* CONFIG_H_ */
@@ -0,0 +1,319 @@
+/*
+ ISBDCreditBudget.cc
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "ISBDCreditBudget.h"
+#include "IridiumSBD.h"
+#include "Metrics.h"
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <syslog.h>
+#include <unistd.h>
+
+#define SECONDS_PER_HOUR    3600
+#define SECONDS_PER_DAY     86400
+
+static const char* window_names[ISBD_BUDGET_WINDOWS] = { "hour", "day", "month" };
+
+ISBDCreditBudget::ISBDCreditBudget() :
+    windows(), path()
+{
+}
+
+void ISBDCreditBudget::set_budget(int window, int credits)
+{
+    windows[window].budget = credits > 0 ? credits : 0;
+}
+
+bool ISBDCreditBudget::is_limited() const
+{
+    for (int i = 0; i < ISBD_BUDGET_WINDOWS; i++) {
+        if (windows[i].budget > 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool ISBDCreditBudget::open(const std::string& path, time_t now)
+{
+    this->path = path;
+
+    for (int i = 0; i < ISBD_BUDGET_WINDOWS; i++) {
+        windows[i].start = window_start(i, now);
+        windows[i].spent = 0;
+    }
+
+    if (path.empty()) {
+        return true;
+    }
+
+    FILE* file = fopen(path.data(), "r");
+
+    if (file == NULL) {
+        if (errno == ENOENT) {
+            return true;
+        }
+
+        syslog(LOG_WARNING, "Failed to read credit file '%s': %s", path.data(), strerror(errno));
+        return false;
+    }
+
+    Window loaded[ISBD_BUDGET_WINDOWS];
+    bool ok = true;
+
+    for (int i = 0; i < ISBD_BUDGET_WINDOWS && ok; i++) {
+        long long start;
+        ok = fscanf(file, "%lld %d", &start, &loaded[i].spent) == 2 && loaded[i].spent >= 0;
+        loaded[i].start = start;
+    }
+
+    fclose(file);
+
+    if (!ok) {
+        syslog(LOG_WARNING, "Invalid credit file '%s'.", path.data());
+        return false;
+    }
+
+    // The counters of the windows that ended since are not loaded
+    for (int i = 0; i < ISBD_BUDGET_WINDOWS; i++) {
+        if (loaded[i].start == windows[i].start) {
+            windows[i].spent = loaded[i].spent;
+        }
+    }
+
+    return true;
+}
+
+void ISBDCreditBudget::spend(int credits, time_t now)
+{
+    for (int i = 0; i < ISBD_BUDGET_WINDOWS; i++) {
+        time_t start = window_start(i, now);
+
+        if (windows[i].start != start) {
+            windows[i].start = start;
+            windows[i].spent = 0;
+        }
+
+        windows[i].spent += credits;
+
+        if (windows[i].budget > 0) {
+            Metrics::gauge("isbd_budget_credits_remaining", Metrics::label("window", window_names[i]),
+                           "Number of ISBD credits left in the budget window.").set(windows[i].budget - windows[i].spent);
+        }
+    }
+
+    Metrics::gauge("isbd_credit_burn_rate", "", "ISBD credits spent per hour in the current day.").set(get_burn_rate(now));
+
+    if (!path.empty()) {
+        save();
+    }
+}
+
+int ISBDCreditBudget::get_spent(int window, time_t now) const
+{
+    return windows[window].start == window_start(window, now) ? windows[window].spent : 0;
+}
+
+int ISBDCreditBudget::get_remaining(time_t now) const
+{
+    int remaining = -1;
+
+    for (int i = 0; i < ISBD_BUDGET_WINDOWS; i++) {
+        if (windows[i].budget > 0) {
+            int left = windows[i].budget - get_spent(i, now);
+
+            if (left < 0) {
+                left = 0;
+            }
+
+            if (remaining < 0 || left < remaining) {
+                remaining = left;
+            }
+        }
+    }
+
+    return remaining;
+}
+
+double ISBDCreditBudget::get_burn_rate(time_t now) const
+{
+    time_t elapsed = now - window_start(ISBD_BUDGET_DAY, now);
+
+    if (elapsed < SECONDS_PER_HOUR) {
+        elapsed = SECONDS_PER_HOUR;
+    }
+
+    return (double)get_spent(ISBD_BUDGET_DAY, now) * SECONDS_PER_HOUR / elapsed;
+}
+
+size_t ISBDCreditBudget::get_report_size(double period, time_t now) const
+{
+    double rate = get_rate(now);
+
+    if (rate < 0 || rate * period * ISBD_CREDIT_SIZE >= ISBD_MAX_MO_MGS_SIZE) {
+        return ISBD_MAX_MO_MGS_SIZE;
+    }
+
+    int credits = (int)(rate * period);
+
+    return credits > 1 ? credits * ISBD_CREDIT_SIZE : ISBD_CREDIT_SIZE;
+}
+
+double ISBDCreditBudget::get_report_period(double period, int report_cost, time_t now) const
+{
+    double rate = get_rate(now);
+
+    if (rate < 0) {
+        return period;
+    }
+
+    if (report_cost < 1) {
+        report_cost = 1;
+    }
+
+    double budget_period = 0;
+
+    if (rate > 0) {
+        budget_period = report_cost / rate;
+    } else {
+        // The spent windows must end before the next report
+        for (int i = 0; i < ISBD_BUDGET_WINDOWS; i++) {
+            if (windows[i].budget > 0 && get_spent(i, now) >= windows[i].budget &&
+                window_end(i, now) - now > budget_period) {
+                budget_period = window_end(i, now) - now;
+            }
+        }
+    }
+
+    return budget_period > period ? budget_period : period;
+}
+
+bool ISBDCreditBudget::allows_event(double period, int report_cost, time_t now) const
+{
+    if (report_cost < 1) {
+        report_cost = 1;
+    }
+
+    double report_period = get_report_period(period, report_cost, now);
+
+    for (int i = 0; i < ISBD_BUDGET_WINDOWS; i++) {
+        if (windows[i].budget > 0) {
+            double scheduled = report_cost * (window_end(i, now) - now) / report_period;
+
+            if (windows[i].budget - get_spent(i, now) - scheduled < report_cost) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+int ISBDCreditBudget::credits(size_t size)
+{
+    return (size + ISBD_CREDIT_SIZE - 1) / ISBD_CREDIT_SIZE;
+}
+
+time_t ISBDCreditBudget::window_start(int window, time_t now)
+{
+    switch (window) {
+    case ISBD_BUDGET_HOUR:
+        return now - now % SECONDS_PER_HOUR;
+    case ISBD_BUDGET_DAY:
+        return now - now % SECONDS_PER_DAY;
+    default: {
+        struct tm tm;
+        gmtime_r(&now, &tm);
+        tm.tm_mday = 1;
+        tm.tm_hour = tm.tm_min = tm.tm_sec = 0;
+        return timegm(&tm);
+    }
+    }
+}
+
+time_t ISBDCreditBudget::window_end(int window, time_t now)
+{
+    switch (window) {
+    case ISBD_BUDGET_HOUR:
+        return window_start(window, now) + SECONDS_PER_HOUR;
+    case ISBD_BUDGET_DAY:
+        return window_start(window, now) + SECONDS_PER_DAY;
+    default: {
+        struct tm tm;
+        gmtime_r(&now, &tm);
+        tm.tm_mon++;
+        tm.tm_mday = 1;
+        tm.tm_hour = tm.tm_min = tm.tm_sec = 0;
+        return timegm(&tm);
+    }
+    }
+}
+
+double ISBDCreditBudget::get_rate(time_t now) const
+{
+    double rate = -1;
+
+    for (int i = 0; i < ISBD_BUDGET_WINDOWS; i++) {
+        if (windows[i].budget > 0) {
+            int left = windows[i].budget - get_spent(i, now);
+            double window_rate = left > 0 ? (double)left / (window_end(i, now) - now) : 0;
+
+            if (rate < 0 || window_rate < rate) {
+                rate = window_rate;
+            }
+        }
+    }
+
+    return rate;
+}
+
+bool ISBDCreditBudget::save() const
+{
+    // Write a temporary file and rename it, so a crash never leaves a partial file
+    std::string tmp_file = path + ".tmp";
+
+    FILE* file = fopen(tmp_file.data(), "w");
+
+    if (file == NULL) {
+        syslog(LOG_WARNING, "Failed to write credit file '%s': %s", tmp_file.data(), strerror(errno));
+        return false;
+    }
+
+    bool ok = true;
+
+    for (int i = 0; i < ISBD_BUDGET_WINDOWS && ok; i++) {
+        ok = fprintf(file, "%lld %d\n", (long long)windows[i].start, windows[i].spent) > 0;
+    }
+
+    ok = fflush(file) == 0 && fsync(fileno(file)) == 0 && ok;
+    ok = (fclose(file) == 0) && ok;
+
+    if (!ok || rename(tmp_file.data(), path.data()) < 0) {
+        syslog(LOG_WARNING, "Failed to write credit file '%s': %s", path.data(), strerror(errno));
+        unlink(tmp_file.data());
+        return false;
+    }
+
+    return true;
+}
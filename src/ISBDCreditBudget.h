@@ -0,0 +1,146 @@
+/*
+ ISBDCreditBudget.h
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef ISBDCREDITBUDGET_H_
+#define ISBDCREDITBUDGET_H_
+
+#include <stddef.h>
+#include <time.h>
+#include <string>
+
+#define ISBD_CREDIT_SIZE        50      // message bytes charged as one credit
+
+#define ISBD_BUDGET_HOUR        0
+#define ISBD_BUDGET_DAY         1
+#define ISBD_BUDGET_MONTH       2
+#define ISBD_BUDGET_WINDOWS     3
+
+/**
+ * Credit budget of ISBD comm channel.
+ *
+ * The budget limits the credits spent in the current UTC hour, day and
+ * month. A budget of 0 credits does not limit the window. The credits
+ * spent in each window are kept in a file, so restarts do not reset them.
+ *
+ * The credits left in a window are spread evenly over the time left in the
+ * window. The lowest of these rates is the rate the channel can spend
+ * credits at. When the rate does not cover the reports at the configured
+ * report period, the reports are first shrunk to the credits available per
+ * report, but not below one credit, and then sent less often. Reports
+ * triggered by events are allowed only if the credits left after the
+ * scheduled reports cover them.
+ */
+class ISBDCreditBudget {
+
+    struct Window {
+        int    budget;  // credits, 0 if not limited
+        time_t start;   // UTC time the counter was started
+        int    spent;   // credits spent since start
+    };
+
+    Window      windows[ISBD_BUDGET_WINDOWS];
+    std::string path;   // file of the spent credits, not kept if empty
+
+public:
+    ISBDCreditBudget();
+
+    /**
+     * Sets the budget of the window in credits. 0 does not limit the window.
+     */
+    void set_budget(int window, int credits);
+
+    /**
+     * Returns true if any window is limited.
+     */
+    bool is_limited() const;
+
+    /**
+     * Loads the credits spent in the windows from the specified file. The
+     * credits spent since are saved to the file.
+     *
+     * Returns false if the file exists but cannot be read.
+     */
+    bool open(const std::string& path, time_t now);
+
+    /**
+     * Records the credits spent at the specified time and saves the counters.
+     */
+    void spend(int credits, time_t now);
+
+    /**
+     * Returns the credits spent in the current window.
+     */
+    int get_spent(int window, time_t now) const;
+
+    /**
+     * Returns the credits left in the tightest window, or -1 if no window is limited.
+     */
+    int get_remaining(time_t now) const;
+
+    /**
+     * Returns the credits spent per hour in the current day.
+     */
+    double get_burn_rate(time_t now) const;
+
+    /**
+     * Returns the maximum size in bytes of the report and the data sent with it.
+     */
+    size_t get_report_size(double period, time_t now) const;
+
+    /**
+     * Returns the report period in seconds that keeps the reports of the
+     * specified cost in credits within the budget, not shorter than the
+     * configured period.
+     */
+    double get_report_period(double period, int report_cost, time_t now) const;
+
+    /**
+     * Returns true if the credits left after the reports at the specified
+     * period cover one more report of the specified cost.
+     */
+    bool allows_event(double period, int report_cost, time_t now) const;
+
+    /**
+     * Returns the number of credits charged for a message of the specified size.
+     */
+    static int credits(size_t size);
+
+    /**
+     * Returns UTC start time of the window that includes the specified time.
+     */
+    static time_t window_start(int window, time_t now);
+
+    /**
+     * Returns UTC end time of the window that includes the specified time.
+     */
+    static time_t window_end(int window, time_t now);
+
+private:
+    /**
+     * Returns the credits per second the budget allows, or -1 if no window is limited.
+     */
+    double get_rate(time_t now) const;
+
+    bool save() const;
+};
+
+#endif /* ISBDCREDITBUDGET_H_ */
@@ -0,0 +1,140 @@
+/*
+ ISBDRetryScheduler.cc
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "ISBDRetryScheduler.h"
+#include "Clock.h"
+#include "Metrics.h"
+
+ISBDRetryScheduler::ISBDRetryScheduler() :
+    history(), history_start(0), history_size(0), csq_interval(0), sbdix_interval(0), minimum_csq(0),
+    failures(0), mo_code(-1), decision(ISBD_RETRY_STEADY), delay(0)
+{
+}
+
+void ISBDRetryScheduler::start_session(int csq_interval, int sbdix_interval, int minimum_csq)
+{
+    this->csq_interval = csq_interval;
+    this->sbdix_interval = sbdix_interval;
+    this->minimum_csq = minimum_csq;
+    mo_code = -1;
+    delay = 0;
+}
+
+void ISBDRetryScheduler::signal_quality(int quality)
+{
+    if (history_size == ISBD_RETRY_HISTORY_SIZE) {
+        history_start = (history_start + 1) % ISBD_RETRY_HISTORY_SIZE;
+        history_size--;
+    }
+
+    Reading& reading = history[(history_start + history_size) % ISBD_RETRY_HISTORY_SIZE];
+    reading.time = Clock::now();
+    reading.quality = quality;
+    history_size++;
+
+    mo_code = -1;
+
+    Metrics::gauge("isbd_signal_quality_trend", "", "Change of ISBD signal quality within the trend window.").set(get_trend());
+}
+
+void ISBDRetryScheduler::sbdix(int mo_code)
+{
+    this->mo_code = mo_code;
+
+    if (mo_code <= 4) {
+        failures = 0;
+        delay = 0;
+    }
+}
+
+int ISBDRetryScheduler::get_trend() const
+{
+    if (history_size < 2) {
+        return 0;
+    }
+
+    const Reading& latest = history[(history_start + history_size - 1) % ISBD_RETRY_HISTORY_SIZE];
+    uint64_t window = ISBD_RETRY_TREND_WINDOW * NSEC_PER_SEC;
+
+    // The oldest reading within the window or the previous reading
+    size_t i = 0;
+
+    while (i < history_size - 2 && latest.time - history[(history_start + i) % ISBD_RETRY_HISTORY_SIZE].time > window) {
+        i++;
+    }
+
+    return latest.quality - history[(history_start + i) % ISBD_RETRY_HISTORY_SIZE].quality;
+}
+
+uint64_t ISBDRetryScheduler::next_delay()
+{
+    int interval;
+    int quality = history_size > 0 ? history[(history_start + history_size - 1) % ISBD_RETRY_HISTORY_SIZE].quality : 0;
+    bool attempted = mo_code >= 0;
+
+    if (mo_code == 36 || mo_code == 37 || mo_code == 38) {
+        decision = ISBD_RETRY_DEFER;
+        interval = ISBD_RETRY_DEFER_INTERVAL;
+    } else if (mo_code == 35) {
+        decision = ISBD_RETRY_BUSY;
+        interval = sbdix_interval;
+    } else if (!attempted && quality > 0 && get_trend() > 0) {
+        // The signal improved since the last attempt
+        decision = ISBD_RETRY_RISING;
+        interval = ISBD_RETRY_MIN_INTERVAL;
+    } else if ((!attempted && quality == 0) ||
+               mo_code == 18 || mo_code == 19 || mo_code == 32 || mo_code == 33 || mo_code == 34) {
+        decision = ISBD_RETRY_BACKOFF;
+        interval = (attempted ? sbdix_interval : csq_interval) * (failures < 3 ? 1 << failures : ISBD_RETRY_MAX_BACKOFF);
+        failures++;
+    } else {
+        decision = ISBD_RETRY_STEADY;
+        interval = attempted ? sbdix_interval : csq_interval;
+    }
+
+    delay = (uint64_t)interval * NSEC_PER_SEC;
+
+    Metrics::counter("isbd_retry_decisions_total", Metrics::label("decision", decision_name(decision)),
+                     "Number of SBD session retries by decision.").inc();
+    Metrics::histogram("isbd_retry_delay_seconds", "", "Delay before SBD session retries.",
+                       METRICS_SESSION_BUCKETS).observe(Clock::to_seconds(delay));
+
+    return delay;
+}
+
+const char* ISBDRetryScheduler::decision_name(int decision)
+{
+    switch (decision) {
+    case ISBD_RETRY_RISING:
+        return "rising";
+    case ISBD_RETRY_STEADY:
+        return "steady";
+    case ISBD_RETRY_BACKOFF:
+        return "backoff";
+    case ISBD_RETRY_BUSY:
+        return "busy";
+    case ISBD_RETRY_DEFER:
+        return "defer";
+    }
+
+    return "unknown";
+}
@@ -0,0 +1,131 @@
+/*
+ ISBDRetryScheduler.h
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef ISBDRETRYSCHEDULER_H_
+#define ISBDRETRYSCHEDULER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define ISBD_RETRY_HISTORY_SIZE     8       // signal quality readings kept
+#define ISBD_RETRY_TREND_WINDOW     60      // seconds of readings used for the signal trend
+#define ISBD_RETRY_MIN_INTERVAL     5       // seconds between attempts while the signal is rising
+#define ISBD_RETRY_MAX_BACKOFF      8       // maximum multiplier of the retry interval
+#define ISBD_RETRY_DEFER_INTERVAL   180     // seconds to wait when the network asks to try later
+
+/**
+ * Retry decisions of ISBDRetryScheduler.
+ */
+enum ISBDRetryDecision {
+    ISBD_RETRY_RISING = 0,  // signal is rising, retry soon
+    ISBD_RETRY_STEADY,      // retry after the regular interval
+    ISBD_RETRY_BACKOFF,     // sky is blocked, retry after exponentially growing intervals
+    ISBD_RETRY_BUSY,        // network is busy, retry after the SBDIX interval
+    ISBD_RETRY_DEFER        // network asked to try later, retry in the next session
+};
+
+/**
+ * Schedules retries of SBD sessions from the recent signal quality readings
+ * and SBDIX MO status codes.
+ *
+ * Rising signal quality since the last attempt is retried after
+ * ISBD_RETRY_MIN_INTERVAL. Zero signal quality and MO codes of RF link
+ * failures (18, 19, 32 no network service, 33, 34) back off exponentially
+ * from the CSQ or SBDIX interval up to ISBD_RETRY_MAX_BACKOFF times the
+ * interval. MO code 35 "Iridium busy" does not depend on the sky and is
+ * retried after the SBDIX interval, while codes 36-38 "try later" defer
+ * the retry by ISBD_RETRY_DEFER_INTERVAL. Other readings and failures are
+ * retried after the regular CSQ or SBDIX interval.
+ *
+ * The readings are kept across sessions for the trend. The backoff is kept
+ * across sessions as well, so the sessions started after an abandoned one
+ * are spaced by the growing intervals too, and starts over only when an MO
+ * message is delivered.
+ */
+class ISBDRetryScheduler {
+
+    struct Reading {
+        uint64_t time;      // Clock time, ns
+        int      quality;
+    };
+
+    Reading  history[ISBD_RETRY_HISTORY_SIZE];
+    size_t   history_start;
+    size_t   history_size;
+    int      csq_interval;      // seconds
+    int      sbdix_interval;    // seconds
+    int      minimum_csq;
+    int      failures;          // attempts that backed off since the last delivered MO message
+    int      mo_code;           // MO status code of the last SBDIX, -1 if none since the last reading
+    int      decision;
+    uint64_t delay;             // delay of the last decision, ns, 0 if none in this session
+
+public:
+    ISBDRetryScheduler();
+
+    /**
+     * Starts scheduling the retries of a new session with the specified
+     * CSQ and SBDIX retry intervals in seconds and the minimum signal quality.
+     */
+    void start_session(int csq_interval, int sbdix_interval, int minimum_csq);
+
+    /**
+     * Records signal quality reading.
+     */
+    void signal_quality(int quality);
+
+    /**
+     * Records MO status code of SBDIX session.
+     */
+    void sbdix(int mo_code);
+
+    /**
+     * Decides when to retry the session after the last reading or SBDIX failure.
+     *
+     * Returns the delay in nanoseconds.
+     */
+    uint64_t next_delay();
+
+    /**
+     * Returns the last decision.
+     */
+    inline int get_decision() const { return decision; };
+
+    /**
+     * Returns the delay of the last decision in nanoseconds, or 0 if the
+     * session did not decide any retry or the MO message was delivered.
+     */
+    inline uint64_t get_delay() const { return delay; };
+
+    /**
+     * Returns the change of signal quality within ISBD_RETRY_TREND_WINDOW,
+     * or since the previous reading if it is older.
+     */
+    int get_trend() const;
+
+    /**
+     * Returns the name of the decision used in the metrics.
+     */
+    static const char* decision_name(int decision);
+};
+
+#endif /* ISBDRETRYSCHEDULER_H_ */
@@ -24,15 +24,15 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 */
 
 #include "IridiumSBD.h"
-#include <chrono>
+#include "Clock.h"
 #include <string.h>
 #include <unistd.h>
 #include <stdio.h>
 #include <syslog.h>
 #include <limits.h>
+#include "Metrics.h"
 
 using namespace std;
-using namespace std::chrono;
 
 #define UNUSED(x) (void)(x)
 
@@ -252,6 +252,21 @@ void IridiumSBD::useMSSTMWorkaround(bool useWorkAround) // true to use workaroun
     this->useWorkaround = useWorkAround;
 }
 
+void IridiumSBD::setCacheMaxAge(int seconds)
+{
+    this->cacheMaxAge = seconds < 0 ? 0 : seconds;
+}
+
+bool IridiumSBD::getCachedSignalQuality(int &quality)
+{
+    if (this->signalQuality < 0 || !isFresh(this->signalQualityTime)) {
+        return false;
+    }
+
+    quality = this->signalQuality;
+    return true;
+}
+
 /*
 Private interface
 */
@@ -269,15 +284,16 @@ int IridiumSBD::internalBegin()
     bool modemAlive = false;
 
     long startupTime = 500; //ms
-    for (high_resolution_clock::time_point start = high_resolution_clock::now();
-         duration_cast<milliseconds>(high_resolution_clock::now() - start).count() < startupTime;)
+    for (uint64_t deadline = Clock::now() + startupTime * NSEC_PER_MSEC; Clock::now() < deadline;) {
         if (cancelled()) {
             return ISBD_CANCELLED;
         }
 
+        Clock::sleep(NSEC_PER_MSEC);
+    }
+
     // Turn on modem and wait for a response from "AT" command to begin
-    for (high_resolution_clock::time_point start = high_resolution_clock::now();
-         duration_cast<seconds>(high_resolution_clock::now() - start).count() < ISBD_STARTUP_MAX_TIME && !modemAlive;) {
+    for (uint64_t deadline = Clock::now() + ISBD_STARTUP_MAX_TIME * NSEC_PER_SEC; Clock::now() < deadline && !modemAlive;) {
         send("AT\r");
         modemAlive = waitForATResponse();
         if (cancelled()) {
@@ -340,12 +356,31 @@ int IridiumSBD::internalSendReceiveSBD(const char *txTxtMessage, const uint8_t *
         return ISBD_IS_ASLEEP;
     }
 
+    int ret = internalEnableIndications();
+    if (ret != ISBD_SUCCESS) {
+        return ret;
+    }
+
+    // Indications received since the last session are discarded by the next write
+    pollIndications();
+
     if (!txTxtMessage && !txDataSize) { //Just receive, clear MO message buffer
-        send("AT+SBDD0\r");
-        if (!waitForATResponse(NULL, 0, NULL, "\r")) {
-            return cancelled() ? ISBD_CANCELLED : ISBD_PROTOCOL_ERROR;
+        if (this->moBufferClear) {
+            Metrics::counter("isbd_at_commands_skipped_total", Metrics::label("command", "+SBDD0"),
+                             "Number of AT commands not sent because the cached state made them redundant.").inc();
+        } else {
+            // Waiting for OK rather than the end of the echo keeps a +CIEV line
+            // received first from leaving the response to the next command
+            send("AT+SBDD0\r");
+            if (!waitForATResponse()) {
+                return cancelled() ? ISBD_CANCELLED : ISBD_PROTOCOL_ERROR;
+            }
+
+            this->moBufferClear = true;
         }
     } else if (txData && txDataSize) { // Binary transmission?
+        this->moBufferClear = false;
+
         send("AT+SBDWB=");
         send(txDataSize);
         send("\r");
@@ -355,7 +390,7 @@ int IridiumSBD::internalSendReceiveSBD(const char *txTxtMessage, const uint8_t *
 
         uint16_t checksum = 0;
         for (size_t i = 0; i < txDataSize; ++i) {
-            stream.write(txData[i]);
+            stream->write(txData[i]);
             checksum += (uint16_t)txData[i];
         }
 
@@ -363,13 +398,15 @@ int IridiumSBD::internalSendReceiveSBD(const char *txTxtMessage, const uint8_t *
 
         //diag << "Checksum:" << checksum << "\n";
 
-        stream.write(checksum >> 8);
-        stream.write(checksum & 0xFF);
+        stream->write(checksum >> 8);
+        stream->write(checksum & 0xFF);
 
         if (!waitForATResponse(NULL, 0, NULL, "0\r\n\r\nOK\r\n")) {
             return cancelled() ? ISBD_CANCELLED : ISBD_PROTOCOL_ERROR;
         }
     } else { // Text transmission
+        this->moBufferClear = false;
+
         send("AT+SBDWT=");
         if (txTxtMessage) { // It's ok to have a NULL txtTxtMessage if the transaction is RX only
             send(txTxtMessage);
@@ -380,23 +417,44 @@ int IridiumSBD::internalSendReceiveSBD(const char *txTxtMessage, const uint8_t *
         }
     }
 
+    retryScheduler.start_session(csqInterval, sbdixInterval, minimumCSQ);
+
     // Long SBDIX loop begins here
-    for (high_resolution_clock::time_point start = high_resolution_clock::now();
-         duration_cast<seconds>(high_resolution_clock::now() - start).count() < ISBD_DEFAULT_SENDRECEIVE_TIME;) {
+    for (uint64_t deadline = Clock::now() + ISBD_DEFAULT_SENDRECEIVE_TIME * NSEC_PER_SEC; Clock::now() < deadline;) {
         int strength = 0;
         bool okToProceed = true;
-        int ret = internalGetSignalQuality(strength);
-        if (ret != ISBD_SUCCESS) {
-            return ret;
+
+        pollIndications();
+
+        // A fresh good reading lets SBDIX go out without waiting for AT+CSQ
+        if (getCachedSignalQuality(strength) && strength >= minimumCSQ) {
+            Metrics::counter("isbd_at_commands_skipped_total", Metrics::label("command", "+CSQ"),
+                             "Number of AT commands not sent because the cached state made them redundant.").inc();
+        } else {
+            ret = internalGetSignalQuality(strength);
+            if (ret != ISBD_SUCCESS) {
+                return ret;
+            }
         }
 
+        Metrics::counter("isbd_signal_quality_total", Metrics::label("csq", strength),
+                         "Number of signal quality readings by value.").inc();
+
+        retryScheduler.signal_quality(strength);
+
         syslog(LOG_INFO, "SBD signal quality: %d", strength);
 
         if (useWorkaround && strength >= minimumCSQ) {
-            okToProceed = false;
-            ret = internalMSSTMWorkaround(okToProceed);
-            if (ret != ISBD_SUCCESS) {
-                return ret;
+            // The transceiver has valid system time while it reports network service
+            if (networkService && isFresh(networkServiceTime)) {
+                Metrics::counter("isbd_at_commands_skipped_total", Metrics::label("command", "-MSSTM"),
+                                 "Number of AT commands not sent because the cached state made them redundant.").inc();
+            } else {
+                okToProceed = false;
+                ret = internalMSSTMWorkaround(okToProceed);
+                if (ret != ISBD_SUCCESS) {
+                    return ret;
+                }
             }
         }
 
@@ -407,11 +465,18 @@ int IridiumSBD::internalSendReceiveSBD(const char *txTxtMessage, const uint8_t *
                 return ret;
             }
 
+            Metrics::counter("isbd_sbdix_total", Metrics::label("mo_status", moCode),
+                             "Number of SBD sessions by MO status code.").inc();
+
+            retryScheduler.sbdix(moCode);
+
             //diag << "SBDIX MO code: " << moCode << "\n";
 
             if (moCode <= 4) { // successful return!
                 //diag << "SBDIX success!\n";
 
+                updateNetworkService(true);
+
                 this->remainingMessages = mtRemaining;
                 if (mtCode == 1 && rxBuffer) { // retrieved 1 message
                     //diag << "Incoming message!\n";
@@ -434,15 +499,23 @@ int IridiumSBD::internalSendReceiveSBD(const char *txTxtMessage, const uint8_t *
 
             else { // retry
                 //diag << "Waiting for SBDIX retry...\n";
-                if (!smartWait(sbdixInterval)) {
-                    return ISBD_CANCELLED;
-                }
-            }
-        } else { // signal strength == 0
-            //diag << "Waiting for CSQ retry...\n";
-            if (!smartWait(csqInterval)) {
-                return ISBD_CANCELLED;
+
+                // The link went bad since the state was cached, so query it again before the retry
+                invalidateCache();
             }
+        } // else the signal is below the minimum or there is no network service
+
+        // Give up at once if the retry would not fit into the session time
+        uint64_t delay = retryScheduler.next_delay();
+
+        if (Clock::now() + delay >= deadline) {
+            syslog(LOG_INFO, "SBD session abandoned, %s retry in %.0f s.",
+                   ISBDRetryScheduler::decision_name(retryScheduler.get_decision()), Clock::to_seconds(delay));
+            break;
+        }
+
+        if (!smartWait(delay)) {
+            return ISBD_CANCELLED;
         }
     } // big wait loop
 
@@ -515,6 +588,7 @@ int IridiumSBD::internalGetSignalQuality(int &quality)
 
     if (isdigit(csqResponseBuf[0])) {
         quality = atoi(csqResponseBuf);
+        updateSignalQuality(quality);
         return ISBD_SUCCESS;
     }
 
@@ -550,9 +624,103 @@ int IridiumSBD::internalMSSTMWorkaround(bool &okToProceed)
 
     // Response buf now contains either an 8-digit number or the string "no network service"
     okToProceed = isxdigit(msstmResponseBuf[0]);
+    updateNetworkService(okToProceed);
+    return ISBD_SUCCESS;
+}
+
+int IridiumSBD::internalEnableIndications()
+{
+    if (this->indicationsRequested) {
+        return ISBD_SUCCESS;
+    }
+
+    this->indicationsRequested = true;
+
+    // Report signal quality and network service changes with +CIEV
+    send("AT+CIER=1,1,1\r");
+
+    if (!waitForATResponse()) {
+        if (cancelled()) {
+            return ISBD_CANCELLED;
+        }
+
+        // Without indications the state is cached from the responses only
+        syslog(LOG_WARNING, "ISBD transceiver did not accept AT+CIER.");
+    }
+
     return ISBD_SUCCESS;
 }
 
+void IridiumSBD::pollIndications()
+{
+    while (stream->available() > 0) {
+        int cc = stream->read();
+
+        if (cc < 0) {
+            break;
+        }
+
+        parseIndication(cc);
+    }
+}
+
+// Collects characters of the current line and handles "+CIEV:<indicator>,<value>" lines.
+// Indicator 0 is signal quality, indicator 1 is network service availability.
+void IridiumSBD::parseIndication(char c)
+{
+    if (c != '\r' && c != '\n') {
+        if (indicationSize < ISBD_MAX_INDICATION_SIZE - 1) {
+            indication[indicationSize++] = c;
+        }
+
+        return;
+    }
+
+    indication[indicationSize] = '\0';
+    indicationSize = 0;
+
+    if (strncmp(indication, "+CIEV:", 6) != 0 || !isdigit(indication[6]) || indication[7] != ',' ||
+        !isdigit(indication[8])) {
+        return;
+    }
+
+    int value = atoi(indication + 8);
+
+    switch (indication[6]) {
+    case '0':
+        updateSignalQuality(value);
+        break;
+    case '1':
+        updateNetworkService(value != 0);
+        break;
+    }
+}
+
+void IridiumSBD::updateSignalQuality(int quality)
+{
+    this->signalQuality = quality;
+    this->signalQualityTime = Clock::now();
+
+    Metrics::gauge("isbd_signal_quality", "", "Last signal quality reported by the ISBD transceiver.").set(quality);
+}
+
+void IridiumSBD::updateNetworkService(bool available)
+{
+    this->networkService = available;
+    this->networkServiceTime = Clock::now();
+}
+
+void IridiumSBD::invalidateCache()
+{
+    this->signalQuality = -1;
+    this->networkService = false;
+}
+
+bool IridiumSBD::isFresh(uint64_t time)
+{
+    return Clock::now() - time < (uint64_t)cacheMaxAge * NSEC_PER_SEC;
+}
+
 int IridiumSBD::internalSleep()
 {
     if (this->asleep) {
@@ -569,15 +737,14 @@ int IridiumSBD::internalSleep()
     return ISBD_SUCCESS;
 }
 
-bool IridiumSBD::smartWait(int seconds)
+bool IridiumSBD::smartWait(uint64_t delay)
 {
-    for (high_resolution_clock::time_point start = high_resolution_clock::now();
-        duration_cast<std::chrono::seconds>(high_resolution_clock::now() - start).count() < seconds;) {
+    for (uint64_t deadline = Clock::now() + delay; Clock::now() < deadline;) {
         if (cancelled()) {
             return false;
         }
 
-        usleep(1000);
+        Clock::sleep(NSEC_PER_MSEC);
     }
 
     return true;
@@ -606,16 +773,17 @@ bool IridiumSBD::waitForATResponse(char *response, int responseSize, const char
 
     int promptState = prompt ? LOOKING_FOR_PROMPT : LOOKING_FOR_TERMINATOR;
 
-    for (high_resolution_clock::time_point start = high_resolution_clock::now();
-         duration_cast<seconds>(high_resolution_clock::now() - start).count() < atTimeout;) {
+    for (uint64_t deadline = Clock::now() + atTimeout * NSEC_PER_SEC; Clock::now() < deadline;) {
         if (cancelled()) {
             return false;
         }
 
-        int cc = stream.read();
+        int cc = stream->read();
         if (cc >= 0) {
             char c = cc;
 
+            parseIndication(c);
+
             if (prompt) {
                 switch (promptState) {
                 case LOOKING_FOR_PROMPT:
@@ -645,6 +813,7 @@ bool IridiumSBD::waitForATResponse(char *response, int responseSize, const char
             if (c == terminator[matchTerminatorPos]) {
                 ++matchTerminatorPos;
                 if (terminator[matchTerminatorPos] == '\0') {
+                    observeATResponse(true);
                     return true;
                 }
             } else {
@@ -653,10 +822,25 @@ bool IridiumSBD::waitForATResponse(char *response, int responseSize, const char
         } // if (cc >= 0)
     } // timer loop
 
+    observeATResponse(false);
+
     return false;
 }
 
 
+void IridiumSBD::observeATResponse(bool received)
+{
+    std::string command = Metrics::label("command", atCommand);
+
+    if (received) {
+        double latency = Clock::to_seconds(Clock::now() - atSentTime);
+        Metrics::histogram("isbd_at_response_seconds", command, "Time from AT command to its response.",
+                           METRICS_LATENCY_BUCKETS).observe(latency);
+    } else {
+        Metrics::counter("isbd_at_timeouts_total", command, "Number of AT commands without response.").inc();
+    }
+}
+
 bool IridiumSBD::cancelled()
 {
     if (isbdCallback != NULL) {
@@ -705,14 +889,14 @@ int IridiumSBD::doSBDRB(uint8_t *rxBuffer, size_t *prxBufferSize)
 
     //cons << "[Binary size:" << size << "]";
 
-    high_resolution_clock::time_point start = high_resolution_clock::now();
+    uint64_t deadline = Clock::now() + atTimeout * NSEC_PER_SEC;
 
     for (uint16_t bytesRead = 0; bytesRead < size;) {
         if (cancelled()) {
             return ISBD_CANCELLED;
         }
 
-        int cc = stream.read();
+        int cc = stream->read();
 
         if (cc >= 0) {
             bytesRead++;
@@ -728,7 +912,7 @@ int IridiumSBD::doSBDRB(uint8_t *rxBuffer, size_t *prxBufferSize)
             }
         }
 
-        if (duration_cast<seconds>(high_resolution_clock::now() - start).count() >= atTimeout) {
+        if (Clock::now() >= deadline) {
             return ISBD_SENDRECEIVE_TIMEOUT;
         }
     }
@@ -755,13 +939,12 @@ int IridiumSBD::readUInt(uint16_t &u)
     int n = 0;
     u = 0;
 
-    for (high_resolution_clock::time_point start = high_resolution_clock::now();
-         duration_cast<seconds>(high_resolution_clock::now() - start).count() < atTimeout && n < 2;) {
+    for (uint64_t deadline = Clock::now() + atTimeout * NSEC_PER_SEC; Clock::now() < deadline && n < 2;) {
         if (cancelled()) {
             return ISBD_CANCELLED;
         }
 
-        sbuf[n] = stream.read();
+        sbuf[n] = stream->read();
 
         if (sbuf[n] >= 0) {
             n++;
@@ -784,8 +967,28 @@ void IridiumSBD::power(bool on)
 
 void IridiumSBD::send(const char *str)
 {
+    // Stale input is read before a command, so the data read next is the response
+    // to the command. Indications received meanwhile are not lost.
+    if (strncmp(str, "AT", 2) == 0) {
+        pollIndications();
+    }
+
     //cons << str;
-    stream.write(str, strlen(str));
+    stream->write(str, strlen(str));
+
+    if (strncmp(str, "AT", 2) == 0) {
+        size_t len = strcspn(str + 2, "=?\r");
+
+        if (len == 0) {
+            strcpy(atCommand, "AT");
+        } else {
+            len = len < sizeof(atCommand) - 1 ? len : sizeof(atCommand) - 1;
+            memcpy(atCommand, str + 2, len);
+            atCommand[len] = '\0';
+        }
+    }
+
+    atSentTime = Clock::now();
 }
 
 void IridiumSBD::send(uint16_t n)
@@ -793,5 +996,5 @@ void IridiumSBD::send(uint16_t n)
     char str[32];
     sprintf(str, "%u", n);
     //cons << str;
-    stream.write(str, strlen(str));
+    stream->write(str, strlen(str));
 }
@@ -23,9 +23,13 @@ License along with this library; if not, write to the Free Software
 Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 */
 
+#ifndef IRIDIUMSBD_H_
+#define IRIDIUMSBD_H_
+
 #include <stdlib.h>
 #include <iostream>
 #include <stdint.h>
+#include "ISBDRetryScheduler.h"
 #include "Serial.h"
 
 #define ISBD_LIBRARY_REVISION           2
@@ -39,6 +43,8 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #define ISBD_DEFAULT_SENDRECEIVE_TIME   30
 #define ISBD_STARTUP_MAX_TIME           240
 #define ISBD_DEFAULT_CSQ_MINIMUM        2
+#define ISBD_DEFAULT_CACHE_MAX_AGE      60  // seconds a cached signal quality or network service state is used
+#define ISBD_MAX_INDICATION_SIZE        16
 
 #define ISBD_SUCCESS             0
 #define ISBD_ALREADY_AWAKE       1
@@ -53,6 +59,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #define ISBD_IS_ASLEEP           10
 #define ISBD_NO_SLEEP_PIN        11
 
+#define ISBD_MAX_MO_MGS_SIZE 340
 #define ISBD_MAX_MT_MGS_SIZE 270
 
 extern bool isbdCallback() __attribute__((weak));
@@ -62,7 +69,7 @@ extern bool isbdCallback() __attribute__((weak));
  */
 class IridiumSBD {
 
-    Serial& stream; // Communicating with the Iridium
+    Serial* stream; // Communicating with the Iridium
 
     // Timings
     int csqInterval;
@@ -79,9 +86,26 @@ class IridiumSBD {
     bool useWorkaround;
     unsigned long lastPowerOnTime;
 
+    // Transceiver state cached from the responses and +CIEV indications
+    int  signalQuality;             // last signal quality reading, -1 if unknown
+    uint64_t signalQualityTime;     // monotonic clock time of the reading, nanoseconds
+    bool networkService;            // network service is available
+    uint64_t networkServiceTime;    // monotonic clock time the service state was reported, nanoseconds
+    bool moBufferClear;             // MO buffer is known to be empty
+    bool indicationsRequested;      // AT+CIER was sent
+    int  cacheMaxAge;               // seconds, 0 disables the cache
+    char indication[ISBD_MAX_INDICATION_SIZE]; // unsolicited result code being received
+    int  indicationSize;
+
+    ISBDRetryScheduler retryScheduler;
+
+    // Metrics state
+    char atCommand[16];     // name of the last AT command sent, such as "+SBDIX"
+    uint64_t atSentTime;    // monotonic clock time of the last write, nanoseconds
+
 public:
     IridiumSBD(Serial& serial) :
-        stream(serial),
+        stream(&serial),
         csqInterval(ISBD_DEFAULT_CSQ_INTERVAL),
         sbdixInterval(ISBD_DEFAULT_SBDIX_INTERVAL),
         atTimeout(ISBD_DEFAULT_AT_TIMEOUT),
@@ -92,8 +116,20 @@ public:
         reentrant(false),
         minimumCSQ(ISBD_DEFAULT_CSQ_MINIMUM),
         useWorkaround(true),
-        lastPowerOnTime(0UL)
+        lastPowerOnTime(0UL),
+        signalQuality(-1),
+        signalQualityTime(0),
+        networkService(false),
+        networkServiceTime(0),
+        moBufferClear(false),
+        indicationsRequested(false),
+        cacheMaxAge(ISBD_DEFAULT_CACHE_MAX_AGE),
+        indicationSize(0),
+        retryScheduler(),
+        atSentTime(0)
     {
+        atCommand[0] = '\0';
+        indication[0] = '\0';
     }
 
     int begin();
@@ -120,11 +156,23 @@ public:
     void adjustSendReceiveTimeout(int seconds); // default value = 300 seconds
     void setMinimumSignalQuality(int quality);  // a number between 1 and 5, default ISBD_DEFAULT_CSQ_MINIMUM
     void useMSSTMWorkaround(bool useWorkAround); // true to use workaround from Iridium Alert 5/7
+    void setCacheMaxAge(int seconds);           // default ISBD_DEFAULT_CACHE_MAX_AGE, 0 to query the transceiver every session
+
+    // Returns true if the signal quality reported by AT+CSQ or +CIEV is not older than the cache max age
+    bool getCachedSignalQuality(int &quality);
+
+    // Delay in nanoseconds and ISBDRetryDecision of the retry decided by the last abandoned session,
+    // the delay is 0 if the last session did not decide any retry or delivered the MO message
+    uint64_t getRetryDelay() const { return retryScheduler.get_delay(); }
+    int getRetryDecision() const { return retryScheduler.get_decision(); }
+
+    // Communicates with the Iridium over the specified opened device, such as a simulated transceiver
+    void setStream(Serial &serial) { stream = &serial; }
 
 private:
 
     // Internal utilities
-    bool smartWait(int seconds);
+    bool smartWait(uint64_t delay); // nanoseconds
     bool waitForATResponse(char *response=NULL, int responseSize=0, const char *prompt=NULL, const char *terminator="OK\r\n");
 
     int  internalBegin();
@@ -136,6 +184,15 @@ private:
     int  internalGetSignalQuality(int &quality);
     int  internalMSSTMWorkaround(bool &okToProceed);
     int  internalSleep();
+    int  internalEnableIndications();
+
+    // Reads the indications received while no command was in progress
+    void pollIndications();
+    void parseIndication(char c);
+    void updateSignalQuality(int quality);
+    void updateNetworkService(bool available);
+    void invalidateCache();
+    bool isFresh(uint64_t time);
 
     int  doSBDIX(uint16_t &moCode, uint16_t &moMSN, uint16_t &mtCode, uint16_t &mtMSN, uint16_t &mtLen, uint16_t &mtRemaining);
     int  doSBDRB(uint8_t *rxBuffer, size_t *prxBufferSize); // in/out
@@ -146,4 +203,9 @@ private:
     void send(uint16_t n);
 
     bool cancelled();
+
+    // Updates AT response latency metrics of the last command sent
+    void observeATResponse(bool received);
 };
+
+#endif /* IRIDIUMSBD_H_ */
@@ -0,0 +1,111 @@
+/*
+ MAVLinkCRC.cc
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "MAVLinkCRC.h"
+#include "MAVLinkFrame.h"
+
+#define CRC_SLICES 4
+
+/**
+ * Lookup tables of the reflected CRC-CCITT polynomial used by X.25.
+ * table[k][i] is the CRC of byte i followed by k zero bytes.
+ */
+struct CRCTables {
+    uint16_t table[CRC_SLICES][256];
+
+    CRCTables()
+    {
+        for (int i = 0; i < 256; i++) {
+            uint16_t crc = i;
+
+            for (int bit = 0; bit < 8; bit++) {
+                crc = (crc & 1) ? (crc >> 1) ^ 0x8408 : crc >> 1;
+            }
+
+            table[0][i] = crc;
+        }
+
+        for (int k = 1; k < CRC_SLICES; k++) {
+            for (int i = 0; i < 256; i++) {
+                uint16_t crc = table[k - 1][i];
+                table[k][i] = (crc >> 8) ^ table[0][crc & 0xFF];
+            }
+        }
+    }
+};
+
+static const CRCTables& crc_tables()
+{
+    static const CRCTables tables;
+    return tables;
+}
+
+static const uint8_t mavlink_message_crcs[256] = MAVLINK_MESSAGE_CRCS;
+
+uint16_t MAVLinkCRC::accumulate(const uint8_t* data, size_t size, uint16_t crc)
+{
+    const CRCTables& t = crc_tables();
+
+    while (size >= CRC_SLICES) {
+        uint16_t x = crc ^ (data[0] | (data[1] << 8));
+
+        crc = t.table[3][x & 0xFF] ^ t.table[2][x >> 8] ^
+              t.table[1][data[2]] ^ t.table[0][data[3]];
+
+        data += CRC_SLICES;
+        size -= CRC_SLICES;
+    }
+
+    while (size-- > 0) {
+        crc = (crc >> 8) ^ t.table[0][(crc ^ *data++) & 0xFF];
+    }
+
+    return crc;
+}
+
+uint16_t MAVLinkCRC::accumulate(uint8_t c, uint16_t crc)
+{
+    return (crc >> 8) ^ crc_tables().table[0][(crc ^ c) & 0xFF];
+}
+
+bool MAVLinkCRC::check_frame(const uint8_t* frame, uint16_t size)
+{
+    bool v2 = frame[0] == MAVLINK2_STX;
+    uint16_t header = v2 ? MAVLINK2_NUM_HEADER_BYTES : MAVLINK_NUM_HEADER_BYTES;
+
+    if (size < header + MAVLINK_NUM_CHECKSUM_BYTES || size < header + frame[1] + MAVLINK_NUM_CHECKSUM_BYTES) {
+        return false;
+    }
+
+    if (v2 && (frame[8] != 0 || frame[9] != 0)) {
+        // The library has no CRC extra bytes for message IDs above 255
+        return false;
+    }
+
+    const uint8_t* checksum = frame + header + frame[1];
+
+    // The checksum covers the header without STX and the payload
+    uint16_t crc = accumulate(frame + 1, checksum - frame - 1, X25_INIT_CRC);
+    crc = accumulate(mavlink_message_crcs[v2 ? frame[7] : frame[5]], crc);
+
+    return checksum[0] == (crc & 0xFF) && checksum[1] == (crc >> 8);
+}
@@ -0,0 +1,60 @@
+/*
+ MAVLinkCRC.h
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef MAVLINKCRC_H_
+#define MAVLINKCRC_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Table driven X.25 CRC used by MAVLink.
+ *
+ * Produces the same results as crc_accumulate() and crc_calculate() of
+ * the MAVLink library, but processes four bytes per step using
+ * slice-by-4 lookup tables.
+ */
+class MAVLinkCRC {
+public:
+    /**
+     * Accumulates the specified bytes into the CRC.
+     *
+     * Returns the updated CRC.
+     */
+    static uint16_t accumulate(const uint8_t* data, size_t size, uint16_t crc);
+
+    /**
+     * Accumulates one byte into the CRC.
+     *
+     * Returns the updated CRC.
+     */
+    static uint16_t accumulate(uint8_t c, uint16_t crc);
+
+    /**
+     * Returns true if the bytes of the complete MAVLink 1 or MAVLink 2 frame
+     * have a valid checksum for the frame's message ID. The signature of
+     * signed MAVLink 2 frames is not checked.
+     */
+    static bool check_frame(const uint8_t* frame, uint16_t size);
+};
+
+#endif /* MAVLINKCRC_H_ */
@@ -26,7 +26,13 @@
 #ifndef MAVLINKCHANNEL_H_
 #define MAVLINKCHANNEL_H_
 
+#include <stdint.h>
+#include <string>
+#include <vector>
 #include "mavlink.h"
+#include "MAVLinkFrame.h"
+#include "MAVLinkParser.h"
+#include "MAVLinkChannelMetrics.h"
 
 /*
  * Interface for send/receive channels of MAVLink messages.
@@ -35,8 +41,12 @@ class MAVLinkChannel {
 
     std::string channel_id;
 
+protected:
+    MAVLinkParser parser;  // parser of the frames received by the channel
+    MAVLinkChannelMetrics metrics; // traffic metrics of the channel
+
 public:
-    MAVLinkChannel(std::string channel_id) : channel_id(channel_id) {}
+    MAVLinkChannel(std::string channel_id) : channel_id(channel_id), parser(), metrics(channel_id) {}
 
     virtual ~MAVLinkChannel() {};
 
@@ -45,6 +55,11 @@ public:
      */
     virtual std::string get_channel_id() const { return channel_id; }
 
+    /**
+     * Returns the parser of the channel with statistics of the received stream.
+     */
+    const MAVLinkParser& get_parser() const { return parser; }
+
     /**
      * Closes the connection if it was open.
      */
@@ -57,6 +72,43 @@ public:
      */
     virtual bool send_message(const mavlink_message_t& msg) = 0;
 
+    /**
+     * Sends the specified serialized MAVLink frame to the socket.
+     *
+     * Channels that write the wire representation directly should override
+     * this method to avoid serializing the message again.
+     *
+     * Returns true if the frame was sent successfully.
+     */
+    virtual bool send_frame(const MAVLinkFrame& frame) { return send_message(frame.get_message()); }
+
+    /**
+     * Sends the specified frames in their order.
+     *
+     * Channels that pay per transmission should override this method to
+     * send several frames at once.
+     *
+     * Returns true if all the frames were sent successfully.
+     */
+    virtual bool send_frames(const std::vector<MAVLinkFrame>& frames)
+    {
+        for (size_t i = 0; i < frames.size(); i++) {
+            if (!send_frame(frames[i])) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    /**
+     * Returns the maximum number of bytes of the frames sent in one transmission.
+     *
+     * Channels that pay per transmission should override this method, so the
+     * frames queued for the channel are batched by that size.
+     */
+    virtual size_t get_transmission_size() const { return SIZE_MAX; }
+
     /**
      * Receives MAVLink message from the socket.
      *
@@ -64,12 +116,39 @@ public:
      */
     virtual bool receive_message(mavlink_message_t& msg) = 0;
 
+    /**
+     * Receives MAVLink frame from the socket.
+     *
+     * Channels that have access to the received bytes should override this
+     * method to keep the original wire representation of the frame.
+     *
+     * Returns true if a frame was received.
+     */
+    virtual bool receive_frame(MAVLinkFrame& frame)
+    {
+        mavlink_message_t msg;
+
+        if (!receive_message(msg)) {
+            return false;
+        }
+
+        frame = MAVLinkFrame(msg);
+        return true;
+    }
+
     /**
      * Checks if data is available in the socket input buffer.
      *
      * Returns true if data is available.
      */
     virtual bool message_available() = 0;
+
+    /**
+     * Checks if frames already received can be read without another transmission.
+     *
+     * Returns true if a frame can be read.
+     */
+    virtual bool frame_buffered() { return message_available(); }
 };
 
 #endif /* MAVLINKCHANNEL_H_ */
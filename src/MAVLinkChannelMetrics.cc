@@ -0,0 +1,85 @@
+/*
+ MAVLinkChannelMetrics.cc
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "MAVLinkChannelMetrics.h"
+
+MAVLinkChannelMetrics::MAVLinkChannelMetrics(const std::string& channel_id) :
+    channel_id(channel_id), frames_received(NULL), frames_sent(NULL),
+    bytes_received(NULL), bytes_sent(NULL), send_failures(NULL),
+    crc_errors(NULL), frames_lost(NULL), last_crc_errors(0), last_frames_lost(0)
+{
+}
+
+void MAVLinkChannelMetrics::init()
+{
+    std::string labels = Metrics::label("channel", channel_id);
+
+    frames_received = &Metrics::counter("mavlink_frames_received_total", labels, "Number of MAVLink frames received.");
+    frames_sent     = &Metrics::counter("mavlink_frames_sent_total", labels, "Number of MAVLink frames sent.");
+    bytes_received  = &Metrics::counter("mavlink_received_bytes_total", labels, "Number of bytes of MAVLink frames received.");
+    bytes_sent      = &Metrics::counter("mavlink_sent_bytes_total", labels, "Number of bytes of MAVLink frames sent.");
+    send_failures   = &Metrics::counter("mavlink_send_failures_total", labels, "Number of MAVLink frames that failed to send.");
+    crc_errors      = &Metrics::counter("mavlink_crc_errors_total", labels, "Number of MAVLink frames dropped because of checksum mismatch.");
+    frames_lost     = &Metrics::counter("mavlink_frames_lost_total", labels, "Number of MAVLink frames lost according to sequence numbers.");
+}
+
+void MAVLinkChannelMetrics::frame_received(const MAVLinkFrame& frame)
+{
+    if (frames_received == NULL) {
+        init();
+    }
+
+    frames_received->inc();
+    bytes_received->inc(frame.size());
+}
+
+void MAVLinkChannelMetrics::frame_sent(const MAVLinkFrame& frame)
+{
+    if (frames_sent == NULL) {
+        init();
+    }
+
+    frames_sent->inc();
+    bytes_sent->inc(frame.size());
+}
+
+void MAVLinkChannelMetrics::send_failed()
+{
+    if (send_failures == NULL) {
+        init();
+    }
+
+    send_failures->inc();
+}
+
+void MAVLinkChannelMetrics::update(const MAVLinkParser& parser)
+{
+    if (crc_errors == NULL) {
+        init();
+    }
+
+    crc_errors->inc(parser.get_crc_errors() - last_crc_errors);
+    frames_lost->inc(parser.get_frames_lost() - last_frames_lost);
+
+    last_crc_errors = parser.get_crc_errors();
+    last_frames_lost = parser.get_frames_lost();
+}
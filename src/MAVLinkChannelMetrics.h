@@ -0,0 +1,77 @@
+/*
+ MAVLinkChannelMetrics.h
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef MAVLINKCHANNELMETRICS_H_
+#define MAVLINKCHANNELMETRICS_H_
+
+#include <string>
+#include "Metrics.h"
+#include "MAVLinkFrame.h"
+#include "MAVLinkParser.h"
+
+/**
+ * Traffic metrics of a MAVLink channel labeled with the channel ID.
+ *
+ * The metrics are registered on the first update, so channels can be
+ * constructed before the metrics registry.
+ */
+class MAVLinkChannelMetrics {
+
+    std::string   channel_id;
+    Counter*      frames_received;
+    Counter*      frames_sent;
+    Counter*      bytes_received;
+    Counter*      bytes_sent;
+    Counter*      send_failures;
+    Counter*      crc_errors;
+    Counter*      frames_lost;
+    unsigned long last_crc_errors;   // parser statistics at the last update
+    unsigned long last_frames_lost;
+
+public:
+    MAVLinkChannelMetrics(const std::string& channel_id);
+
+    /**
+     * Counts the frame received by the channel.
+     */
+    void frame_received(const MAVLinkFrame& frame);
+
+    /**
+     * Counts the frame sent by the channel.
+     */
+    void frame_sent(const MAVLinkFrame& frame);
+
+    /**
+     * Counts the frame the channel failed to send.
+     */
+    void send_failed();
+
+    /**
+     * Adds the CRC errors and lost frames counted by the parser since the last call.
+     */
+    void update(const MAVLinkParser& parser);
+
+private:
+    void init();
+};
+
+#endif /* MAVLINKCHANNELMETRICS_H_ */
@@ -0,0 +1,82 @@
+/*
+ MAVLinkFrame.cc
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "MAVLinkFrame.h"
+
+MAVLinkFrame::MAVLinkFrame() : length(0), decoded(true)
+{
+    message.checksum = 0;
+    message.magic    = 0;
+    message.len      = 0;
+    message.seq      = 0;
+    message.sysid    = 0;
+    message.compid   = 0;
+    message.msgid    = 0;
+}
+
+MAVLinkFrame::MAVLinkFrame(const mavlink_message_t& msg) : length(0), message(msg), decoded(true)
+{
+    if (msg.len != 0 || msg.msgid != 0) {
+        length = mavlink_msg_to_send_buffer(buffer, &msg);
+    }
+}
+
+MAVLinkFrame::MAVLinkFrame(const uint8_t* data, uint16_t size) : length(size), decoded(false)
+{
+    if (length > sizeof(buffer)) {
+        length = sizeof(buffer);
+    }
+
+    memcpy(buffer, data, length);
+}
+
+const mavlink_message_t& MAVLinkFrame::get_message() const
+{
+    if (!decoded) {
+        if (v2() && length >= MAVLINK2_NUM_HEADER_BYTES + payload_length() + MAVLINK_NUM_CHECKSUM_BYTES &&
+            msgid() <= UINT8_MAX) {
+            const uint8_t* checksum = buffer + MAVLINK2_NUM_HEADER_BYTES + payload_length();
+
+            message.magic  = MAVLINK_STX;
+            message.len    = payload_length();
+            message.seq    = seq();
+            message.sysid  = sysid();
+            message.compid = compid();
+            message.msgid  = msgid();
+            memset(message.payload64, 0, sizeof(message.payload64));
+            memcpy(message.payload64, buffer + MAVLINK2_NUM_HEADER_BYTES, payload_length());
+            message.checksum = checksum[0] | (checksum[1] << 8);
+        } else if (!v2() && length >= MAVLINK_NUM_NON_PAYLOAD_BYTES && length <= MAVLINK_MAX_PACKET_LEN) {
+            // Header, payload and checksum bytes are laid out in mavlink_message_t
+            // starting from magic the same way they are on the wire.
+            memcpy(&message.magic, buffer, length);
+            message.checksum = buffer[length - 2] | (buffer[length - 1] << 8);
+        } else {
+            message.len   = 0;
+            message.msgid = 0;
+        }
+
+        decoded = true;
+    }
+
+    return message;
+}
@@ -0,0 +1,122 @@
+/*
+ MAVLinkFrame.h
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef MAVLINKFRAME_H_
+#define MAVLINKFRAME_H_
+
+#include "mavlink.h"
+
+/*
+ * MAVLink 2 framing. The MAVLink library used by the project is MAVLink 1,
+ * MAVLink 2 frames are only delimited and forwarded.
+ */
+#define MAVLINK2_STX                253
+#define MAVLINK2_NUM_HEADER_BYTES   10
+#define MAVLINK2_SIGNATURE_LEN      13
+#define MAVLINK2_IFLAG_SIGNED       0x01
+
+#define MAVLINK_FRAME_MAX_LEN       (MAVLINK2_NUM_HEADER_BYTES + MAVLINK_MAX_PAYLOAD_LEN + \
+                                     MAVLINK_NUM_CHECKSUM_BYTES + MAVLINK2_SIGNATURE_LEN)
+
+/**
+ * MAVLink 1 or MAVLink 2 frame as it appears on the wire.
+ *
+ * The frame keeps the original bytes, so it can be forwarded to any number
+ * of channels untouched. Header fields are read directly from the bytes and
+ * the payload is decoded into mavlink_message_t only when it is requested.
+ */
+class MAVLinkFrame {
+
+    uint8_t                   buffer[MAVLINK_FRAME_MAX_LEN];
+    uint16_t                  length;
+    mutable mavlink_message_t message;   // decoded message, valid if decoded is true
+    mutable bool              decoded;
+
+public:
+    /**
+     * Constructs an empty frame.
+     */
+    MAVLinkFrame();
+
+    /**
+     * Constructs frame from the specified message.
+     */
+    MAVLinkFrame(const mavlink_message_t& msg);
+
+    /**
+     * Constructs frame from the bytes of a complete frame received from the wire.
+     * The bytes are expected to be validated by the parser.
+     */
+    MAVLinkFrame(const uint8_t* data, uint16_t size);
+
+    /**
+     * Returns the MAVLink message decoding it on the first call.
+     *
+     * The truncated payload of MAVLink 2 frames is padded with zeros. Messages
+     * with IDs above 255 cannot be decoded and are returned empty.
+     */
+    const mavlink_message_t& get_message() const;
+
+    /**
+     * Returns the serialized frame.
+     */
+    inline const uint8_t* data() const { return buffer; }
+
+    /**
+     * Returns the serialized frame size in bytes.
+     */
+    inline uint16_t size() const { return length; }
+
+    /**
+     * Returns true if the frame carries no message.
+     */
+    inline bool empty() const { return length == 0; }
+
+    /**
+     * Returns true for MAVLink 2 frames.
+     */
+    inline bool v2() const { return buffer[0] == MAVLINK2_STX; }
+
+    /**
+     * Header fields of the frame. Must not be called for empty frames.
+     */
+    inline uint8_t payload_length() const { return buffer[1]; }
+    inline uint8_t seq() const { return v2() ? buffer[4] : buffer[2]; }
+    inline uint8_t sysid() const { return v2() ? buffer[5] : buffer[3]; }
+    inline uint8_t compid() const { return v2() ? buffer[6] : buffer[4]; }
+    inline uint32_t msgid() const { return v2() ? buffer[7] | (buffer[8] << 8) | (buffer[9] << 16) : buffer[5]; }
+};
+
+/**
+ * Interface of objects notified about frames received by a channel.
+ */
+class MAVLinkFrameListener {
+public:
+    virtual ~MAVLinkFrameListener() {};
+
+    /**
+     * Called for each MAVLink frame received by the channel.
+     */
+    virtual void frame_received(const MAVLinkFrame& frame) = 0;
+};
+
+#endif /* MAVLINKFRAME_H_ */
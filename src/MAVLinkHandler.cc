@@ -26,10 +26,13 @@ BVLOS telemetry for MAVLink autopilots.
 #include "MAVLinkHandler.h"
 
 #include "MAVLinkLogger.h"
+#include "MAVLinkMissionPack.h"
+#include "Metrics.h"
+#include "Clock.h"
+#include <time.h>
 #include <unistd.h>
 #include <syslog.h>
 #include <vector>
-#include <algorithm>
 
 /**
  * The maximum number of high frequency messages send by autopilot in one period,
@@ -43,6 +46,9 @@ BVLOS telemetry for MAVLink autopilots.
 
 #define MAX_SEND_RETRIES   5
 
+#define AUTOPILOT_DRAIN_TIME    (10 * NSEC_PER_MSEC) // maximum time route() reads frames from the autopilot
+#define HEARTBEAT_INTERVAL      (1 * NSEC_PER_SEC)   // GCS heartbeats sent to the autopilot
+
 // Masks of MAVLink messages used to compose single HIGH_LATENCY message
 #define MAVLINK_MSG_MASK_HEARTBEAT              0x01
 #define MAVLINK_MSG_MASK_SYS_STATUS             0x02
@@ -60,18 +66,25 @@ inline int16_t radToCentidegrees(float rad) {
   return rad / M_PI * 18000;
 }
 
-bool missions_comp(mavlink_message_t msg1, mavlink_message_t msg2)
+static MAVLinkFrame param_value_frame(const mavlink_param_value_t& value)
 {
-    int seq1 = mavlink_msg_mission_item_get_seq(&msg1);
-    int seq2 = mavlink_msg_mission_item_get_seq(&msg2);
-    return seq1 < seq2;
+    mavlink_message_t msg;
+    mavlink_msg_param_value_encode(ARDUPILOT_SYSTEM_ID, ARDUPILOT_COMPONENT_ID, &msg, &value);
+    return MAVLinkFrame(msg);
 }
 
 MAVLinkHandler::MAVLinkHandler() :
-    autopilot(), isbd_channel(), tcp_channel(), report_time()
+    autopilot(), isbd_channel(), isbd_outbox(isbd_channel.get_channel_id()), tcp_endpoints(), report_time(), router(), drain_autopilot(false),
+    mission_cache(), param_cache(), report_codec(), track(), credit_budget(), report_cost(1),
+    isbd_report_start_time(0), mission_read_forwarded(false), timers(NULL), heartbeat_timer(0), isbd_report_timer(0), tcp_report_timer(0)
 {
 }
 
+MAVLinkHandler::~MAVLinkHandler()
+{
+    close();
+}
+
 /**
  * Handles HL_REPORT_PERIOD_PARAM parameter setting.
  */
@@ -98,6 +111,16 @@ bool MAVLinkHandler::handle_param_set(const mavlink_message_t& msg, mavlink_mess
         mavlink_msg_param_value_encode(ARDUPILOT_SYSTEM_ID, ARDUPILOT_COMPONENT_ID, &ack, &paramValue);
 
         syslog(LOG_INFO, "Report period changed to %f seconds.", config.get_isbd_report_period());
+
+        schedule_reports();
+        return true;
+    }
+
+    mavlink_param_value_t budgetValue;
+
+    if (get_budget_param(param_id, budgetValue)) {
+        // The budget parameters are read-only
+        mavlink_msg_param_value_encode(ARDUPILOT_SYSTEM_ID, ARDUPILOT_COMPONENT_ID, &ack, &budgetValue);
         return true;
     } else {
         return autopilot.send_receive_message(msg, ack);
@@ -106,17 +129,174 @@ bool MAVLinkHandler::handle_param_set(const mavlink_message_t& msg, mavlink_mess
     return false;
 }
 
+/**
+ * Reports the burn rate of ISBD credits.
+ */
+bool MAVLinkHandler::get_budget_param(const char* param_id, mavlink_param_value_t& value)
+{
+    time_t now = Clock::wall_time();
+
+    if (strncmp(param_id, HL_CREDIT_RATE_PARAM, 16) == 0) {
+        value.param_value = credit_budget.get_burn_rate(now);
+    } else if (strncmp(param_id, HL_CREDIT_LEFT_PARAM, 16) == 0) {
+        value.param_value = credit_budget.get_remaining(now);
+    } else if (strncmp(param_id, HL_EFF_PERIOD_PARAM, 16) == 0) {
+        value.param_value = credit_budget.get_report_period(config.get_isbd_report_period(), report_cost, now);
+    } else {
+        return false;
+    }
+
+    value.param_count = 0;
+    value.param_index = 0;
+    memset(value.param_id, 0, sizeof(value.param_id));
+    memcpy(value.param_id, param_id, strnlen(param_id, sizeof(value.param_id)));
+    value.param_type = MAV_PARAM_TYPE_REAL32;
+
+    return true;
+}
+
+/**
+ * Answers parameter reads from the parameter cache.
+ */
+bool MAVLinkHandler::handle_param_read(MAVLinkOutbox& outbox, const mavlink_message_t& msg)
+{
+    if (msg.msgid == MAVLINK_MSG_ID_PARAM_REQUEST_READ) {
+        char param_id[17] = {};
+        mavlink_msg_param_request_read_get_param_id(&msg, param_id);
+
+        // The budget parameters are answered without the parameter cache
+        mavlink_param_value_t value;
+
+        if (get_budget_param(param_id, value)) {
+            outbox.push(param_value_frame(value));
+            return true;
+        }
+    }
+
+    if (!param_cache.is_valid() || param_cache.is_changed()) {
+        // The autopilot answers the requests if the parameters cannot be loaded
+        if (drain_autopilot || !load_param_cache()) {
+            return false;
+        }
+    }
+
+    switch (msg.msgid) {
+    case MAVLINK_MSG_ID_PARAM_REQUEST_READ: {
+        char param_id[17] = {};
+        mavlink_msg_param_request_read_get_param_id(&msg, param_id);
+
+        if (strncmp(param_id, PARAM_HASH_CHECK, 16) == 0) {
+            outbox.push(param_cache.get_hash_frame());
+            return true;
+        }
+
+        mavlink_param_value_t value;
+
+        if (!param_cache.get_param(mavlink_msg_param_request_read_get_param_index(&msg), param_id, value)) {
+            return false;
+        }
+
+        outbox.push(param_value_frame(value));
+        return true;
+    }
+    case MAVLINK_MSG_ID_PARAM_REQUEST_LIST: {
+        vector<mavlink_param_value_t> params;
+        param_cache.get_params(params);
+
+        vector<MAVLinkFrame> frames;
+
+        for (size_t i = 0; i < params.size(); i++) {
+            frames.push_back(param_value_frame(params[i]));
+        }
+
+        frames.push_back(param_cache.get_hash_frame());
+
+        syslog(LOG_INFO, "Sending %d cached parameters to %s channel.", (int)params.size(),
+               outbox.get_channel_id().data());
+
+        outbox.push_bulk(frames);
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+/**
+ * Sends the parameters changed since the specified hash.
+ */
+bool MAVLinkHandler::handle_param_sync(MAVLinkOutbox& outbox, const mavlink_message_t& msg)
+{
+    char param_id[17] = {};
+    mavlink_msg_param_set_get_param_id(&msg, param_id);
+
+    if (strncmp(param_id, PARAM_HASH_CHECK, 16) != 0) {
+        return false;
+    }
+
+    if (!param_cache.is_valid() || param_cache.is_changed()) {
+        if (drain_autopilot || !load_param_cache()) {
+            return false;
+        }
+    }
+
+    uint32_t hash = MAVLinkParamCache::decode_hash(mavlink_msg_param_set_get_param_value(&msg));
+
+    vector<mavlink_param_value_t> params;
+    bool known = param_cache.get_changed_params(hash, params);
+
+    vector<MAVLinkFrame> frames;
+
+    for (size_t i = 0; i < params.size(); i++) {
+        frames.push_back(param_value_frame(params[i]));
+    }
+
+    frames.push_back(param_cache.get_hash_frame());
+
+    syslog(LOG_INFO, "Sending %d parameters changed since %s hash %08x to %s channel.", (int)params.size(),
+           known ? "known" : "unknown", hash, outbox.get_channel_id().data());
+
+    outbox.push_bulk(frames);
+    return true;
+}
+
+/**
+ * Loads the parameter cache from the autopilot.
+ */
+bool MAVLinkHandler::load_param_cache()
+{
+    vector<mavlink_param_value_t> params;
+
+    if (!autopilot.receive_params(params)) {
+        param_cache.invalidate();
+        return false;
+    }
+
+    param_cache.update(params);
+    return true;
+}
+
 /**
  * Handles mission write transaction.
  */
 bool MAVLinkHandler::handle_mission_write(MAVLinkChannel& channel, const mavlink_message_t& msg, mavlink_message_t& ack)
 {
-    if (msg.msgid != MAVLINK_MSG_ID_MISSION_COUNT)
+    uint16_t count = 0;
+    vector<mavlink_mission_item_int_t> items;
+    mavlink_message_t mission_count = msg;
+
+    if (msg.msgid == MAVLINK_MSG_ID_MISSION_COUNT) {
+        count = mavlink_msg_mission_count_get_count(&msg);
+    } else if (MAVLinkMissionPack::unpack(msg, count, items)) {
+        // The packed mission starts with its first chunk instead of MISSION_COUNT
+        mavlink_msg_mission_count_pack(msg.sysid, msg.compid, &mission_count, ARDUPILOT_SYSTEM_ID,
+                                       ARDUPILOT_COMPONENT_ID, count);
+    } else {
         return false;
+    }
 
-    uint16_t count = mavlink_msg_mission_count_get_count(&msg);
-
-    vector<mavlink_message_t> missions(count);
+    vector<mavlink_mission_item_int_t> missions(count);
+    vector<bool> received(count, false);
 
     mavlink_message_t mt_msg;
 
@@ -125,14 +305,36 @@ bool MAVLinkHandler::handle_mission_write(MAVLinkChannel& channel, const mavlink
     uint16_t idx = 0;
 
     for (uint16_t i = 0; i < count * MAX_SEND_RETRIES && idx < count; i++) {
-        if (channel.receive_message(mt_msg)) {
+        if (items.empty()) {
+            if (!channel.receive_message(mt_msg)) {
+                Clock::sleep(ISBD_RETRY_INTERVAL * NSEC_PER_USEC);
+                continue;
+            }
+
+            uint16_t chunk_count = 0;
+
             if (mt_msg.msgid == MAVLINK_MSG_ID_MISSION_ITEM) {
-                //syslog(LOG_DEBUG, "MISSION_ITEM MT message received.");
-                missions[idx++] = mt_msg;
+                mavlink_mission_item_t item;
+                mavlink_msg_mission_item_decode(&mt_msg, &item);
+                items.resize(1);
+                MAVLinkMissionUpload::to_item_int(item, items[0]);
+            } else if (mt_msg.msgid == MAVLINK_MSG_ID_MISSION_ITEM_INT) {
+                items.resize(1);
+                mavlink_msg_mission_item_int_decode(&mt_msg, &items[0]);
+            } else if (MAVLinkMissionPack::unpack(mt_msg, chunk_count, items) && chunk_count != count) {
+                items.clear();
+            }
+        }
+
+        for (size_t j = 0; j < items.size(); j++) {
+            if (items[j].seq < count && !received[items[j].seq]) {
+                missions[items[j].seq] = items[j];
+                received[items[j].seq] = true;
+                idx++;
             }
-        } else {
-            usleep(ISBD_RETRY_INTERVAL);
         }
+
+        items.clear();
     }
 
     if (idx != count) {
@@ -147,91 +349,203 @@ bool MAVLinkHandler::handle_mission_write(MAVLinkChannel& channel, const mavlink
         return true;
     }
 
-    std::sort(missions.begin(), missions.end(), missions_comp);
-
-    return send_missions_to_autopilot(msg, missions, ack);
+    return send_missions_to_autopilot(mission_count, missions, ack);
 }
 
 /**
  * Sends the specified missions to autopilot.
  */
-bool MAVLinkHandler::send_missions_to_autopilot(const mavlink_message_t& mission_count, const vector<mavlink_message_t>& missions, mavlink_message_t& ack)
+bool MAVLinkHandler::send_missions_to_autopilot(const mavlink_message_t& mission_count, const vector<mavlink_mission_item_int_t>& missions, mavlink_message_t& ack)
 {
     if (mission_count.msgid != MAVLINK_MSG_ID_MISSION_COUNT)
         return false;
 
     syslog(LOG_INFO, "Sending mission items to autopilot...");
 
-    for (int i = 0; i < MAX_SEND_RETRIES; i++) {
-        if (autopilot.send_message(mission_count)) {
-            break;
+    autopilot.send_mission(mission_count, missions, ack);
+
+    if (mavlink_msg_mission_ack_get_type(&ack) == MAV_MISSION_ACCEPTED) {
+        mission_cache.update(missions);
+        syslog(LOG_INFO, "Missions accepted by autopilot.");
+    } else {
+        syslog(LOG_WARNING, "Missions not accepted by autopilot: %d", mavlink_msg_mission_ack_get_type(&ack));
+    }
+
+    return true;
+}
+
+/**
+ * Answers mission read requests from the mission cache.
+ */
+bool MAVLinkHandler::handle_mission_read(MAVLinkOutbox& outbox, const mavlink_message_t& msg)
+{
+    if (!mission_cache.is_valid() || mission_cache.is_changed()) {
+        // The autopilot answers the requests if the mission cannot be loaded
+        if (drain_autopilot || !load_mission_cache()) {
+            return false;
         }
+    }
 
-        usleep(AUTOPILOT_SEND_INTERVAL);
+    switch (msg.msgid) {
+    case MAVLINK_MSG_ID_MISSION_REQUEST_LIST: {
+        vector<MAVLinkFrame> frames;
+        mission_cache.get_mission_frames(msg.sysid, msg.compid, frames);
+
+        syslog(LOG_INFO, "Sending %d cached mission items to %s channel.", (int)mission_cache.size(),
+               outbox.get_channel_id().data());
+
+        outbox.push_bulk(frames);
+        return true;
     }
+    case MAVLINK_MSG_ID_MISSION_REQUEST:
+    case MAVLINK_MSG_ID_MISSION_REQUEST_INT: {
+        bool item_int = msg.msgid == MAVLINK_MSG_ID_MISSION_REQUEST_INT;
+        uint16_t seq = item_int ? mavlink_msg_mission_request_int_get_seq(&msg) : mavlink_msg_mission_request_get_seq(&msg);
+        MAVLinkFrame frame;
 
-    for (uint16_t i = 0; i < missions.size(); i++) {
-        autopilot.send_receive_message(missions[i], ack);
+        if (!mission_cache.get_item_frame(seq, item_int, msg.sysid, msg.compid, frame)) {
+            return false;
+        }
 
-        usleep(AUTOPILOT_SEND_INTERVAL);
+        // The item is a part of the mission download
+        outbox.push_bulk(vector<MAVLinkFrame>(1, frame));
+        return true;
     }
+    default:
+        return false;
+    }
+}
 
-    if (mavlink_msg_mission_ack_get_type(&ack) == MAV_MISSION_ACCEPTED) {
-        syslog(LOG_INFO, "Missions accepted by autopilot.");
-    } else {
-        syslog(LOG_WARNING, "Missions not accepted by autopilot: %d", mavlink_msg_mission_ack_get_type(&ack));
+/**
+ * Loads the mission cache from the autopilot.
+ */
+bool MAVLinkHandler::load_mission_cache()
+{
+    vector<mavlink_mission_item_int_t> items;
+
+    if (!autopilot.receive_mission(items)) {
+        syslog(LOG_WARNING, "Failed to load mission from autopilot.");
+        mission_cache.invalidate();
+        return false;
     }
 
+    mission_cache.update(items);
     return true;
 }
 
 /**
- * Send the specified mo_msg to the specified channel.
+ * Send the frames queued in the outbox to the specified channel.
  * Receive and handle all messages waiting in the MT queue.
- * Send ACKs for received messages from autopilot to ISBD.
+ * Queue ACKs for received messages from autopilot in the outbox.
  */
-bool MAVLinkHandler::comm_session(MAVLinkChannel& channel, mavlink_message_t& mo_msg)
+bool MAVLinkHandler::comm_session(MAVLinkChannel& channel, MAVLinkOutbox& outbox)
 {
     syslog(LOG_INFO, "Comm session started for %s channel.", channel.get_channel_id().data());
 
-    if (!channel.send_message(mo_msg)) {
-        return false;
-    }
+    std::string labels = Metrics::label("channel", channel.get_channel_id());
+    Stopwatch session_time;
+
+    unsigned long mt_frames = 0;
+
+    for (;;) {
+        MAVLinkFrame mt_frame;
+
+        // The received frames are handled first, so their responses share the next transmission.
+        // The transmissions of ISBD channel also receive the next MT message.
+        if (!channel.frame_buffered() && !outbox.empty()) {
+            if (!outbox.send_next(channel)) {
+                Metrics::counter("comm_session_failures_total", labels, "Number of comm sessions failed to send MO message.").inc();
+                return false;
+            }
+
+            continue;
+        }
+
+        if (!channel.message_available()) {
+            break;
+        }
+
+        if (!channel.receive_frame(mt_frame)) {
+            continue;
+        }
 
-    while (channel.message_available()) {
-        mavlink_message_t mt_msg;
+        mt_frames++;
 
-        if (channel.receive_message(mt_msg)) {
-            mo_msg.len = mo_msg.msgid = 0;
-            bool ack_received = false;
+        mavlink_message_t mo_msg;
+        mo_msg.len = mo_msg.msgid = 0;
+        MAVLinkFrame ack;
+        bool ack_received = false;
 
-            switch(mt_msg.msgid) {
-                case MAVLINK_MSG_ID_PARAM_SET:
-                    ack_received = handle_param_set(mt_msg, mo_msg);
+        switch(mt_frame.msgid()) {
+            case MAVLINK_MSG_ID_PARAM_SET:
+                if (handle_param_sync(outbox, mt_frame.get_message())) {
                     break;
-                case MAVLINK_MSG_ID_MISSION_COUNT:
-                    ack_received = handle_mission_write(channel, mt_msg, mo_msg);
+                }
+
+                ack_received = handle_param_set(mt_frame.get_message(), mo_msg);
+                ack = MAVLinkFrame(mo_msg);
+                break;
+            case MAVLINK_MSG_ID_PARAM_REQUEST_READ:
+            case MAVLINK_MSG_ID_PARAM_REQUEST_LIST:
+                if (handle_param_read(outbox, mt_frame.get_message())) {
                     break;
-                default:
-                    /*
-                     * Send a heartbeat first
-                     */
-                    mavlink_message_t heartbeat;
-                    mavlink_msg_heartbeat_pack(mt_msg.sysid, mt_msg.compid, &heartbeat, MAV_TYPE_GCS, MAV_AUTOPILOT_INVALID, 0, 0, 0);
-                    autopilot.send_message(heartbeat);
-
-                    //Forward unhandled messages to the autopilot.
-                    ack_received = autopilot.send_receive_message(mt_msg, mo_msg);
-            }
+                }
 
-            if (ack_received) {
-                channel.send_message(mo_msg);
-            }
+                ack_received = autopilot.send_receive_frame(mt_frame, ack);
+                break;
+            case MAVLINK_MSG_ID_MISSION_COUNT:
+                ack_received = handle_mission_write(channel, mt_frame.get_message(), mo_msg);
+                ack = MAVLinkFrame(mo_msg);
+                break;
+            case MAVLINK_MSG_ID_ENCAPSULATED_DATA:
+                if (handle_mission_write(channel, mt_frame.get_message(), mo_msg)) {
+                    ack_received = true;
+                    ack = MAVLinkFrame(mo_msg);
+                    break;
+                }
+
+                ack_received = autopilot.send_receive_frame(mt_frame, ack);
+                break;
+            case MAVLINK_MSG_ID_MISSION_REQUEST_LIST:
+            case MAVLINK_MSG_ID_MISSION_REQUEST:
+            case MAVLINK_MSG_ID_MISSION_REQUEST_INT:
+                if (handle_mission_read(outbox, mt_frame.get_message())) {
+                    break;
+                }
+
+                // The autopilot's read transaction is completed by the ground's MISSION_ACK
+                mission_read_forwarded = true;
+                ack_received = autopilot.send_receive_frame(mt_frame, ack);
+                break;
+            case MAVLINK_MSG_ID_MISSION_ACK:
+                // Mission read transactions served by the cache are completed by the cache
+                if (mission_read_forwarded) {
+                    mission_read_forwarded = false;
+                    autopilot.send_frame(mt_frame);
+                }
+                break;
+            default:
+                /*
+                 * Send a heartbeat first
+                 */
+                mavlink_message_t heartbeat;
+                mavlink_msg_heartbeat_pack(mt_frame.sysid(), mt_frame.compid(), &heartbeat, MAV_TYPE_GCS, MAV_AUTOPILOT_INVALID, 0, 0, 0);
+                autopilot.send_message(heartbeat);
+
+                //Forward unhandled frames to the autopilot as is.
+                ack_received = autopilot.send_receive_frame(mt_frame, ack);
+        }
+
+        if (ack_received) {
+            outbox.push(ack);
         }
     }
 
     syslog(LOG_INFO, "Comm session ended.");
 
+    Metrics::histogram("comm_session_seconds", labels, "Duration of comm sessions.", METRICS_SESSION_BUCKETS).observe(session_time.elapsed_time());
+    Metrics::counter("comm_session_mt_frames_total", labels, "Number of MAVLink frames received in comm sessions.").inc(mt_frames);
+
     return true;
 }
 
@@ -242,7 +556,7 @@ bool MAVLinkHandler::comm_session(MAVLinkChannel& channel, mavlink_message_t& mo
  * do not respond on the devices specified by the configuration properties.
  *
  */
-bool MAVLinkHandler::init()
+bool MAVLinkHandler::init(Serial* autopilot_device, Serial* isbd_device)
 {
     vector<string> devices;
 
@@ -250,10 +564,20 @@ bool MAVLinkHandler::init()
         Serial::get_serial_devices(devices);
     }
 
-    if (!autopilot.init(config.get_autopilot_serial(),  config.get_autopilot_serial_speed(), devices)) {
+    if (autopilot_device != NULL) {
+        if (!autopilot.init(*autopilot_device)) {
+            return false;
+        }
+
+        drain_autopilot = true;
+    } else if (!autopilot.init(config.get_autopilot_serial(),  config.get_autopilot_serial_speed(), devices)) {
         return false;
     }
 
+    autopilot.add_frame_listener(&mission_cache);
+    autopilot.add_frame_listener(&param_cache);
+    autopilot.add_frame_listener(&track);
+
     // Exclude the serial device used by autopilot from the device list used
     // for ISBD transceiver serial device auto-detection.
     for (std::vector<string>::iterator iter = devices.begin(); iter != devices.end(); ++iter) {
@@ -263,8 +587,34 @@ bool MAVLinkHandler::init()
         }
     }
 
-    if (config.get_tcp_enabled() && !tcp_channel.init(config.get_tcp_host(), config.get_tcp_port())) {
-        return false;
+    for (size_t i = 0; i < config.get_tcp_endpoint_count(); i++) {
+        const TCPEndpointConfig& endpoint_config = config.get_tcp_endpoint(i);
+
+        if (!endpoint_config.enabled) {
+            continue;
+        }
+
+        string channel_id = "TCP";
+
+        if (i > 0) {
+            channel_id += std::to_string(i + 1);
+        }
+
+        TCPEndpoint* endpoint = new TCPEndpoint(channel_id, i);
+
+        tcp_endpoints.push_back(endpoint);
+
+        if (!endpoint->channel.init(endpoint_config.host, endpoint_config.port)) {
+            return false;
+        }
+    }
+
+    if (config.get_router_enabled()) {
+        if (!router.init(&autopilot, config.get_router_address(),
+                         config.get_router_tcp_port(), config.get_router_udp_port(),
+                         config.get_router_unix_socket())) {
+            return false;
+        }
     }
 
     if (config.get_isbd_enabled()) {
@@ -278,9 +628,25 @@ bool MAVLinkHandler::init()
             isbd_serial = devices[0];
         }
 
-        if (!isbd_channel.init(isbd_serial, config.get_isbd_serial_speed(), devices)) {
+        if (isbd_device != NULL) {
+            if (!isbd_channel.init(*isbd_device)) {
+                return false;
+            }
+        } else if (!isbd_channel.init(isbd_serial, config.get_isbd_serial_speed(), devices)) {
             return false;
         }
+
+        report_codec.set_keyframe_interval(config.get_isbd_report_keyframe_interval());
+        track.set_sample_period(config.get_isbd_track_sample_period());
+
+        credit_budget.set_budget(ISBD_BUDGET_HOUR, config.get_isbd_hourly_credits());
+        credit_budget.set_budget(ISBD_BUDGET_DAY, config.get_isbd_daily_credits());
+        credit_budget.set_budget(ISBD_BUDGET_MONTH, config.get_isbd_monthly_credits());
+
+        // The credits spent before the restart count against the budget
+        if (credit_budget.is_limited() && !credit_budget.open(config.get_isbd_credit_file(), Clock::wall_time())) {
+            syslog(LOG_WARNING, "ISBD credit budget starts with no credits spent.");
+        }
     }
 
     if (!config.get_tcp_enabled() && !config.get_isbd_enabled()) {
@@ -291,13 +657,49 @@ bool MAVLinkHandler::init()
     return true;
 }
 
+/**
+ * Schedules the heartbeat and report timers.
+ */
+void MAVLinkHandler::start(TimerWheel& wheel)
+{
+    timers = &wheel;
+
+    heartbeat_timer = timers->schedule_periodic(HEARTBEAT_INTERVAL, [this]() {
+        send_heartbeat();
+    });
+
+    schedule_reports();
+}
+
 /**
  * Closes all opened connections.
  */
 void MAVLinkHandler::close()
 {
-    tcp_channel.close();
+    if (timers != NULL) {
+        timers->cancel(heartbeat_timer);
+        timers->cancel(isbd_report_timer);
+        timers->cancel(tcp_report_timer);
+
+        for (size_t i = 0; i < tcp_endpoints.size(); i++) {
+            timers->cancel(tcp_endpoints[i]->report_timer);
+        }
+
+        timers = NULL;
+    }
+
+    for (size_t i = 0; i < tcp_endpoints.size(); i++) {
+        tcp_endpoints[i]->channel.close();
+        delete tcp_endpoints[i];
+    }
+
+    tcp_endpoints.clear();
+
+    router.close();
     isbd_channel.close();
+    autopilot.remove_frame_listener(&mission_cache);
+    autopilot.remove_frame_listener(&param_cache);
+    autopilot.remove_frame_listener(&track);
     autopilot.close();
 }
 
@@ -306,6 +708,17 @@ void MAVLinkHandler::close()
  */
 void MAVLinkHandler::loop()
 {
+    route();
+
+    // The replayed autopilot does not respond to mission requests.
+    if (mission_cache.is_changed() && !drain_autopilot) {
+        load_mission_cache();
+    }
+
+    if (param_cache.is_changed() && !drain_autopilot) {
+        load_param_cache();
+    }
+
     if (config.get_tcp_report_period() <= config.get_isbd_report_period()) {
         tcp_loop();
         isbd_loop();
@@ -315,70 +728,267 @@ void MAVLinkHandler::loop()
     }
 }
 
-// Start TCP comm session first if the TCP channel is enabled and
-// either data is available to receive or TCP report period is elapsed.
+/**
+ * Forwards frames between the autopilot and the router's local endpoints.
+ */
+void MAVLinkHandler::route()
+{
+    router.route();
+
+    // The track samples the autopilot's stream between the reports.
+    if (drain_autopilot || track.get_sample_period() > 0) {
+        mavlink_message_t msg;
+
+        for (uint64_t deadline = Clock::now() + AUTOPILOT_DRAIN_TIME;
+             Clock::now() < deadline && autopilot.data_available() && autopilot.receive_message(msg);) {
+        }
+    }
+}
+
+bool MAVLinkHandler::needs_route() const
+{
+    return config.get_router_enabled() || drain_autopilot || track.get_sample_period() > 0;
+}
+
+vector<string> MAVLinkHandler::get_comm_channel_ids() const
+{
+    vector<string> ids;
+
+    if (config.get_isbd_enabled()) {
+        ids.push_back(isbd_channel.get_channel_id());
+    }
+
+    for (size_t i = 0; i < tcp_endpoints.size(); i++) {
+        ids.push_back(tcp_endpoints[i]->channel.get_channel_id());
+    }
+
+    return ids;
+}
+
+// Start TCP comm sessions of the enabled TCP endpoints that have data available
+// to receive. The endpoints that received data are sent a report.
 void MAVLinkHandler::tcp_loop() {
-    if (!config.get_tcp_enabled()) {
-        return;
+    bool report = false;
+
+    for (size_t i = 0; i < tcp_endpoints.size(); i++) {
+        TCPEndpoint* endpoint = tcp_endpoints[i];
+        const TCPEndpointConfig& endpoint_config = config.get_tcp_endpoint(endpoint->config_index);
+
+        if (!endpoint->channel.message_available()) {
+            continue;
+        }
+
+        comm_session(endpoint->channel, endpoint->outbox);
+
+        if (endpoint_config.accepts(MAVLINK_MSG_ID_HIGH_LATENCY)) {
+            endpoint->report_due = true;
+            report = true;
+        }
     }
 
-    bool message_available = tcp_channel.message_available();
+    if (report) {
+        tcp_report();
+    }
+}
 
-    if (message_available) {
-        mavlink_message_t msg;
-        msg.len   = 0;
-        msg.msgid = 0;
+void MAVLinkHandler::tcp_report()
+{
+    vector<TCPEndpoint*> report_endpoints;
+
+    for (size_t i = 0; i < tcp_endpoints.size(); i++) {
+        if (tcp_endpoints[i]->report_due) {
+            tcp_endpoints[i]->report_due = false;
+            report_endpoints.push_back(tcp_endpoints[i]);
+        }
+    }
 
-        comm_session(tcp_channel, msg);
+    if (report_endpoints.empty()) {
+        return;
     }
 
-    if (message_available || report_time.elapsed_time() >= config.get_tcp_report_period()) {
-        time_t period_start_time = report_time.time();
+    uint64_t period_start_time = report_time.time();
 
-        mavlink_message_t msg;
+    mavlink_message_t msg;
+
+    get_high_latency_msg(msg);
 
-        get_high_latency_msg(msg);
+    // The report is serialized once and shared by all the endpoints.
+    MAVLinkFrame report(msg);
 
-        if (comm_session(tcp_channel, msg)) {
-            // Reset the stopwatch if the comm session succeeded.
+    for (size_t i = 0; i < report_endpoints.size(); i++) {
+        TCPEndpoint* endpoint = report_endpoints[i];
+
+        endpoint->outbox.push_telemetry(vector<MAVLinkFrame>(1, report));
+
+        if (comm_session(endpoint->channel, endpoint->outbox)) {
+            // The report period restarts if the comm session succeeded.
             report_time.reset(period_start_time);
+            schedule_tcp_report(endpoint, Clock::from_seconds(config.get_tcp_endpoint(endpoint->config_index).report_period));
+        } else {
+            schedule_tcp_report(endpoint, TCP_RETRY_INTERVAL * NSEC_PER_USEC);
         }
     }
 }
 
+void MAVLinkHandler::schedule_tcp_report(TCPEndpoint* endpoint, uint64_t delay)
+{
+    if (timers == NULL) {
+        return;
+    }
+
+    timers->cancel(endpoint->report_timer);
+    endpoint->report_timer = 0;
+
+    if (!config.get_tcp_endpoint(endpoint->config_index).accepts(MAVLINK_MSG_ID_HIGH_LATENCY)) {
+        return;
+    }
+
+    endpoint->report_timer = timers->schedule(delay, [this, endpoint]() {
+        endpoint->report_timer = 0;
+        endpoint->report_due = true;
+
+        // The endpoints due at the same time share one report
+        if (tcp_report_timer == 0) {
+            tcp_report_timer = timers->schedule(0, [this]() {
+                tcp_report_timer = 0;
+                tcp_report();
+            });
+        }
+    });
+}
+
 /*
- * Start ISBD comm session if the ISBD channel is enabled and
- * either data is available to receive or ISBD report period is elapsed.
- * Typically, configuration ISBD report period should be greater than
- * TCP report period, so ISBD report period will elapse only when
- * TCP sessions failed.
+ * Start ISBD comm session if the ISBD channel is enabled and data is
+ * available to receive. The ground is sent a report unless the credits
+ * would run out before the end of a budget window.
  */
 void MAVLinkHandler::isbd_loop() {
-    if (!config.get_isbd_enabled()) {
+    if (!config.get_isbd_enabled() || !isbd_channel.message_available()) {
         return;
     }
 
-    bool message_available = isbd_channel.message_available();
+    isbd_comm_session();
 
-    if (message_available) {
-        mavlink_message_t msg;
-        msg.len   = 0;
-        msg.msgid = 0;
-        comm_session(isbd_channel, msg);
+    if (credit_budget.allows_event(config.get_isbd_report_period(), report_cost, Clock::wall_time())) {
+        isbd_report();
     }
+}
 
-    if (message_available || report_time.elapsed_time() >= config.get_isbd_report_period()) {
-        time_t period_start_time = report_time.time();
+void MAVLinkHandler::isbd_report()
+{
+    time_t now = Clock::wall_time();
+    double period = config.get_isbd_report_period();
 
-        mavlink_message_t msg;
+    isbd_report_start_time = report_time.time();
 
-        get_high_latency_msg(msg);
+    mavlink_message_t msg;
 
-        if (comm_session(isbd_channel, msg)) {
-            // Reset the stopwatch if the comm session succeeded.
-            report_time.reset(period_start_time);
+    get_high_latency_msg(msg);
+
+    // The track samples are sent in the same SBD message after the report
+    vector<MAVLinkFrame> frames;
+    report_codec.encode(msg, Clock::now(), track, frames);
+
+    // The oldest track samples are dropped to keep the report within its credits.
+    // Unless a credit budget leaves room for more, the track only fills the
+    // unused bytes of the report's own credits.
+    size_t report_size = credit_budget.is_limited() ? credit_budget.get_report_size(period, now) :
+                         ISBDCreditBudget::credits(frames[0].size()) * ISBD_CREDIT_SIZE;
+    size_t size = frames[0].size();
+
+    for (size_t i = 1; i < frames.size(); i++) {
+        if (size + frames[i].size() > report_size) {
+            frames.resize(i);
+            break;
         }
+
+        size += frames[i].size();
     }
+
+    report_cost = ISBDCreditBudget::credits(size);
+
+    // The report replaces the report not sent yet
+    isbd_outbox.push_telemetry(frames);
+
+    isbd_comm_session();
+
+    if (isbd_outbox.has_report()) {
+        // The backoff of the abandoned session spans the following sessions,
+        // so the overdue report does not start a new session right away.
+        uint64_t delay = isbd_channel.get_retry_delay();
+        schedule_isbd_report(delay > 0 ? delay : ISBD_RETRY_INTERVAL * NSEC_PER_USEC);
+    }
+}
+
+void MAVLinkHandler::schedule_isbd_report(uint64_t delay)
+{
+    if (timers == NULL || !config.get_isbd_enabled()) {
+        return;
+    }
+
+    timers->cancel(isbd_report_timer);
+
+    isbd_report_timer = timers->schedule(delay, [this]() {
+        isbd_report_timer = 0;
+
+        // TCP reports restart the period and the credit budget may lengthen it
+        uint64_t delay = get_isbd_report_delay();
+
+        if (delay > 0) {
+            schedule_isbd_report(delay);
+        } else {
+            isbd_report();
+        }
+    });
+}
+
+uint64_t MAVLinkHandler::get_isbd_report_delay()
+{
+    // The report period is lengthened when the credits would run out before
+    // the end of a budget window.
+    double period = credit_budget.get_report_period(config.get_isbd_report_period(), report_cost, Clock::wall_time());
+
+    return Clock::from_seconds(period - report_time.elapsed_time());
+}
+
+void MAVLinkHandler::schedule_reports()
+{
+    for (size_t i = 0; i < tcp_endpoints.size(); i++) {
+        schedule_tcp_report(tcp_endpoints[i], Clock::from_seconds(config.get_tcp_endpoint(tcp_endpoints[i]->config_index).report_period));
+    }
+
+    schedule_isbd_report(get_isbd_report_delay());
+}
+
+void MAVLinkHandler::send_heartbeat()
+{
+    mavlink_message_t msg;
+    mavlink_msg_heartbeat_pack(SYSTEM_ID, COMPONENT_ID, &msg, MAV_TYPE_GCS, MAV_AUTOPILOT_INVALID, 0, 0, 0);
+    autopilot.send_message(msg);
+}
+
+bool MAVLinkHandler::isbd_comm_session()
+{
+    unsigned long credits = isbd_channel.get_credits();
+    bool report_queued = isbd_outbox.has_report();
+
+    bool ret = comm_session(isbd_channel, isbd_outbox);
+
+    if (isbd_channel.get_credits() > credits) {
+        credit_budget.spend(isbd_channel.get_credits() - credits, Clock::wall_time());
+    }
+
+    if (report_queued && !isbd_outbox.has_report()) {
+        // The ground received the report, following deltas are relative to it.
+        report_codec.acknowledge();
+        track.clear();
+
+        // Reset the stopwatch when the report was sent.
+        report_time.reset(isbd_report_start_time);
+        schedule_isbd_report(get_isbd_report_delay());
+    }
+
+    return ret;
 }
 
 /*
@@ -391,14 +1001,7 @@ void MAVLinkHandler::get_high_latency_msg(mavlink_message_t& msg)
     mavlink_message_t mt_msg;
 
     /*
-     * Send a heartbeat first
-     */
-    mavlink_msg_heartbeat_pack(SYSTEM_ID, COMPONENT_ID, &mt_msg, MAV_TYPE_GCS,
-                               MAV_AUTOPILOT_INVALID, 0, 0, 0);
-    autopilot.send_message(mt_msg);
-
-    /*
-     * Request data streams from the autopilot.
+     * Request data streams from the autopilot. The heartbeats are sent by the heartbeat timer.
      */
     uint8_t req_stream_ids[] = {MAV_DATA_STREAM_EXTRA1, MAV_DATA_STREAM_EXTRA2,
                                 MAV_DATA_STREAM_EXTENDED_STATUS, MAV_DATA_STREAM_POSITION,
@@ -412,7 +1015,7 @@ void MAVLinkHandler::get_high_latency_msg(mavlink_message_t& msg)
 
         autopilot.send_message(mt_msg);
 
-        usleep(AUTOPILOT_SEND_INTERVAL);
+        Clock::sleep(AUTOPILOT_SEND_INTERVAL * NSEC_PER_USEC);
     }
 
     /**
@@ -435,10 +1038,12 @@ void MAVLinkHandler::get_high_latency_msg(mavlink_message_t& msg)
             }
         }
 
-        usleep(AUTOPILOT_SEND_INTERVAL);
+        Clock::sleep(AUTOPILOT_SEND_INTERVAL * NSEC_PER_USEC);
     }
 
     mavlink_msg_high_latency_encode(ARDUPILOT_SYSTEM_ID, ARDUPILOT_COMPONENT_ID, &msg, &high_latency);
+
+    Metrics::counter("high_latency_reports_total", "", "Number of HIGH_LATENCY reports composed.").inc();
 }
 
 /**
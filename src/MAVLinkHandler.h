@@ -33,8 +33,34 @@ BVLOS telemetry for MAVLink autopilots.
 #include "Config.h"
 #include "MAVLinkISBDChannel.h"
 #include "MAVLinkTCPChannel.h"
+#include "MAVLinkRouter.h"
+#include "MAVLinkMissionCache.h"
+#include "MAVLinkOutbox.h"
+#include "MAVLinkParamCache.h"
+#include "MAVLinkReportCodec.h"
+#include "MAVLinkTrack.h"
+#include "TimerWheel.h"
 
 #define HL_REPORT_PERIOD_PARAM "HL_REPORT_PERIOD"
+#define HL_CREDIT_RATE_PARAM   "HL_CREDIT_RATE"     // ISBD credits spent per hour in the current day
+#define HL_CREDIT_LEFT_PARAM   "HL_CREDIT_LEFT"     // ISBD credits left in the tightest budget window
+#define HL_EFF_PERIOD_PARAM    "HL_EFF_PERIOD"      // ISBD report period within the credit budget
+
+/**
+ * TCP/IP endpoint state.
+ */
+struct TCPEndpoint {
+    MAVLinkTCPChannel channel;       // connection state
+    size_t            config_index;  // index of the endpoint's configuration in config
+    uint64_t          report_timer;  // timer of the next report, 0 if not scheduled
+    bool              report_due;    // the endpoint waits for the next shared report
+    MAVLinkOutbox     outbox;        // frames waiting to be sent to the endpoint
+
+    TCPEndpoint(const std::string& channel_id, size_t config_index) :
+        channel(channel_id), config_index(config_index), report_timer(0), report_due(false), outbox(channel_id)
+    {
+    }
+};
 
 /**
  * Telemetry for MAVLink autopilots.
@@ -43,8 +69,23 @@ class MAVLinkHandler {
 
     MAVLinkSerial           autopilot;
     MAVLinkISBDChannel      isbd_channel;
-    MAVLinkTCPChannel       tcp_channel;
+    MAVLinkOutbox           isbd_outbox;   // frames waiting to be sent to ISBD
+    vector<TCPEndpoint*>    tcp_endpoints;
     Stopwatch               report_time;
+    MAVLinkRouter           router;
+    bool                    drain_autopilot; // read all the frames from the autopilot in route()
+    MAVLinkMissionCache     mission_cache;
+    MAVLinkParamCache       param_cache;
+    MAVLinkReportCodec      report_codec;  // deltas of ISBD reports
+    MAVLinkTrack            track;         // samples sent with ISBD reports
+    ISBDCreditBudget        credit_budget; // credits of ISBD channel
+    int                     report_cost;   // credits of the last ISBD report
+    uint64_t                isbd_report_start_time; // report_time of the queued ISBD report
+    bool                    mission_read_forwarded; // the autopilot serves a mission read and waits for MISSION_ACK
+    TimerWheel*             timers;        // wheel of the report and heartbeat timers, NULL if not started
+    uint64_t                heartbeat_timer;
+    uint64_t                isbd_report_timer;
+    uint64_t                tcp_report_timer; // composes the report shared by the due TCP endpoints
 
 public:
 
@@ -53,12 +94,33 @@ public:
      */
     MAVLinkHandler();
 
+    /**
+     * Closes all connections and frees TCP endpoints.
+     */
+    ~MAVLinkHandler();
+
     /**
      * Initializes enabled ISBD and TCP comm links and autopilot connections.
      *
+     * If autopilot_device is not NULL, the autopilot is connected over the
+     * opened device, such as tlog replay, instead of the configured serial
+     * device. The frames received from such device are read by route() even
+     * if the router is disabled.
+     *
+     * If isbd_device is not NULL and ISBD channel is enabled, the ISBD
+     * transceiver is connected over the opened device, such as a simulated
+     * transceiver, instead of the configured serial device.
+     *
      * Returns true if autopilot and enabled comm link connections were initialized successfully.
      */
-    bool init();
+    bool init(Serial* autopilot_device = NULL, Serial* isbd_device = NULL);
+
+    /**
+     * Schedules the heartbeat sent to the autopilot and the report timers of
+     * the enabled comm channels on the timer wheel. The timers are cancelled
+     * by close().
+     */
+    void start(TimerWheel& timers);
 
     /*
      * Closes all opened connections.
@@ -66,72 +128,206 @@ public:
     void close();
 
     /**
-     * Starts TCP session if report period is elapsed.
-     * Starts ISBD session if ring alert received.
+     * Starts comm sessions of the channels that received MT messages.
+     * The reports are sent by the timers scheduled by start().
      */
     void loop();
 
+    /**
+     * Forwards MAVLink frames between the autopilot and the local endpoints
+     * connected to the router if the router is enabled.
+     *
+     * The call does not block, so it can be called while waiting for comm links.
+     */
+    void route();
+
+    /**
+     * Returns true if route() has to be called between loop() calls: the
+     * router is enabled, the autopilot is drained or the track samples the
+     * autopilot's stream.
+     */
+    bool needs_route() const;
+
+    /**
+     * Returns IDs of the enabled comm channels.
+     */
+    vector<string> get_comm_channel_ids() const;
+
+    /*
+     * Integrates the specified message into the HIGH_LATENCY message.
+     *
+     * Returns true if the message was integrated.
+     */
+    static bool update_high_latency_msg(const mavlink_message_t& msg, mavlink_high_latency_t& high_latency, uint16_t& mask);
+
 private:
 
     /**
-     * Starts TCP session if TCP channel is enabled and MAVlink message is available
-     * or TCP report period is elapsed.
+     * Starts TCP session for each enabled TCP endpoint if MAVlink message is
+     * available and reports to the endpoints that received messages.
      */
     void tcp_loop();
 
     /**
-     * Starts ISBD session if ISBD channel is enabled and MAVlink message is available
-     * or ISBD report period is elapsed.
+     * Sends HIGH_LATENCY report to the TCP endpoints due for report and
+     * schedules their next reports, or retries if the session failed.
+     *
+     * The report is composed and serialized once and shared by all the
+     * endpoints due for report.
+     */
+    void tcp_report();
+
+    /**
+     * Schedules the next report of the TCP endpoint after the specified delay
+     * in nanoseconds.
+     */
+    void schedule_tcp_report(TCPEndpoint* endpoint, uint64_t delay);
+
+    /**
+     * Starts ISBD session if ISBD channel is enabled and MAVlink message is
+     * available, and reports if the credit budget allows.
      */
     void isbd_loop();
 
+    /**
+     * Queues ISBD report with the track samples and starts ISBD session.
+     * Schedules a retry if the report was not sent, after the backoff or
+     * defer interval decided by the SBD session if there is one.
+     */
+    void isbd_report();
+
+    /**
+     * Schedules the next ISBD report after the specified delay in nanoseconds.
+     */
+    void schedule_isbd_report(uint64_t delay);
+
+    /**
+     * Returns nanoseconds left until ISBD report period within the credit
+     * budget elapses. The period restarts when a report is sent to any
+     * channel.
+     */
+    uint64_t get_isbd_report_delay();
+
+    /**
+     * Schedules the reports of all the channels according to their report
+     * periods.
+     */
+    void schedule_reports();
+
+    /**
+     * Sends GCS heartbeat to the autopilot.
+     */
+    void send_heartbeat();
+
     /**
      * If the specified message is of type PARAM_SET and the parameter name is HL_REPORT_PERIOD,
-     * the method sets report period configuration property. Otherwise the method does nothing.
+     * the method sets report period configuration property. PARAM_SET of the read-only credit
+     * budget parameters is answered with their current values. Otherwise the message is
+     * forwarded to the autopilot.
      *
      * Returns true if the message was handled.
      */
     bool handle_param_set(const mavlink_message_t& msg, mavlink_message_t& ack);
 
+    /**
+     * Retrieves the value of a read-only ISBD credit budget parameter.
+     *
+     * Returns false if the parameter is not a credit budget parameter.
+     */
+    bool get_budget_param(const char* param_id, mavlink_param_value_t& value);
+
+    /**
+     * Answers PARAM_REQUEST_READ and PARAM_REQUEST_LIST messages received from
+     * the channel using the parameter cache. PARAM_REQUEST_READ of _HASH_CHECK
+     * pseudo-parameter is answered with the hash of the parameter table.
+     * The answers are queued in the channel's outbox, the whole parameter
+     * table as a bulk download.
+     *
+     * Returns true if the message was handled.
+     */
+    bool handle_param_read(MAVLinkOutbox& outbox, const mavlink_message_t& msg);
+
+    /**
+     * If the message is PARAM_SET of _HASH_CHECK pseudo-parameter, queues the
+     * parameters changed since the parameter table had the hash specified by
+     * the parameter value, followed by the current hash. All the parameters
+     * are sent if the hash is unknown.
+     *
+     * Returns true if the message was handled.
+     */
+    bool handle_param_sync(MAVLinkOutbox& outbox, const mavlink_message_t& msg);
+
+    /**
+     * Reloads the parameter cache from the autopilot.
+     *
+     * Returns true if the parameters were loaded.
+     */
+    bool load_param_cache();
+
     /**
      * Handles writing waypoints list as described  in
      * http://qgroundcontrol.org/mavlink/waypoint_protocol
      *
-     * If message specified by msg parameter is of type MISSION_COUNT,
-     * the method retrieves all the mission items from the channel, sends them
-     * to the autopilot, and sends MISSION_ACK to the channel. Otherwise the
-     * method does nothing and just returns false.
+     * If message specified by msg parameter is of type MISSION_COUNT or is
+     * the first ENCAPSULATED_DATA chunk of a packed mission (see
+     * MAVLinkMissionPack), the method retrieves all the mission items from
+     * the channel, sends them to the autopilot, and sends MISSION_ACK to the
+     * channel. The items may arrive as MISSION_ITEM, MISSION_ITEM_INT or
+     * packed chunks in any order. Otherwise the method does nothing and just
+     * returns false.
      *
      * Returns true if waypoints list was updated in the autopilot.
      */
     bool handle_mission_write(MAVLinkChannel& channel, const mavlink_message_t& msg, mavlink_message_t& ack);
 
     /**
-     * Sends MISSION_COUNT and MISSION_ITEM messages to the autopilot.
-     * Receives MISSION_ACK message from the autopilot.
+     * Sends MISSION_COUNT message to the autopilot and the mission items
+     * requested by the autopilot. Receives MISSION_ACK message from the autopilot.
      *
      * Returns true if the missions were successfully sent to the autopilot.
      */
-    bool send_missions_to_autopilot(const mavlink_message_t& mission_count, const vector<mavlink_message_t>& missions, mavlink_message_t& ack);
+    bool send_missions_to_autopilot(const mavlink_message_t& mission_count, const vector<mavlink_mission_item_int_t>& missions, mavlink_message_t& ack);
 
     /**
-     * Sends the specified HIGH_LATENCY message to the Cchannel.
+     * Answers MISSION_REQUEST_LIST, MISSION_REQUEST and MISSION_REQUEST_INT
+     * messages received from the channel using the mission cache. The items
+     * are queued in the channel's outbox as a bulk download, the whole mission
+     * in response to MISSION_REQUEST_LIST.
      *
-     * Receives and handles all the messages in the MT queue.
+     * Returns true if the message was handled.
      */
-    bool comm_session(MAVLinkChannel& channel, mavlink_message_t& mo_msg);
+    bool handle_mission_read(MAVLinkOutbox& outbox, const mavlink_message_t& msg);
 
     /**
-     * Retrieves all the required data from the autopilot and composes HIGH_LATENCY message.
+     * Reloads the mission cache from the autopilot.
+     *
+     * Returns true if the mission was loaded.
      */
-    void get_high_latency_msg(mavlink_message_t& msg);
+    bool load_mission_cache();
 
-    /*
-     * Integrates the specified message into the HIGH_LATENCY message.
+    /**
+     * Sends the frames queued in the outbox to the channel, highest priority
+     * first, packing as many of them as fit into each transmission.
      *
-     * Returns true if the message was integrated.
+     * Receives and handles all the messages in the MT queue. The responses
+     * are queued in the outbox and sent with the next transmission.
+     *
+     * Returns false if a transmission failed. The frames not sent remain
+     * in the outbox.
+     */
+    bool comm_session(MAVLinkChannel& channel, MAVLinkOutbox& outbox);
+
+    /**
+     * Runs comm session of ISBD channel and charges its credits to the budget.
+     * The report codec and the track are acknowledged once the queued report
+     * was sent, whether in this session or in a later one.
      */
-    bool update_high_latency_msg(const mavlink_message_t& msg, mavlink_high_latency_t& high_latency, uint16_t& mask);
+    bool isbd_comm_session();
+
+    /**
+     * Retrieves all the required data from the autopilot and composes HIGH_LATENCY message.
+     */
+    void get_high_latency_msg(mavlink_message_t& msg);
 };
 
 #endif /* MAVLINKHANDLER_H_ */
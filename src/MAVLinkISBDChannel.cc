@@ -27,10 +27,13 @@
 #include "MAVLinkISBDChannel.h"
 
 #include "MAVLinkLogger.h"
+#include "MAVLinkTlog.h"
+#include "Metrics.h"
 #include <stdio.h>
+#include <string.h>
 #include <syslog.h>
 
-MAVLinkISBDChannel::MAVLinkISBDChannel() : MAVLinkChannel("ISBD"), stream(), isbd(stream), received_messages()
+MAVLinkISBDChannel::MAVLinkISBDChannel() : MAVLinkChannel("ISBD"), stream(), isbd(stream), received_frames(), credits(0)
 {
 }
 
@@ -121,6 +124,22 @@ bool MAVLinkISBDChannel::init(string path, int speed, const vector<string>& devi
     return false;
 }
 
+bool MAVLinkISBDChannel::init(Serial& device)
+{
+    syslog(LOG_INFO, "Connecting to ISBD transceiver (%s)...", device.get_path().data());
+
+    isbd.setPowerProfile(1);
+    isbd.setStream(device);
+
+    if (detect_transceiver(device.get_path())) {
+        return true;
+    }
+
+    syslog(LOG_ERR, "ISBD transceiver was not detected at '%s'.", device.get_path().data());
+
+    return false;
+}
+
 void MAVLinkISBDChannel::close()
 {
     stream.close();
@@ -134,19 +153,52 @@ void MAVLinkISBDChannel::close()
  */
 bool MAVLinkISBDChannel::send_message(const mavlink_message_t& msg)
 {
-    if (msg.len == 0 && msg.msgid == 0) {
+    return send_frame(MAVLinkFrame(msg));
+}
+
+/**
+ * Sends the specified serialized MAVLink frame to ISBD.
+ *
+ * Returns true if the frame was sent successfully.
+ */
+bool MAVLinkISBDChannel::send_frame(const MAVLinkFrame& frame)
+{
+    if (frame.empty()) {
        return true;
     }
 
-    mavlink_message_t mt_msg;
-    bool received;
-    bool ret = send_receive_message(msg, mt_msg, received);
+    return send_receive_message(frame);
+}
+
+/**
+ * Sends the specified frames packing as many frames as fit into each SBD MO message.
+ *
+ * Returns true if all the frames were sent successfully.
+ */
+bool MAVLinkISBDChannel::send_frames(const vector<MAVLinkFrame>& frames)
+{
+    vector<MAVLinkFrame> mo_frames;
+    size_t mo_size = 0;
+
+    for (size_t i = 0; i < frames.size(); i++) {
+        if (frames[i].empty()) {
+            continue;
+        }
+
+        if (mo_size + frames[i].size() > ISBD_MAX_MO_MGS_SIZE && !mo_frames.empty()) {
+            if (!send_receive_message(mo_frames)) {
+                return false;
+            }
+
+            mo_frames.clear();
+            mo_size = 0;
+        }
 
-    if (received) {
-        received_messages.push(mt_msg);
+        mo_frames.push_back(frames[i]);
+        mo_size += frames[i].size();
     }
 
-    return ret;
+    return mo_frames.empty() || send_receive_message(mo_frames);
 }
 
 /**
@@ -156,20 +208,34 @@ bool MAVLinkISBDChannel::send_message(const mavlink_message_t& msg)
  */
 bool MAVLinkISBDChannel::receive_message(mavlink_message_t& msg)
 {
-    if (!received_messages.empty()) {
-        msg = received_messages.front();
-        received_messages.pop();
-        return true;
+    MAVLinkFrame frame;
+
+    if (!receive_frame(frame)) {
+        return false;
     }
 
-    mavlink_message_t mo_msg;
-    mo_msg.len   = 0;
-    mo_msg.msgid = 0;
+    msg = frame.get_message();
+    return true;
+}
+
+/**
+ * Receives MAVLink frame from ISBD.
+ *
+ * Returns true if a frame was received.
+ */
+bool MAVLinkISBDChannel::receive_frame(MAVLinkFrame& frame)
+{
+    if (received_frames.empty()) {
+        send_receive_message(MAVLinkFrame());
+    }
 
-    bool received = false;
-    send_receive_message(mo_msg, msg, received);
+    if (received_frames.empty()) {
+        return false;
+    }
 
-    return received;
+    frame = received_frames.front();
+    received_frames.pop();
+    return true;
 }
 
 /**
@@ -179,7 +245,7 @@ bool MAVLinkISBDChannel::receive_message(mavlink_message_t& msg)
  */
 bool MAVLinkISBDChannel::message_available()
 {
-    if (!received_messages.empty() || isbd.getWaitingMessageCount() > 0) {
+    if (!received_frames.empty() || isbd.getWaitingMessageCount() > 0) {
         return true;
     }
 
@@ -190,25 +256,41 @@ bool MAVLinkISBDChannel::message_available()
     return ra_flag != 0;
 }
 
-bool MAVLinkISBDChannel::send_receive_message(const mavlink_message_t& mo_msg, mavlink_message_t& mt_msg, bool& received)
+bool MAVLinkISBDChannel::send_receive_message(const MAVLinkFrame& mo_frame)
 {
-    uint8_t buf[ISBD_MAX_MT_MGS_SIZE];
-    size_t buf_size = sizeof(buf);
-    uint16_t len = 0;
+    vector<MAVLinkFrame> mo_frames;
 
-    if (mo_msg.len != 0 && mo_msg.msgid != 0) {
-        len = mavlink_msg_to_send_buffer(buf, &mo_msg);
+    if (!mo_frame.empty()) {
+        mo_frames.push_back(mo_frame);
     }
 
-    received = false;
+    return send_receive_message(mo_frames);
+}
 
-    int ret = isbd.sendReceiveSBDBinary(buf, len, buf, buf_size);
+bool MAVLinkISBDChannel::send_receive_message(const vector<MAVLinkFrame>& mo_frames)
+{
+    uint8_t mo_buf[ISBD_MAX_MO_MGS_SIZE];
+    size_t mo_size = 0;
+
+    for (size_t i = 0; i < mo_frames.size(); i++) {
+        memcpy(mo_buf + mo_size, mo_frames[i].data(), mo_frames[i].size());
+        mo_size += mo_frames[i].size();
+    }
+
+    uint8_t buf[ISBD_MAX_MT_MGS_SIZE];
+    size_t buf_size = sizeof(buf);
+
+    int ret = isbd.sendReceiveSBDBinary(mo_buf, mo_size, buf, buf_size);
 
     if (ret != ISBD_SUCCESS) {
-        if (mo_msg.len != 0 && mo_msg.msgid != 0) {
+        if (!mo_frames.empty()) {
             char prefix[32];
             snprintf(prefix, 32, "SBD << FAILED(%d)", ret);
-            MAVLinkLogger::log(LOG_WARNING, prefix, mo_msg);
+
+            for (size_t i = 0; i < mo_frames.size(); i++) {
+                MAVLinkLogger::log(LOG_WARNING, prefix, mo_frames[i]);
+                metrics.send_failed();
+            }
         } else {
             syslog(LOG_WARNING, "SBD >> FAILED(%d)", ret); //Failed to receive MT message from ISBD
         }
@@ -217,23 +299,40 @@ bool MAVLinkISBDChannel::send_receive_message(const mavlink_message_t& mo_msg, m
     }
 
     if (buf_size > 0) {
-        mavlink_status_t mavlink_status;
-
-        for (size_t i = 0; i < buf_size; i++) {
-            if (mavlink_parse_char(MAVLINK_COMM_0, buf[i], &mt_msg, &mavlink_status)) {
-                received = true;
-
-                MAVLinkLogger::log(LOG_INFO, "SBD >>", mt_msg);
-                break;
-            }
+        // Each MT message is self-contained and may carry several MAVLink frames
+        vector<MAVLinkFrame> frames;
+        parser.reset();
+        parser.feed(buf, buf_size, frames);
+        metrics.update(parser);
+
+        for (size_t i = 0; i < frames.size(); i++) {
+            MAVLinkLogger::log(LOG_INFO, "SBD >>", frames[i]);
+            MAVLinkTlog::record(frames[i]);
+            metrics.frame_received(frames[i]);
+            received_frames.push(frames[i]);
         }
 
-        if (!received) {
+        if (frames.empty()) {
             syslog(LOG_WARNING, "Failed to parse MAVLink message received from ISBD.");
         }
     }
 
-    MAVLinkLogger::log(LOG_INFO, "SBD <<", mo_msg);
+    if (mo_frames.empty()) {
+        MAVLinkLogger::log(LOG_INFO, "SBD <<", MAVLinkFrame());
+    }
+
+    for (size_t i = 0; i < mo_frames.size(); i++) {
+        MAVLinkLogger::log(LOG_INFO, "SBD <<", mo_frames[i]);
+        MAVLinkTlog::record(mo_frames[i]);
+        metrics.frame_sent(mo_frames[i]);
+    }
+
+    Metrics::counter("isbd_mo_bytes_total", "", "Number of bytes sent in SBD MO messages.").inc(mo_size);
+    Metrics::counter("isbd_mt_bytes_total", "", "Number of bytes received in SBD MT messages.").inc(buf_size);
+
+    int session_credits = ISBDCreditBudget::credits(mo_size) + ISBDCreditBudget::credits(buf_size);
+    credits += session_credits;
+    Metrics::counter("isbd_credits_total", "", "Number of credits used by SBD messages.").inc(session_credits);
 
     return true;
 }
@@ -28,6 +28,7 @@
 
 #include <queue>
 #include "IridiumSBD.h"
+#include "ISBDCreditBudget.h"
 #include "mavlink.h"
 #include "MAVLinkChannel.h"
 
@@ -38,7 +39,8 @@ class MAVLinkISBDChannel : public MAVLinkChannel {
 
     Serial stream;
     IridiumSBD isbd;
-    queue<mavlink_message_t> received_messages;
+    queue<MAVLinkFrame> received_frames;
+    unsigned long credits;  // credits used by the SBD sessions
 
 public:
     MAVLinkISBDChannel();
@@ -53,6 +55,14 @@ public:
      */
     bool init(std::string path, int speed, const vector<string>& devices);
 
+    /**
+     * Initializes connection to ISBD transceiver over the specified opened
+     * device, such as a simulated transceiver.
+     *
+     * Returns true if the transceiver was detected.
+     */
+    bool init(Serial& device);
+
     /*
      * Closes the serial device used to connect to ISBD.
      */
@@ -65,6 +75,26 @@ public:
      */
     bool send_message(const mavlink_message_t& msg);
 
+    /**
+     * Sends the specified serialized MAVLink frame to ISBD.
+     *
+     * Returns true if the frame was sent successfully.
+     */
+    bool send_frame(const MAVLinkFrame& frame);
+
+    /**
+     * Sends the specified frames packing as many frames as fit into each
+     * SBD MO message.
+     *
+     * Returns true if all the frames were sent successfully.
+     */
+    bool send_frames(const vector<MAVLinkFrame>& frames);
+
+    /**
+     * Returns the maximum size of SBD MO message.
+     */
+    size_t get_transmission_size() const { return ISBD_MAX_MO_MGS_SIZE; }
+
     /**
      * Receives MAVLink message from ISBD.
      *
@@ -72,6 +102,13 @@ public:
      */
     bool receive_message(mavlink_message_t& msg);
 
+    /**
+     * Receives MAVLink frame from ISBD.
+     *
+     * Returns true if a frame was received.
+     */
+    bool receive_frame(MAVLinkFrame& frame);
+
     /**
      * Checks if data is available in ISBD.
      *
@@ -79,6 +116,30 @@ public:
      */
     bool message_available();
 
+    /**
+     * Checks if frames of the last MT message wait to be read.
+     *
+     * Returns true if a frame can be read without SBD session.
+     */
+    bool frame_buffered() { return !received_frames.empty(); }
+
+    /**
+     * Returns the number of credits used by the SBD sessions so far.
+     */
+    inline unsigned long get_credits() const { return credits; };
+
+    /**
+     * Returns nanoseconds the last SBD session decided to wait before the
+     * retry when it was abandoned, or 0 if it did not decide any retry.
+     * The backoff and defer intervals span the sessions.
+     */
+    inline uint64_t get_retry_delay() const { return isbd.getRetryDelay(); };
+
+    /**
+     * Returns ISBDRetryDecision of the last retry decided by SBD sessions.
+     */
+    inline int get_retry_decision() const { return isbd.getRetryDecision(); };
+
 private:
     /**
      * Retrieves ring alert flag.
@@ -93,11 +154,20 @@ private:
     int get_waiting_wessage_count();
 
     /**
-     * Sends MT message to ISBD and receives MO message from the in-bound message queue if any.
+     * Sends MO frame to ISBD and receives MT message from the in-bound message queue if any.
+     * Frames of the received MT message are queued in received_frames.
+     *
+     * Returns true if the ISBD session succeeded.
+     */
+    bool send_receive_message(const MAVLinkFrame& mo_frame);
+
+    /**
+     * Sends the frames in one MO message and receives MT message if any.
+     * The frames must fit into ISBD_MAX_MO_MGS_SIZE bytes.
      *
      * Returns true if the ISBD session succeeded.
      */
-    bool send_receive_message(const mavlink_message_t& mo_msg, mavlink_message_t& mt_msg, bool& received);
+    bool send_receive_message(const vector<MAVLinkFrame>& mo_frames);
 
     /**
      * Returns true if ISBD transceiver detected at the specified serial device.
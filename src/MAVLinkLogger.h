@@ -27,10 +27,26 @@
 #define MAVLINKLOGGER_H_
 
 #include <syslog.h>
+#include <stddef.h>
 #include "mavlink.h"
+#include "MAVLinkFrame.h"
+
+#define MAVLINK_LOG_LEVEL_DEFAULT  -1   // use the category level or the log mask
+#define MAVLINK_LOG_LEVEL_QUIET    -2   // never log
 
 /**
  * Class MAVLinkLogger provides static methos for logging MAVLink messages to syslog.
+ *
+ * After start() is called, log(...) only copies the frame to a lock-free ring
+ * buffer and the messages are formatted and written to syslog by a background
+ * thread. If the ring buffer is full, the messages are dropped and counted.
+ * Before start() and after stop() the messages are written synchronously.
+ *
+ * The priority is checked before the message is copied or decoded. By default
+ * a message is logged if its priority is enabled by the log mask. The mask can
+ * be overridden per message ID and per category (the first word of the prefix,
+ * such as "MAV", "SBD", "TCP", or "ROUTE"), message ID levels take precedence.
+ * The levels can be changed at runtime.
  */
 class MAVLinkLogger {
 public:
@@ -47,6 +63,83 @@ public:
      * "SBD <<" - message sent to the SBD transceiver
      */
     static void log(int priority, const char* prefix, const mavlink_message_t& message);
+
+    /**
+     * Logs MAVLink frame to syslog at the specified priority with the specified text prefix.
+     *
+     * The frame is decoded only when it is formatted.
+     */
+    static void log(int priority, const char* prefix, const MAVLinkFrame& frame);
+
+    /**
+     * Returns true if message with the specified ID logged at the specified
+     * priority with the specified prefix would be written to syslog.
+     */
+    static bool is_enabled(int priority, const char* prefix, uint32_t msgid);
+
+    /**
+     * Sets the syslog log mask used for the messages without level overrides.
+     */
+    static void set_log_mask(int mask);
+
+    /**
+     * Sets the maximum priority logged for the message ID.
+     *
+     * MAVLINK_LOG_LEVEL_DEFAULT removes the override, MAVLINK_LOG_LEVEL_QUIET
+     * disables logging of the message.
+     */
+    static void set_message_level(uint8_t msgid, int level);
+
+    /**
+     * Sets the maximum priority logged for the category.
+     *
+     * Returns false if the category is unknown.
+     */
+    static bool set_category_level(const char* category, int level);
+
+    /**
+     * Removes all the message ID and category level overrides.
+     */
+    static void clear_levels();
+
+    /**
+     * Starts the background logging thread.
+     *
+     * Returns true if the thread is running.
+     */
+    static bool start();
+
+    /**
+     * Writes the queued messages and stops the background logging thread.
+     */
+    static void stop();
+
+    /**
+     * Returns the number of messages dropped because the ring buffer was full.
+     */
+    static unsigned long get_dropped_count();
+
+private:
+    /**
+     * Body of the background logging thread.
+     */
+    static void run();
+
+    /**
+     * Formats the message and writes it to syslog.
+     */
+    static void write(int priority, const char* prefix, const mavlink_message_t& message);
+
+    /**
+     * Formats the frame and writes it to syslog. Only the header of frames that
+     * cannot be decoded is written.
+     */
+    static void write(int priority, const char* prefix, const MAVLinkFrame& frame);
+
+    /**
+     * Formats the message with the specified prefix into the buffer.
+     */
+    static void format(const char* prefix, const mavlink_message_t& message, char* buff, size_t size);
 };
 
 #endif /* MAVLINKLOGGER_H_ */
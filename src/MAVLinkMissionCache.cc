@@ -0,0 +1,120 @@
+/*
+ MAVLinkMissionCache.cc
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "MAVLinkMissionCache.h"
+#include "MAVLinkMissionUpload.h"
+#include "MAVLinkSerial.h"
+#include <syslog.h>
+
+MAVLinkMissionCache::MAVLinkMissionCache() : items(), valid(false), changed(true)
+{
+}
+
+void MAVLinkMissionCache::frame_received(const MAVLinkFrame& frame)
+{
+    if (frame.empty() || changed) {
+        return;
+    }
+
+    const mavlink_message_t& msg = frame.get_message();
+
+    switch (frame.msgid()) {
+    case MAVLINK_MSG_ID_MISSION_ACK:
+        // Upload by another system or MISSION_CLEAR_ALL
+        if (mavlink_msg_mission_ack_get_type(&msg) == MAV_MISSION_ACCEPTED) {
+            changed = true;
+        }
+        break;
+    case MAVLINK_MSG_ID_MISSION_COUNT:
+        if (mavlink_msg_mission_count_get_count(&msg) != items.size()) {
+            changed = true;
+        }
+        break;
+    case MAVLINK_MSG_ID_MISSION_CURRENT: {
+        uint16_t seq = mavlink_msg_mission_current_get_seq(&msg);
+        if (valid && seq > 0 && seq >= items.size()) {
+            changed = true;
+        }
+        break;
+    }
+    default:
+        return;
+    }
+
+    if (changed) {
+        syslog(LOG_INFO, "Autopilot's mission changed.");
+    }
+}
+
+void MAVLinkMissionCache::update(const std::vector<mavlink_mission_item_int_t>& mission)
+{
+    items = mission;
+    valid = true;
+    changed = false;
+}
+
+void MAVLinkMissionCache::invalidate()
+{
+    items.clear();
+    valid = false;
+    changed = false;
+}
+
+void MAVLinkMissionCache::get_mission_frames(uint8_t target_sysid, uint8_t target_compid, std::vector<MAVLinkFrame>& frames) const
+{
+    mavlink_message_t msg;
+
+    mavlink_msg_mission_count_pack(ARDUPILOT_SYSTEM_ID, ARDUPILOT_COMPONENT_ID, &msg, target_sysid, target_compid, items.size());
+    frames.push_back(MAVLinkFrame(msg));
+
+    for (uint16_t seq = 0; seq < items.size(); seq++) {
+        MAVLinkFrame frame;
+        get_item_frame(seq, true, target_sysid, target_compid, frame);
+        frames.push_back(frame);
+    }
+}
+
+bool MAVLinkMissionCache::get_item_frame(uint16_t seq, bool item_int, uint8_t target_sysid, uint8_t target_compid, MAVLinkFrame& frame) const
+{
+    if (seq >= items.size()) {
+        return false;
+    }
+
+    mavlink_mission_item_int_t item = items[seq];
+    item.seq = seq;
+    item.target_system = target_sysid;
+    item.target_component = target_compid;
+
+    mavlink_message_t msg;
+
+    if (item_int) {
+        mavlink_msg_mission_item_int_encode(ARDUPILOT_SYSTEM_ID, ARDUPILOT_COMPONENT_ID, &msg, &item);
+    } else {
+        mavlink_mission_item_t item_float;
+        MAVLinkMissionUpload::to_item(item, item_float);
+        mavlink_msg_mission_item_encode(ARDUPILOT_SYSTEM_ID, ARDUPILOT_COMPONENT_ID, &msg, &item_float);
+    }
+
+    frame = MAVLinkFrame(msg);
+
+    return true;
+}
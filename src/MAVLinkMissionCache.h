@@ -0,0 +1,95 @@
+/*
+ MAVLinkMissionCache.h
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef MAVLINKMISSIONCACHE_H_
+#define MAVLINKMISSIONCACHE_H_
+
+#include <stdint.h>
+#include <vector>
+#include "mavlink.h"
+#include "MAVLinkFrame.h"
+
+/**
+ * Copy of the mission stored in the autopilot.
+ *
+ * The cache watches the frames received from the autopilot and marks itself
+ * changed when MISSION_ACK, MISSION_COUNT or MISSION_CURRENT show that the
+ * onboard mission is different from the cached one, for example after an
+ * upload by a ground station connected to the router. The owner reloads the
+ * changed cache from the autopilot and answers mission download requests of
+ * the comm channels from the cache.
+ */
+class MAVLinkMissionCache : public MAVLinkFrameListener {
+
+    std::vector<mavlink_mission_item_int_t> items;
+    bool valid;     // items match the autopilot's mission
+    bool changed;   // the autopilot's mission changed since the last update
+
+public:
+    MAVLinkMissionCache();
+
+    /**
+     * Checks if the frame received from the autopilot shows that the mission changed.
+     */
+    void frame_received(const MAVLinkFrame& frame);
+
+    /**
+     * Replaces the cached mission with the mission loaded to or from the autopilot.
+     */
+    void update(const std::vector<mavlink_mission_item_int_t>& mission);
+
+    /**
+     * Marks the cache invalid after it failed to load.
+     */
+    void invalidate();
+
+    /**
+     * Returns true if the cached mission matches the autopilot's mission.
+     */
+    inline bool is_valid() const { return valid; };
+
+    /**
+     * Returns true if the autopilot's mission changed since the last update.
+     */
+    inline bool is_changed() const { return changed; };
+
+    /**
+     * Returns the number of the cached mission items.
+     */
+    inline size_t size() const { return items.size(); };
+
+    /**
+     * Composes MISSION_COUNT followed by all the mission items as MISSION_ITEM_INT
+     * frames addressed to the specified system.
+     */
+    void get_mission_frames(uint8_t target_sysid, uint8_t target_compid, std::vector<MAVLinkFrame>& frames) const;
+
+    /**
+     * Composes MISSION_ITEM or MISSION_ITEM_INT frame of the mission item
+     * addressed to the specified system.
+     *
+     * Returns false if there is no such item.
+     */
+    bool get_item_frame(uint16_t seq, bool item_int, uint8_t target_sysid, uint8_t target_compid, MAVLinkFrame& frame) const;
+};
+
+#endif /* MAVLINKMISSIONCACHE_H_ */
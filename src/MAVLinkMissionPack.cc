@@ -0,0 +1,336 @@
+/*
+ MAVLinkMissionPack.cc
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "MAVLinkMissionPack.h"
+#include <math.h>
+#include <string.h>
+
+#define MISSION_PACK_COMMAND         0x01
+#define MISSION_PACK_FRAME           0x02
+#define MISSION_PACK_PARAMS          0x04
+#define MISSION_PACK_CURRENT         0x08
+#define MISSION_PACK_NO_AUTOCONTINUE 0x10
+
+#define MISSION_PACK_MAX_ITEM_LEN    36 // flags, command, frame, params and three varints
+
+/**
+ * Values the first item of a chunk is encoded relative to.
+ */
+static void reset_item(mavlink_mission_item_int_t& item)
+{
+    memset(&item, 0, sizeof(item));
+    item.command = MAV_CMD_NAV_WAYPOINT;
+    item.frame = MAV_FRAME_GLOBAL_RELATIVE_ALT;
+}
+
+static int32_t to_cm(float z)
+{
+    return (int32_t)lroundf(z * 100);
+}
+
+static size_t put_varint(uint8_t* buf, int64_t value)
+{
+    uint64_t zigzag = ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+    size_t n = 0;
+
+    while (zigzag >= 0x80) {
+        buf[n++] = (uint8_t)(zigzag | 0x80);
+        zigzag >>= 7;
+    }
+
+    buf[n++] = (uint8_t)zigzag;
+
+    return n;
+}
+
+static bool get_varint(const uint8_t* buf, size_t size, size_t& pos, int64_t& value)
+{
+    uint64_t zigzag = 0;
+
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (pos >= size) {
+            return false;
+        }
+
+        uint8_t b = buf[pos++];
+        zigzag |= (uint64_t)(b & 0x7F) << shift;
+
+        if ((b & 0x80) == 0) {
+            value = (int64_t)(zigzag >> 1) ^ -(int64_t)(zigzag & 1);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static size_t put_float(uint8_t* buf, float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    for (size_t i = 0; i < sizeof(bits); i++) {
+        buf[i] = (bits >> (8 * i)) & 0xFF;
+    }
+
+    return sizeof(bits);
+}
+
+/**
+ * Encodes the item relative to prev into buf of at least MISSION_PACK_MAX_ITEM_LEN bytes.
+ *
+ * Returns the number of bytes written.
+ */
+static size_t encode_item(const mavlink_mission_item_int_t& item, const mavlink_mission_item_int_t& prev, uint8_t* buf)
+{
+    const float params[] = { item.param1, item.param2, item.param3, item.param4 };
+    uint8_t flags = 0;
+    uint8_t mask = 0;
+
+    for (int i = 0; i < 4; i++) {
+        if (params[i] != 0) {
+            mask |= 1 << i;
+        }
+    }
+
+    if (item.command != prev.command) {
+        flags |= MISSION_PACK_COMMAND;
+    }
+
+    if (item.frame != prev.frame) {
+        flags |= MISSION_PACK_FRAME;
+    }
+
+    if (mask != 0) {
+        flags |= MISSION_PACK_PARAMS;
+    }
+
+    if (item.current) {
+        flags |= MISSION_PACK_CURRENT;
+    }
+
+    if (!item.autocontinue) {
+        flags |= MISSION_PACK_NO_AUTOCONTINUE;
+    }
+
+    size_t n = 0;
+    buf[n++] = flags;
+
+    if (flags & MISSION_PACK_COMMAND) {
+        buf[n++] = item.command & 0xFF;
+        buf[n++] = item.command >> 8;
+    }
+
+    if (flags & MISSION_PACK_FRAME) {
+        buf[n++] = item.frame;
+    }
+
+    if (flags & MISSION_PACK_PARAMS) {
+        buf[n++] = mask;
+
+        for (int i = 0; i < 4; i++) {
+            if (mask & (1 << i)) {
+                n += put_float(buf + n, params[i]);
+            }
+        }
+    }
+
+    n += put_varint(buf + n, (int64_t)item.x - prev.x);
+    n += put_varint(buf + n, (int64_t)item.y - prev.y);
+    n += put_varint(buf + n, (int64_t)to_cm(item.z) - to_cm(prev.z));
+
+    return n;
+}
+
+/**
+ * Decodes the item relative to prev from buf starting at pos.
+ *
+ * Returns false if the item is truncated.
+ */
+static bool decode_item(const uint8_t* buf, size_t size, size_t& pos, const mavlink_mission_item_int_t& prev,
+                        mavlink_mission_item_int_t& item)
+{
+    if (pos >= size) {
+        return false;
+    }
+
+    uint8_t flags = buf[pos++];
+
+    item = prev;
+    item.param1 = item.param2 = item.param3 = item.param4 = 0;
+    item.current = (flags & MISSION_PACK_CURRENT) ? 1 : 0;
+    item.autocontinue = (flags & MISSION_PACK_NO_AUTOCONTINUE) ? 0 : 1;
+
+    if (flags & MISSION_PACK_COMMAND) {
+        if (pos + 2 > size) {
+            return false;
+        }
+
+        item.command = buf[pos] | (buf[pos + 1] << 8);
+        pos += 2;
+    }
+
+    if (flags & MISSION_PACK_FRAME) {
+        if (pos + 1 > size) {
+            return false;
+        }
+
+        item.frame = buf[pos++];
+    }
+
+    if (flags & MISSION_PACK_PARAMS) {
+        if (pos + 1 > size) {
+            return false;
+        }
+
+        uint8_t mask = buf[pos++];
+        float params[4] = { 0, 0, 0, 0 };
+
+        for (int i = 0; i < 4; i++) {
+            if (mask & (1 << i)) {
+                if (pos + 4 > size) {
+                    return false;
+                }
+
+                uint32_t bits = buf[pos] | (buf[pos + 1] << 8) | (buf[pos + 2] << 16) | ((uint32_t)buf[pos + 3] << 24);
+                memcpy(&params[i], &bits, sizeof(bits));
+                pos += 4;
+            }
+        }
+
+        item.param1 = params[0];
+        item.param2 = params[1];
+        item.param3 = params[2];
+        item.param4 = params[3];
+    }
+
+    int64_t dx, dy, dz;
+
+    if (!get_varint(buf, size, pos, dx) || !get_varint(buf, size, pos, dy) || !get_varint(buf, size, pos, dz)) {
+        return false;
+    }
+
+    item.x = (int32_t)(prev.x + dx);
+    item.y = (int32_t)(prev.y + dy);
+    item.z = (to_cm(prev.z) + dz) / 100.0f;
+
+    return true;
+}
+
+static void finish_chunk(uint8_t sysid, uint8_t compid, uint16_t chunk, uint8_t* data, size_t item_count,
+                         std::vector<mavlink_message_t>& msgs)
+{
+    data[9] = item_count;
+
+    mavlink_message_t msg;
+    mavlink_msg_encapsulated_data_pack(sysid, compid, &msg, chunk, data);
+    msgs.push_back(msg);
+}
+
+void MAVLinkMissionPack::pack(uint8_t sysid, uint8_t compid, const std::vector<mavlink_mission_item_int_t>& items,
+                              std::vector<mavlink_message_t>& msgs)
+{
+    uint8_t data[MAVLINK_MSG_ENCAPSULATED_DATA_FIELD_DATA_LEN];
+    size_t size = 0;
+    size_t item_count = 0;
+    uint16_t chunk = 0;
+    mavlink_mission_item_int_t prev;
+
+    for (size_t i = 0; i < items.size(); i++) {
+        uint8_t buf[MISSION_PACK_MAX_ITEM_LEN];
+        size_t n = 0;
+
+        if (size > 0) {
+            n = encode_item(items[i], prev, buf);
+        }
+
+        if (size == 0 || size + n > sizeof(data) || item_count == UINT8_MAX) {
+            if (size > 0) {
+                finish_chunk(sysid, compid, chunk++, data, item_count, msgs);
+            }
+
+            memset(data, 0, sizeof(data));
+            memcpy(data, MISSION_PACK_MAGIC, MISSION_PACK_MAGIC_LEN);
+            data[4] = MISSION_PACK_VERSION;
+            data[5] = items.size() & 0xFF;
+            data[6] = items.size() >> 8;
+            data[7] = i & 0xFF;
+            data[8] = i >> 8;
+            size = MISSION_PACK_HEADER_LEN;
+            item_count = 0;
+
+            reset_item(prev);
+            n = encode_item(items[i], prev, buf);
+        }
+
+        memcpy(data + size, buf, n);
+        size += n;
+        item_count++;
+        prev = items[i];
+    }
+
+    if (size > 0) {
+        finish_chunk(sysid, compid, chunk, data, item_count, msgs);
+    }
+}
+
+bool MAVLinkMissionPack::unpack(const mavlink_message_t& msg, uint16_t& count,
+                                std::vector<mavlink_mission_item_int_t>& items)
+{
+    if (msg.msgid != MAVLINK_MSG_ID_ENCAPSULATED_DATA) {
+        return false;
+    }
+
+    uint8_t data[MAVLINK_MSG_ENCAPSULATED_DATA_FIELD_DATA_LEN];
+    mavlink_msg_encapsulated_data_get_data(&msg, data);
+
+    if (memcmp(data, MISSION_PACK_MAGIC, MISSION_PACK_MAGIC_LEN) != 0 || data[4] != MISSION_PACK_VERSION) {
+        return false;
+    }
+
+    uint16_t mission_count = data[5] | (data[6] << 8);
+    uint16_t seq = data[7] | (data[8] << 8);
+    uint8_t item_count = data[9];
+
+    if (item_count == 0 || seq + item_count > mission_count) {
+        return false;
+    }
+
+    std::vector<mavlink_mission_item_int_t> chunk_items(item_count);
+    size_t pos = MISSION_PACK_HEADER_LEN;
+    mavlink_mission_item_int_t prev;
+    reset_item(prev);
+
+    for (size_t i = 0; i < item_count; i++) {
+        if (!decode_item(data, sizeof(data), pos, prev, chunk_items[i])) {
+            return false;
+        }
+
+        chunk_items[i].seq = seq + i;
+        prev = chunk_items[i];
+    }
+
+    count = mission_count;
+    items.insert(items.end(), chunk_items.begin(), chunk_items.end());
+
+    return true;
+}
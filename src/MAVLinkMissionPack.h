@@ -0,0 +1,84 @@
+/*
+ MAVLinkMissionPack.h
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef MAVLINKMISSIONPACK_H_
+#define MAVLINKMISSIONPACK_H_
+
+#include <stdint.h>
+#include <vector>
+#include "mavlink.h"
+
+#define MISSION_PACK_MAGIC      "RRMP"  // tells mission chunks from other ENCAPSULATED_DATA payloads
+#define MISSION_PACK_MAGIC_LEN  4
+#define MISSION_PACK_VERSION    2
+#define MISSION_PACK_HEADER_LEN 10      // magic, version, mission count, first seq, items in the chunk
+
+/**
+ * Compact binary container of mission items for the uplink over SBD.
+ *
+ * The mission is split into chunks carried in ENCAPSULATED_DATA messages,
+ * each of which fits into one SBD MT message. Every chunk starts with
+ * the header:
+ *
+ *   char[4] magic (MISSION_PACK_MAGIC)
+ *   uint8   version (MISSION_PACK_VERSION)
+ *   uint16  number of items in the mission
+ *   uint16  seq of the first item in the chunk
+ *   uint8   number of items in the chunk
+ *
+ * followed by the items. An item is a flags byte followed by the fields
+ * that differ from the previous item or from the defaults:
+ *
+ *   uint16  command if MISSION_PACK_COMMAND flag is set
+ *   uint8   frame if MISSION_PACK_FRAME flag is set
+ *   uint8   mask of param1..param4 followed by the masked params as float,
+ *           if MISSION_PACK_PARAMS flag is set
+ *
+ * and zigzag varints of the x and y deltas and of the z delta in
+ * centimeters relative to the previous item. Multi-byte fields are little
+ * endian.
+ *
+ * The first item of a chunk is encoded relative to MAV_CMD_NAV_WAYPOINT
+ * in MAV_FRAME_GLOBAL_RELATIVE_ALT at (0, 0, 0), so the chunks can be
+ * unpacked in any order.
+ */
+class MAVLinkMissionPack {
+public:
+    /**
+     * Packs the mission items into ENCAPSULATED_DATA messages. The seqnr
+     * of the messages is the chunk number.
+     */
+    static void pack(uint8_t sysid, uint8_t compid, const std::vector<mavlink_mission_item_int_t>& items,
+                     std::vector<mavlink_message_t>& msgs);
+
+    /**
+     * Unpacks mission items from ENCAPSULATED_DATA message and appends them
+     * to items. The number of items in the whole mission is returned in count.
+     *
+     * Returns false if the message is not a valid mission chunk. Chunks
+     * without the magic are ENCAPSULATED_DATA of other protocols.
+     */
+    static bool unpack(const mavlink_message_t& msg, uint16_t& count,
+                       std::vector<mavlink_mission_item_int_t>& items);
+};
+
+#endif /* MAVLINKMISSIONPACK_H_ */
@@ -0,0 +1,207 @@
+/*
+ MAVLinkMissionUpload.cc
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "MAVLinkMissionUpload.h"
+#include "Clock.h"
+#include <math.h>
+#include <syslog.h>
+
+/**
+ * Returns true if x and y of the frame are latitude and longitude.
+ */
+static bool is_global_frame(uint8_t frame)
+{
+    switch (frame) {
+    case MAV_FRAME_GLOBAL:
+    case MAV_FRAME_GLOBAL_RELATIVE_ALT:
+    case MAV_FRAME_GLOBAL_INT:
+    case MAV_FRAME_GLOBAL_RELATIVE_ALT_INT:
+    case MAV_FRAME_GLOBAL_TERRAIN_ALT:
+    case MAV_FRAME_GLOBAL_TERRAIN_ALT_INT:
+        return true;
+    default:
+        return false;
+    }
+}
+
+MAVLinkMissionUpload::MAVLinkMissionUpload() :
+    items(), system_id(0), component_id(0), target_system(0), target_component(0),
+    item_int(false), active(false), result(MAV_MISSION_ERROR), last_sent(), last_seq(-1),
+    deadline(0), retries(0), sent(), items_sent(0), items_resent(0)
+{
+}
+
+void MAVLinkMissionUpload::start(uint8_t sysid, uint8_t compid, uint8_t target_sysid, uint8_t target_compid,
+                                 const std::vector<mavlink_mission_item_int_t>& mission, bool mission_int,
+                                 mavlink_message_t& msg)
+{
+    items = mission;
+    system_id = sysid;
+    component_id = compid;
+    target_system = target_sysid;
+    target_component = target_compid;
+    item_int = mission_int;
+    active = true;
+    result = MAV_MISSION_ERROR;
+    retries = 0;
+    sent.assign(items.size(), false);
+    items_sent = items_resent = 0;
+
+    for (size_t i = 0; i < items.size(); i++) {
+        items[i].seq = i;
+        items[i].target_system = target_system;
+        items[i].target_component = target_component;
+    }
+
+    mavlink_msg_mission_count_pack(system_id, component_id, &msg, target_system, target_component, items.size());
+
+    last_sent = msg;
+    last_seq = -1;
+    deadline = Clock::now() + MISSION_ITEM_TIMEOUT * NSEC_PER_MSEC;
+}
+
+bool MAVLinkMissionUpload::handle_message(const mavlink_message_t& msg, mavlink_message_t& reply)
+{
+    if (!active || msg.sysid != target_system) {
+        return false;
+    }
+
+    switch (msg.msgid) {
+    case MAVLINK_MSG_ID_MISSION_REQUEST:
+    case MAVLINK_MSG_ID_MISSION_REQUEST_INT: {
+        bool request_int = msg.msgid == MAVLINK_MSG_ID_MISSION_REQUEST_INT;
+        uint16_t seq = request_int ? mavlink_msg_mission_request_int_get_seq(&msg) : mavlink_msg_mission_request_get_seq(&msg);
+        uint8_t target = request_int ? mavlink_msg_mission_request_int_get_target_system(&msg) :
+                                       mavlink_msg_mission_request_get_target_system(&msg);
+
+        if (target != system_id) {
+            return false;
+        }
+
+        if (seq >= items.size()) {
+            syslog(LOG_WARNING, "Autopilot requested mission item %d of %d.", seq, (int)items.size());
+            return false;
+        }
+
+        retries = 0;
+        send_item(seq, request_int || item_int, reply);
+        return true;
+    }
+    case MAVLINK_MSG_ID_MISSION_ACK:
+        if (mavlink_msg_mission_ack_get_target_system(&msg) != system_id) {
+            return false;
+        }
+
+        result = mavlink_msg_mission_ack_get_type(&msg);
+        active = false;
+        return false;
+    default:
+        return false;
+    }
+}
+
+bool MAVLinkMissionUpload::check_timeout(uint64_t now, mavlink_message_t& msg)
+{
+    if (!active || now < deadline) {
+        return false;
+    }
+
+    if (++retries > MISSION_UPLOAD_RETRIES) {
+        syslog(LOG_WARNING, "Autopilot stopped responding to mission upload.");
+        result = MAV_MISSION_ERROR;
+        active = false;
+        return false;
+    }
+
+    if (last_seq < 0) {
+        msg = last_sent;
+        deadline = now + MISSION_ITEM_TIMEOUT * NSEC_PER_MSEC;
+    } else {
+        send_item(last_seq, last_sent.msgid == MAVLINK_MSG_ID_MISSION_ITEM_INT, msg);
+    }
+
+    return true;
+}
+
+void MAVLinkMissionUpload::send_item(uint16_t seq, bool as_int, mavlink_message_t& msg)
+{
+    const mavlink_mission_item_int_t& item = items[seq];
+
+    if (as_int) {
+        mavlink_msg_mission_item_int_encode(system_id, component_id, &msg, &item);
+    } else {
+        mavlink_mission_item_t item_float;
+        to_item(item, item_float);
+        mavlink_msg_mission_item_encode(system_id, component_id, &msg, &item_float);
+    }
+
+    if (sent[seq]) {
+        items_resent++;
+    }
+
+    sent[seq] = true;
+    items_sent++;
+
+    last_sent = msg;
+    last_seq = seq;
+    deadline = Clock::now() + MISSION_ITEM_TIMEOUT * NSEC_PER_MSEC;
+}
+
+void MAVLinkMissionUpload::to_item_int(const mavlink_mission_item_t& item, mavlink_mission_item_int_t& item_int)
+{
+    double scale = is_global_frame(item.frame) ? 1e7 : 1e4;
+
+    item_int.param1 = item.param1;
+    item_int.param2 = item.param2;
+    item_int.param3 = item.param3;
+    item_int.param4 = item.param4;
+    item_int.x = (int32_t)lround(item.x * scale);
+    item_int.y = (int32_t)lround(item.y * scale);
+    item_int.z = item.z;
+    item_int.seq = item.seq;
+    item_int.command = item.command;
+    item_int.target_system = item.target_system;
+    item_int.target_component = item.target_component;
+    item_int.frame = item.frame;
+    item_int.current = item.current;
+    item_int.autocontinue = item.autocontinue;
+}
+
+void MAVLinkMissionUpload::to_item(const mavlink_mission_item_int_t& item_int, mavlink_mission_item_t& item)
+{
+    double scale = is_global_frame(item_int.frame) ? 1e7 : 1e4;
+
+    item.param1 = item_int.param1;
+    item.param2 = item_int.param2;
+    item.param3 = item_int.param3;
+    item.param4 = item_int.param4;
+    item.x = (float)(item_int.x / scale);
+    item.y = (float)(item_int.y / scale);
+    item.z = item_int.z;
+    item.seq = item_int.seq;
+    item.command = item_int.command;
+    item.target_system = item_int.target_system;
+    item.target_component = item_int.target_component;
+    item.frame = item_int.frame;
+    item.current = item_int.current;
+    item.autocontinue = item_int.autocontinue;
+}
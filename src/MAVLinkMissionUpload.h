@@ -0,0 +1,125 @@
+/*
+ MAVLinkMissionUpload.h
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef MAVLINKMISSIONUPLOAD_H_
+#define MAVLINKMISSIONUPLOAD_H_
+
+#include <stdint.h>
+#include <vector>
+#include "mavlink.h"
+
+#define MISSION_ITEM_TIMEOUT    1500    // ms to wait for the next MISSION_REQUEST or MISSION_ACK
+#define MISSION_UPLOAD_RETRIES  5       // timeouts in a row before the upload fails
+
+/**
+ * State machine of the mission upload to the autopilot as described in
+ * https://mavlink.io/en/services/mission.html
+ *
+ * The autopilot drives the upload: every MISSION_REQUEST or MISSION_REQUEST_INT
+ * is answered right away with the requested item, so the upload runs as fast
+ * as the autopilot asks for the items and only the items the autopilot did not
+ * receive are sent again. If neither request nor MISSION_ACK arrives within
+ * MISSION_ITEM_TIMEOUT, the last sent message is repeated.
+ *
+ * Items are sent as MISSION_ITEM_INT if the autopilot requests them with
+ * MISSION_REQUEST_INT or supports MAV_PROTOCOL_CAPABILITY_MISSION_INT, and as
+ * MISSION_ITEM otherwise.
+ *
+ * The class does no I/O, the messages to send are returned to the caller.
+ */
+class MAVLinkMissionUpload {
+
+    std::vector<mavlink_mission_item_int_t> items;
+    uint8_t           system_id;         // source of the sent messages
+    uint8_t           component_id;
+    uint8_t           target_system;
+    uint8_t           target_component;
+    bool              item_int;          // send MISSION_ITEM_INT for MISSION_REQUEST
+    bool              active;
+    uint8_t           result;            // MAV_MISSION_RESULT
+    mavlink_message_t last_sent;
+    int               last_seq;          // seq of the last sent item, -1 for MISSION_COUNT
+    uint64_t          deadline;
+    int               retries;
+    std::vector<bool> sent;
+    unsigned long     items_sent;
+    unsigned long     items_resent;
+
+public:
+    MAVLinkMissionUpload();
+
+    /**
+     * Starts upload of the items on behalf of the specified system and composes
+     * MISSION_COUNT message in msg. The items are renumbered in their order.
+     */
+    void start(uint8_t sysid, uint8_t compid, uint8_t target_sysid, uint8_t target_compid,
+               const std::vector<mavlink_mission_item_int_t>& mission, bool mission_int, mavlink_message_t& msg);
+
+    /**
+     * Handles the message received from the autopilot.
+     *
+     * Returns true if the reply to send was composed in reply.
+     */
+    bool handle_message(const mavlink_message_t& msg, mavlink_message_t& reply);
+
+    /**
+     * Checks the timeout of the autopilot's response.
+     *
+     * Returns true if the message to send again was composed in msg.
+     */
+    bool check_timeout(uint64_t now, mavlink_message_t& msg);
+
+    /**
+     * Returns true if the upload is in progress.
+     */
+    inline bool in_progress() const { return active; };
+
+    /**
+     * Returns MAV_MISSION_RESULT of the finished upload.
+     */
+    inline uint8_t get_result() const { return result; };
+
+    /**
+     * Returns the number of items sent, including the repeated ones.
+     */
+    inline unsigned long get_items_sent() const { return items_sent; };
+
+    /**
+     * Returns the number of items sent more than once.
+     */
+    inline unsigned long get_items_resent() const { return items_resent; };
+
+    /**
+     * Converts MISSION_ITEM to MISSION_ITEM_INT.
+     */
+    static void to_item_int(const mavlink_mission_item_t& item, mavlink_mission_item_int_t& item_int);
+
+    /**
+     * Converts MISSION_ITEM_INT to MISSION_ITEM.
+     */
+    static void to_item(const mavlink_mission_item_int_t& item_int, mavlink_mission_item_t& item);
+
+private:
+    void send_item(uint16_t seq, bool as_int, mavlink_message_t& msg);
+};
+
+#endif /* MAVLINKMISSIONUPLOAD_H_ */
@@ -0,0 +1,219 @@
+/*
+ MAVLinkOutbox.cc
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "MAVLinkOutbox.h"
+#include "Metrics.h"
+
+static const char* priority_names[OUTBOX_PRIORITY_COUNT] = { "ack", "alert", "bulk", "telemetry" };
+
+MAVLinkOutbox::MAVLinkOutbox(const std::string& channel_id) : channel_id(channel_id), queues()
+{
+}
+
+int MAVLinkOutbox::priority(const MAVLinkFrame& frame)
+{
+    switch (frame.msgid()) {
+    case MAVLINK_MSG_ID_COMMAND_ACK:
+    case MAVLINK_MSG_ID_MISSION_ACK:
+    case MAVLINK_MSG_ID_PARAM_VALUE:
+        return OUTBOX_PRIORITY_ACK;
+    case MAVLINK_MSG_ID_STATUSTEXT:
+        return OUTBOX_PRIORITY_ALERT;
+    default:
+        return OUTBOX_PRIORITY_TELEMETRY;
+    }
+}
+
+void MAVLinkOutbox::push(const MAVLinkFrame& frame)
+{
+    if (frame.empty()) {
+        return;
+    }
+
+    int p = priority(frame);
+    push(p, frame.msgid(), std::vector<MAVLinkFrame>(1, frame), p == OUTBOX_PRIORITY_TELEMETRY);
+}
+
+void MAVLinkOutbox::push_telemetry(const std::vector<MAVLinkFrame>& frames)
+{
+    if (frames.empty() || frames[0].empty()) {
+        return;
+    }
+
+    // Keyframes and deltas of the reports are coalesced under one key
+    push(OUTBOX_PRIORITY_TELEMETRY, MAVLINK_MSG_ID_HIGH_LATENCY, frames, true);
+}
+
+bool MAVLinkOutbox::has_report() const
+{
+    const std::deque<Entry>& queue = queues[OUTBOX_PRIORITY_TELEMETRY];
+
+    for (size_t i = 0; i < queue.size(); i++) {
+        if (queue[i].msgid == MAVLINK_MSG_ID_HIGH_LATENCY) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void MAVLinkOutbox::push_bulk(const std::vector<MAVLinkFrame>& frames)
+{
+    if (frames.empty()) {
+        return;
+    }
+
+    push(OUTBOX_PRIORITY_BULK, frames[0].msgid(), frames, false);
+}
+
+void MAVLinkOutbox::push(int priority, uint32_t msgid, const std::vector<MAVLinkFrame>& frames, bool coalesce)
+{
+    std::string labels = Metrics::label("channel", channel_id) + "," +
+                         Metrics::label("priority", priority_names[priority]);
+
+    Entry entry;
+    entry.msgid = msgid;
+    entry.sysid = frames[0].sysid();
+    entry.size = 0;
+    entry.frames = frames;
+
+    for (size_t i = 0; i < frames.size(); i++) {
+        entry.size += frames[i].size();
+    }
+
+    std::deque<Entry>& queue = queues[priority];
+
+    if (coalesce) {
+        for (size_t i = 0; i < queue.size(); i++) {
+            if (queue[i].msgid == entry.msgid && queue[i].sysid == entry.sysid) {
+                queue[i] = entry;
+                Metrics::counter("outbox_coalesced_total", labels, "Number of queued entries replaced by newer ones.").inc();
+                return;
+            }
+        }
+    }
+
+    if (size() >= OUTBOX_MAX_ENTRIES) {
+        int p = OUTBOX_PRIORITY_COUNT - 1;
+
+        while (queues[p].empty()) {
+            p--;
+        }
+
+        // The entry itself is dropped unless it outranks the lowest queued class
+        int dropped = priority < p ? p : priority;
+
+        Metrics::counter("outbox_dropped_total",
+                         Metrics::label("channel", channel_id) + "," + Metrics::label("priority", priority_names[dropped]),
+                         "Number of entries dropped because the queue was full.").inc();
+
+        if (dropped == priority) {
+            return;
+        }
+
+        queues[p].pop_front();
+    }
+
+    queue.push_back(entry);
+}
+
+bool MAVLinkOutbox::send_next(MAVLinkChannel& channel)
+{
+    size_t capacity = channel.get_transmission_size();
+    std::vector<MAVLinkFrame> frames;
+    std::vector<std::pair<int, size_t> > taken;
+    size_t size = 0;
+    size_t part = 0;    // frames sent of an entry that does not fit
+
+    for (int p = 0; p < OUTBOX_PRIORITY_COUNT && part == 0; p++) {
+        for (size_t i = 0; i < queues[p].size() && part == 0; i++) {
+            const Entry& entry = queues[p][i];
+
+            if (size + entry.size <= capacity) {
+                frames.insert(frames.end(), entry.frames.begin(), entry.frames.end());
+                taken.push_back(std::make_pair(p, i));
+                size += entry.size;
+            } else if (frames.empty()) {
+                // The first frames of the entry fill the transmission
+                do {
+                    size += entry.frames[part].size();
+                    frames.push_back(entry.frames[part++]);
+                } while (part < entry.frames.size() && size + entry.frames[part].size() <= capacity);
+
+                taken.push_back(std::make_pair(p, i));
+            }
+        }
+    }
+
+    if (frames.empty()) {
+        return true;
+    }
+
+    if (!(frames.size() == 1 ? channel.send_frame(frames[0]) : channel.send_frames(frames))) {
+        return false;
+    }
+
+    if (part > 0) {
+        Entry& entry = queues[taken[0].first][taken[0].second];
+        entry.frames.erase(entry.frames.begin(), entry.frames.begin() + part);
+        entry.size = 0;
+
+        for (size_t i = 0; i < entry.frames.size(); i++) {
+            entry.size += entry.frames[i].size();
+        }
+
+        if (!entry.frames.empty()) {
+            return true;
+        }
+    }
+
+    // Remove the sent entries, the last ones first to keep the indices valid
+    for (size_t i = taken.size(); i > 0; i--) {
+        std::deque<Entry>& queue = queues[taken[i - 1].first];
+        queue.erase(queue.begin() + taken[i - 1].second);
+    }
+
+    return true;
+}
+
+bool MAVLinkOutbox::empty() const
+{
+    return size() == 0;
+}
+
+size_t MAVLinkOutbox::size() const
+{
+    size_t n = 0;
+
+    for (int p = 0; p < OUTBOX_PRIORITY_COUNT; p++) {
+        n += queues[p].size();
+    }
+
+    return n;
+}
+
+void MAVLinkOutbox::clear()
+{
+    for (int p = 0; p < OUTBOX_PRIORITY_COUNT; p++) {
+        queues[p].clear();
+    }
+}
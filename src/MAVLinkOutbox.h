@@ -0,0 +1,141 @@
+/*
+ MAVLinkOutbox.h
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef MAVLINKOUTBOX_H_
+#define MAVLINKOUTBOX_H_
+
+#include <stdint.h>
+#include <deque>
+#include <string>
+#include <vector>
+#include "MAVLinkChannel.h"
+#include "MAVLinkFrame.h"
+
+#define OUTBOX_MAX_ENTRIES      64      // entries kept while the channel is down
+
+/**
+ * Priority classes of the outbound frames, the highest first.
+ */
+enum OutboxPriority {
+    OUTBOX_PRIORITY_ACK = 0,        // COMMAND_ACK, MISSION_ACK and other responses
+    OUTBOX_PRIORITY_ALERT,          // STATUSTEXT
+    OUTBOX_PRIORITY_BULK,           // parameter and mission downloads
+    OUTBOX_PRIORITY_TELEMETRY,      // periodic reports
+    OUTBOX_PRIORITY_COUNT
+};
+
+/**
+ * Queue of the frames waiting to be sent to a comm channel.
+ *
+ * The entries are sent highest priority class first and in the order they
+ * were queued within a class. Each transmission takes as many entries as fit
+ * into the channel's transmission size, so a backlog of telemetry cannot
+ * delay a response queued after it. An entry larger than the transmission
+ * size is sent in parts, as many of its frames as fit into each transmission,
+ * so responses queued meanwhile overtake the rest of a bulk download.
+ *
+ * Telemetry entries are coalesced: an entry replaces the queued entry with
+ * the same msgid and sysid in place, so only the newest report waits in the
+ * queue. An entry may hold several frames that are sent together in the
+ * same transmission, such as a report and its track.
+ *
+ * When the queue is full, the oldest entry of the lowest queued priority class
+ * is dropped to admit an entry of a higher class. An entry of the lowest
+ * queued class or below is dropped itself.
+ */
+class MAVLinkOutbox {
+
+    struct Entry {
+        uint32_t                  msgid;    // coalescing key of telemetry entries
+        uint8_t                   sysid;
+        size_t                    size;     // bytes of the frames
+        std::vector<MAVLinkFrame> frames;
+    };
+
+    std::string       channel_id;
+    std::deque<Entry> queues[OUTBOX_PRIORITY_COUNT];
+
+public:
+    MAVLinkOutbox(const std::string& channel_id);
+
+    /**
+     * Queues the frame in its priority class.
+     */
+    void push(const MAVLinkFrame& frame);
+
+    /**
+     * Queues a report and the frames sent with it as one telemetry entry
+     * coalesced by the sysid of the first frame. All the report entries share
+     * the HIGH_LATENCY key, so a keyframe and a delta replace each other.
+     */
+    void push_telemetry(const std::vector<MAVLinkFrame>& frames);
+
+    /**
+     * Returns true if a report is queued.
+     */
+    bool has_report() const;
+
+    /**
+     * Queues the frames of a bulk download as one entry sent in order.
+     */
+    void push_bulk(const std::vector<MAVLinkFrame>& frames);
+
+    /**
+     * Sends one transmission of the highest priority entries that fit into
+     * the channel's transmission size. If the first entry does not fit, only
+     * its first frames that fit are sent.
+     *
+     * Returns false if the channel failed to send the frames. The entries
+     * remain queued then.
+     */
+    bool send_next(MAVLinkChannel& channel);
+
+    /**
+     * Returns true if no entries are queued.
+     */
+    bool empty() const;
+
+    /**
+     * Returns the number of queued entries.
+     */
+    size_t size() const;
+
+    /**
+     * Removes all the entries.
+     */
+    void clear();
+
+    /**
+     * Returns ID of the channel the frames are queued for.
+     */
+    inline const std::string& get_channel_id() const { return channel_id; };
+
+    /**
+     * Returns the priority class of the frame.
+     */
+    static int priority(const MAVLinkFrame& frame);
+
+private:
+    void push(int priority, uint32_t msgid, const std::vector<MAVLinkFrame>& frames, bool coalesce);
+};
+
+#endif /* MAVLINKOUTBOX_H_ */
@@ -0,0 +1,234 @@
+/*
+ MAVLinkParamCache.cc
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "MAVLinkParamCache.h"
+#include "MAVLinkSerial.h"
+#include <string.h>
+#include <syslog.h>
+
+#define FNV_OFFSET_BASIS    2166136261u
+#define FNV_PRIME           16777619u
+
+static std::string get_id(const char* param_id)
+{
+    return std::string(param_id, strnlen(param_id, MAVLINK_MSG_PARAM_VALUE_FIELD_PARAM_ID_LEN));
+}
+
+static uint32_t fnv1a(uint32_t hash, const void* data, size_t size)
+{
+    const uint8_t* bytes = (const uint8_t*)data;
+
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * FNV_PRIME;
+    }
+
+    return hash;
+}
+
+MAVLinkParamCache::MAVLinkParamCache() :
+    params(), index(), hashes(), version(0), valid(false), changed(true)
+{
+}
+
+void MAVLinkParamCache::frame_received(const MAVLinkFrame& frame)
+{
+    if (!valid || changed || frame.empty() || frame.msgid() != MAVLINK_MSG_ID_PARAM_VALUE) {
+        return;
+    }
+
+    mavlink_param_value_t value;
+    mavlink_msg_param_value_decode(&frame.get_message(), &value);
+
+    std::map<std::string, size_t>::const_iterator iter = index.find(get_id(value.param_id));
+
+    if (iter == index.end()) {
+        if (value.param_count != params.size()) {
+            syslog(LOG_INFO, "Autopilot's parameter count changed to %d.", value.param_count);
+            changed = true;
+        }
+
+        return;
+    }
+
+    CachedParam& param = params[iter->second];
+
+    if (memcmp(&param.value.param_value, &value.param_value, sizeof(value.param_value)) != 0 ||
+        param.value.param_type != value.param_type) {
+        param.value.param_value = value.param_value;
+        param.value.param_type = value.param_type;
+        param.version = ++version;
+    }
+}
+
+void MAVLinkParamCache::update(const std::vector<mavlink_param_value_t>& table)
+{
+    // Parameters are compared with the previous table by their place in it,
+    // since the parameter index is a part of the copies held by other systems.
+    bool same_layout = valid && params.size() == table.size();
+
+    if (!same_layout) {
+        hashes.clear();
+    }
+
+    params.resize(table.size());
+    index.clear();
+
+    version++;
+
+    for (size_t i = 0; i < table.size(); i++) {
+        CachedParam& param = params[i];
+
+        if (!same_layout || strncmp(param.value.param_id, table[i].param_id, sizeof(param.value.param_id)) != 0 ||
+            memcmp(&param.value.param_value, &table[i].param_value, sizeof(param.value.param_value)) != 0 ||
+            param.value.param_type != table[i].param_type) {
+            param.version = version;
+        }
+
+        param.value = table[i];
+        param.value.param_index = i;
+        param.value.param_count = table.size();
+        index[get_id(table[i].param_id)] = i;
+    }
+
+    valid = true;
+    changed = false;
+
+    // Systems that already hold the loaded table get no parameters
+    get_hash();
+}
+
+void MAVLinkParamCache::invalidate()
+{
+    params.clear();
+    index.clear();
+    hashes.clear();
+    valid = false;
+    changed = false;
+}
+
+bool MAVLinkParamCache::get_param(int16_t param_index, const char* param_id, mavlink_param_value_t& value) const
+{
+    if (param_index >= 0) {
+        if ((size_t)param_index >= params.size()) {
+            return false;
+        }
+
+        value = params[param_index].value;
+        return true;
+    }
+
+    std::map<std::string, size_t>::const_iterator iter = index.find(get_id(param_id));
+
+    if (iter == index.end()) {
+        return false;
+    }
+
+    value = params[iter->second].value;
+    return true;
+}
+
+void MAVLinkParamCache::get_params(std::vector<mavlink_param_value_t>& all_params) const
+{
+    for (size_t i = 0; i < params.size(); i++) {
+        all_params.push_back(params[i].value);
+    }
+}
+
+uint32_t MAVLinkParamCache::compute_hash() const
+{
+    uint32_t hash = FNV_OFFSET_BASIS;
+
+    for (size_t i = 0; i < params.size(); i++) {
+        const mavlink_param_value_t& value = params[i].value;
+        hash = fnv1a(hash, value.param_id, sizeof(value.param_id));
+        hash = fnv1a(hash, &value.param_value, sizeof(value.param_value));
+        hash = fnv1a(hash, &value.param_type, sizeof(value.param_type));
+    }
+
+    return hash;
+}
+
+uint32_t MAVLinkParamCache::get_hash()
+{
+    uint32_t hash = compute_hash();
+
+    if (hashes.find(hash) == hashes.end() && hashes.size() >= PARAM_HASH_HISTORY) {
+        // Forget the oldest hash
+        std::map<uint32_t, uint32_t>::iterator oldest = hashes.begin();
+
+        for (std::map<uint32_t, uint32_t>::iterator iter = hashes.begin(); iter != hashes.end(); ++iter) {
+            if (iter->second < oldest->second) {
+                oldest = iter;
+            }
+        }
+
+        hashes.erase(oldest);
+    }
+
+    hashes[hash] = version;
+
+    return hash;
+}
+
+bool MAVLinkParamCache::get_changed_params(uint32_t hash, std::vector<mavlink_param_value_t>& changed_params) const
+{
+    std::map<uint32_t, uint32_t>::const_iterator iter = hashes.find(hash);
+    bool known = iter != hashes.end();
+
+    if (!known && hash == compute_hash()) {
+        // The table was not reported since it changed, but the system has it
+        return true;
+    }
+
+    for (size_t i = 0; i < params.size(); i++) {
+        if (!known || params[i].version > iter->second) {
+            changed_params.push_back(params[i].value);
+        }
+    }
+
+    return known;
+}
+
+MAVLinkFrame MAVLinkParamCache::get_hash_frame()
+{
+    uint32_t hash = get_hash();
+
+    mavlink_param_value_t value;
+    memset(&value, 0, sizeof(value));
+    memcpy(value.param_id, PARAM_HASH_CHECK, strnlen(PARAM_HASH_CHECK, sizeof(value.param_id)));
+    memcpy(&value.param_value, &hash, sizeof(hash));
+    value.param_type = MAV_PARAM_TYPE_UINT32;
+    value.param_count = params.size();
+    value.param_index = UINT16_MAX;
+
+    mavlink_message_t msg;
+    mavlink_msg_param_value_encode(ARDUPILOT_SYSTEM_ID, ARDUPILOT_COMPONENT_ID, &msg, &value);
+
+    return MAVLinkFrame(msg);
+}
+
+uint32_t MAVLinkParamCache::decode_hash(float param_value)
+{
+    uint32_t hash;
+    memcpy(&hash, &param_value, sizeof(hash));
+    return hash;
+}
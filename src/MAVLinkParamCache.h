@@ -0,0 +1,148 @@
+/*
+ MAVLinkParamCache.h
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef MAVLINKPARAMCACHE_H_
+#define MAVLINKPARAMCACHE_H_
+
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <vector>
+#include "mavlink.h"
+#include "MAVLinkFrame.h"
+
+#define PARAM_HASH_CHECK        "_HASH_CHECK"   // pseudo-parameter carrying hash of the parameter table
+#define PARAM_HASH_HISTORY      16              // number of reported hashes remembered for delta sync
+
+/**
+ * Copy of the autopilot's parameter table.
+ *
+ * The cache watches PARAM_VALUE frames received from the autopilot, so the
+ * parameters set by any system are tracked. Every change of the table gets
+ * a new version number and each parameter remembers the version of its last
+ * change.
+ *
+ * The table is identified by a hash reported as value of _HASH_CHECK
+ * pseudo-parameter. The cache remembers the versions of the recently
+ * reported hashes, so a system that has a copy of the table with a known hash
+ * can get only the parameters changed since then.
+ */
+class MAVLinkParamCache : public MAVLinkFrameListener {
+
+    struct CachedParam {
+        mavlink_param_value_t value;
+        uint32_t              version;  // table version of the last change
+    };
+
+    std::vector<CachedParam>         params;
+    std::map<std::string, size_t>    index;      // parameter ID to index in params
+    std::map<uint32_t, uint32_t>     hashes;     // reported hashes to table versions
+    uint32_t                         version;
+    bool                             valid;
+    bool                             changed;    // the table must be reloaded
+
+public:
+    MAVLinkParamCache();
+
+    /**
+     * Updates the parameter from PARAM_VALUE frame received from the autopilot.
+     */
+    void frame_received(const MAVLinkFrame& frame);
+
+    /**
+     * Replaces the cached table with the table loaded from the autopilot.
+     *
+     * The parameters that did not change since the previous table keep their
+     * versions and the remembered hashes stay valid, so a reload does not
+     * turn the next delta sync into a full dump. The hash of the loaded table
+     * is remembered as well.
+     */
+    void update(const std::vector<mavlink_param_value_t>& table);
+
+    /**
+     * Marks the cache invalid after it failed to load.
+     */
+    void invalidate();
+
+    /**
+     * Returns true if the cached table was loaded from the autopilot.
+     */
+    inline bool is_valid() const { return valid; };
+
+    /**
+     * Returns true if the table must be reloaded from the autopilot.
+     */
+    inline bool is_changed() const { return changed; };
+
+    /**
+     * Returns the number of the cached parameters.
+     */
+    inline size_t size() const { return params.size(); };
+
+    /**
+     * Returns the current table version.
+     */
+    inline uint32_t get_version() const { return version; };
+
+    /**
+     * Finds the parameter by index, or by ID if index is negative.
+     *
+     * Returns false if there is no such parameter.
+     */
+    bool get_param(int16_t param_index, const char* param_id, mavlink_param_value_t& value) const;
+
+    /**
+     * Retrieves all the parameters.
+     */
+    void get_params(std::vector<mavlink_param_value_t>& all_params) const;
+
+    /**
+     * Returns the hash of the table and remembers its version for get_changed_params(...).
+     */
+    uint32_t get_hash();
+
+    /**
+     * Retrieves the parameters changed since the table had the specified hash.
+     * No parameters are retrieved for the hash of the current table.
+     *
+     * Returns false and retrieves all the parameters if the hash is unknown.
+     */
+    bool get_changed_params(uint32_t hash, std::vector<mavlink_param_value_t>& changed_params) const;
+
+    /**
+     * Composes PARAM_VALUE frame of _HASH_CHECK pseudo-parameter with the table hash.
+     */
+    MAVLinkFrame get_hash_frame();
+
+    /**
+     * Decodes the hash from value of _HASH_CHECK pseudo-parameter.
+     */
+    static uint32_t decode_hash(float param_value);
+
+private:
+    /**
+     * Returns the hash of the table.
+     */
+    uint32_t compute_hash() const;
+};
+
+#endif /* MAVLINKPARAMCACHE_H_ */
@@ -0,0 +1,192 @@
+/*
+ MAVLinkParser.cc
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "MAVLinkParser.h"
+#include "MAVLinkCRC.h"
+#include <string.h>
+
+static const uint8_t mavlink_message_lengths[256] = MAVLINK_MESSAGE_LENGTHS;
+
+/*
+ * Returns the size of the frame starting with the specified bytes or 0 if
+ * the bytes cannot start a frame. At least 3 bytes must be available.
+ */
+static uint16_t frame_size(const uint8_t* frame)
+{
+    if (frame[0] == MAVLINK_STX) {
+        return frame[1] + MAVLINK_NUM_NON_PAYLOAD_BYTES;
+    }
+
+    if ((frame[2] & ~MAVLINK2_IFLAG_SIGNED) != 0) {
+        // Unknown incompatibility flags
+        return 0;
+    }
+
+    return MAVLINK2_NUM_HEADER_BYTES + frame[1] + MAVLINK_NUM_CHECKSUM_BYTES +
+           ((frame[2] & MAVLINK2_IFLAG_SIGNED) ? MAVLINK2_SIGNATURE_LEN : 0);
+}
+
+/*
+ * Returns the offset of the first MAVLink 1 or MAVLink 2 STX byte or 'size'
+ * if there is none.
+ */
+static size_t find_stx(const uint8_t* data, size_t size)
+{
+    const uint8_t* v1 = (const uint8_t*)memchr(data, MAVLINK_STX, size);
+    const uint8_t* v2 = (const uint8_t*)memchr(data, MAVLINK2_STX, v1 != NULL ? v1 - data : size);
+    const uint8_t* stx = v2 != NULL ? v2 : v1;
+
+    return stx != NULL ? stx - data : size;
+}
+
+MAVLinkParser::MAVLinkParser() :
+    rx_length(0), frames_received(0), crc_errors(0), bytes_dropped(0), frames_lost(0), last_seq()
+{
+}
+
+void MAVLinkParser::reset()
+{
+    rx_length = 0;
+}
+
+bool MAVLinkParser::is_known(uint32_t msgid)
+{
+    return msgid <= UINT8_MAX && mavlink_message_lengths[msgid] != 0;
+}
+
+size_t MAVLinkParser::feed(const uint8_t* data, size_t size, std::vector<MAVLinkFrame>& frames)
+{
+    size_t count = frames.size();
+    size_t i = 0;
+
+    if (rx_length > 0) {
+        // Scan the frame started by the previous call together with enough
+        // bytes to complete any frame that starts in it.
+        uint8_t joined[2 * MAVLINK_FRAME_MAX_LEN];
+        size_t n = size < MAVLINK_FRAME_MAX_LEN ? size : MAVLINK_FRAME_MAX_LEN;
+
+        memcpy(joined, rx_buffer, rx_length);
+        memcpy(joined + rx_length, data, n);
+
+        size_t end = scan(joined, rx_length + n, frames);
+
+        if (end < rx_length) {
+            // All the bytes are in joined, keep the incomplete frame
+            rx_length = rx_length + n - end;
+            memmove(rx_buffer, joined + end, rx_length);
+            return frames.size() - count;
+        }
+
+        i = end - rx_length;
+        rx_length = 0;
+    }
+
+    i += scan(data + i, size - i, frames);
+
+    // Keep the incomplete frame at the end of data for the next call
+    rx_length = size - i;
+    memcpy(rx_buffer, data + i, rx_length);
+
+    return frames.size() - count;
+}
+
+size_t MAVLinkParser::scan(const uint8_t* data, size_t size, std::vector<MAVLinkFrame>& frames)
+{
+    size_t i = 0;
+
+    while (i < size) {
+        if (data[i] != MAVLINK_STX && data[i] != MAVLINK2_STX) {
+            size_t n = find_stx(data + i, size - i);
+            bytes_dropped += n;
+            i += n;
+            continue;
+        }
+
+        if (size - i < 3) {
+            break;
+        }
+
+        const uint8_t* frame = data + i;
+        uint16_t n = frame_size(frame);
+
+        if (n != 0 && size - i < n) {
+            break;
+        }
+
+        if (n == 0 || !check(frame, n)) {
+            // Not a frame start
+            bytes_dropped++;
+            i++;
+            continue;
+        }
+
+        frames.emplace_back(frame, n);
+        update_statistics(frames.back());
+
+        i += n;
+    }
+
+    return i;
+}
+
+bool MAVLinkParser::check(const uint8_t* frame, uint16_t size)
+{
+    bool v2 = frame[0] == MAVLINK2_STX;
+    uint32_t msgid = v2 ? frame[7] | (frame[8] << 8) | (frame[9] << 16) : frame[5];
+
+    if (!is_known(msgid)) {
+        // Without the CRC extra byte a MAVLink 1 frame of an unknown message
+        // cannot be told from a stray STX byte. MAVLink 2 frames of unknown
+        // messages are forwarded unchecked.
+        return v2;
+    }
+
+    // MAVLink 2 payloads are truncated and may have extension fields, so
+    // only the length of MAVLink 1 frames is known.
+    if (!v2 && frame[1] != mavlink_message_lengths[msgid]) {
+        return false;
+    }
+
+    if (!MAVLinkCRC::check_frame(frame, size)) {
+        crc_errors++;
+        return false;
+    }
+
+    return true;
+}
+
+void MAVLinkParser::update_statistics(const MAVLinkFrame& frame)
+{
+    frames_received++;
+
+    uint16_t source = (frame.sysid() << 8) | frame.compid();
+    uint8_t seq = frame.seq();
+
+    std::map<uint16_t, uint8_t>::iterator iter = last_seq.find(source);
+
+    if (iter != last_seq.end()) {
+        frames_lost += (uint8_t)(seq - iter->second - 1);
+        iter->second = seq;
+    } else {
+        last_seq[source] = seq;
+    }
+}
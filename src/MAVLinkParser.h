@@ -0,0 +1,130 @@
+/*
+ MAVLinkParser.h
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef MAVLINKPARSER_H_
+#define MAVLINKPARSER_H_
+
+#include <map>
+#include <vector>
+#include "mavlink.h"
+#include "MAVLinkFrame.h"
+
+/**
+ * Splits a byte stream into MAVLink 1 and MAVLink 2 frames.
+ *
+ * Unlike mavlink_parse_char(), which keeps its state in the global per-channel
+ * buffers of the MAVLink library, each parser instance has its own state, so
+ * every stream can have a parser of its own. The parser keeps the bytes of the
+ * frames and maintains the stream statistics.
+ *
+ * Frames of the messages defined by the dialect radioroom is compiled with
+ * are validated against the message length table and the CRC extra bytes of
+ * the dialect. MAVLink 2 frames of the other messages, including messages of
+ * other dialects and messages with IDs above 255, are only delimited, so they
+ * are forwarded unchanged. MAVLink 1 frames of unknown messages are dropped,
+ * as mavlink_parse_char() does.
+ */
+class MAVLinkParser {
+
+    uint8_t           rx_buffer[MAVLINK_FRAME_MAX_LEN]; // bytes of the frame started by the previous call
+    uint16_t          rx_length;
+
+    unsigned long     frames_received;
+    unsigned long     crc_errors;
+    unsigned long     bytes_dropped;
+    unsigned long     frames_lost;
+
+    std::map<uint16_t, uint8_t> last_seq; // last sequence number received from each (sysid, compid)
+
+public:
+    /**
+     * Constructs parser in the initial state.
+     */
+    MAVLinkParser();
+
+    /**
+     * Discards the partially received frame. The statistics are not reset.
+     */
+    void reset();
+
+    /**
+     * Parses the specified bytes of the stream and appends all the completed
+     * valid frames to 'frames'. A frame split between calls is completed by
+     * the next call.
+     *
+     * The STX bytes of the frames are searched with memchr(), and complete
+     * frames are validated in place using the message length table and
+     * table driven CRC. The bytes of a frame split between
+     * calls are kept and scanned together with the bytes of the next call,
+     * so such frames pass the same checks.
+     *
+     * Returns the number of frames appended.
+     */
+    size_t feed(const uint8_t* data, size_t size, std::vector<MAVLinkFrame>& frames);
+
+    /**
+     * Returns the number of valid frames received.
+     */
+    inline unsigned long get_frames_received() const { return frames_received; };
+
+    /**
+     * Returns the number of frames discarded because of checksum mismatch.
+     */
+    inline unsigned long get_crc_errors() const { return crc_errors; };
+
+    /**
+     * Returns the number of bytes discarded outside of frames.
+     */
+    inline unsigned long get_bytes_dropped() const { return bytes_dropped; };
+
+    /**
+     * Returns the number of frames lost according to gaps in the sequence numbers.
+     */
+    inline unsigned long get_frames_lost() const { return frames_lost; };
+
+    /**
+     * Returns true if the message is defined by the dialect, so its frames are
+     * validated.
+     */
+    static bool is_known(uint32_t msgid);
+
+private:
+    /**
+     * Appends the valid frames located in the bytes to 'frames'.
+     *
+     * Returns the offset of the first byte that was not consumed, which is
+     * the start of an incomplete frame, or 'size'.
+     */
+    size_t scan(const uint8_t* data, size_t size, std::vector<MAVLinkFrame>& frames);
+
+    /**
+     * Returns true if the complete frame is valid.
+     */
+    bool check(const uint8_t* frame, uint16_t size);
+
+    /**
+     * Updates statistics with the valid frame.
+     */
+    void update_statistics(const MAVLinkFrame& frame);
+};
+
+#endif /* MAVLINKPARSER_H_ */
@@ -0,0 +1,276 @@
+/*
+ MAVLinkReportCodec.cc
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "MAVLinkReportCodec.h"
+#include <stddef.h>
+#include <string.h>
+
+#define REPORT_CODEC_MASK_LEN   3   // bytes of the changed fields mask
+#define REPORT_CODEC_LEN_BITS   5
+
+struct ReportField {
+    size_t offset;
+    size_t size;
+};
+
+#define REPORT_FIELD(name) { offsetof(mavlink_high_latency_t, name), sizeof(((mavlink_high_latency_t*)0)->name) }
+
+static const ReportField report_fields[] = {
+    REPORT_FIELD(custom_mode),
+    REPORT_FIELD(latitude),
+    REPORT_FIELD(longitude),
+    REPORT_FIELD(roll),
+    REPORT_FIELD(pitch),
+    REPORT_FIELD(heading),
+    REPORT_FIELD(heading_sp),
+    REPORT_FIELD(altitude_amsl),
+    REPORT_FIELD(altitude_sp),
+    REPORT_FIELD(wp_distance),
+    REPORT_FIELD(base_mode),
+    REPORT_FIELD(landed_state),
+    REPORT_FIELD(throttle),
+    REPORT_FIELD(airspeed),
+    REPORT_FIELD(airspeed_sp),
+    REPORT_FIELD(groundspeed),
+    REPORT_FIELD(climb_rate),
+    REPORT_FIELD(gps_nsat),
+    REPORT_FIELD(gps_fix_type),
+    REPORT_FIELD(battery_remaining),
+    REPORT_FIELD(temperature),
+    REPORT_FIELD(temperature_air),
+    REPORT_FIELD(failsafe),
+    REPORT_FIELD(wp_num)
+};
+
+#define REPORT_FIELD_COUNT (sizeof(report_fields) / sizeof(report_fields[0]))
+
+static uint32_t get_field(const mavlink_high_latency_t& report, size_t i)
+{
+    const uint8_t* p = (const uint8_t*)&report + report_fields[i].offset;
+
+    switch (report_fields[i].size) {
+    case 1: return p[0];
+    case 2: { uint16_t v; memcpy(&v, p, sizeof(v)); return v; }
+    default: { uint32_t v; memcpy(&v, p, sizeof(v)); return v; }
+    }
+}
+
+static void set_field(mavlink_high_latency_t& report, size_t i, uint32_t value)
+{
+    uint8_t* p = (uint8_t*)&report + report_fields[i].offset;
+
+    switch (report_fields[i].size) {
+    case 1: p[0] = (uint8_t)value; break;
+    case 2: { uint16_t v = (uint16_t)value; memcpy(p, &v, sizeof(v)); break; }
+    default: memcpy(p, &value, sizeof(value)); break;
+    }
+}
+
+/**
+ * Returns the zigzag encoding of value - base wrapped around the width of the field.
+ */
+static uint32_t zigzag_delta(uint32_t value, uint32_t base, size_t size)
+{
+    int shift = 64 - 8 * size;
+    int64_t delta = (int64_t)((uint64_t)((int64_t)value - base) << shift) >> shift;
+
+    return (uint32_t)(((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63));
+}
+
+static uint32_t apply_delta(uint32_t base, uint32_t zigzag)
+{
+    int64_t delta = (int64_t)(zigzag >> 1) ^ -(int64_t)(zigzag & 1);
+
+    return (uint32_t)(base + delta);
+}
+
+static void put_bits(uint8_t* data, size_t& pos, uint32_t value, int n)
+{
+    for (int i = 0; i < n; i++, pos++) {
+        if (value & (1UL << i)) {
+            data[pos / 8] |= 1 << (pos % 8);
+        }
+    }
+}
+
+static bool get_bits(const uint8_t* data, size_t size, size_t& pos, int n, uint32_t& value)
+{
+    if (pos + n > size * 8) {
+        return false;
+    }
+
+    value = 0;
+
+    for (int i = 0; i < n; i++, pos++) {
+        if (data[pos / 8] & (1 << (pos % 8))) {
+            value |= 1UL << i;
+        }
+    }
+
+    return true;
+}
+
+static uint16_t report_crc(const mavlink_high_latency_t& report)
+{
+    return crc_calculate((const uint8_t*)&report, sizeof(report));
+}
+
+MAVLinkReportCodec::MAVLinkReportCodec() :
+    keyframe_interval(0), base(), base_valid(false), pending(), pending_valid(false),
+    pending_keyframe(false), deltas(0)
+{
+}
+
+void MAVLinkReportCodec::set_keyframe_interval(int interval)
+{
+    keyframe_interval = interval;
+}
+
+void MAVLinkReportCodec::encode(const mavlink_message_t& report, uint64_t report_time, const MAVLinkTrack& track,
+                                std::vector<MAVLinkFrame>& frames)
+{
+    mavlink_msg_high_latency_decode(&report, &pending);
+    pending_valid = true;
+    pending_keyframe = !base_valid || keyframe_interval < 2 || deltas + 1 >= keyframe_interval;
+
+    size_t packed = 0;
+
+    if (!pending_keyframe) {
+        uint8_t data[MAVLINK_MSG_MEMORY_VECT_FIELD_VALUE_LEN];
+        memset(data, 0, sizeof(data));
+        size_t pos = 0;
+
+        if (encode_delta(data, sizeof(data), pos)) {
+            // The newest track samples share the delta's credit
+            packed = track.pack_samples(pending, report_time, 0, data, sizeof(data), pos);
+
+            mavlink_message_t msg;
+            mavlink_msg_memory_vect_pack(report.sysid, report.compid, &msg, report_crc(base), REPORT_CODEC_DELTA,
+                                         packed, (const int8_t*)data);
+            frames.push_back(MAVLinkFrame(msg));
+        } else {
+            // Too many changes, send a keyframe instead
+            pending_keyframe = true;
+        }
+    }
+
+    if (pending_keyframe) {
+        frames.push_back(MAVLinkFrame(report));
+    }
+
+    track.pack(report.sysid, report.compid, pending, report_time, frames, packed);
+}
+
+bool MAVLinkReportCodec::encode_delta(uint8_t* data, size_t size, size_t& pos) const
+{
+    uint32_t mask = 0;
+    pos = REPORT_CODEC_MASK_LEN * 8;
+
+    for (size_t i = 0; i < REPORT_FIELD_COUNT; i++) {
+        uint32_t delta = zigzag_delta(get_field(pending, i), get_field(base, i), report_fields[i].size);
+
+        if (delta == 0) {
+            continue;
+        }
+
+        int n = 1;
+
+        while (n < 32 && (delta >> n) != 0) {
+            n++;
+        }
+
+        if (pos + REPORT_CODEC_LEN_BITS + n > size * 8) {
+            return false;
+        }
+
+        mask |= 1UL << i;
+        put_bits(data, pos, n - 1, REPORT_CODEC_LEN_BITS);
+        put_bits(data, pos, delta, n);
+    }
+
+    data[0] = mask & 0xFF;
+    data[1] = (mask >> 8) & 0xFF;
+    data[2] = (mask >> 16) & 0xFF;
+
+    return true;
+}
+
+void MAVLinkReportCodec::acknowledge()
+{
+    if (!pending_valid) {
+        return;
+    }
+
+    base = pending;
+    base_valid = true;
+    deltas = pending_keyframe ? 0 : deltas + 1;
+    pending_valid = false;
+}
+
+bool MAVLinkReportCodec::decode(const mavlink_message_t& msg, uint64_t report_time, mavlink_message_t& report,
+                                std::vector<TrackSample>& samples)
+{
+    if (msg.msgid == MAVLINK_MSG_ID_HIGH_LATENCY) {
+        mavlink_msg_high_latency_decode(&msg, &base);
+        base_valid = true;
+        report = msg;
+        return true;
+    }
+
+    if (msg.msgid != MAVLINK_MSG_ID_MEMORY_VECT || !base_valid ||
+        mavlink_msg_memory_vect_get_ver(&msg) != REPORT_CODEC_DELTA ||
+        mavlink_msg_memory_vect_get_address(&msg) != report_crc(base)) {
+        return false;
+    }
+
+    uint8_t data[MAVLINK_MSG_MEMORY_VECT_FIELD_VALUE_LEN];
+    mavlink_msg_memory_vect_get_value(&msg, (int8_t*)data);
+
+    uint32_t mask = data[0] | (data[1] << 8) | ((uint32_t)data[2] << 16);
+    size_t pos = REPORT_CODEC_MASK_LEN * 8;
+    mavlink_high_latency_t decoded = base;
+
+    for (size_t i = 0; i < REPORT_FIELD_COUNT; i++) {
+        if ((mask & (1UL << i)) == 0) {
+            continue;
+        }
+
+        uint32_t n, delta;
+
+        if (!get_bits(data, sizeof(data), pos, REPORT_CODEC_LEN_BITS, n) ||
+            !get_bits(data, sizeof(data), pos, n + 1, delta)) {
+            return false;
+        }
+
+        set_field(decoded, i, apply_delta(get_field(base, i), delta));
+    }
+
+    if (!MAVLinkTrack::unpack_samples(decoded, report_time, data, sizeof(data), pos,
+                                      mavlink_msg_memory_vect_get_type(&msg), samples)) {
+        return false;
+    }
+
+    base = decoded;
+    mavlink_msg_high_latency_encode(msg.sysid, msg.compid, &report, &decoded);
+
+    return true;
+}
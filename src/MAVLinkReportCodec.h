@@ -0,0 +1,113 @@
+/*
+ MAVLinkReportCodec.h
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef MAVLINKREPORTCODEC_H_
+#define MAVLINKREPORTCODEC_H_
+
+#include <stdint.h>
+#include <vector>
+#include "mavlink.h"
+#include "MAVLinkFrame.h"
+#include "MAVLinkTrack.h"
+
+#define REPORT_CODEC_DELTA      0x80    // MEMORY_VECT ver of report deltas
+
+/**
+ * Delta codec of HIGH_LATENCY reports sent over ISBD.
+ *
+ * Every keyframe_interval-th report is sent as a full HIGH_LATENCY keyframe.
+ * The reports in between are sent as MEMORY_VECT messages with the fields
+ * changed since the last report acknowledged by the ground, that is, the
+ * last report sent in a successful SBD session. The MEMORY_VECT fields are:
+ *
+ *   address  CRC-16/MCRF4XX of the acknowledged report, which lets the
+ *            decoder check that it holds the same base report
+ *   ver      REPORT_CODEC_DELTA
+ *   type     number of track samples packed after the deltas
+ *   value    uint24 mask of the changed fields in mavlink_high_latency_t
+ *            order followed, for each changed field, by 5 bits of the delta
+ *            length n - 1 and n bits of the zigzag-encoded delta, LSB first,
+ *            followed by the newest track samples in MAVLinkTrack format
+ *
+ * Deltas wrap around the field width. A report whose deltas do not fit into
+ * the value is sent as a keyframe.
+ *
+ * A keyframe and a delta both cost one credit on their own. The savings come
+ * from the track samples that share the delta's credit instead of taking a
+ * MEMORY_VECT frame and a credit of their own.
+ *
+ * The same class decodes the reports on the ground.
+ */
+class MAVLinkReportCodec {
+
+    int                    keyframe_interval;
+    mavlink_high_latency_t base;        // last acknowledged or decoded report
+    bool                   base_valid;
+    mavlink_high_latency_t pending;     // last encoded report
+    bool                   pending_valid;
+    bool                   pending_keyframe;
+    int                    deltas;      // reports acknowledged since the last keyframe
+
+public:
+    MAVLinkReportCodec();
+
+    /**
+     * Sets the number of reports per keyframe. Values less than 2 disable deltas.
+     */
+    void set_keyframe_interval(int interval);
+
+    inline int get_keyframe_interval() const { return keyframe_interval; };
+
+    /**
+     * Encodes the HIGH_LATENCY report composed at the specified Clock time
+     * into a keyframe or a delta message followed by the frames of the track
+     * samples that did not fit into the delta.
+     */
+    void encode(const mavlink_message_t& report, uint64_t report_time, const MAVLinkTrack& track,
+                std::vector<MAVLinkFrame>& frames);
+
+    /**
+     * Makes the last encoded report the base of the following deltas after
+     * it was delivered to the ground.
+     */
+    void acknowledge();
+
+    /**
+     * Decodes a keyframe or delta message into HIGH_LATENCY report composed at
+     * the specified time. The track samples packed into a delta are appended
+     * to samples.
+     *
+     * Returns false if msg is not a report or the base of the delta is unknown.
+     */
+    bool decode(const mavlink_message_t& msg, uint64_t report_time, mavlink_message_t& report,
+                std::vector<TrackSample>& samples);
+
+private:
+    /**
+     * Packs the deltas of the pending report against the base into data.
+     *
+     * Returns false if the deltas do not fit.
+     */
+    bool encode_delta(uint8_t* data, size_t size, size_t& pos) const;
+};
+
+#endif /* MAVLINKREPORTCODEC_H_ */
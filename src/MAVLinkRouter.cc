@@ -0,0 +1,554 @@
+/*
+ MAVLinkRouter.cc
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "MAVLinkRouter.h"
+#include "MAVLinkLogger.h"
+#include <vector>
+#include <algorithm>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <syslog.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#define ROUTER_LISTEN_BACKLOG   4
+#define ROUTER_READ_BUFFER_SIZE 1024
+
+#define ROUTE_KEY(sysid, compid) ((uint16_t)(((sysid) << 8) | (compid)))
+
+#define TARGET_CASE(NAME, name) \
+    case MAVLINK_MSG_ID_##NAME: \
+        target_system = mavlink_msg_##name##_get_target_system(&frame.get_message()); \
+        target_component = mavlink_msg_##name##_get_target_component(&frame.get_message()); \
+        return true;
+
+#define TARGET_SYSTEM_CASE(NAME, name) \
+    case MAVLINK_MSG_ID_##NAME: \
+        target_system = mavlink_msg_##name##_get_target_system(&frame.get_message()); \
+        target_component = 0; \
+        return true;
+
+static bool set_nonblocking(int fd)
+{
+    int flags = ::fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+MAVLinkRouter::Endpoint::Endpoint(int id, int fd, bool datagram) :
+    id(id), fd(fd), datagram(datagram), addr_len(0), parser(), tx_pending(), frames_in(0), frames_out(0)
+{
+    memset(&addr, 0, sizeof(addr));
+}
+
+MAVLinkRouter::MAVLinkRouter() :
+    autopilot(NULL), tcp_fd(-1), udp_fd(-1), unix_fd(-1), unix_path(),
+    next_id(ROUTER_AUTOPILOT_ID + 1), endpoints(), routes(), frames_dropped(0)
+{
+}
+
+MAVLinkRouter::~MAVLinkRouter()
+{
+    close();
+}
+
+bool MAVLinkRouter::init(MAVLinkSerial* autopilot, const std::string& address,
+                         int tcp_port, int udp_port, const std::string& unix_socket)
+{
+    close();
+
+    if (!address.empty() && tcp_port > 0) {
+        tcp_fd = open_tcp_socket(address, tcp_port);
+    }
+
+    if (!address.empty() && udp_port > 0) {
+        udp_fd = open_udp_socket(address, udp_port);
+    }
+
+    if (!unix_socket.empty()) {
+        unix_fd = open_unix_socket(unix_socket);
+    }
+
+    if (tcp_fd < 0 && udp_fd < 0 && unix_fd < 0) {
+        syslog(LOG_ERR, "MAVLink router was not started.");
+        return false;
+    }
+
+    this->autopilot = autopilot;
+    autopilot->add_frame_listener(this);
+
+    syslog(LOG_NOTICE, "MAVLink router started.");
+
+    return true;
+}
+
+void MAVLinkRouter::close()
+{
+    if (autopilot != NULL) {
+        autopilot->remove_frame_listener(this);
+        autopilot = NULL;
+    }
+
+    while (!endpoints.empty()) {
+        remove_endpoint(endpoints.begin()->first);
+    }
+
+    if (tcp_fd >= 0) {
+        ::close(tcp_fd);
+        tcp_fd = -1;
+    }
+
+    if (udp_fd >= 0) {
+        ::close(udp_fd);
+        udp_fd = -1;
+    }
+
+    if (unix_fd >= 0) {
+        ::close(unix_fd);
+        ::unlink(unix_path.c_str());
+        unix_fd = -1;
+    }
+
+    routes.clear();
+}
+
+void MAVLinkRouter::route()
+{
+    if (autopilot == NULL) {
+        return;
+    }
+
+    if (tcp_fd >= 0) {
+        accept_connection(tcp_fd, "TCP");
+    }
+
+    if (unix_fd >= 0) {
+        accept_connection(unix_fd, "Unix");
+    }
+
+    if (udp_fd >= 0) {
+        receive_datagrams();
+    }
+
+    std::vector<int> closed;
+
+    for (std::map<int, Endpoint*>::iterator iter = endpoints.begin(); iter != endpoints.end(); ++iter) {
+        if (!iter->second->datagram && !receive_stream(iter->second)) {
+            closed.push_back(iter->first);
+        } else if (!iter->second->datagram) {
+            flush(iter->second);
+        }
+    }
+
+    for (size_t i = 0; i < closed.size(); i++) {
+        remove_endpoint(closed[i]);
+    }
+
+    // Frames received from the autopilot are forwarded by frame_received(...)
+    mavlink_message_t msg;
+    while (autopilot->data_available() && autopilot->receive_message(msg)) {
+    }
+}
+
+void MAVLinkRouter::frame_received(const MAVLinkFrame& frame)
+{
+    forward(ROUTER_AUTOPILOT_ID, frame);
+}
+
+int MAVLinkRouter::open_tcp_socket(const std::string& address, int port)
+{
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+
+    if (::inet_pton(AF_INET, address.c_str(), &addr.sin_addr) != 1) {
+        syslog(LOG_ERR, "Invalid router address '%s'.", address.c_str());
+        return -1;
+    }
+
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+
+    if (fd < 0) {
+        syslog(LOG_ERR, "Router TCP socket creation failed.");
+        return -1;
+    }
+
+    int reuse = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    if (::bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 ||
+        ::listen(fd, ROUTER_LISTEN_BACKLOG) < 0 || !set_nonblocking(fd)) {
+        syslog(LOG_ERR, "Failed to listen on TCP port %d (%s).", port, strerror(errno));
+        ::close(fd);
+        return -1;
+    }
+
+    syslog(LOG_INFO, "MAVLink router listening on TCP %s:%d.", address.c_str(), port);
+
+    return fd;
+}
+
+int MAVLinkRouter::open_udp_socket(const std::string& address, int port)
+{
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+
+    if (::inet_pton(AF_INET, address.c_str(), &addr.sin_addr) != 1) {
+        syslog(LOG_ERR, "Invalid router address '%s'.", address.c_str());
+        return -1;
+    }
+
+    int fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+
+    if (fd < 0) {
+        syslog(LOG_ERR, "Router UDP socket creation failed.");
+        return -1;
+    }
+
+    if (::bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || !set_nonblocking(fd)) {
+        syslog(LOG_ERR, "Failed to bind UDP port %d (%s).", port, strerror(errno));
+        ::close(fd);
+        return -1;
+    }
+
+    syslog(LOG_INFO, "MAVLink router listening on UDP %s:%d.", address.c_str(), port);
+
+    return fd;
+}
+
+int MAVLinkRouter::open_unix_socket(const std::string& path)
+{
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+
+    if (path.size() >= sizeof(addr.sun_path)) {
+        syslog(LOG_ERR, "Unix socket path '%s' is too long.", path.c_str());
+        return -1;
+    }
+
+    strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if (fd < 0) {
+        syslog(LOG_ERR, "Router Unix socket creation failed.");
+        return -1;
+    }
+
+    ::unlink(path.c_str());
+
+    if (::bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 ||
+        ::listen(fd, ROUTER_LISTEN_BACKLOG) < 0 || !set_nonblocking(fd)) {
+        syslog(LOG_ERR, "Failed to listen on Unix socket '%s' (%s).", path.c_str(), strerror(errno));
+        ::close(fd);
+        return -1;
+    }
+
+    unix_path = path;
+
+    syslog(LOG_INFO, "MAVLink router listening on Unix socket '%s'.", path.c_str());
+
+    return fd;
+}
+
+void MAVLinkRouter::accept_connection(int listen_fd, const char* transport)
+{
+    int fd = ::accept(listen_fd, NULL, NULL);
+
+    if (fd < 0) {
+        return;
+    }
+
+    if (endpoints.size() >= ROUTER_MAX_ENDPOINTS || !set_nonblocking(fd)) {
+        syslog(LOG_WARNING, "MAVLink router rejected %s connection.", transport);
+        ::close(fd);
+        return;
+    }
+
+    Endpoint* endpoint = new Endpoint(next_id++, fd, false);
+    endpoints[endpoint->id] = endpoint;
+
+    syslog(LOG_INFO, "MAVLink router accepted %s connection (endpoint %d).", transport, endpoint->id);
+}
+
+void MAVLinkRouter::receive_datagrams()
+{
+    uint8_t buffer[ROUTER_READ_BUFFER_SIZE];
+    struct sockaddr_storage addr;
+    socklen_t addr_len = sizeof(addr);
+
+    ssize_t n;
+    while ((n = ::recvfrom(udp_fd, buffer, sizeof(buffer), 0, (struct sockaddr*)&addr, &addr_len)) > 0) {
+        Endpoint* endpoint = NULL;
+
+        for (std::map<int, Endpoint*>::iterator iter = endpoints.begin(); iter != endpoints.end(); ++iter) {
+            if (iter->second->datagram && iter->second->addr_len == addr_len &&
+                memcmp(&iter->second->addr, &addr, addr_len) == 0) {
+                endpoint = iter->second;
+                break;
+            }
+        }
+
+        if (endpoint == NULL) {
+            if (endpoints.size() >= ROUTER_MAX_ENDPOINTS) {
+                frames_dropped++;
+                addr_len = sizeof(addr);
+                continue;
+            }
+
+            endpoint = new Endpoint(next_id++, udp_fd, true);
+            memcpy(&endpoint->addr, &addr, addr_len);
+            endpoint->addr_len = addr_len;
+            endpoints[endpoint->id] = endpoint;
+
+            syslog(LOG_INFO, "MAVLink router added UDP peer (endpoint %d).", endpoint->id);
+        }
+
+        parse(endpoint, buffer, n);
+
+        addr_len = sizeof(addr);
+    }
+}
+
+bool MAVLinkRouter::receive_stream(Endpoint* endpoint)
+{
+    uint8_t buffer[ROUTER_READ_BUFFER_SIZE];
+
+    ssize_t n;
+    while ((n = ::recv(endpoint->fd, buffer, sizeof(buffer), 0)) > 0) {
+        parse(endpoint, buffer, n);
+    }
+
+    if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+        syslog(LOG_INFO, "MAVLink router endpoint %d disconnected.", endpoint->id);
+        return false;
+    }
+
+    return true;
+}
+
+/*
+ * Sends the rest of the frame partially accepted by the stream endpoint.
+ *
+ * Returns true if no bytes are pending.
+ */
+bool MAVLinkRouter::flush(Endpoint* endpoint)
+{
+    if (endpoint->tx_pending.empty()) {
+        return true;
+    }
+
+    ssize_t n = ::send(endpoint->fd, endpoint->tx_pending.data(), endpoint->tx_pending.size(), MSG_NOSIGNAL);
+
+    if (n > 0) {
+        endpoint->tx_pending.erase(endpoint->tx_pending.begin(), endpoint->tx_pending.begin() + n);
+    }
+
+    return endpoint->tx_pending.empty();
+}
+
+void MAVLinkRouter::parse(Endpoint* endpoint, const uint8_t* data, size_t size)
+{
+    std::vector<MAVLinkFrame> frames;
+
+    endpoint->parser.feed(data, size, frames);
+
+    for (size_t i = 0; i < frames.size(); i++) {
+        endpoint->frames_in++;
+        forward(endpoint->id, frames[i]);
+    }
+}
+
+void MAVLinkRouter::remove_endpoint(int id)
+{
+    std::map<int, Endpoint*>::iterator iter = endpoints.find(id);
+
+    if (iter == endpoints.end()) {
+        return;
+    }
+
+    for (std::map<uint16_t, int>::iterator route = routes.begin(); route != routes.end(); ) {
+        if (route->second == id) {
+            routes.erase(route++);
+        } else {
+            ++route;
+        }
+    }
+
+    if (!iter->second->datagram) {
+        ::close(iter->second->fd);
+    }
+
+    delete iter->second;
+    endpoints.erase(iter);
+}
+
+void MAVLinkRouter::forward(int source_id, const MAVLinkFrame& frame)
+{
+    routes[ROUTE_KEY(frame.sysid(), frame.compid())] = source_id;
+
+    uint8_t target_system = 0, target_component = 0;
+    bool targeted = get_target(frame, target_system, target_component) && target_system != 0;
+
+    std::vector<int> targets;
+
+    if (!targeted) {
+        if (source_id != ROUTER_AUTOPILOT_ID) {
+            targets.push_back(ROUTER_AUTOPILOT_ID);
+        }
+
+        for (std::map<int, Endpoint*>::iterator iter = endpoints.begin(); iter != endpoints.end(); ++iter) {
+            if (iter->first != source_id) {
+                targets.push_back(iter->first);
+            }
+        }
+    } else {
+        bool known = false;
+
+        for (std::map<uint16_t, int>::iterator route = routes.begin(); route != routes.end(); ++route) {
+            if ((route->first >> 8) != target_system ||
+                (target_component != 0 && (route->first & 0xFF) != target_component)) {
+                continue;
+            }
+
+            known = true;
+
+            if (route->second != source_id &&
+                std::find(targets.begin(), targets.end(), route->second) == targets.end()) {
+                targets.push_back(route->second);
+            }
+        }
+
+        if (!known && source_id != ROUTER_AUTOPILOT_ID) {
+            // Systems not seen yet are assumed to be behind the autopilot's serial link
+            targets.push_back(ROUTER_AUTOPILOT_ID);
+        }
+
+        if (targets.empty()) {
+            frames_dropped++;
+            MAVLinkLogger::log(LOG_DEBUG, "ROUTE DROPPED", frame);
+            return;
+        }
+    }
+
+    for (size_t i = 0; i < targets.size(); i++) {
+        if (!send_to(targets[i], frame)) {
+            frames_dropped++;
+        }
+    }
+}
+
+bool MAVLinkRouter::send_to(int endpoint_id, const MAVLinkFrame& frame)
+{
+    if (endpoint_id == ROUTER_AUTOPILOT_ID) {
+        return autopilot->forward_frame(frame);
+    }
+
+    std::map<int, Endpoint*>::iterator iter = endpoints.find(endpoint_id);
+
+    if (iter == endpoints.end()) {
+        return false;
+    }
+
+    Endpoint* endpoint = iter->second;
+
+    ssize_t n;
+    if (endpoint->datagram) {
+        n = ::sendto(endpoint->fd, frame.data(), frame.size(), 0,
+                     (struct sockaddr*)&endpoint->addr, endpoint->addr_len);
+    } else if (flush(endpoint)) {
+        // Slow stream endpoints lose whole frames instead of blocking the router.
+        // The rest of a frame partially accepted by the socket is sent before
+        // the next frames, so the stream stays in sync.
+        n = ::send(endpoint->fd, frame.data(), frame.size(), MSG_NOSIGNAL);
+
+        if (n > 0 && n < frame.size()) {
+            endpoint->tx_pending.assign(frame.data() + n, frame.data() + frame.size());
+            n = frame.size();
+        }
+    } else {
+        n = -1;
+    }
+
+    if (n != frame.size()) {
+        return false;
+    }
+
+    endpoint->frames_out++;
+
+    return true;
+}
+
+bool MAVLinkRouter::get_target(const MAVLinkFrame& frame, uint8_t& target_system, uint8_t& target_component)
+{
+    switch (frame.msgid()) {
+    TARGET_CASE(COMMAND_INT, command_int)
+    TARGET_CASE(COMMAND_LONG, command_long)
+    TARGET_CASE(FILE_TRANSFER_PROTOCOL, file_transfer_protocol)
+    TARGET_CASE(GPS_INJECT_DATA, gps_inject_data)
+    TARGET_CASE(LOG_ERASE, log_erase)
+    TARGET_CASE(LOG_REQUEST_DATA, log_request_data)
+    TARGET_CASE(LOG_REQUEST_END, log_request_end)
+    TARGET_CASE(LOG_REQUEST_LIST, log_request_list)
+    TARGET_CASE(MISSION_ACK, mission_ack)
+    TARGET_CASE(MISSION_CLEAR_ALL, mission_clear_all)
+    TARGET_CASE(MISSION_COUNT, mission_count)
+    TARGET_CASE(MISSION_ITEM, mission_item)
+    TARGET_CASE(MISSION_ITEM_INT, mission_item_int)
+    TARGET_CASE(MISSION_REQUEST, mission_request)
+    TARGET_CASE(MISSION_REQUEST_INT, mission_request_int)
+    TARGET_CASE(MISSION_REQUEST_LIST, mission_request_list)
+    TARGET_CASE(MISSION_REQUEST_PARTIAL_LIST, mission_request_partial_list)
+    TARGET_CASE(MISSION_SET_CURRENT, mission_set_current)
+    TARGET_CASE(MISSION_WRITE_PARTIAL_LIST, mission_write_partial_list)
+    TARGET_CASE(PARAM_MAP_RC, param_map_rc)
+    TARGET_CASE(PARAM_REQUEST_LIST, param_request_list)
+    TARGET_CASE(PARAM_REQUEST_READ, param_request_read)
+    TARGET_CASE(PARAM_SET, param_set)
+    TARGET_CASE(PING, ping)
+    TARGET_CASE(RC_CHANNELS_OVERRIDE, rc_channels_override)
+    TARGET_CASE(REQUEST_DATA_STREAM, request_data_stream)
+    TARGET_CASE(SAFETY_SET_ALLOWED_AREA, safety_set_allowed_area)
+    TARGET_CASE(SET_ACTUATOR_CONTROL_TARGET, set_actuator_control_target)
+    TARGET_CASE(SET_ATTITUDE_TARGET, set_attitude_target)
+    TARGET_CASE(SET_POSITION_TARGET_GLOBAL_INT, set_position_target_global_int)
+    TARGET_CASE(SET_POSITION_TARGET_LOCAL_NED, set_position_target_local_ned)
+    TARGET_CASE(V2_EXTENSION, v2_extension)
+    TARGET_SYSTEM_CASE(CHANGE_OPERATOR_CONTROL, change_operator_control)
+    TARGET_SYSTEM_CASE(SET_GPS_GLOBAL_ORIGIN, set_gps_global_origin)
+    TARGET_SYSTEM_CASE(SET_HOME_POSITION, set_home_position)
+    TARGET_SYSTEM_CASE(SET_MODE, set_mode)
+    case MAVLINK_MSG_ID_MANUAL_CONTROL:
+        target_system = mavlink_msg_manual_control_get_target(&frame.get_message());
+        target_component = 0;
+        return true;
+    default:
+        return false;
+    }
+}
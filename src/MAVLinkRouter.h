@@ -0,0 +1,160 @@
+/*
+ MAVLinkRouter.h
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef MAVLINKROUTER_H_
+#define MAVLINKROUTER_H_
+
+#include <map>
+#include <string>
+#include <sys/socket.h>
+#include "mavlink.h"
+#include "MAVLinkFrame.h"
+#include "MAVLinkParser.h"
+#include "MAVLinkSerial.h"
+
+#define ROUTER_MAX_ENDPOINTS    16
+#define ROUTER_AUTOPILOT_ID     0
+
+/**
+ * Routes MAVLink frames between the autopilot serial link and local
+ * ground stations or companion computers connected over TCP, UDP and
+ * Unix domain sockets.
+ *
+ * The router learns the systems and components behind each endpoint from
+ * the frames received from that endpoint. Frames addressed to a specific
+ * system or component are forwarded only to the endpoints the target was
+ * seen on, broadcast frames are forwarded to all the other endpoints.
+ * Frames are forwarded using their wire bytes and are never re-encoded, so
+ * MAVLink 2 frames, including frames of other dialects, pass through the
+ * router.
+ */
+class MAVLinkRouter : public MAVLinkFrameListener
+{
+    /**
+     * Local endpoint connected to the router.
+     */
+    struct Endpoint {
+        int                     id;
+        int                     fd;         // socket descriptor, shared by all UDP endpoints
+        bool                    datagram;   // true for UDP peers
+        struct sockaddr_storage addr;       // peer address of UDP endpoints
+        socklen_t               addr_len;
+        MAVLinkParser           parser;     // parser of the endpoint's stream
+        std::vector<uint8_t>    tx_pending; // unsent bytes of a frame partially accepted by a stream endpoint
+        unsigned long           frames_in;
+        unsigned long           frames_out;
+
+        Endpoint(int id, int fd, bool datagram);
+    };
+
+    MAVLinkSerial*              autopilot;
+    int                         tcp_fd;
+    int                         udp_fd;
+    int                         unix_fd;
+    std::string                 unix_path;
+    int                         next_id;
+    std::map<int, Endpoint*>    endpoints;
+    std::map<uint16_t, int>     routes;     // (sysid << 8 | compid) -> endpoint id
+    unsigned long               frames_dropped;
+
+public:
+    /**
+     * Constructs an inactive router.
+     */
+    MAVLinkRouter();
+
+    /**
+     * Closes all the sockets.
+     */
+    virtual ~MAVLinkRouter();
+
+    /**
+     * Starts listening for local connections. Empty address, zero port or empty
+     * Unix socket path disable the corresponding transport. The router registers
+     * itself as frame listener of the autopilot channel.
+     *
+     * Returns true if at least one of the transports was initialized.
+     */
+    bool init(MAVLinkSerial* autopilot, const std::string& address,
+              int tcp_port, int udp_port, const std::string& unix_socket);
+
+    /**
+     * Closes all the sockets and detaches from the autopilot channel.
+     */
+    void close();
+
+    /**
+     * Returns true if the router was initialized.
+     */
+    inline bool is_active() const { return autopilot != NULL; };
+
+    /**
+     * Accepts new connections, reads the frames available from the local endpoints
+     * and from the autopilot, and forwards them according to the routing table.
+     *
+     * The call does not block.
+     */
+    void route();
+
+    /**
+     * Forwards the frame received from the autopilot to the local endpoints.
+     */
+    void frame_received(const MAVLinkFrame& frame);
+
+    /**
+     * Returns the number of frames dropped because their target was unknown
+     * or the endpoint could not accept them.
+     */
+    inline unsigned long get_frames_dropped() const { return frames_dropped; };
+
+private:
+    int  open_tcp_socket(const std::string& address, int port);
+    int  open_udp_socket(const std::string& address, int port);
+    int  open_unix_socket(const std::string& path);
+
+    void accept_connection(int listen_fd, const char* transport);
+    void receive_datagrams();
+    bool receive_stream(Endpoint* endpoint);
+    bool flush(Endpoint* endpoint);
+    void parse(Endpoint* endpoint, const uint8_t* data, size_t size);
+    void remove_endpoint(int id);
+
+    /**
+     * Learns the route to the frame source and forwards the frame.
+     */
+    void forward(int source_id, const MAVLinkFrame& frame);
+
+    /**
+     * Sends the frame to the endpoint or to the autopilot.
+     */
+    bool send_to(int endpoint_id, const MAVLinkFrame& frame);
+
+    /**
+     * Retrieves target system and component of the frame.
+     * The payload is decoded only for messages that have target fields.
+     *
+     * Returns false if the message does not have target fields.
+     */
+    static bool get_target(const MAVLinkFrame& frame, uint8_t& target_system, uint8_t& target_component);
+};
+
+#endif /* MAVLINKROUTER_H_ */
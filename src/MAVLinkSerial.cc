@@ -22,17 +22,21 @@
 
 #include "MAVLinkSerial.h"
 #include "MAVLinkLogger.h"
-#include <chrono>
+#include "MAVLinkTlog.h"
+#include "Metrics.h"
+#include "Stopwatch.h"
+#include "Clock.h"
+#include <deque>
 #include <unistd.h>
 #include <stdio.h>
 #include <syslog.h>
 #include <limits.h>
 
 using namespace std;
-using namespace std::chrono;
 
 MAVLinkSerial::MAVLinkSerial() :
-    MAVLinkChannel("serial"), serial(), timeout(1000)
+    MAVLinkChannel("serial"), serial_device(), serial(&serial_device), timeout(1000), listeners(),
+    received_frames(), next_frame(0), capabilities(0)
 {
 }
 
@@ -46,6 +50,8 @@ bool MAVLinkSerial::detect_autopilot(const string device)
         return false;
     }
 
+    capabilities = autopilot_version.capabilities;
+
     char buff[64];
     get_firmware_version(autopilot_version, buff, sizeof(buff));
 
@@ -59,12 +65,14 @@ bool MAVLinkSerial::init(const string& path, int speed, const vector<string>& de
 {
     syslog(LOG_NOTICE, "Connecting to autopilot (%s %d)...", path.data(), speed);
 
-    if (serial.open(path, speed) == 0) {
+    serial = &serial_device;
+
+    if (serial->open(path, speed) == 0) {
         if (detect_autopilot(path)) {
             return true;
         }
 
-        serial.close();
+        serial->close();
     } else {
         syslog(LOG_WARNING, "Failed to open serial device '%s'.", path.data());
     }
@@ -75,27 +83,42 @@ bool MAVLinkSerial::init(const string& path, int speed, const vector<string>& de
             if (devices[i] == path)
                 continue;
 
-            if (serial.open(devices[i], speed) == 0) {
+            if (serial->open(devices[i], speed) == 0) {
                 if (detect_autopilot(devices[i].data())) {
                     return true;
                 }
 
-                serial.close();
+                serial->close();
             } else {
                 syslog(LOG_DEBUG, "Failed to open serial device '%s'.", devices[i].data());
             }
         }
     }
 
-    serial.open(path, speed);
+    serial->open(path, speed);
     syslog(LOG_ERR, "Autopilot was not detected on any of the serial devices.");
 
     return false;
 }
 
+bool MAVLinkSerial::init(Serial& device)
+{
+    syslog(LOG_NOTICE, "Connecting to autopilot (%s)...", device.get_path().data());
+
+    serial = &device;
+
+    if (detect_autopilot(device.get_path())) {
+        return true;
+    }
+
+    syslog(LOG_ERR, "Autopilot was not detected at '%s'.", device.get_path().data());
+
+    return false;
+}
+
 void MAVLinkSerial::close()
 {
-    serial.close();
+    serial->close();
 }
 
 bool MAVLinkSerial::request_autopilot_version(uint8_t& autopilot, uint8_t& mav_type, uint8_t& sys_id, mavlink_autopilot_version_t& autopilot_version)
@@ -104,8 +127,7 @@ bool MAVLinkSerial::request_autopilot_version(uint8_t& autopilot, uint8_t& mav_t
     autopilot = mav_type = sys_id = 0;
     memset(&autopilot_version, 0, sizeof(autopilot_version));
 
-    for (high_resolution_clock::time_point start = high_resolution_clock::now();
-         duration_cast<milliseconds>(high_resolution_clock::now() - start).count() < MAX_HEARTBEAT_INTERVAL; ) {
+    for (uint64_t deadline = Clock::now() + MAX_HEARTBEAT_INTERVAL * NSEC_PER_MSEC; Clock::now() < deadline; ) {
         if (receive_message(msg)) {
              if (msg.msgid == MAVLINK_MSG_ID_HEARTBEAT) {
                 autopilot = mavlink_msg_heartbeat_get_autopilot(&msg);
@@ -117,7 +139,7 @@ bool MAVLinkSerial::request_autopilot_version(uint8_t& autopilot, uint8_t& mav_t
             }
         }
 
-        usleep(RECEIVE_RETRY_DELAY * 1000);
+        Clock::sleep(RECEIVE_RETRY_DELAY * NSEC_PER_MSEC);
     }
 
     //Return false if heartbeat message was not received
@@ -146,7 +168,7 @@ bool MAVLinkSerial::request_autopilot_version(uint8_t& autopilot, uint8_t& mav_t
             syslog(LOG_DEBUG, "Failed to send message to autopilot.\n");
         }
 
-        usleep(RECEIVE_RETRY_DELAY * 1000);
+        Clock::sleep(RECEIVE_RETRY_DELAY * NSEC_PER_MSEC);
     }
 
     return true;
@@ -177,17 +199,26 @@ bool MAVLinkSerial::send_message(const mavlink_message_t& msg)
        return true;
     }
 
-    uint8_t buf[MAVLINK_MAX_PACKET_LEN];
+    return send_frame(MAVLinkFrame(msg));
+}
+
+bool MAVLinkSerial::send_frame(const MAVLinkFrame& frame)
+{
+    if (frame.empty()) {
+       return true;
+    }
 
-    //Copy the message to send buffer
-    uint16_t len = mavlink_msg_to_send_buffer(buf, &msg);
+    uint16_t len = frame.size();
 
-    uint16_t n = serial.write(buf, len);
+    uint16_t n = serial->write(frame.data(), len);
 
     if (n == len) {
-        MAVLinkLogger::log(LOG_INFO, "MAV <<", msg);
+        MAVLinkLogger::log(LOG_INFO, "MAV <<", frame);
+        MAVLinkTlog::record(frame);
+        metrics.frame_sent(frame);
     } else {
-        MAVLinkLogger::log(LOG_WARNING, "MAV << FAILED", msg);
+        MAVLinkLogger::log(LOG_WARNING, "MAV << FAILED", frame);
+        metrics.send_failed();
     }
 
     return n == len;
@@ -195,25 +226,60 @@ bool MAVLinkSerial::send_message(const mavlink_message_t& msg)
 
 bool MAVLinkSerial::receive_message(mavlink_message_t& msg)
 {
-    mavlink_status_t mavlink_status;
+    MAVLinkFrame frame;
+
+    if (!receive_frame(frame)) {
+        return false;
+    }
 
-    // Receive data from stream
-    //serial.listen();
+    msg = frame.get_message();
+    return true;
+}
 
-    int c = serial.read();
+bool MAVLinkSerial::receive_frame(MAVLinkFrame& frame)
+{
+    while (next_frame >= received_frames.size()) {
+        received_frames.clear();
+        next_frame = 0;
 
-    while (c >= 0) {
-        //Serial.println(c);
+        uint8_t buffer[SERIAL_READ_BUFFER_SIZE];
 
-        if (mavlink_parse_char(MAVLINK_COMM_0, c, &msg, &mavlink_status)) {
-            MAVLinkLogger::log(LOG_DEBUG, "MAV >>", msg);
-            return true;
+        int n = serial->read(buffer, sizeof(buffer));
+
+        if (n <= 0) {
+            return false;
         }
 
-        c = serial.read();
+        parser.feed(buffer, n, received_frames);
+        metrics.update(parser);
     }
 
-    return false;
+    frame = received_frames[next_frame++];
+
+    MAVLinkLogger::log(LOG_DEBUG, "MAV >>", frame);
+    MAVLinkTlog::record(frame);
+    metrics.frame_received(frame);
+
+    for (size_t i = 0; i < listeners.size(); i++) {
+        listeners[i]->frame_received(frame);
+    }
+
+    return true;
+}
+
+void MAVLinkSerial::add_frame_listener(MAVLinkFrameListener* listener)
+{
+    listeners.push_back(listener);
+}
+
+void MAVLinkSerial::remove_frame_listener(MAVLinkFrameListener* listener)
+{
+    for (vector<MAVLinkFrameListener*>::iterator iter = listeners.begin(); iter != listeners.end(); ++iter) {
+        if (*iter == listener) {
+            listeners.erase(iter);
+            break;
+        }
+    }
 }
 
 bool MAVLinkSerial::message_available()
@@ -221,65 +287,324 @@ bool MAVLinkSerial::message_available()
     return true;
 }
 
+bool MAVLinkSerial::data_available()
+{
+    return next_frame < received_frames.size() || serial->available() > 0;
+}
+
+bool MAVLinkSerial::forward_frame(const MAVLinkFrame& frame)
+{
+    if (frame.empty()) {
+       return true;
+    }
+
+    uint16_t len = frame.size();
+
+    uint16_t n = serial->write(frame.data(), len);
+
+    if (n == len) {
+        MAVLinkLogger::log(LOG_DEBUG, "MAV <<", frame);
+        MAVLinkTlog::record(frame);
+        metrics.frame_sent(frame);
+    } else {
+        MAVLinkLogger::log(LOG_WARNING, "MAV << FAILED", frame);
+        metrics.send_failed();
+    }
+
+    return n == len;
+}
+
 bool MAVLinkSerial::send_receive_message(const mavlink_message_t& msg, mavlink_message_t& ack)
+{
+    MAVLinkFrame ack_frame;
+
+    bool ret = send_receive_frame(MAVLinkFrame(msg), ack_frame);
+
+    ack = ack_frame.get_message();
+
+    return ret;
+}
+
+bool MAVLinkSerial::send_receive_frame(const MAVLinkFrame& frame, MAVLinkFrame& ack)
 {
     for (int i = 0; i < SEND_RETRIES; i++) {
-        if (send_message(msg)) {
-            if (msg.msgid != MAVLINK_MSG_ID_COMMAND_LONG &&
-                msg.msgid != MAVLINK_MSG_ID_COMMAND_INT &&
-                msg.msgid != MAVLINK_MSG_ID_MISSION_ITEM &&
-                msg.msgid != MAVLINK_MSG_ID_PARAM_SET) {
+        if (send_frame(frame)) {
+            if (frame.msgid() != MAVLINK_MSG_ID_COMMAND_LONG &&
+                frame.msgid() != MAVLINK_MSG_ID_COMMAND_INT &&
+                frame.msgid() != MAVLINK_MSG_ID_MISSION_ITEM &&
+                frame.msgid() != MAVLINK_MSG_ID_PARAM_SET) {
                 return false;
             }
 
-            if (receive_ack(msg, ack)) {
+            if (receive_ack(frame, ack)) {
                 return true;
             }
         }
     }
 
-    return compose_failed_ack(msg, ack);
+    mavlink_message_t failed_ack;
+
+    bool ret = compose_failed_ack(frame.get_message(), failed_ack);
+
+    ack = MAVLinkFrame(failed_ack);
+
+    return ret;
+}
+
+bool MAVLinkSerial::send_mission(const mavlink_message_t& mission_count, const vector<mavlink_mission_item_int_t>& items, mavlink_message_t& ack)
+{
+    MAVLinkMissionUpload upload;
+    mavlink_message_t msg, reply;
+    Stopwatch upload_time;
+
+    upload.start(mission_count.sysid, mission_count.compid,
+                 mavlink_msg_mission_count_get_target_system(&mission_count),
+                 mavlink_msg_mission_count_get_target_component(&mission_count),
+                 items, (capabilities & MAV_PROTOCOL_CAPABILITY_MISSION_INT) != 0, msg);
+
+    ack.len = ack.msgid = 0;
+
+    send_message(msg);
+
+    while (upload.in_progress()) {
+        if (receive_message(msg)) {
+            if (upload.handle_message(msg, reply)) {
+                send_message(reply);
+            } else if (msg.msgid == MAVLINK_MSG_ID_MISSION_ACK && !upload.in_progress()) {
+                ack = msg;
+            }
+        }
+
+        if (upload.check_timeout(Clock::now(), reply)) {
+            send_message(reply);
+        }
+    }
+
+    syslog(LOG_INFO, "%d mission items uploaded in %.3f seconds, %lu items sent again.",
+           (int)items.size(), upload_time.elapsed_time(), upload.get_items_resent());
+
+    Metrics::counter("mission_items_sent_total", "", "Number of mission items sent to the autopilot.").inc(upload.get_items_sent());
+    Metrics::counter("mission_items_resent_total", "", "Number of mission items sent to the autopilot more than once.").inc(upload.get_items_resent());
+
+    if (ack.msgid != MAVLINK_MSG_ID_MISSION_ACK) {
+        mavlink_mission_ack_t mission_ack;
+        mission_ack.target_system = mission_count.sysid;
+        mission_ack.target_component = mission_count.compid;
+        mission_ack.type = upload.get_result();
+        mavlink_msg_mission_ack_encode(ARDUPILOT_SYSTEM_ID, ARDUPILOT_COMPONENT_ID, &ack, &mission_ack);
+    }
+
+    return true;
+}
+
+bool MAVLinkSerial::receive_mission(vector<mavlink_mission_item_int_t>& items)
+{
+    bool item_int = (capabilities & MAV_PROTOCOL_CAPABILITY_MISSION_INT) != 0;
+    int count = -1;
+    size_t seq = 0;
+    int retries = 0;
+    mavlink_message_t msg;
+    Stopwatch download_time;
+
+    items.clear();
+
+    while (count < 0 || seq < (size_t)count) {
+        if (retries++ > MISSION_UPLOAD_RETRIES) {
+            syslog(LOG_WARNING, "Autopilot stopped responding to mission download.");
+            return false;
+        }
+
+        if (count < 0) {
+            mavlink_msg_mission_request_list_pack(SYSTEM_ID, COMPONENT_ID, &msg, ARDUPILOT_SYSTEM_ID, ARDUPILOT_COMPONENT_ID);
+        } else if (item_int) {
+            mavlink_msg_mission_request_int_pack(SYSTEM_ID, COMPONENT_ID, &msg, ARDUPILOT_SYSTEM_ID, ARDUPILOT_COMPONENT_ID, seq);
+        } else {
+            mavlink_msg_mission_request_pack(SYSTEM_ID, COMPONENT_ID, &msg, ARDUPILOT_SYSTEM_ID, ARDUPILOT_COMPONENT_ID, seq);
+        }
+
+        send_message(msg);
+
+        for (uint64_t deadline = Clock::now() + MISSION_ITEM_TIMEOUT * NSEC_PER_MSEC; Clock::now() < deadline;) {
+            if (!receive_message(msg)) {
+                continue;
+            }
+
+            if (count < 0 && msg.msgid == MAVLINK_MSG_ID_MISSION_COUNT &&
+                mavlink_msg_mission_count_get_target_system(&msg) == SYSTEM_ID) {
+                count = mavlink_msg_mission_count_get_count(&msg);
+                items.resize(count);
+                retries = 0;
+                break;
+            }
+
+            if (count >= 0 && msg.msgid == MAVLINK_MSG_ID_MISSION_ITEM_INT &&
+                mavlink_msg_mission_item_int_get_target_system(&msg) == SYSTEM_ID &&
+                mavlink_msg_mission_item_int_get_seq(&msg) == seq) {
+                mavlink_msg_mission_item_int_decode(&msg, &items[seq++]);
+                retries = 0;
+                break;
+            }
+
+            if (count >= 0 && msg.msgid == MAVLINK_MSG_ID_MISSION_ITEM &&
+                mavlink_msg_mission_item_get_target_system(&msg) == SYSTEM_ID &&
+                mavlink_msg_mission_item_get_seq(&msg) == seq) {
+                mavlink_mission_item_t item;
+                mavlink_msg_mission_item_decode(&msg, &item);
+                MAVLinkMissionUpload::to_item_int(item, items[seq++]);
+                retries = 0;
+                break;
+            }
+        }
+    }
+
+    mavlink_msg_mission_ack_pack(SYSTEM_ID, COMPONENT_ID, &msg, ARDUPILOT_SYSTEM_ID, ARDUPILOT_COMPONENT_ID, MAV_MISSION_ACCEPTED);
+    send_message(msg);
+
+    syslog(LOG_INFO, "%d mission items downloaded in %.3f seconds.", count, download_time.elapsed_time());
+
+    return true;
+}
+
+bool MAVLinkSerial::receive_params(vector<mavlink_param_value_t>& params)
+{
+    vector<bool> received;
+    size_t missing = 0;
+    mavlink_message_t msg;
+    mavlink_param_value_t value;
+    Stopwatch load_time;
+
+    params.clear();
+
+    // Receive the parameters streamed in response to PARAM_REQUEST_LIST
+    for (int i = 0; i <= PARAM_LOAD_RETRIES && received.empty(); i++) {
+        mavlink_msg_param_request_list_pack(SYSTEM_ID, COMPONENT_ID, &msg, ARDUPILOT_SYSTEM_ID, ARDUPILOT_COMPONENT_ID);
+        send_message(msg);
+
+        for (uint64_t deadline = Clock::now() + PARAM_VALUE_TIMEOUT * NSEC_PER_MSEC;
+             Clock::now() < deadline && (received.empty() || missing > 0);) {
+            if (!receive_message(msg) || msg.msgid != MAVLINK_MSG_ID_PARAM_VALUE) {
+                continue;
+            }
+
+            mavlink_msg_param_value_decode(&msg, &value);
+
+            if (received.empty()) {
+                params.resize(value.param_count);
+                received.assign(value.param_count, false);
+                missing = value.param_count;
+            }
+
+            if (value.param_count == received.size() && value.param_index < received.size() &&
+                !received[value.param_index]) {
+                received[value.param_index] = true;
+                params[value.param_index] = value;
+                missing--;
+            }
+
+            deadline = Clock::now() + PARAM_VALUE_TIMEOUT * NSEC_PER_MSEC;
+        }
+    }
+
+    // Request the missing parameters by index keeping PARAM_READ_WINDOW requests in flight
+    deque<uint16_t> requests;
+    deque<pair<uint16_t, uint64_t> > in_flight; // requested indices and request times
+    vector<int> attempts(received.size(), 0);
+
+    for (size_t i = 0; i < received.size(); i++) {
+        if (!received[i]) {
+            requests.push_back(i);
+        }
+    }
+
+    bool exhausted = false;
+
+    while (missing > 0 && !exhausted) {
+        while (!requests.empty() && in_flight.size() < PARAM_READ_WINDOW) {
+            char param_id[MAVLINK_MSG_PARAM_VALUE_FIELD_PARAM_ID_LEN] = {};
+            mavlink_msg_param_request_read_pack(SYSTEM_ID, COMPONENT_ID, &msg, ARDUPILOT_SYSTEM_ID, ARDUPILOT_COMPONENT_ID,
+                                                param_id, requests.front());
+            send_message(msg);
+
+            attempts[requests.front()]++;
+            in_flight.push_back(make_pair(requests.front(), Clock::now()));
+            requests.pop_front();
+        }
+
+        uint64_t now = Clock::now();
+
+        while (!in_flight.empty() && (received[in_flight.front().first] ||
+               in_flight.front().second + PARAM_READ_TIMEOUT * NSEC_PER_MSEC <= now)) {
+            uint16_t index = in_flight.front().first;
+
+            if (!received[index]) {
+                if (attempts[index] > PARAM_LOAD_RETRIES) {
+                    exhausted = true;
+                    break;
+                }
+
+                requests.push_back(index);
+            }
+
+            in_flight.pop_front();
+        }
+
+        if (!receive_message(msg) || msg.msgid != MAVLINK_MSG_ID_PARAM_VALUE) {
+            continue;
+        }
+
+        mavlink_msg_param_value_decode(&msg, &value);
+
+        if (value.param_count == received.size() && value.param_index < received.size() &&
+            !received[value.param_index]) {
+            received[value.param_index] = true;
+            params[value.param_index] = value;
+            missing--;
+        }
+    }
+
+    if (received.empty() || missing > 0) {
+        syslog(LOG_WARNING, "Failed to load autopilot parameters, %d of %d received.",
+               (int)(received.size() - missing), (int)received.size());
+        return false;
+    }
+
+    syslog(LOG_INFO, "%d parameters loaded in %.3f seconds.", (int)params.size(), load_time.elapsed_time());
+
+    return true;
 }
 
-bool MAVLinkSerial::receive_ack(const mavlink_message_t& msg, mavlink_message_t& ack)
+bool MAVLinkSerial::receive_ack(const MAVLinkFrame& frame, MAVLinkFrame& ack)
 {
     for (int i = 0; i < RECEIVE_RETRIES; i++) {
-        switch (msg.msgid) {
+        switch (frame.msgid()) {
         case MAVLINK_MSG_ID_COMMAND_LONG:
         case MAVLINK_MSG_ID_COMMAND_INT:
-            if (receive_message(ack) && ack.msgid == MAVLINK_MSG_ID_COMMAND_ACK) {
-                //Repackage the message to get around problems with CRC mismatch
-                mavlink_command_ack_t command_ack;
-                command_ack.command = mavlink_msg_command_ack_get_command(&ack);
-                command_ack.result  = mavlink_msg_command_ack_get_result(&ack);
-                mavlink_msg_command_ack_encode(ARDUPILOT_SYSTEM_ID, ARDUPILOT_COMPONENT_ID, &ack, &command_ack);
-                //ack.seq = seq++;
+            if (receive_frame(ack) && ack.msgid() == MAVLINK_MSG_ID_COMMAND_ACK) {
                 return true;
             }
             break;
         case MAVLINK_MSG_ID_MISSION_ITEM:
-            if (receive_message(ack) && (ack.msgid == MAVLINK_MSG_ID_MISSION_ACK || ack.msgid == MAVLINK_MSG_ID_MISSION_REQUEST)) {
-                //Repackage the message to get around problems with CRC mismatch
-                mavlink_mission_ack_t missionAck;
-                missionAck.target_system = msg.sysid;
-                missionAck.target_component = msg.compid;
-                missionAck.type = mavlink_msg_mission_ack_get_type(&ack);
-                mavlink_msg_mission_ack_encode(ARDUPILOT_SYSTEM_ID, ARDUPILOT_COMPONENT_ID, &ack, &missionAck);
-                //ack.seq = seq++;
-                return true;
+            if (receive_frame(ack)) {
+                if (ack.msgid() == MAVLINK_MSG_ID_MISSION_ACK) {
+                    return true;
+                }
+
+                if (ack.msgid() == MAVLINK_MSG_ID_MISSION_REQUEST) {
+                    // Request for the next item means that the item was accepted
+                    mavlink_mission_ack_t mission_ack;
+                    mission_ack.target_system = frame.sysid();
+                    mission_ack.target_component = frame.compid();
+                    mission_ack.type = MAV_MISSION_ACCEPTED;
+
+                    mavlink_message_t msg;
+                    mavlink_msg_mission_ack_encode(ARDUPILOT_SYSTEM_ID, ARDUPILOT_COMPONENT_ID, &msg, &mission_ack);
+                    ack = MAVLinkFrame(msg);
+                    return true;
+                }
             }
             break;
         case MAVLINK_MSG_ID_PARAM_SET:
-            if (receive_message(ack) && ack.msgid == MAVLINK_MSG_ID_PARAM_VALUE) {
-                //Repackage the message to get around problems with CRC mismatch
-                mavlink_param_value_t param_value;
-                param_value.param_type = mavlink_msg_param_value_get_param_type(&ack);
-                param_value.param_count = mavlink_msg_param_value_get_param_count(&ack);
-                param_value.param_index = mavlink_msg_param_value_get_param_index(&ack);
-                mavlink_msg_param_value_get_param_id(&ack, param_value.param_id);
-                param_value.param_value = mavlink_msg_param_set_get_param_value(&msg);
-                mavlink_msg_param_value_encode(ARDUPILOT_SYSTEM_ID, ARDUPILOT_COMPONENT_ID, &ack, &param_value);
-                //ack.seq = seq++;
+            if (receive_frame(ack) && ack.msgid() == MAVLINK_MSG_ID_PARAM_VALUE) {
                 return true;
             }
             break;
@@ -287,7 +612,7 @@ bool MAVLinkSerial::receive_ack(const mavlink_message_t& msg, mavlink_message_t&
             return false;
         }
 
-        usleep(RECEIVE_RETRY_DELAY * 1000);
+        Clock::sleep(RECEIVE_RETRY_DELAY * NSEC_PER_MSEC);
     }
 
     return false;
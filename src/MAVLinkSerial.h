@@ -26,6 +26,7 @@
 #include "Serial.h"
 #include "mavlink.h"
 #include "MAVLinkChannel.h"
+#include "MAVLinkMissionUpload.h"
 
 #define SYSTEM_ID               255
 #define COMPONENT_ID            1
@@ -40,13 +41,25 @@
 
 #define MAX_HEARTBEAT_INTERVAL  2000 //ms
 
+#define PARAM_VALUE_TIMEOUT     1000 //ms to wait for the next PARAM_VALUE while loading parameters
+#define PARAM_LOAD_RETRIES      5    //times a missing parameter is requested again
+#define PARAM_READ_TIMEOUT      200  //ms to wait for PARAM_VALUE in response to PARAM_REQUEST_READ
+#define PARAM_READ_WINDOW       16   //PARAM_REQUEST_READ messages in flight
+
+#define SERIAL_READ_BUFFER_SIZE 256
+
 /**
  * MAVLinkSerial is used to send and receive MAVLink messages to/from a serial interface.
  */
 class MAVLinkSerial : public MAVLinkChannel
 {
-    Serial         serial;
-    unsigned long  timeout;       // number of milliseconds to wait for the next char before aborting timed read
+    Serial                serial_device;
+    Serial*               serial;        // serial_device or the device passed to init(Serial&)
+    unsigned long         timeout;       // number of milliseconds to wait for the next char before aborting timed read
+    vector<MAVLinkFrameListener*> listeners; // notified about every frame received from the autopilot
+    vector<MAVLinkFrame>  received_frames; // frames parsed but not returned by receive_frame(...) yet
+    size_t                next_frame;
+    uint64_t              capabilities;  // MAV_PROTOCOL_CAPABILITY flags reported by the autopilot
 
 public:
 
@@ -60,6 +73,14 @@ public:
      */
     bool init(const string& path, int speed, const vector<string>& devices);
 
+    /**
+     * Initializes connection over the specified opened device, such as tlog replay.
+     * The device is not owned by MAVLinkSerial.
+     *
+     * Returns true if autopilot was detected.
+     */
+    bool init(Serial& device);
+
     /**
      * Closes connection to the serial device.
      */
@@ -68,7 +89,12 @@ public:
     /**
      * Returns the path of serial device set by init(...) call.
      */
-    inline string get_path() const { return serial.get_path(); };
+    inline string get_path() const { return serial->get_path(); };
+
+    /**
+     * Returns MAV_PROTOCOL_CAPABILITY flags reported by the autopilot in AUTOPILOT_VERSION message.
+     */
+    inline uint64_t get_capabilities() const { return capabilities; };
 
     /**
      * Sends REQUEST_AUTOPILOT_CAPABILITIES message to the autopilot and
@@ -92,6 +118,13 @@ public:
      */
     bool send_message(const mavlink_message_t& msg);
 
+    /**
+     * Send serialized MAVLink frame to ArduPilot.
+     *
+     * Returns true on success.
+     */
+    bool send_frame(const MAVLinkFrame& frame);
+
     /**
      * Receive MAVLink message from ArduPilot.
      *
@@ -99,11 +132,42 @@ public:
      */
     bool receive_message(mavlink_message_t& msg);
 
+    /**
+     * Receive MAVLink frame from ArduPilot keeping the received bytes.
+     *
+     * Returns true if MAVLink frame was received.
+     */
+    bool receive_frame(MAVLinkFrame& frame);
+
     /**
      * Always returns true.
      */
     bool message_available();
 
+    /**
+     * Returns true if there are bytes received from the autopilot that were not read yet.
+     */
+    bool data_available();
+
+    /**
+     * Adds the listener notified about every frame received from the autopilot.
+     * The listener is not owned by MAVLinkSerial.
+     */
+    void add_frame_listener(MAVLinkFrameListener* listener);
+
+    /**
+     * Removes the listener added by add_frame_listener(...).
+     */
+    void remove_frame_listener(MAVLinkFrameListener* listener);
+
+    /**
+     * Writes the frame received from another MAVLink system to the autopilot as is.
+     * Unlike send_frame(...) the frame is logged at debug level only.
+     *
+     * Returns true on success.
+     */
+    bool forward_frame(const MAVLinkFrame& frame);
+
     /**
      * Retries sending message to ArduPilot until ACK is received.
      *
@@ -111,6 +175,42 @@ public:
      */
     bool send_receive_message(const mavlink_message_t& msg, mavlink_message_t& ack);
 
+    /**
+     * Retries sending frame to ArduPilot until ACK is received.
+     * ACK frames received from ArduPilot are returned as is.
+     *
+     * Returns true if ACK frame was received or composed.
+     */
+    bool send_receive_frame(const MAVLinkFrame& frame, MAVLinkFrame& ack);
+
+    /**
+     * Uploads the mission items to the autopilot on behalf of the sender of
+     * the specified MISSION_COUNT message. The items are sent as requested by
+     * the autopilot's MISSION_REQUEST and MISSION_REQUEST_INT messages.
+     *
+     * Returns true if MISSION_ACK was received or composed.
+     */
+    bool send_mission(const mavlink_message_t& mission_count, const vector<mavlink_mission_item_int_t>& items, mavlink_message_t& ack);
+
+    /**
+     * Downloads the mission items from the autopilot requesting them one by one
+     * right after the previous item is received.
+     *
+     * Returns true if all the mission items were received.
+     */
+    bool receive_mission(vector<mavlink_mission_item_int_t>& items);
+
+    /**
+     * Loads all the parameters of the autopilot. The parameters streamed in
+     * response to PARAM_REQUEST_LIST are received first, then the missing
+     * parameters are requested by index keeping PARAM_READ_WINDOW requests
+     * in flight. Requests not answered in PARAM_READ_TIMEOUT are repeated up
+     * to PARAM_LOAD_RETRIES times.
+     *
+     * Returns true if all the parameters were received.
+     */
+    bool receive_params(vector<mavlink_param_value_t>& params);
+
 private:
 
     /*
@@ -121,11 +221,11 @@ private:
     bool detect_autopilot(const string device);
 
     /**
-     * Receive messages from serial several times until received
-     * COMMAND_ACK for COMMAND_LONG and COMMAND_INT or
-     * MISSION_ACK for MISSION_ITEM message.
+     * Receive frames from serial several times until received
+     * COMMAND_ACK for COMMAND_LONG and COMMAND_INT,
+     * MISSION_ACK for MISSION_ITEM, or PARAM_VALUE for PARAM_SET message.
      */
-    bool receive_ack(const mavlink_message_t& msg, mavlink_message_t& ack);
+    bool receive_ack(const MAVLinkFrame& frame, MAVLinkFrame& ack);
 
     /**
      * Compose an unconfirmed COMMAND_ACK or MISSION_ACK message.
@@ -26,12 +26,13 @@
 #include "MAVLinkTCPChannel.h"
 
 #include "MAVLinkLogger.h"
+#include "MAVLinkTlog.h"
+#include "Clock.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/socket.h>
-#include <sys/poll.h>
 #include <netinet/in.h>
 #include <netdb.h>
 #include <errno.h>
@@ -43,6 +44,11 @@ MAVLinkTCPChannel::MAVLinkTCPChannel() :
 {
 }
 
+MAVLinkTCPChannel::MAVLinkTCPChannel(const std::string& channel_id) :
+        MAVLinkChannel(channel_id), socket_fd(0), timeout(1000), start_millis(0), address(""), port(0)
+{
+}
+
 MAVLinkTCPChannel::~MAVLinkTCPChannel()
 {
 }
@@ -114,22 +120,31 @@ bool MAVLinkTCPChannel::send_message(const mavlink_message_t& msg)
        return true;
     }
 
+    return send_frame(MAVLinkFrame(msg));
+}
+
+bool MAVLinkTCPChannel::send_frame(const MAVLinkFrame& frame)
+{
+    if (frame.empty()) {
+       return true;
+    }
+
     if (socket_fd == 0) {
         init(address, port);
     }
 
-    uint8_t buf[MAVLINK_MAX_PACKET_LEN];
+    uint16_t len = frame.size();
 
-    //Copy the message to send buffer
-    uint16_t len = mavlink_msg_to_send_buffer(buf, &msg);
-
-    uint16_t n = ::send(socket_fd, buf, len, 0);
+    uint16_t n = ::send(socket_fd, frame.data(), len, 0);
 
     if (n == len) {
-        MAVLinkLogger::log(LOG_INFO, "TCP <<", msg);
+        MAVLinkLogger::log(LOG_INFO, "TCP <<", frame);
+        MAVLinkTlog::record(frame);
+        metrics.frame_sent(frame);
     }
     else {
-        MAVLinkLogger::log(LOG_WARNING, "TCP << FAILED", msg);
+        MAVLinkLogger::log(LOG_WARNING, "TCP << FAILED", frame);
+        metrics.send_failed();
         close();
         init(address, port);
     }
@@ -138,6 +153,18 @@ bool MAVLinkTCPChannel::send_message(const mavlink_message_t& msg)
 }
 
 bool MAVLinkTCPChannel::receive_message(mavlink_message_t& msg)
+{
+    MAVLinkFrame frame;
+
+    if (!receive_frame(frame)) {
+        return false;
+    }
+
+    msg = frame.get_message();
+    return true;
+}
+
+bool MAVLinkTCPChannel::receive_frame(MAVLinkFrame& frame)
 {
     if (socket_fd == 0) {
         return false;
@@ -147,33 +174,35 @@ bool MAVLinkTCPChannel::receive_message(mavlink_message_t& msg)
         return false;
     }
 
-    uint8_t stx;
-    int rc = ::recv(socket_fd, &stx, 1, 0);
+    uint8_t buffer[MAVLINK_MAX_PACKET_LEN];
+    int rc = ::recv(socket_fd, buffer, 1, 0);
 
     if (rc > 0) {
-        if (stx != MAVLINK_STX) {
+        if (buffer[0] != MAVLINK_STX) {
             return false;
         }
 
-        uint8_t payload_length;
-        rc = ::recv(socket_fd, &payload_length, 1, 0);
+        rc = ::recv(socket_fd, buffer + 1, 1, 0);
 
         if (rc > 0) {
-            uint8_t buffer[263];
-            rc = ::recv(socket_fd, buffer, payload_length + 6, MSG_WAITALL);
+            uint8_t payload_length = buffer[1];
+            rc = ::recv(socket_fd, buffer + 2, payload_length + 6, MSG_WAITALL);
 
             if (rc > 0) {
-                mavlink_status_t mavlink_status;
+                std::vector<MAVLinkFrame> frames;
 
-                mavlink_parse_char(MAVLINK_COMM_0, stx, &msg, &mavlink_status);
-                mavlink_parse_char(MAVLINK_COMM_0, payload_length, &msg, &mavlink_status);
+                parser.reset();
 
-                for (int i = 0; i < rc; i++) {
-                    if (mavlink_parse_char(MAVLINK_COMM_0, buffer[i], &msg, &mavlink_status)) {
-                        MAVLinkLogger::log(LOG_INFO, "TCP >>", msg);
-                        return true;
-                    }
+                if (parser.feed(buffer, rc + 2, frames) > 0) {
+                    frame = frames[0];
+                    MAVLinkLogger::log(LOG_INFO, "TCP >>", frame);
+                    MAVLinkTlog::record(frame);
+                    metrics.frame_received(frame);
+                    metrics.update(parser);
+                    return true;
                 }
+
+                metrics.update(parser);
             }
         }
     }
@@ -181,7 +210,7 @@ bool MAVLinkTCPChannel::receive_message(mavlink_message_t& msg)
     if (rc < 0) {
         syslog(LOG_ERR, "Failed to receive MAVLink message from socket (errno = %d).", errno);
     } else if (rc == 0) {
-        MAVLinkLogger::log(LOG_WARNING, "TCP >> FAILED (The stream socket peer has performed an orderly shutdown)", msg);
+        syslog(LOG_WARNING, "TCP >> FAILED (The stream socket peer has performed an orderly shutdown)");
         close();
         init(address, port);
     } else {
@@ -197,13 +226,5 @@ bool MAVLinkTCPChannel::message_available()
         return false;
     }
 
-    struct pollfd fds[1];
-    int nfds = 1;
-
-    memset(fds, 0, sizeof(fds));
-
-    fds[0].fd = socket_fd;
-    fds[0].events = POLLIN;
-
-    return ::poll(fds, nfds, POLL_TIMEOUT) > 0;
+    return Clock::wait_readable(socket_fd, POLL_TIMEOUT * NSEC_PER_MSEC) > 0;
 }
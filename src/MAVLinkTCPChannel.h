@@ -48,6 +48,11 @@ public:
      */
     MAVLinkTCPChannel();
 
+    /**
+     * Constructs an instance of MAVLinkTcpClient with the specified channel ID.
+     */
+    MAVLinkTCPChannel(const std::string& channel_id);
+
     /**
      * Closes connection and frees the resources.
      */
@@ -72,6 +77,13 @@ public:
      */
     bool send_message(const mavlink_message_t& msg);
 
+    /**
+     * Sends the specified serialized MAVLink frame to the socket.
+     *
+     * Returns true if the frame was sent successfully.
+     */
+    bool send_frame(const MAVLinkFrame& frame);
+
     /**
      * Receives MAVLink message from the socket.
      *
@@ -79,6 +91,13 @@ public:
      */
     bool receive_message(mavlink_message_t& msg);
 
+    /**
+     * Receives MAVLink frame from the socket keeping the received bytes.
+     *
+     * Returns true if a frame was received.
+     */
+    bool receive_frame(MAVLinkFrame& frame);
+
     /**
      * Checks if data is available in the socket input buffer.
      *
@@ -0,0 +1,265 @@
+/*
+ MAVLinkTlog.cc
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "MAVLinkTlog.h"
+#include "Stopwatch.h"
+#include <syslog.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/time.h>
+#include <algorithm>
+#include <vector>
+
+static std::string  tlog_path;
+static size_t       tlog_max_file_size = 0;
+static int          tlog_max_files = 0;
+static double       tlog_flush_interval = 0;
+static double       tlog_sync_interval = 0;
+
+static int          tlog_fd = -1;
+static size_t       file_size = 0;
+static bool         unsynced = false;
+static uint8_t      buffer[TLOG_BUFFER_SIZE];
+static size_t       buffer_length = 0;
+static Stopwatch    flush_time;
+static Stopwatch    sync_time;
+
+bool MAVLinkTlog::start(const std::string& path, size_t max_file_size, int max_files,
+                        double flush_interval, double sync_interval)
+{
+    if (tlog_fd >= 0) {
+        stop();
+    }
+
+    tlog_path = path;
+    tlog_max_file_size = max_file_size;
+    tlog_max_files = max_files;
+    tlog_flush_interval = flush_interval;
+    tlog_sync_interval = sync_interval;
+
+    return open_file();
+}
+
+void MAVLinkTlog::stop()
+{
+    close_file();
+}
+
+bool MAVLinkTlog::is_active()
+{
+    return tlog_fd >= 0;
+}
+
+void MAVLinkTlog::record(const MAVLinkFrame& frame)
+{
+    if (tlog_fd < 0 || frame.empty()) {
+        return;
+    }
+
+    if (buffer_length + TLOG_TIMESTAMP_SIZE + frame.size() > sizeof(buffer)) {
+        if (!write_buffer() || !rotate()) {
+            return;
+        }
+    }
+
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+
+    uint64_t timestamp = (uint64_t)tv.tv_sec * 1000000ULL + tv.tv_usec;
+
+    for (int i = TLOG_TIMESTAMP_SIZE - 1; i >= 0; i--) {
+        buffer[buffer_length + i] = timestamp & 0xFF;
+        timestamp >>= 8;
+    }
+
+    memcpy(buffer + buffer_length + TLOG_TIMESTAMP_SIZE, frame.data(), frame.size());
+
+    buffer_length += TLOG_TIMESTAMP_SIZE + frame.size();
+}
+
+void MAVLinkTlog::flush()
+{
+    if (tlog_fd < 0) {
+        return;
+    }
+
+    if (buffer_length > 0 && flush_time.elapsed_time() >= tlog_flush_interval) {
+        if (write_buffer()) {
+            rotate();
+        }
+    }
+}
+
+bool MAVLinkTlog::open_file()
+{
+    char timestamp[32];
+    char name[64];
+    time_t now = time(NULL);
+    struct tm tm;
+    std::string file_path;
+
+    gmtime_r(&now, &tm);
+    strftime(timestamp, sizeof(timestamp), "%Y%m%d-%H%M%S", &tm);
+
+    // The counter keeps the names of files started within the same second unique
+    for (unsigned int i = 0; i < 1000; i++) {
+        snprintf(name, sizeof(name), TLOG_FILE_PREFIX "%s-%03u" TLOG_FILE_SUFFIX, timestamp, i);
+        file_path = tlog_path + "/" + name;
+
+        tlog_fd = ::open(file_path.data(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+
+        if (tlog_fd >= 0 || errno != EEXIST) {
+            break;
+        }
+    }
+
+    if (tlog_fd < 0) {
+        syslog(LOG_ERR, "Failed to open telemetry log file '%s': %s", file_path.data(), strerror(errno));
+        return false;
+    }
+
+    file_size = 0;
+    unsynced = false;
+    buffer_length = 0;
+    flush_time.reset();
+    sync_time.reset();
+
+    syslog(LOG_INFO, "Recording telemetry log to '%s'.", file_path.data());
+
+    remove_old_files();
+
+    return true;
+}
+
+void MAVLinkTlog::close_file()
+{
+    if (tlog_fd < 0) {
+        return;
+    }
+
+    write_buffer();
+
+    if (unsynced) {
+        fdatasync(tlog_fd);
+    }
+
+    ::close(tlog_fd);
+    tlog_fd = -1;
+}
+
+bool MAVLinkTlog::write_buffer()
+{
+    if (buffer_length == 0) {
+        return true;
+    }
+
+    size_t written = 0;
+
+    while (written < buffer_length) {
+        ssize_t n = ::write(tlog_fd, buffer + written, buffer_length - written);
+
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            // Drop the buffered records rather than stall the telemetry
+            syslog(LOG_WARNING, "Failed to write telemetry log: %s", strerror(errno));
+            buffer_length = 0;
+            flush_time.reset();
+            return false;
+        }
+
+        written += n;
+    }
+
+    file_size += buffer_length;
+    unsynced = true;
+    buffer_length = 0;
+    flush_time.reset();
+
+    if (sync_time.elapsed_time() >= tlog_sync_interval) {
+        fdatasync(tlog_fd);
+        unsynced = false;
+        sync_time.reset();
+    }
+
+    return true;
+}
+
+bool MAVLinkTlog::rotate()
+{
+    if (tlog_max_file_size == 0 || file_size < tlog_max_file_size) {
+        return true;
+    }
+
+    close_file();
+
+    return open_file();
+}
+
+void MAVLinkTlog::remove_old_files()
+{
+    if (tlog_max_files <= 0) {
+        return;
+    }
+
+    DIR* dir = opendir(tlog_path.data());
+
+    if (dir == NULL) {
+        return;
+    }
+
+    std::vector<std::string> files;
+    struct dirent* entry;
+
+    size_t prefix_len = strlen(TLOG_FILE_PREFIX);
+    size_t suffix_len = strlen(TLOG_FILE_SUFFIX);
+
+    while ((entry = readdir(dir)) != NULL) {
+        size_t len = strlen(entry->d_name);
+
+        if (len > prefix_len + suffix_len &&
+            strncmp(entry->d_name, TLOG_FILE_PREFIX, prefix_len) == 0 &&
+            strcmp(entry->d_name + len - suffix_len, TLOG_FILE_SUFFIX) == 0) {
+            files.push_back(entry->d_name);
+        }
+    }
+
+    closedir(dir);
+
+    // File names are timestamps, so they sort from the oldest to the newest
+    std::sort(files.begin(), files.end());
+
+    for (size_t i = 0; i + tlog_max_files < files.size(); i++) {
+        std::string file_path = tlog_path + "/" + files[i];
+
+        if (unlink(file_path.data()) == 0) {
+            syslog(LOG_INFO, "Removed telemetry log file '%s'.", file_path.data());
+        }
+    }
+}
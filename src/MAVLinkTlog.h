@@ -0,0 +1,98 @@
+/*
+ MAVLinkTlog.h
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef MAVLINKTLOG_H_
+#define MAVLINKTLOG_H_
+
+#include <stddef.h>
+#include <string>
+#include "MAVLinkFrame.h"
+
+#define TLOG_BUFFER_SIZE    65536
+#define TLOG_FILE_PREFIX    "radioroom-"
+#define TLOG_FILE_SUFFIX    ".tlog"
+#define TLOG_TIMESTAMP_SIZE 8
+
+/**
+ * Class MAVLinkTlog records MAVLink frames to telemetry log (.tlog) files
+ * that can be replayed by QGroundControl and Mission Planner.
+ *
+ * Each record of a .tlog file is a 64-bit big-endian timestamp in microseconds
+ * since the Unix epoch followed by the frame bytes as they appear on the wire.
+ *
+ * The records are accumulated in memory and appended to the file when the
+ * buffer is full or the flush interval expires, so the file is written in a
+ * few large sequential writes. The data is synced to the storage no more often
+ * than the sync interval and when a file is closed. When the file reaches the
+ * maximum size, a new file is started and the oldest files are deleted.
+ *
+ * The methods must be called from the same thread.
+ */
+class MAVLinkTlog {
+public:
+    /**
+     * Starts recording to a new file in the specified directory.
+     *
+     * max_file_size - maximum file size in bytes
+     * max_files - maximum number of .tlog files kept in the directory, 0 for unlimited
+     * flush_interval - maximum time in seconds the frames are kept in memory
+     * sync_interval - minimum time in seconds between syncs to the storage
+     *
+     * Returns true if the file was opened.
+     */
+    static bool start(const std::string& path, size_t max_file_size, int max_files,
+                      double flush_interval, double sync_interval);
+
+    /**
+     * Writes the buffered records, syncs and closes the file.
+     */
+    static void stop();
+
+    /**
+     * Returns true if the recording is started.
+     */
+    static bool is_active();
+
+    /**
+     * Records the frame with the current time.
+     */
+    static void record(const MAVLinkFrame& frame);
+
+    /**
+     * Writes the buffered records if the flush interval expired.
+     * Should be called periodically.
+     */
+    static void flush();
+
+private:
+    static bool open_file();
+    static void close_file();
+    static bool write_buffer();
+
+    /**
+     * Starts a new file if the current file reached the maximum size.
+     */
+    static bool rotate();
+    static void remove_old_files();
+};
+
+#endif /* MAVLINKTLOG_H_ */
@@ -0,0 +1,236 @@
+/*
+ MAVLinkTlogReplay.cc
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "MAVLinkTlogReplay.h"
+#include "MAVLinkTlog.h"
+#include "Clock.h"
+#include <syslog.h>
+#include <errno.h>
+#include <string.h>
+
+#define TLOG_REPLAY_READ_TIMEOUT    (250 * NSEC_PER_MSEC)
+
+#define MAVLINK_V1_STX              0xFE
+#define MAVLINK_V2_STX              0xFD
+#define MAVLINK_V1_OVERHEAD         8       // header and checksum
+#define MAVLINK_V2_OVERHEAD         12
+#define MAVLINK_V2_SIGNATURE_LEN    13
+#define MAVLINK_V2_FLAG_SIGNED      0x01
+
+MAVLinkTlogReplay::MAVLinkTlogReplay() :
+    Serial(), file(NULL), path(), start_time(0), first_timestamp(0),
+    last_timestamp(0), due_time(0), record_size(0), record_pos(0), eof(true),
+    frames(0), bytes(0), v2_frames(0), skipped_frames(0), written_bytes(0), max_lag(0), total_lag(0)
+{
+}
+
+MAVLinkTlogReplay::~MAVLinkTlogReplay()
+{
+    close();
+}
+
+int MAVLinkTlogReplay::open(const string& path, int baud_rate)
+{
+    (void)baud_rate;
+
+    close();
+
+    this->path = path;
+
+    file = fopen(path.data(), "rb");
+
+    if (file == NULL) {
+        syslog(LOG_ERR, "Failed to open tlog file '%s' (errno = %d).", path.data(), errno);
+        return -1;
+    }
+
+    setvbuf(file, NULL, _IOFBF, TLOG_BUFFER_SIZE);
+
+    start_time = Clock::now();
+    first_timestamp = last_timestamp = 0;
+    due_time = start_time;
+    record_size = record_pos = 0;
+    eof = false;
+    frames = bytes = v2_frames = skipped_frames = written_bytes = max_lag = total_lag = 0;
+
+    syslog(LOG_NOTICE, "Replaying tlog file '%s'.", path.data());
+
+    return 0;
+}
+
+int MAVLinkTlogReplay::close()
+{
+    if (file != NULL) {
+        fclose(file);
+        file = NULL;
+    }
+
+    eof = true;
+
+    return 0;
+}
+
+bool MAVLinkTlogReplay::next_record()
+{
+    record_size = record_pos = 0;
+
+    while (!eof) {
+        uint8_t timestamp_buf[TLOG_TIMESTAMP_SIZE];
+
+        // The shortest MAVLink 1 frame is longer than STX, length and flags bytes
+        if (fread(timestamp_buf, 1, TLOG_TIMESTAMP_SIZE, file) != TLOG_TIMESTAMP_SIZE ||
+            fread(record, 1, 3, file) != 3) {
+            eof = true;
+            return false;
+        }
+
+        size_t size;
+
+        if (record[0] == MAVLINK_V1_STX) {
+            size = record[1] + MAVLINK_V1_OVERHEAD;
+        } else if (record[0] == MAVLINK_V2_STX) {
+            size = record[1] + MAVLINK_V2_OVERHEAD + ((record[2] & MAVLINK_V2_FLAG_SIGNED) ? MAVLINK_V2_SIGNATURE_LEN : 0);
+        } else {
+            syslog(LOG_ERR, "Invalid record in tlog file '%s' at offset %ld.", path.data(), ftell(file) - 3);
+            eof = true;
+            return false;
+        }
+
+        if (fread(record + 3, 1, size - 3, file) != size - 3) {
+            eof = true;
+            return false;
+        }
+
+        uint8_t sysid = record[0] == MAVLINK_V1_STX ? record[3] : record[5];
+
+        if (sysid == TLOG_REPLAY_GCS_SYSTEM_ID) {
+            skipped_frames++;
+            continue;
+        }
+
+        uint64_t timestamp = 0;
+
+        for (int i = 0; i < TLOG_TIMESTAMP_SIZE; i++) {
+            timestamp = (timestamp << 8) | timestamp_buf[i];
+        }
+
+        if (frames == 0) {
+            first_timestamp = timestamp;
+        }
+
+        // Records out of order, such as of concatenated files, are replayed immediately
+        if (timestamp > first_timestamp) {
+            uint64_t time = start_time + (timestamp - first_timestamp) * NSEC_PER_USEC;
+
+            if (time > due_time) {
+                due_time = time;
+            }
+        }
+
+        if (timestamp > last_timestamp) {
+            last_timestamp = timestamp;
+        }
+
+        record_size = size;
+        frames++;
+        bytes += size;
+
+        if (record[0] == MAVLINK_V2_STX) {
+            v2_frames++;
+        }
+
+        return true;
+    }
+
+    return false;
+}
+
+int MAVLinkTlogReplay::read(void* buffer, size_t size)
+{
+    uint8_t* data = (uint8_t*)buffer;
+    uint64_t now = Clock::now();
+    size_t n = 0;
+
+    while (n < size) {
+        if (record_pos >= record_size && !next_record()) {
+            break;
+        }
+
+        if (due_time > now) {
+            break;
+        }
+
+        if (record_pos == 0) {
+            uint64_t lag = now - due_time;
+
+            total_lag += lag;
+
+            if (lag > max_lag) {
+                max_lag = lag;
+            }
+        }
+
+        size_t count = record_size - record_pos < size - n ? record_size - record_pos : size - n;
+        memcpy(data + n, record + record_pos, count);
+        record_pos += count;
+        n += count;
+    }
+
+    if (n == 0 && !finished()) {
+        Clock::sleep_until(due_time < now + TLOG_REPLAY_READ_TIMEOUT ? due_time : now + TLOG_REPLAY_READ_TIMEOUT);
+    }
+
+    return n;
+}
+
+int MAVLinkTlogReplay::available()
+{
+    if (record_pos >= record_size && !next_record()) {
+        return 0;
+    }
+
+    return due_time <= Clock::now() ? record_size - record_pos : 0;
+}
+
+int MAVLinkTlogReplay::write(const void* buffer, size_t n)
+{
+    (void)buffer;
+
+    written_bytes += n;
+
+    return n;
+}
+
+double MAVLinkTlogReplay::get_span() const
+{
+    return (last_timestamp - first_timestamp) / 1000000.0;
+}
+
+double MAVLinkTlogReplay::get_max_lag() const
+{
+    return Clock::to_seconds(max_lag);
+}
+
+double MAVLinkTlogReplay::get_mean_lag() const
+{
+    return frames > 0 ? Clock::to_seconds(total_lag) / frames : 0;
+}
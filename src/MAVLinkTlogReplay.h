@@ -0,0 +1,171 @@
+/*
+ MAVLinkTlogReplay.h
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef MAVLINKTLOGREPLAY_H_
+#define MAVLINKTLOGREPLAY_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include "Serial.h"
+
+#define TLOG_REPLAY_MAX_FRAME_SIZE  280     // MAVLink 2 frame with signature
+#define TLOG_REPLAY_GCS_SYSTEM_ID   255     // system ID of ground stations and radioroom
+
+/**
+ * Serial device that replays the frames recorded in a .tlog file, so the
+ * recorded telemetry goes through the same MAVLinkSerial and MAVLinkHandler
+ * pipeline as the live autopilot link.
+ *
+ * A record becomes readable when the Clock time elapsed since the file was
+ * opened reaches the record's offset from the first record. The replay speed
+ * is set by the clock: MonotonicClock replays in real time, ScaledClock at a
+ * multiple of the recorded speed, and SimulatedClock as fast as the frames
+ * are processed. The lag of the reads behind the recorded times shows whether
+ * the pipeline keeps up with the replay.
+ *
+ * Both MAVLink 1 and MAVLink 2 records are replayed; MAVLink 2 frames are
+ * counted separately, so the replay stats show how much of the log took the
+ * MAVLink 2 path of the parser. Frames sent by ground stations and by
+ * radioroom itself (system ID 255) are skipped. The bytes written to the
+ * device are discarded.
+ */
+class MAVLinkTlogReplay : public Serial
+{
+    FILE*    file;
+    string   path;
+    uint64_t start_time;
+    uint64_t first_timestamp;   // microseconds since the epoch
+    uint64_t last_timestamp;
+    uint64_t due_time;          // time the current record becomes readable
+    uint8_t  record[TLOG_REPLAY_MAX_FRAME_SIZE];
+    size_t   record_size;
+    size_t   record_pos;
+    bool     eof;
+
+    uint64_t frames;
+    uint64_t bytes;
+    uint64_t v2_frames;
+    uint64_t skipped_frames;
+    uint64_t written_bytes;
+    uint64_t max_lag;
+    uint64_t total_lag;
+
+public:
+
+    MAVLinkTlogReplay();
+
+    ~MAVLinkTlogReplay();
+
+    /**
+     * Returns the path of the .tlog file.
+     */
+    string get_path() const { return path; };
+
+    /**
+     * Opens the .tlog file and starts the replay. The baud rate is ignored.
+     *
+     * Returns 0 in case of success or -1 in case of failure.
+     */
+    int open(const string& path, int baud_rate);
+
+    /**
+     * Closes the .tlog file.
+     */
+    int close();
+
+    /**
+     * Reads the bytes of the records that are due. If no record is due, waits
+     * for the next record no longer than the serial read timeout.
+     *
+     * Returns the number of bytes read.
+     */
+    int read(void* buffer, size_t size);
+
+    /**
+     * Returns the number of bytes of the current record that can be read now.
+     */
+    int available();
+
+    /**
+     * Discards the bytes.
+     *
+     * Returns n.
+     */
+    int write(const void* buffer, size_t n);
+
+    /**
+     * Returns true if all the records were read.
+     */
+    inline bool finished() const { return eof && record_pos >= record_size; };
+
+    /**
+     * Returns the number of frames replayed.
+     */
+    inline uint64_t get_frames() const { return frames; };
+
+    /**
+     * Returns the number of bytes of the frames replayed.
+     */
+    inline uint64_t get_bytes() const { return bytes; };
+
+    /**
+     * Returns the number of MAVLink 2 frames replayed.
+     */
+    inline uint64_t get_v2_frames() const { return v2_frames; };
+
+    /**
+     * Returns the number of skipped ground station frames.
+     */
+    inline uint64_t get_skipped_frames() const { return skipped_frames; };
+
+    /**
+     * Returns the number of bytes written to the device.
+     */
+    inline uint64_t get_written_bytes() const { return written_bytes; };
+
+    /**
+     * Returns time in seconds between the first and the last records replayed.
+     */
+    double get_span() const;
+
+    /**
+     * Returns the maximum lag of the reads behind the recorded times in seconds of Clock time.
+     */
+    double get_max_lag() const;
+
+    /**
+     * Returns the mean lag of the reads behind the recorded times in seconds of Clock time.
+     */
+    double get_mean_lag() const;
+
+private:
+
+    /**
+     * Reads the next record that is not skipped.
+     *
+     * Returns false at the end of the file or if the record is invalid.
+     */
+    bool next_record();
+};
+
+#endif /* MAVLINKTLOGREPLAY_H_ */
@@ -0,0 +1,326 @@
+/*
+ MAVLinkTrack.cc
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "MAVLinkTrack.h"
+#include "Clock.h"
+#include <string.h>
+#include <algorithm>
+
+#define TRACK_FIELD_COUNT       6
+#define TRACK_WIDTH_BITS        5
+#define TRACK_MAX_WIDTH         31
+
+/**
+ * Returns the age of the sample at the report time in seconds.
+ */
+static int64_t sample_age(const TrackSample& sample, uint64_t report_time)
+{
+    return sample.time < report_time ? (report_time - sample.time) / NSEC_PER_SEC : 0;
+}
+
+/**
+ * Track sample fields in the units of the packed deltas.
+ */
+static void get_fields(const TrackSample& sample, uint64_t report_time, int64_t fields[TRACK_FIELD_COUNT])
+{
+    fields[0] = -sample_age(sample, report_time);
+    fields[1] = sample.latitude / TRACK_LATLON_SCALE;
+    fields[2] = sample.longitude / TRACK_LATLON_SCALE;
+    fields[3] = sample.altitude;
+    fields[4] = sample.heading;
+    fields[5] = sample.groundspeed;
+}
+
+static void set_fields(TrackSample& sample, uint64_t report_time, const int64_t fields[TRACK_FIELD_COUNT])
+{
+    sample.time = report_time - (uint64_t)(-fields[0]) * NSEC_PER_SEC;
+    sample.latitude = fields[1] * TRACK_LATLON_SCALE;
+    sample.longitude = fields[2] * TRACK_LATLON_SCALE;
+    sample.altitude = fields[3];
+    sample.heading = fields[4];
+    sample.groundspeed = fields[5];
+}
+
+static TrackSample report_sample(const mavlink_high_latency_t& report, uint64_t report_time)
+{
+    TrackSample sample;
+    sample.time = report_time;
+    sample.latitude = report.latitude;
+    sample.longitude = report.longitude;
+    sample.altitude = report.altitude_amsl;
+    sample.heading = report.heading / 100;
+    sample.groundspeed = report.groundspeed;
+    return sample;
+}
+
+static uint64_t zigzag(int64_t value)
+{
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static int64_t unzigzag(uint64_t value)
+{
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+static int bit_width(uint64_t value)
+{
+    int n = 0;
+
+    while (value >> n) {
+        n++;
+    }
+
+    return n;
+}
+
+static void put_bits(uint8_t* data, size_t& pos, uint64_t value, int n)
+{
+    for (int i = 0; i < n; i++, pos++) {
+        if (value & (1ULL << i)) {
+            data[pos / 8] |= 1 << (pos % 8);
+        }
+    }
+}
+
+static bool get_bits(const uint8_t* data, size_t size, size_t& pos, int n, uint64_t& value)
+{
+    if (pos + n > size * 8) {
+        return false;
+    }
+
+    value = 0;
+
+    for (int i = 0; i < n; i++, pos++) {
+        if (data[pos / 8] & (1 << (pos % 8))) {
+            value |= 1ULL << i;
+        }
+    }
+
+    return true;
+}
+
+MAVLinkTrack::MAVLinkTrack() :
+    sample_period(0), samples()
+{
+}
+
+void MAVLinkTrack::set_sample_period(double period)
+{
+    sample_period = period;
+}
+
+void MAVLinkTrack::frame_received(const MAVLinkFrame& frame)
+{
+    if (sample_period <= 0 || frame.msgid() != MAVLINK_MSG_ID_GPS_RAW_INT) {
+        return;
+    }
+
+    uint64_t now = Clock::now();
+
+    if (!samples.empty() && now - samples.back().time < (uint64_t)(sample_period * NSEC_PER_SEC)) {
+        return;
+    }
+
+    const mavlink_message_t& msg = frame.get_message();
+
+    if (mavlink_msg_gps_raw_int_get_fix_type(&msg) < GPS_FIX_TYPE_2D_FIX) {
+        return;
+    }
+
+    TrackSample sample;
+    sample.time = now;
+    sample.latitude = mavlink_msg_gps_raw_int_get_lat(&msg);
+    sample.longitude = mavlink_msg_gps_raw_int_get_lon(&msg);
+    sample.altitude = mavlink_msg_gps_raw_int_get_alt(&msg) / 1000;
+    sample.heading = mavlink_msg_gps_raw_int_get_cog(&msg) / 100;
+    sample.groundspeed = mavlink_msg_gps_raw_int_get_vel(&msg) / 100;
+
+    add_sample(sample);
+}
+
+void MAVLinkTrack::add_sample(const TrackSample& sample)
+{
+    if (samples.size() >= TRACK_MAX_SAMPLES) {
+        samples.pop_front();
+    }
+
+    samples.push_back(sample);
+}
+
+void MAVLinkTrack::clear()
+{
+    samples.clear();
+}
+
+size_t MAVLinkTrack::pack_samples(const mavlink_high_latency_t& report, uint64_t report_time, size_t skip,
+                                  uint8_t* data, size_t size, size_t& pos) const
+{
+    if (skip >= samples.size()) {
+        return 0;
+    }
+
+    // The first sample is relative to the next newer sample or to the report
+    int64_t prev[TRACK_FIELD_COUNT];
+
+    if (skip == 0) {
+        get_fields(report_sample(report, report_time), report_time, prev);
+    } else {
+        get_fields(samples[samples.size() - skip], report_time, prev);
+    }
+
+    // Find how many samples fit into the data with the field widths of the samples
+    int widths[TRACK_FIELD_COUNT] = {};
+    std::vector<uint64_t> deltas;
+    size_t count = 0;
+
+    for (std::deque<TrackSample>::const_reverse_iterator iter = samples.rbegin() + skip;
+         iter != samples.rend() && count < UINT8_MAX; ++iter) {
+        int64_t fields[TRACK_FIELD_COUNT];
+        get_fields(*iter, report_time, fields);
+
+        int new_widths[TRACK_FIELD_COUNT];
+        uint64_t sample_deltas[TRACK_FIELD_COUNT];
+        size_t bits = TRACK_FIELD_COUNT * TRACK_WIDTH_BITS;
+        bool fits = true;
+
+        for (int i = 0; i < TRACK_FIELD_COUNT; i++) {
+            sample_deltas[i] = zigzag(fields[i] - prev[i]);
+            new_widths[i] = std::max(widths[i], bit_width(sample_deltas[i]));
+            fits = fits && new_widths[i] <= TRACK_MAX_WIDTH;
+            bits += new_widths[i] * (count + 1);
+        }
+
+        if (!fits || pos + bits > size * 8) {
+            break;
+        }
+
+        memcpy(widths, new_widths, sizeof(widths));
+        deltas.insert(deltas.end(), sample_deltas, sample_deltas + TRACK_FIELD_COUNT);
+        memcpy(prev, fields, sizeof(prev));
+        count++;
+    }
+
+    if (count == 0) {
+        return 0;
+    }
+
+    for (int i = 0; i < TRACK_FIELD_COUNT; i++) {
+        put_bits(data, pos, widths[i], TRACK_WIDTH_BITS);
+    }
+
+    for (size_t j = 0; j < deltas.size(); j++) {
+        put_bits(data, pos, deltas[j], widths[j % TRACK_FIELD_COUNT]);
+    }
+
+    return count;
+}
+
+void MAVLinkTrack::pack(uint8_t sysid, uint8_t compid, const mavlink_high_latency_t& report, uint64_t report_time,
+                        std::vector<MAVLinkFrame>& frames, size_t skip) const
+{
+    for (int f = 0; f < TRACK_MAX_FRAMES && skip < samples.size(); f++) {
+        uint8_t data[MAVLINK_MSG_MEMORY_VECT_FIELD_VALUE_LEN];
+        memset(data, 0, sizeof(data));
+        size_t pos = 0;
+
+        size_t count = pack_samples(report, report_time, skip, data, sizeof(data), pos);
+
+        if (count == 0) {
+            break;
+        }
+
+        mavlink_message_t msg;
+        mavlink_msg_memory_vect_pack(sysid, compid, &msg, sample_age(samples[samples.size() - 1 - skip], report_time),
+                                     REPORT_CODEC_TRACK, count, (const int8_t*)data);
+        frames.push_back(MAVLinkFrame(msg));
+
+        skip += count;
+    }
+}
+
+bool MAVLinkTrack::unpack_samples(const mavlink_high_latency_t& report, uint64_t report_time, const uint8_t* data,
+                                  size_t size, size_t& pos, size_t count, std::vector<TrackSample>& samples)
+{
+    if (count == 0) {
+        return true;
+    }
+
+    int64_t prev[TRACK_FIELD_COUNT];
+
+    if (samples.empty()) {
+        get_fields(report_sample(report, report_time), report_time, prev);
+    } else {
+        get_fields(samples.back(), report_time, prev);
+    }
+
+    uint64_t widths[TRACK_FIELD_COUNT];
+
+    for (int i = 0; i < TRACK_FIELD_COUNT; i++) {
+        if (!get_bits(data, size, pos, TRACK_WIDTH_BITS, widths[i])) {
+            return false;
+        }
+    }
+
+    for (size_t j = 0; j < count; j++) {
+        for (int i = 0; i < TRACK_FIELD_COUNT; i++) {
+            uint64_t delta;
+
+            if (!get_bits(data, size, pos, widths[i], delta)) {
+                return false;
+            }
+
+            prev[i] += unzigzag(delta);
+        }
+
+        TrackSample sample;
+        set_fields(sample, report_time, prev);
+        samples.push_back(sample);
+    }
+
+    return true;
+}
+
+bool MAVLinkTrack::unpack(const mavlink_high_latency_t& report, uint64_t report_time,
+                          const std::vector<mavlink_message_t>& msgs, std::vector<TrackSample>& samples)
+{
+    for (size_t m = 0; m < msgs.size(); m++) {
+        const mavlink_message_t& msg = msgs[m];
+
+        if (msg.msgid != MAVLINK_MSG_ID_MEMORY_VECT ||
+            mavlink_msg_memory_vect_get_ver(&msg) != REPORT_CODEC_TRACK) {
+            return false;
+        }
+
+        uint8_t data[MAVLINK_MSG_MEMORY_VECT_FIELD_VALUE_LEN];
+        mavlink_msg_memory_vect_get_value(&msg, (int8_t*)data);
+
+        size_t pos = 0;
+
+        if (!unpack_samples(report, report_time, data, sizeof(data), pos, mavlink_msg_memory_vect_get_type(&msg),
+                            samples)) {
+            return false;
+        }
+    }
+
+    return true;
+}
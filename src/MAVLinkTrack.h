@@ -0,0 +1,147 @@
+/*
+ MAVLinkTrack.h
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef MAVLINKTRACK_H_
+#define MAVLINKTRACK_H_
+
+#include <stdint.h>
+#include <deque>
+#include <vector>
+#include "mavlink.h"
+#include "MAVLinkFrame.h"
+
+#define REPORT_CODEC_TRACK      0x81    // MEMORY_VECT ver of packed track samples
+#define TRACK_MAX_SAMPLES       64      // capacity of the ring buffer
+#define TRACK_MAX_FRAMES        6       // MEMORY_VECT frames sent with one report
+#define TRACK_LATLON_SCALE      10      // track lat/lon units of 1E-7 degrees
+
+/**
+ * Position sample of the vehicle track.
+ */
+struct TrackSample {
+    uint64_t time;          // Clock time, ns
+    int32_t  latitude;      // degrees * 1E7
+    int32_t  longitude;     // degrees * 1E7
+    int16_t  altitude;      // altitude AMSL, meters
+    uint16_t heading;       // course over ground, degrees
+    uint16_t groundspeed;   // m/s
+};
+
+/**
+ * Track of the vehicle between HIGH_LATENCY reports.
+ *
+ * The track samples GPS_RAW_INT messages received from the autopilot with
+ * the configured sample period into a ring buffer of TRACK_MAX_SAMPLES
+ * samples. The samples are sent with the next ISBD report as MEMORY_VECT
+ * messages and cleared after the report was delivered.
+ *
+ * The samples are packed newest first, each one relative to the next newer
+ * sample, and the first one relative to the HIGH_LATENCY report sent in the
+ * same SBD message. The MEMORY_VECT fields are:
+ *
+ *   address  report time minus the time of the first sample in the message,
+ *            seconds
+ *   ver      REPORT_CODEC_TRACK
+ *   type     number of samples in the message
+ *   value    for each of the age, latitude, longitude, altitude, heading
+ *            and groundspeed fields, 5 bits of the field width n followed,
+ *            for each sample, by n bits of each field's zigzag-encoded
+ *            delta, LSB first
+ *
+ * Age deltas are in seconds and lat/lon deltas are in TRACK_LATLON_SCALE
+ * units of 1E-7 degrees.
+ *
+ * The newest samples may also be packed into the unused bits of a report
+ * delta, see MAVLinkReportCodec.
+ */
+class MAVLinkTrack : public MAVLinkFrameListener {
+
+    double                  sample_period;  // seconds, 0 disables sampling
+    std::deque<TrackSample> samples;
+
+public:
+    MAVLinkTrack();
+
+    /**
+     * Sets the track sample period in seconds. 0 disables sampling.
+     */
+    void set_sample_period(double period);
+
+    inline double get_sample_period() const { return sample_period; };
+
+    /**
+     * Samples GPS_RAW_INT received from the autopilot.
+     */
+    void frame_received(const MAVLinkFrame& frame);
+
+    /**
+     * Adds the sample to the track dropping the oldest sample if the track is full.
+     */
+    void add_sample(const TrackSample& sample);
+
+    /**
+     * Returns the number of the buffered samples.
+     */
+    inline size_t size() const { return samples.size(); };
+
+    /**
+     * Removes all the samples after they were delivered to the ground.
+     */
+    void clear();
+
+    /**
+     * Packs up to TRACK_MAX_FRAMES MEMORY_VECT messages with the newest samples
+     * relative to the specified report composed at the specified Clock time,
+     * skipping the specified number of the newest samples packed elsewhere.
+     */
+    void pack(uint8_t sysid, uint8_t compid, const mavlink_high_latency_t& report, uint64_t report_time,
+              std::vector<MAVLinkFrame>& frames, size_t skip = 0) const;
+
+    /**
+     * Packs as many samples as fit into the data of the specified size starting
+     * at bit pos, after skipping the specified number of the newest samples.
+     *
+     * Returns the number of the packed samples.
+     */
+    size_t pack_samples(const mavlink_high_latency_t& report, uint64_t report_time, size_t skip,
+                        uint8_t* data, size_t size, size_t& pos) const;
+
+    /**
+     * Unpacks track samples from MEMORY_VECT messages in the order they were
+     * sent with the report. The sample times are relative to report_time.
+     * The samples already in the vector are the newer samples of the report.
+     *
+     * Returns false if a message is not a valid track message.
+     */
+    static bool unpack(const mavlink_high_latency_t& report, uint64_t report_time,
+                       const std::vector<mavlink_message_t>& msgs, std::vector<TrackSample>& samples);
+
+    /**
+     * Unpacks the specified number of samples from the data starting at bit pos.
+     *
+     * Returns false if the data is too short.
+     */
+    static bool unpack_samples(const mavlink_high_latency_t& report, uint64_t report_time, const uint8_t* data,
+                               size_t size, size_t& pos, size_t count, std::vector<TrackSample>& samples);
+};
+
+#endif /* MAVLINKTRACK_H_ */
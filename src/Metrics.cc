@@ -0,0 +1,336 @@
+/*
+ Metrics.cc
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "Metrics.h"
+#include "Stopwatch.h"
+#include <syslog.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <map>
+#include <mutex>
+
+static const double latency_buckets[] = { 0.001, 0.005, 0.01, 0.05, 0.1, 0.5, 1, 5, 10, 30, 60 };
+static const double session_buckets[] = { 1, 5, 10, 20, 30, 60, 120, 300 };
+
+const std::vector<double> METRICS_LATENCY_BUCKETS(latency_buckets,
+    latency_buckets + sizeof(latency_buckets) / sizeof(latency_buckets[0]));
+
+const std::vector<double> METRICS_SESSION_BUCKETS(session_buckets,
+    session_buckets + sizeof(session_buckets) / sizeof(session_buckets[0]));
+
+Histogram::Histogram(const std::vector<double>& bounds) : bounds(bounds), counts(), sum(0), count(0)
+{
+    for (size_t i = 0; i <= bounds.size(); i++) {
+        counts.push_back(new std::atomic<uint64_t>(0));
+    }
+}
+
+Histogram::~Histogram()
+{
+    for (size_t i = 0; i < counts.size(); i++) {
+        delete counts[i];
+    }
+}
+
+void Histogram::observe(double v)
+{
+    size_t i = 0;
+
+    while (i < bounds.size() && v > bounds[i]) {
+        i++;
+    }
+
+    counts[i]->fetch_add(1, std::memory_order_relaxed);
+
+    double s = sum.load(std::memory_order_relaxed);
+    while (!sum.compare_exchange_weak(s, s + v, std::memory_order_relaxed)) {
+    }
+
+    count.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * Metrics of the same name that differ by labels.
+ */
+struct MetricFamily {
+    MetricFamily() : type(NULL), help(), counters(), gauges(), histograms() {}
+
+    const char*                         type;
+    std::string                         help;
+    std::map<std::string, Counter*>     counters;
+    std::map<std::string, Gauge*>       gauges;
+    std::map<std::string, Histogram*>   histograms;
+};
+
+static std::mutex                           registry_mutex;
+static std::map<std::string, MetricFamily>  registry;
+
+static std::string  metrics_file;
+static int          metrics_fd = -1;
+static std::string  metrics_unix_socket;
+static double       metrics_interval = 0;
+static Stopwatch    export_time;
+
+static MetricFamily& get_family(const char* name, const char* type, const char* help)
+{
+    MetricFamily& family = registry[name];
+
+    if (family.type == NULL) {
+        family.type = type;
+        family.help = help;
+    }
+
+    return family;
+}
+
+Counter& Metrics::counter(const char* name, const std::string& labels, const char* help)
+{
+    std::lock_guard<std::mutex> lock(registry_mutex);
+
+    Counter*& counter = get_family(name, "counter", help).counters[labels];
+
+    if (counter == NULL) {
+        counter = new Counter();
+    }
+
+    return *counter;
+}
+
+Gauge& Metrics::gauge(const char* name, const std::string& labels, const char* help)
+{
+    std::lock_guard<std::mutex> lock(registry_mutex);
+
+    Gauge*& gauge = get_family(name, "gauge", help).gauges[labels];
+
+    if (gauge == NULL) {
+        gauge = new Gauge();
+    }
+
+    return *gauge;
+}
+
+Histogram& Metrics::histogram(const char* name, const std::string& labels, const char* help,
+                              const std::vector<double>& bounds)
+{
+    std::lock_guard<std::mutex> lock(registry_mutex);
+
+    Histogram*& histogram = get_family(name, "histogram", help).histograms[labels];
+
+    if (histogram == NULL) {
+        histogram = new Histogram(bounds);
+    }
+
+    return *histogram;
+}
+
+std::string Metrics::label(const char* name, const std::string& value)
+{
+    return std::string(name) + "=\"" + value + "\"";
+}
+
+std::string Metrics::label(const char* name, int value)
+{
+    char buff[16];
+    snprintf(buff, sizeof(buff), "%d", value);
+    return label(name, std::string(buff));
+}
+
+static void append_sample(std::string& out, const std::string& name, const std::string& labels, double value)
+{
+    char buff[32];
+    snprintf(buff, sizeof(buff), " %.17g\n", value);
+
+    out += name;
+
+    if (!labels.empty()) {
+        out += "{" + labels + "}";
+    }
+
+    out += buff;
+}
+
+std::string Metrics::format()
+{
+    std::lock_guard<std::mutex> lock(registry_mutex);
+
+    std::string out;
+
+    for (std::map<std::string, MetricFamily>::const_iterator it = registry.begin(); it != registry.end(); ++it) {
+        const std::string& name = it->first;
+        const MetricFamily& family = it->second;
+
+        out += "# HELP " + name + " " + family.help + "\n";
+        out += "# TYPE " + name + " " + family.type + "\n";
+
+        for (std::map<std::string, Counter*>::const_iterator c = family.counters.begin(); c != family.counters.end(); ++c) {
+            append_sample(out, name, c->first, c->second->get());
+        }
+
+        for (std::map<std::string, Gauge*>::const_iterator g = family.gauges.begin(); g != family.gauges.end(); ++g) {
+            append_sample(out, name, g->first, g->second->get());
+        }
+
+        for (std::map<std::string, Histogram*>::const_iterator h = family.histograms.begin(); h != family.histograms.end(); ++h) {
+            const Histogram& histogram = *h->second;
+            std::string prefix = h->first.empty() ? "" : h->first + ",";
+            uint64_t cumulative = 0;
+            char bound[32];
+
+            for (size_t i = 0; i < histogram.get_bounds().size(); i++) {
+                cumulative += histogram.get_bucket_count(i);
+                snprintf(bound, sizeof(bound), "%g", histogram.get_bounds()[i]);
+                append_sample(out, name + "_bucket", prefix + label("le", std::string(bound)), cumulative);
+            }
+
+            cumulative += histogram.get_bucket_count(histogram.get_bounds().size());
+            append_sample(out, name + "_bucket", prefix + label("le", std::string("+Inf")), cumulative);
+            append_sample(out, name + "_sum", h->first, histogram.get_sum());
+            append_sample(out, name + "_count", h->first, histogram.get_count());
+        }
+    }
+
+    return out;
+}
+
+bool Metrics::start(const std::string& file, const std::string& unix_socket, double interval)
+{
+    metrics_file = file;
+    metrics_interval = interval;
+    export_time.reset();
+
+    if (unix_socket.empty()) {
+        return true;
+    }
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+
+    if (unix_socket.size() >= sizeof(addr.sun_path)) {
+        syslog(LOG_ERR, "Metrics Unix socket path '%s' is too long.", unix_socket.data());
+        return false;
+    }
+
+    strncpy(addr.sun_path, unix_socket.data(), sizeof(addr.sun_path) - 1);
+
+    metrics_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+    if (metrics_fd < 0) {
+        syslog(LOG_ERR, "Failed to create metrics Unix socket: %s", strerror(errno));
+        return false;
+    }
+
+    unlink(unix_socket.data());
+
+    if (bind(metrics_fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(metrics_fd, 4) < 0) {
+        syslog(LOG_ERR, "Failed to listen on metrics Unix socket '%s': %s", unix_socket.data(), strerror(errno));
+        ::close(metrics_fd);
+        metrics_fd = -1;
+        return false;
+    }
+
+    metrics_unix_socket = unix_socket;
+
+    syslog(LOG_INFO, "Serving metrics on Unix socket '%s'.", unix_socket.data());
+
+    return true;
+}
+
+void Metrics::update()
+{
+    if (!metrics_file.empty() && export_time.elapsed_time() >= metrics_interval) {
+        write_file();
+        export_time.reset();
+    }
+
+    if (metrics_fd < 0) {
+        return;
+    }
+
+    int client_fd;
+
+    while ((client_fd = accept4(metrics_fd, NULL, NULL, SOCK_CLOEXEC)) >= 0) {
+        std::string text = format();
+        size_t sent = 0;
+
+        while (sent < text.size()) {
+            ssize_t n = send(client_fd, text.data() + sent, text.size() - sent, MSG_NOSIGNAL);
+
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+
+            if (n <= 0) {
+                break;
+            }
+
+            sent += n;
+        }
+
+        ::close(client_fd);
+    }
+}
+
+void Metrics::stop()
+{
+    if (!metrics_file.empty()) {
+        write_file();
+    }
+
+    if (metrics_fd >= 0) {
+        ::close(metrics_fd);
+        unlink(metrics_unix_socket.data());
+        metrics_fd = -1;
+    }
+}
+
+bool Metrics::write_file()
+{
+    // Write a temporary file and rename it, so readers never see a partial file
+    std::string tmp_file = metrics_file + ".tmp";
+
+    FILE* file = fopen(tmp_file.data(), "w");
+
+    if (file == NULL) {
+        syslog(LOG_WARNING, "Failed to write metrics file '%s': %s", tmp_file.data(), strerror(errno));
+        return false;
+    }
+
+    std::string text = format();
+
+    bool ok = fwrite(text.data(), 1, text.size(), file) == text.size();
+
+    ok = (fclose(file) == 0) && ok;
+
+    if (!ok || rename(tmp_file.data(), metrics_file.data()) < 0) {
+        syslog(LOG_WARNING, "Failed to write metrics file '%s': %s", metrics_file.data(), strerror(errno));
+        unlink(tmp_file.data());
+        return false;
+    }
+
+    return true;
+}
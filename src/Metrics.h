@@ -0,0 +1,177 @@
+/*
+ Metrics.h
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef METRICS_H_
+#define METRICS_H_
+
+#include <stdint.h>
+#include <atomic>
+#include <string>
+#include <vector>
+
+/**
+ * Monotonically increasing count of events.
+ */
+class Counter {
+    std::atomic<uint64_t> value;
+
+public:
+    Counter() : value(0) {}
+
+    inline void inc(uint64_t n = 1) { value.fetch_add(n, std::memory_order_relaxed); }
+
+    inline uint64_t get() const { return value.load(std::memory_order_relaxed); }
+};
+
+/**
+ * Value that can go up and down.
+ */
+class Gauge {
+    std::atomic<double> value;
+
+public:
+    Gauge() : value(0) {}
+
+    inline void set(double v) { value.store(v, std::memory_order_relaxed); }
+
+    inline double get() const { return value.load(std::memory_order_relaxed); }
+};
+
+/**
+ * Distribution of observed values over fixed buckets.
+ */
+class Histogram {
+    std::vector<double>                 bounds;   // upper bounds of the buckets in ascending order
+    std::vector<std::atomic<uint64_t>*> counts;   // non-cumulative counts, the last one is +Inf
+    std::atomic<double>                 sum;
+    std::atomic<uint64_t>               count;
+
+public:
+    Histogram(const std::vector<double>& bounds);
+
+    ~Histogram();
+
+    /**
+     * Adds the value to the bucket with the smallest upper bound the value fits in.
+     */
+    void observe(double v);
+
+    inline const std::vector<double>& get_bounds() const { return bounds; }
+
+    /**
+     * Returns the number of observations in the bucket. Index bounds.size() is the +Inf bucket.
+     */
+    inline uint64_t get_bucket_count(size_t i) const { return counts[i]->load(std::memory_order_relaxed); }
+
+    inline double get_sum() const { return sum.load(std::memory_order_relaxed); }
+
+    inline uint64_t get_count() const { return count.load(std::memory_order_relaxed); }
+
+private:
+    Histogram(const Histogram&);
+    Histogram& operator=(const Histogram&);
+};
+
+/**
+ * Class Metrics is the registry of the application metrics.
+ *
+ * Metrics are identified by family name and labels in Prometheus syntax,
+ * for example counter("isbd_sbdix_total", "mo_status=\"0\"", "..."). A metric
+ * is created on the first request and lives until the process exits, so the
+ * callers may keep the returned references. Looking a metric up takes the
+ * registry lock, updating it is lock-free, so per-frame code keeps the
+ * references (see MAVLinkChannelMetrics) and only session-level code looks
+ * the metrics up on every update.
+ *
+ * The registry is exported in Prometheus text exposition format to a file,
+ * which can be picked up by node_exporter's textfile collector, and to the
+ * clients connecting to a local Unix domain socket.
+ */
+class Metrics {
+public:
+    /**
+     * Returns the counter with the specified name and labels.
+     */
+    static Counter& counter(const char* name, const std::string& labels, const char* help);
+
+    /**
+     * Returns the gauge with the specified name and labels.
+     */
+    static Gauge& gauge(const char* name, const std::string& labels, const char* help);
+
+    /**
+     * Returns the histogram with the specified name and labels.
+     *
+     * The buckets are set when the histogram is created.
+     */
+    static Histogram& histogram(const char* name, const std::string& labels, const char* help,
+                                const std::vector<double>& bounds);
+
+    /**
+     * Formats all the metrics in Prometheus text exposition format.
+     */
+    static std::string format();
+
+    /**
+     * Starts exporting the metrics. Empty file path or Unix socket path disable
+     * the corresponding export.
+     *
+     * Returns false if the Unix socket could not be opened.
+     */
+    static bool start(const std::string& file, const std::string& unix_socket, double interval);
+
+    /**
+     * Writes the file if the export interval elapsed and answers the clients
+     * connected to the Unix socket. The call does not block.
+     */
+    static void update();
+
+    /**
+     * Writes the file and closes the Unix socket.
+     */
+    static void stop();
+
+    /**
+     * Returns label string "name=\"value\"".
+     */
+    static std::string label(const char* name, const std::string& value);
+
+    /**
+     * Returns label string "name=\"value\"".
+     */
+    static std::string label(const char* name, int value);
+
+private:
+    static bool write_file();
+};
+
+/**
+ * Bucket bounds in seconds for latencies of serial and socket operations.
+ */
+extern const std::vector<double> METRICS_LATENCY_BUCKETS;
+
+/**
+ * Bucket bounds in seconds for durations of satellite sessions.
+ */
+extern const std::vector<double> METRICS_SESSION_BUCKETS;
+
+#endif /* METRICS_H_ */
@@ -23,6 +23,7 @@
      Author: Pavel Bobov
  */
 #include "Serial.h"
+#include "Clock.h"
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -37,7 +38,6 @@
 #include <errno.h>
 #include <istream>
 #include <dirent.h>
-#include <sys/select.h>
 
 #define SERIAL_READ_TIMEOUT 250000 // microseconds
 
@@ -172,16 +172,7 @@ int Serial::read()
 
 int Serial::read(void* buffer, size_t size)
 {
-    fd_set set;
-    struct timeval timeout;
-
-    FD_ZERO(&set); /* clear the set */
-    FD_SET(tty_fd, &set); /* add our file descriptor to the set */
-
-    timeout.tv_sec = 0;
-    timeout.tv_usec = SERIAL_READ_TIMEOUT;
-
-    int rv = ::select(tty_fd + 1, &set, NULL, NULL, &timeout);
+    int rv = Clock::wait_readable(tty_fd, SERIAL_READ_TIMEOUT * NSEC_PER_USEC);
 
     if (rv < 0) {
       return -1; /* an error accured */
@@ -194,6 +185,17 @@ int Serial::read(void* buffer, size_t size)
     return ::read(tty_fd, buffer, size);
 }
 
+int Serial::available()
+{
+    int n = 0;
+
+    if (::ioctl(tty_fd, FIONREAD, &n) < 0) {
+        return -1;
+    }
+
+    return n;
+}
+
 int Serial::write(int c)
 {
     return write(&c, 1);
@@ -201,15 +203,7 @@ int Serial::write(int c)
 
 int Serial::write(const void* buffer, size_t n)
 {
-    int ret = ::write(tty_fd, buffer, n);
-
-    if (ret < 0)
-        return ret;
-
-    if (::tcflush(tty_fd, TCIOFLUSH) < 0)
-        return -1;
-
-    return ret;
+    return ::write(tty_fd, buffer, n);
 }
 
 int Serial::get_serial_devices(vector<string>& devices) {
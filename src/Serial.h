@@ -38,6 +38,10 @@ using namespace std;
 
 /**
  * Provides access to serial devices.
+ *
+ * Reads wait for data using Clock, so the read timeouts follow the simulated
+ * time in tests. The I/O methods are virtual, so tests can replace the device
+ * with a scripted one.
  */
 class Serial
 {
@@ -60,19 +64,19 @@ public:
     /**
      * Returns the serial device path set by open(...) call.
      */
-    inline string get_path() const { return path; };
+    virtual string get_path() const { return path; };
 
     /**
      * Opens serial device with the specified path and sets the baud rate.
      *
      * Returns 0 in case of success or -1 in case of failure.
      */
-    int open(const string& path, int baud_rate);
+    virtual int open(const string& path, int baud_rate);
 
     /**
      * Closes the serial device.
      */
-    int close();
+    virtual int close();
 
     /*
      * Reads single byte from the serial device.
@@ -86,7 +90,13 @@ public:
      *
      * Returns the number of bytes read or -1 in case of error.
      */
-    int read(void* buffer, size_t size);
+    virtual int read(void* buffer, size_t size);
+
+    /**
+     * Returns the number of bytes that can be read from the serial device
+     * without blocking or -1 in case of error.
+     */
+    virtual int available();
 
     /**
      * Writes single character to the serial device.
@@ -100,7 +110,7 @@ public:
      *
      * Returns the number of bytes written or -1 in case of error.
      */
-    int write(const void* buffer, size_t n);
+    virtual int write(const void* buffer, size_t n);
 
     /**
      * Retrieves the list of serial devices from '/dev/serial/by-path' folder.
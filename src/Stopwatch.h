@@ -24,26 +24,29 @@
 #ifndef STOPWATCH_H_
 #define STOPWATCH_H_
 
-#include <time.h>
+#include <stdint.h>
+#include "Clock.h"
 
 /**
- * Stopwatch class is used to measure absolute elapsed time.
+ * Stopwatch class is used to measure elapsed time.
+ *
+ * The time is measured by the monotonic clock with nanosecond resolution.
  */
 class Stopwatch
 {
-    time_t start_time;
+    uint64_t start_time; // nanoseconds
 
 public:
 
-    Stopwatch() : start_time(::time(0))
+    Stopwatch() : start_time(Clock::now())
     {
     }
 
     /*
-     * Get current time.
+     * Get current monotonic time in nanoseconds.
      */
-    time_t time() {
-        return ::time(0);
+    uint64_t time() {
+        return Clock::now();
     }
 
     /*
@@ -57,7 +60,7 @@ public:
     /*
      * Set start time.
      */
-    void reset(time_t t)
+    void reset(uint64_t t)
     {
         start_time = t;
     }
@@ -67,7 +70,7 @@ public:
      */
     double elapsed_time()
     {
-        return time() - start_time;
+        return Clock::to_seconds(time() - start_time);
     }
 
 };
@@ -0,0 +1,226 @@
+/*
+ TimerWheel.cc
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "TimerWheel.h"
+
+#define SLOT_MASK (TIMER_WHEEL_SLOTS - 1)
+
+TimerWheel::TimerWheel(uint64_t tick, uint64_t now) :
+    origin(now), tick(tick > 0 ? tick : 1), current_tick(0), next_id(1), timers()
+{
+}
+
+TimerWheel::~TimerWheel()
+{
+    clear();
+}
+
+void TimerWheel::clear()
+{
+    for (int level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+        for (int slot = 0; slot < TIMER_WHEEL_SLOTS; slot++) {
+            std::list<Timer*>& timers_in_slot = slots[level][slot];
+
+            for (std::list<Timer*>::iterator it = timers_in_slot.begin(); it != timers_in_slot.end(); ++it) {
+                delete *it;
+            }
+
+            timers_in_slot.clear();
+        }
+    }
+
+    timers.clear();
+}
+
+uint64_t TimerWheel::schedule(uint64_t delay, std::function<void()> callback)
+{
+    return add(delay, 0, callback);
+}
+
+uint64_t TimerWheel::schedule_periodic(uint64_t period, std::function<void()> callback)
+{
+    uint64_t period_ticks = (period + tick - 1) / tick;
+
+    return add(period, period_ticks > 0 ? period_ticks : 1, callback);
+}
+
+uint64_t TimerWheel::add(uint64_t delay, uint64_t period, std::function<void()> callback)
+{
+    uint64_t now = Clock::now();
+    uint64_t expires = now > origin ? (now - origin + delay + tick - 1) / tick : (delay + tick - 1) / tick;
+
+    Timer* timer = new Timer();
+    timer->id = next_id++;
+    timer->expires = expires > current_tick ? expires : current_tick;
+    timer->period = period;
+    timer->cancelled = false;
+    timer->callback = callback;
+
+    timers[timer->id] = timer;
+
+    insert(timer);
+
+    return timer->id;
+}
+
+bool TimerWheel::cancel(uint64_t id)
+{
+    std::unordered_map<uint64_t, Timer*>::iterator it = timers.find(id);
+
+    if (it == timers.end()) {
+        return false;
+    }
+
+    // The timer is removed from its slot when the slot is processed
+    it->second->cancelled = true;
+    timers.erase(it);
+
+    return true;
+}
+
+void TimerWheel::insert(Timer* timer)
+{
+    uint64_t delta = timer->expires - current_tick;
+
+    for (int level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+        if (delta < (1ULL << (TIMER_WHEEL_SLOT_BITS * (level + 1))) || level == TIMER_WHEEL_LEVELS - 1) {
+            int slot = (timer->expires >> (TIMER_WHEEL_SLOT_BITS * level)) & SLOT_MASK;
+            slots[level][slot].push_back(timer);
+            return;
+        }
+    }
+}
+
+void TimerWheel::cascade(int level)
+{
+    int slot = (current_tick >> (TIMER_WHEEL_SLOT_BITS * level)) & SLOT_MASK;
+
+    std::list<Timer*> cascaded;
+    cascaded.swap(slots[level][slot]);
+
+    for (std::list<Timer*>::iterator it = cascaded.begin(); it != cascaded.end(); ++it) {
+        if ((*it)->cancelled) {
+            delete *it;
+        } else {
+            insert(*it);
+        }
+    }
+
+    if (slot == 0 && level < TIMER_WHEEL_LEVELS - 1) {
+        cascade(level + 1);
+    }
+}
+
+void TimerWheel::advance(uint64_t now)
+{
+    if (now < origin) {
+        return;
+    }
+
+    uint64_t target = (now - origin) / tick;
+
+    while (current_tick <= target) {
+        if (timers.empty()) {
+            // Only cancelled timers can be left in the slots, skip the idle ticks
+            clear();
+            current_tick = target + 1;
+            break;
+        }
+
+        if ((current_tick & SLOT_MASK) == 0 && current_tick > 0) {
+            cascade(1);
+        }
+
+        std::list<Timer*> expired;
+        expired.swap(slots[0][current_tick & SLOT_MASK]);
+
+        current_tick++;
+
+        while (!expired.empty()) {
+            Timer* timer = expired.front();
+            expired.pop_front();
+
+            if (timer->cancelled) {
+                delete timer;
+                continue;
+            }
+
+            if (timer->period == 0) {
+                timers.erase(timer->id);
+            }
+
+            timer->callback();
+
+            if (timer->period == 0 || timer->cancelled) {
+                delete timer;
+                continue;
+            }
+
+            timer->expires += timer->period;
+
+            // Missed periods are not made up, so a callback running longer
+            // than its period is not called again by the same advance().
+            if (timer->expires <= target) {
+                timer->expires = target + 1;
+            }
+
+            insert(timer);
+        }
+    }
+}
+
+uint64_t TimerWheel::next_expiration() const
+{
+    uint64_t earliest = UINT64_MAX;
+
+    for (int level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+        int shift = TIMER_WHEEL_SLOT_BITS * level;
+
+        // Timers of the higher wheels expire after the current revolution of this wheel
+        if (level > 0 && earliest < (((current_tick >> shift) + 1) << shift)) {
+            break;
+        }
+
+        // The current slot of the higher wheels has been cascaded, so it holds
+        // only the timers of the next revolution
+        int start = ((current_tick >> shift) + (level > 0 ? 1 : 0)) & SLOT_MASK;
+
+        // The first non-empty slot of the wheel holds its earliest timers
+        for (int i = 0; i < TIMER_WHEEL_SLOTS; i++) {
+            const std::list<Timer*>& timers_in_slot = slots[level][(start + i) & SLOT_MASK];
+            bool found = false;
+
+            for (std::list<Timer*>::const_iterator it = timers_in_slot.begin(); it != timers_in_slot.end(); ++it) {
+                if (!(*it)->cancelled && (*it)->expires < earliest) {
+                    earliest = (*it)->expires;
+                    found = true;
+                }
+            }
+
+            if (found) {
+                break;
+            }
+        }
+    }
+
+    return earliest == UINT64_MAX ? UINT64_MAX : origin + earliest * tick;
+}
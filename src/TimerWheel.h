@@ -0,0 +1,131 @@
+/*
+ TimerWheel.h
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef TIMERWHEEL_H_
+#define TIMERWHEEL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include "Clock.h"
+
+#define TIMER_WHEEL_LEVELS      4
+#define TIMER_WHEEL_SLOT_BITS   8
+#define TIMER_WHEEL_SLOTS       (1 << TIMER_WHEEL_SLOT_BITS)
+#define TIMER_WHEEL_TICK        NSEC_PER_MSEC
+
+/**
+ * Hierarchical timer wheel.
+ *
+ * Timers are kept in slots of four wheels of 256 slots each. The first wheel
+ * has one slot per tick, every next wheel has slots 256 times longer than the
+ * previous one. Timers are moved to the lower wheel when the lower wheel
+ * completes a revolution, so scheduling, cancelling and expiring a timer take
+ * constant time regardless of the number of timers.
+ *
+ * The wheel does not run by itself. The owner sleeps until next_expiration()
+ * and calls advance() to run the expired timers, so the wheel costs nothing
+ * while idle.
+ *
+ * The class is not thread safe.
+ */
+class TimerWheel {
+
+    struct Timer {
+        uint64_t              id;
+        uint64_t              expires;   // tick the timer expires at
+        uint64_t              period;    // period in ticks, 0 for one-shot timers
+        bool                  cancelled;
+        std::function<void()> callback;
+    };
+
+    uint64_t                                origin;        // clock time of tick 0
+    uint64_t                                tick;          // tick length in nanoseconds
+    uint64_t                                current_tick;  // next tick to process
+    uint64_t                                next_id;
+    std::list<Timer*>                       slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+    std::unordered_map<uint64_t, Timer*>    timers;        // active timers by ID
+
+public:
+    /**
+     * Constructs the wheel with the specified tick length in nanoseconds
+     * starting at the specified clock time.
+     */
+    TimerWheel(uint64_t tick = TIMER_WHEEL_TICK, uint64_t now = Clock::now());
+
+    /**
+     * Deletes all the timers.
+     */
+    ~TimerWheel();
+
+    /**
+     * Schedules callback to be called once after the specified delay in nanoseconds.
+     *
+     * Returns ID of the timer.
+     */
+    uint64_t schedule(uint64_t delay, std::function<void()> callback);
+
+    /**
+     * Schedules callback to be called with the specified period in nanoseconds.
+     * The first call is made after one period.
+     *
+     * Returns ID of the timer.
+     */
+    uint64_t schedule_periodic(uint64_t period, std::function<void()> callback);
+
+    /**
+     * Cancels the timer. Timers can be cancelled from the callbacks.
+     *
+     * Returns false if the timer has already expired or was cancelled.
+     */
+    bool cancel(uint64_t id);
+
+    /**
+     * Runs the callbacks of all the timers expired by the specified clock time.
+     * A periodic timer that missed several periods is called once.
+     */
+    void advance(uint64_t now = Clock::now());
+
+    /**
+     * Returns clock time of the earliest timer expiration
+     * or UINT64_MAX if there are no timers.
+     */
+    uint64_t next_expiration() const;
+
+    /**
+     * Returns the number of active timers.
+     */
+    inline size_t size() const { return timers.size(); }
+
+private:
+    TimerWheel(const TimerWheel&);
+    TimerWheel& operator=(const TimerWheel&);
+
+    uint64_t add(uint64_t delay, uint64_t period, std::function<void()> callback);
+    void clear();
+    void insert(Timer* timer);
+    void cascade(int level);
+};
+
+#endif /* TIMERWHEEL_H_ */
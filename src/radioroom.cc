@@ -25,16 +25,40 @@
 #include <fcntl.h>
 #include <signal.h>
 #include <stdio.h>
+#include <sys/resource.h>
 
 #include "build.h"
 
 #include "MAVLinkHandler.h"
+#include "MAVLinkLogger.h"
+#include "MAVLinkTlog.h"
+#include "MAVLinkTlogReplay.h"
+#include "Metrics.h"
+#include "Clock.h"
+#include "TimerWheel.h"
 
 #define LOG_IDENTITY     "radioroom"
 
+#define LOOP_INTERVAL    (100 * NSEC_PER_MSEC)
+#define ROUTE_INTERVAL   (10 * NSEC_PER_MSEC)
+#define FLUSH_INTERVAL   (1 * NSEC_PER_SEC)
+
 MAVLinkHandler msg_handler;
+MAVLinkTlogReplay replay;
+TimerWheel timers;
 
 static int running = 0;
+static volatile sig_atomic_t reload_logging = 0;
+
+/**
+ * Called by IridiumSBD while waiting for the transceiver.
+ * Keeps the local MAVLink traffic flowing during long ISBD sessions.
+ */
+bool isbdCallback()
+{
+    msg_handler.route();
+    return true;
+}
 
 void print_help()
 {
@@ -45,6 +69,14 @@ void print_help()
     std::cout << std::endl;
     std::cout << "    -h    Print this help and exit." << std::endl;
     std::cout << std::endl;
+    std::cout << "    -r <tlog file>" << std::endl;
+    std::cout << "          Replay the telemetry log instead of connecting to the autopilot," << std::endl;
+    std::cout << "          print the statistics and exit when the log ends." << std::endl;
+    std::cout << std::endl;
+    std::cout << "    -x <speed>" << std::endl;
+    std::cout << "          Replay speed factor, 1 for real time (default), 0 for as fast as possible." << std::endl;
+    std::cout << "          Report periods and timeouts follow the replayed time." << std::endl;
+    std::cout << std::endl;
     std::cout << "    -v    Verbose logging." << std::endl;
     std::cout << std::endl;
     std::cout << "    -V    Print version and exit." << std::endl;
@@ -56,6 +88,57 @@ void print_version()
     std::cout << "MAVLink wire protocol version " << MAVLINK_WIRE_PROTOCOL_VERSION << std::endl;
 }
 
+/**
+ * Returns CPU time used by the process in seconds.
+ */
+double get_cpu_time()
+{
+    struct rusage usage;
+
+    if (getrusage(RUSAGE_SELF, &usage) < 0) {
+        return 0;
+    }
+
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+/**
+ * Prints the end-to-end statistics of the tlog replay to stdout as a JSON object.
+ */
+void print_replay_stats(double speed, double wall_time, double cpu_time)
+{
+    uint64_t frames = Metrics::counter("mavlink_frames_received_total", Metrics::label("channel", "serial"),
+                                       "Number of MAVLink frames received.").get();
+    uint64_t reports = Metrics::counter("high_latency_reports_total", "",
+                                        "Number of HIGH_LATENCY reports composed.").get();
+
+    printf("{\"tlog\":\"%s\",\"speed\":%g,\"tlog_seconds\":%.3f,\"wall_seconds\":%.3f,\"cpu_seconds\":%.3f,"
+           "\"frames_replayed\":%llu,\"frames_v2\":%llu,\"bytes_replayed\":%llu,\"frames_parsed\":%llu,\"frames_per_second\":%.1f,"
+           "\"cpu_us_per_frame\":%.3f,\"required_baud_rate\":%.0f,\"max_lag_seconds\":%.3f,\"mean_lag_seconds\":%.6f,"
+           "\"high_latency_reports\":%llu,\"channels\":{",
+           replay.get_path().data(), speed, replay.get_span(), wall_time, cpu_time,
+           (unsigned long long)replay.get_frames(), (unsigned long long)replay.get_v2_frames(),
+           (unsigned long long)replay.get_bytes(), (unsigned long long)frames,
+           wall_time > 0 ? frames / wall_time : 0.0, frames > 0 ? cpu_time * 1e6 / frames : 0.0,
+           replay.get_span() > 0 ? replay.get_bytes() * 10 / replay.get_span() : 0.0,
+           replay.get_max_lag(), replay.get_mean_lag(), (unsigned long long)reports);
+
+    std::vector<std::string> channels = msg_handler.get_comm_channel_ids();
+
+    for (size_t i = 0; i < channels.size(); i++) {
+        std::string labels = Metrics::label("channel", channels[i]);
+
+        printf("%s\"%s\":{\"bytes_sent\":%llu,\"bytes_received\":%llu}", i > 0 ? "," : "", channels[i].data(),
+               (unsigned long long)Metrics::counter("mavlink_sent_bytes_total", labels, "Number of bytes of MAVLink frames sent.").get(),
+               (unsigned long long)Metrics::counter("mavlink_received_bytes_total", labels, "Number of bytes of MAVLink frames received.").get());
+    }
+
+    printf("}}\n");
+
+    syslog(LOG_NOTICE, "Replayed %llu frames in %.3f s (%.1f frames/s), %llu HIGH_LATENCY reports.",
+           (unsigned long long)frames, wall_time, wall_time > 0 ? frames / wall_time : 0.0, (unsigned long long)reports);
+}
+
 void handle_signal(int sig)
 {
     if (sig == SIGTERM) {
@@ -63,18 +146,55 @@ void handle_signal(int sig)
 
         /* Reset signal handling to default behavior */
         signal(SIGTERM, SIG_DFL);
+    } else if (sig == SIGHUP) {
+        reload_logging = 1;
+    }
+}
+
+/**
+ * Applies log mask and per-message and per-category log levels from the configuration.
+ */
+void apply_logging_config()
+{
+    MAVLinkLogger::set_log_mask(config.get_debug_mode() ? LOG_UPTO(LOG_DEBUG) : LOG_UPTO(LOG_INFO));
+
+    MAVLinkLogger::clear_levels();
+
+    const std::vector<std::string>& categories = config.get_debug_categories();
+    for (size_t i = 0; i < categories.size(); i++) {
+        if (!MAVLinkLogger::set_category_level(categories[i].data(), LOG_DEBUG)) {
+            syslog(LOG_WARNING, "Unknown log category '%s'.", categories[i].data());
+        }
+    }
+
+    const std::vector<int>& debug_messages = config.get_debug_messages();
+    for (size_t i = 0; i < debug_messages.size(); i++) {
+        MAVLinkLogger::set_message_level(debug_messages[i], LOG_DEBUG);
+    }
+
+    const std::vector<int>& quiet_messages = config.get_quiet_messages();
+    for (size_t i = 0; i < quiet_messages.size(); i++) {
+        MAVLinkLogger::set_message_level(quiet_messages[i], MAVLINK_LOG_LEVEL_QUIET);
     }
 }
 
 int main(int argc, char** argv) {
     std::string config_file = DEFAULT_CONFIG_FILE;
+    std::string replay_file;
+    double replay_speed = 1;
 
     int c;
-    while ((c = getopt(argc, argv, "c:hvV")) != -1) {
+    while ((c = getopt(argc, argv, "c:hr:vVx:")) != -1) {
         switch (c) {
         case 'c':
             config_file = optarg;
             break;
+        case 'r':
+            replay_file = optarg;
+            break;
+        case 'x':
+            replay_speed = atof(optarg);
+            break;
         case 'h':
             print_help();
             return EXIT_SUCCESS;
@@ -85,8 +205,8 @@ int main(int argc, char** argv) {
             print_version();
             return EXIT_SUCCESS;
         case '?':
-            if (optopt == 'c') {
-                std::cout << "Option -c requires an argument." << std::endl;
+            if (optopt == 'c' || optopt == 'r' || optopt == 'x') {
+                std::cout << "Option -" << std::string(1, optopt) << " requires an argument." << std::endl;
             } else if (isprint(optopt)) {
                 std::cout << "Unknown option '-" << std::string(1, optopt) << "'." << std::endl;
             } else {
@@ -97,7 +217,7 @@ int main(int argc, char** argv) {
     }
 
     openlog(LOG_IDENTITY, LOG_CONS | LOG_NDELAY, LOG_USER);
-    setlogmask(config.get_debug_mode() ? LOG_UPTO(LOG_DEBUG) : LOG_UPTO(LOG_INFO));
+    MAVLinkLogger::set_log_mask(config.get_debug_mode() ? LOG_UPTO(LOG_DEBUG) : LOG_UPTO(LOG_INFO));
 
     syslog(LOG_INFO, "Starting %s.%s...", RADIO_ROOM_VERSION, BUILD_NUM);
 
@@ -105,26 +225,120 @@ int main(int argc, char** argv) {
         syslog(LOG_ERR, "Can't load configuration file '%s'", config_file.data());
     }
 
-    if (msg_handler.init()) {
+    apply_logging_config();
+
+    MAVLinkLogger::start();
+
+    // The replayed frames are not recorded again
+    if (config.get_tlog_enabled() && replay_file.empty()) {
+        MAVLinkTlog::start(config.get_tlog_path(), (size_t)config.get_tlog_max_file_size() * 1024,
+                           config.get_tlog_max_files(), config.get_tlog_flush_interval(),
+                           config.get_tlog_sync_interval());
+    }
+
+    Metrics::start(config.get_metrics_file(), config.get_metrics_unix_socket(), config.get_metrics_interval());
+
+    /*
+     * The replay speed is set by the clock, so the report periods and timeouts
+     * follow the recorded time.
+     */
+    ScaledClock* scaled_clock = NULL;
+    SimulatedClock* simulated_clock = NULL;
+
+    if (!replay_file.empty() && replay_speed <= 0) {
+        simulated_clock = new SimulatedClock(Clock::now());
+        Clock::set_source(simulated_clock);
+    } else if (!replay_file.empty() && replay_speed != 1) {
+        scaled_clock = new ScaledClock(replay_speed);
+        Clock::set_source(scaled_clock);
+    }
+
+    if (!replay_file.empty() && replay.open(replay_file, 0) < 0) {
+        std::cout << "Failed to open tlog file '" << replay_file << "'." << std::endl;
+        Metrics::stop();
+        MAVLinkLogger::stop();
+        return EXIT_FAILURE;
+    }
+
+    if (msg_handler.init(replay_file.empty() ? NULL : &replay)) {
         syslog(LOG_NOTICE, "%s.%s started.", RADIO_ROOM_VERSION, BUILD_NUM);
     } else {
         syslog(LOG_CRIT, "%s.%s initialization failed.", RADIO_ROOM_VERSION, BUILD_NUM);
+        MAVLinkTlog::stop();
+        Metrics::stop();
+        MAVLinkLogger::stop();
         return EXIT_FAILURE;
     }
 
     signal(SIGTERM, handle_signal);
+    signal(SIGHUP, handle_signal);
+
+    timers.schedule_periodic(LOOP_INTERVAL, [&config_file, &replay_file]() {
+        if (reload_logging) {
+            reload_logging = 0;
+
+            if (config.reload_logging(config_file) < 0) {
+                syslog(LOG_ERR, "Can't reload logging configuration from '%s'", config_file.data());
+            } else {
+                apply_logging_config();
+                syslog(LOG_NOTICE, "Logging configuration reloaded.");
+            }
+        }
+
+        if (!replay_file.empty() && replay.finished()) {
+            running = 0;
+            return;
+        }
+
+        msg_handler.loop();
+
+        Metrics::update();
+    });
+
+    // Without the router loop() keeps the serial buffer drained
+    if (msg_handler.needs_route()) {
+        timers.schedule_periodic(ROUTE_INTERVAL, []() {
+            msg_handler.route();
+        });
+    }
+
+    // Report and heartbeat timers
+    msg_handler.start(timers);
+
+    timers.schedule_periodic(FLUSH_INTERVAL, []() {
+        MAVLinkTlog::flush();
+    });
 
     running = 1;
 
+    MonotonicClock wall_clock;
+    uint64_t start_time = wall_clock.now();
+    double start_cpu_time = get_cpu_time();
+
     while (running) {
-        msg_handler.loop();
-        usleep(100000);
+        Clock::sleep_until(timers.next_expiration());
+        timers.advance();
+    }
+
+    if (!replay_file.empty()) {
+        print_replay_stats(replay_speed > 0 ? replay_speed : 0, Clock::to_seconds(wall_clock.now() - start_time),
+                           get_cpu_time() - start_cpu_time);
     }
 
     syslog(LOG_INFO, "Stopping %s.%s...", RADIO_ROOM_VERSION, BUILD_NUM);
 
     msg_handler.close();
 
+    MAVLinkTlog::stop();
+
+    Metrics::stop();
+
+    MAVLinkLogger::stop();
+
+    Clock::set_source(NULL);
+    delete scaled_clock;
+    delete simulated_clock;
+
     syslog(LOG_NOTICE, "%s.%s stopped.", RADIO_ROOM_VERSION, BUILD_NUM);
 
     closelog();
@@ -0,0 +1,660 @@
+/*
+ ArduPilotSimulator.cc
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "ArduPilotSimulator.h"
+#include "Clock.h"
+#include <math.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LOSS_RATE_SCALE     1000000
+#define MAX_BURST           0.1         // seconds of link bandwidth that can be sent at once
+#define READ_BUFFER_SIZE    1024
+
+// Simulated vehicle circles around the home position
+#define HOME_LAT            47.397742   // degrees
+#define HOME_LON            8.545594    // degrees
+#define HOME_ALT            488.0       // meters AMSL
+#define CIRCLE_ALT          100.0       // meters above home
+#define CIRCLE_RADIUS       200.0       // meters
+#define CIRCLE_PERIOD       120.0       // seconds
+#define EARTH_RADIUS        6378137.0   // meters
+
+// Well known ArduPilot parameters, the rest are named SIM_PARAMnnn
+static const char* const param_names[] = {
+    "SYSID_THISMAV", "SYSID_MYGCS", "SERIAL1_BAUD", "SERIAL1_PROTOCOL", "SR1_EXT_STAT",
+    "SR1_EXTRA1", "SR1_EXTRA2", "SR1_POSITION", "WPNAV_SPEED", "WPNAV_RADIUS",
+    "RTL_ALT", "FENCE_ENABLE", "BATT_CAPACITY", "ARMING_CHECK", "FS_THR_ENABLE"
+};
+
+static const float param_defaults[] = {
+    1, 255, 57, 1, 2, 4, 4, 2, 500, 200, 1500, 0, 3300, 1, 1
+};
+
+ArduPilotSimulator::ArduPilotSimulator() :
+    pty(), parser(), streams(), params(), mission(), responses(),
+    baud_rate(ARDUPILOT_SIM_DEFAULT_BAUD_RATE), latency(0), loss_rate(0), response_loss_rate(0), random_seed(1),
+    start_time(Clock::now()), tokens(0), tokens_time(start_time),
+    mission_upload(false), mission_count(0), mission_seq(0), mission_sysid(0), mission_compid(0),
+    mission_int(false), mission_request_time(0), mission_retries(0), mission_current(0),
+    frames_sent(0), bytes_sent(0), frames_throttled(0), frames_received(0),
+    requests_lost(0), responses_lost(0), mission_uploads(0)
+{
+    // Default rates of ArduPilot telemetry port streams
+    static const Stream default_streams[] = {
+        { MAVLINK_MSG_ID_HEARTBEAT,           1,  0 },
+        { MAVLINK_MSG_ID_SYS_STATUS,          1,  0 },
+        { MAVLINK_MSG_ID_GPS_RAW_INT,         5,  0 },
+        { MAVLINK_MSG_ID_ATTITUDE,            10, 0 },
+        { MAVLINK_MSG_ID_GLOBAL_POSITION_INT, 5,  0 },
+        { MAVLINK_MSG_ID_VFR_HUD,             5,  0 },
+        { MAVLINK_MSG_ID_MISSION_CURRENT,     1,  0 }
+    };
+
+    streams.assign(default_streams, default_streams + sizeof(default_streams) / sizeof(default_streams[0]));
+
+    set_param_count(ARDUPILOT_SIM_DEFAULT_PARAMS);
+}
+
+bool ArduPilotSimulator::open(const std::string& link_path)
+{
+    start_time = Clock::now();
+    tokens = baud_rate / 10.0 * MAX_BURST;
+    tokens_time = start_time;
+
+    for (size_t i = 0; i < streams.size(); i++) {
+        streams[i].next_time = start_time;
+    }
+
+    return pty.open(link_path);
+}
+
+void ArduPilotSimulator::close()
+{
+    pty.close();
+}
+
+void ArduPilotSimulator::set_baud_rate(int baud_rate)
+{
+    this->baud_rate = baud_rate;
+}
+
+bool ArduPilotSimulator::set_message_rate(uint8_t msgid, double rate)
+{
+    for (size_t i = 0; i < streams.size(); i++) {
+        if (streams[i].msgid == msgid) {
+            streams[i].rate = rate > 0 ? rate : 0;
+            streams[i].next_time = Clock::now();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ArduPilotSimulator::scale_message_rates(double factor)
+{
+    for (size_t i = 0; i < streams.size(); i++) {
+        if (streams[i].msgid != MAVLINK_MSG_ID_HEARTBEAT) {
+            streams[i].rate *= factor;
+        }
+    }
+}
+
+void ArduPilotSimulator::set_latency(int ms)
+{
+    latency = (uint64_t)ms * NSEC_PER_MSEC;
+}
+
+void ArduPilotSimulator::set_loss(double rate)
+{
+    loss_rate = (int)(rate * LOSS_RATE_SCALE);
+}
+
+void ArduPilotSimulator::set_response_loss(double rate)
+{
+    response_loss_rate = (int)(rate * LOSS_RATE_SCALE);
+}
+
+void ArduPilotSimulator::set_param_count(size_t count)
+{
+    size_t known = sizeof(param_names) / sizeof(param_names[0]);
+
+    params.resize(count);
+
+    for (size_t i = 0; i < count; i++) {
+        memset(params[i].id, 0, sizeof(params[i].id));
+
+        if (i < known) {
+            strncpy(params[i].id, param_names[i], MAVLINK_MSG_PARAM_VALUE_FIELD_PARAM_ID_LEN);
+            params[i].value = param_defaults[i];
+        } else {
+            snprintf(params[i].id, sizeof(params[i].id), "SIM_PARAM%03u", (unsigned int)i);
+            params[i].value = (float)i;
+        }
+    }
+}
+
+float ArduPilotSimulator::get_param(const char* id) const
+{
+    int index = find_param(id);
+    return index < 0 ? NAN : params[index].value;
+}
+
+void ArduPilotSimulator::run(int timeout)
+{
+    uint64_t now = Clock::now();
+    uint64_t wake_time = now + (uint64_t)timeout * NSEC_PER_MSEC;
+
+    for (size_t i = 0; i < streams.size(); i++) {
+        if (streams[i].rate > 0 && streams[i].next_time < wake_time) {
+            wake_time = streams[i].next_time;
+        }
+    }
+
+    if (!responses.empty() && responses.front().time < wake_time) {
+        wake_time = responses.front().time;
+    }
+
+    if (mission_upload && mission_request_time + ARDUPILOT_SIM_MISSION_TIMEOUT * NSEC_PER_MSEC < wake_time) {
+        wake_time = mission_request_time + ARDUPILOT_SIM_MISSION_TIMEOUT * NSEC_PER_MSEC;
+    }
+
+    struct pollfd pfd;
+    pfd.fd = pty.get_fd();
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+
+    int wait = wake_time > now ? (int)((wake_time - now + NSEC_PER_MSEC - 1) / NSEC_PER_MSEC) : 0;
+
+    if (poll(&pfd, 1, wait) > 0 && (pfd.revents & POLLIN)) {
+        uint8_t buffer[READ_BUFFER_SIZE];
+        int n = pty.read(buffer, sizeof(buffer));
+
+        if (n > 0) {
+            std::vector<MAVLinkFrame> frames;
+            parser.feed(buffer, n, frames);
+
+            now = Clock::now();
+
+            for (size_t i = 0; i < frames.size(); i++) {
+                frames_received++;
+
+                if (loss_rate > 0 && rand_r(&random_seed) % LOSS_RATE_SCALE < loss_rate) {
+                    requests_lost++;
+                    continue;
+                }
+
+                handle(frames[i], now);
+            }
+        }
+    }
+
+    now = Clock::now();
+
+    while (!responses.empty() && responses.front().time <= now) {
+        if (response_loss_rate > 0 && rand_r(&random_seed) % LOSS_RATE_SCALE < response_loss_rate) {
+            responses_lost++;
+        } else {
+            send(responses.front().frame, false, now);
+        }
+
+        responses.pop_front();
+    }
+
+    if (mission_upload && now >= mission_request_time + ARDUPILOT_SIM_MISSION_TIMEOUT * NSEC_PER_MSEC) {
+        if (++mission_retries > ARDUPILOT_SIM_MISSION_RETRIES) {
+            mission_upload = false;
+        } else {
+            request_mission_item(now);
+        }
+    }
+
+    send_streams(now);
+}
+
+void ArduPilotSimulator::send_streams(uint64_t now)
+{
+    for (size_t i = 0; i < streams.size(); i++) {
+        Stream& stream = streams[i];
+
+        if (stream.rate <= 0 || now < stream.next_time) {
+            continue;
+        }
+
+        send_stream_message(stream.msgid, now);
+
+        uint64_t period = (uint64_t)(NSEC_PER_SEC / stream.rate);
+
+        stream.next_time += period;
+
+        // Do not try to catch up after a stall
+        if (stream.next_time < now) {
+            stream.next_time = now + period;
+        }
+    }
+}
+
+void ArduPilotSimulator::send_stream_message(uint8_t msgid, uint64_t now)
+{
+    double t = Clock::to_seconds(now - start_time);
+    double angle = 2 * M_PI * t / CIRCLE_PERIOD;
+    double north = CIRCLE_RADIUS * cos(angle);
+    double east = CIRCLE_RADIUS * sin(angle);
+    double lat = HOME_LAT + north / EARTH_RADIUS * 180 / M_PI;
+    double lon = HOME_LON + east / (EARTH_RADIUS * cos(HOME_LAT * M_PI / 180)) * 180 / M_PI;
+    double speed = 2 * M_PI * CIRCLE_RADIUS / CIRCLE_PERIOD;
+    double heading = fmod(angle + M_PI / 2, 2 * M_PI);
+    uint64_t time_usec = (now - start_time) / NSEC_PER_USEC;
+    uint32_t time_boot_ms = (uint32_t)(time_usec / 1000);
+
+    mavlink_message_t msg;
+
+    switch (msgid) {
+    case MAVLINK_MSG_ID_HEARTBEAT:
+        mavlink_msg_heartbeat_pack_chan(ARDUPILOT_SIM_SYSTEM_ID, ARDUPILOT_SIM_COMPONENT_ID, ARDUPILOT_SIM_CHANNEL, &msg,
+                                        MAV_TYPE_QUADROTOR, MAV_AUTOPILOT_ARDUPILOTMEGA,
+                                        MAV_MODE_FLAG_CUSTOM_MODE_ENABLED | MAV_MODE_FLAG_SAFETY_ARMED,
+                                        3, MAV_STATE_ACTIVE);
+        break;
+    case MAVLINK_MSG_ID_SYS_STATUS:
+        mavlink_msg_sys_status_pack_chan(ARDUPILOT_SIM_SYSTEM_ID, ARDUPILOT_SIM_COMPONENT_ID, ARDUPILOT_SIM_CHANNEL, &msg,
+                                         0x3FFFFF, 0x3FFFFF, 0x3FFFFF, 250, 12400, 1500,
+                                         (int8_t)(100 - fmod(t / 36, 100)), 0, 0, 0, 0, 0, 0);
+        break;
+    case MAVLINK_MSG_ID_GPS_RAW_INT:
+        mavlink_msg_gps_raw_int_pack_chan(ARDUPILOT_SIM_SYSTEM_ID, ARDUPILOT_SIM_COMPONENT_ID, ARDUPILOT_SIM_CHANNEL, &msg,
+                                          time_usec, GPS_FIX_TYPE_3D_FIX, (int32_t)(lat * 1e7), (int32_t)(lon * 1e7),
+                                          (int32_t)((HOME_ALT + CIRCLE_ALT) * 1000), 90, 120,
+                                          (uint16_t)(speed * 100), (uint16_t)(heading * 18000 / M_PI), 12);
+        break;
+    case MAVLINK_MSG_ID_ATTITUDE:
+        mavlink_msg_attitude_pack_chan(ARDUPILOT_SIM_SYSTEM_ID, ARDUPILOT_SIM_COMPONENT_ID, ARDUPILOT_SIM_CHANNEL, &msg,
+                                       time_boot_ms, 0.2f + 0.01f * (float)sin(t), 0.01f * (float)cos(t),
+                                       (float)(heading > M_PI ? heading - 2 * M_PI : heading),
+                                       0.001f, 0.001f, (float)(2 * M_PI / CIRCLE_PERIOD));
+        break;
+    case MAVLINK_MSG_ID_GLOBAL_POSITION_INT:
+        mavlink_msg_global_position_int_pack_chan(ARDUPILOT_SIM_SYSTEM_ID, ARDUPILOT_SIM_COMPONENT_ID, ARDUPILOT_SIM_CHANNEL, &msg,
+                                                  time_boot_ms, (int32_t)(lat * 1e7), (int32_t)(lon * 1e7),
+                                                  (int32_t)((HOME_ALT + CIRCLE_ALT) * 1000), (int32_t)(CIRCLE_ALT * 1000),
+                                                  (int16_t)(speed * 100 * cos(heading)), (int16_t)(speed * 100 * sin(heading)), 0,
+                                                  (uint16_t)(heading * 18000 / M_PI));
+        break;
+    case MAVLINK_MSG_ID_VFR_HUD:
+        mavlink_msg_vfr_hud_pack_chan(ARDUPILOT_SIM_SYSTEM_ID, ARDUPILOT_SIM_COMPONENT_ID, ARDUPILOT_SIM_CHANNEL, &msg,
+                                      (float)speed, (float)speed, (int16_t)(heading * 180 / M_PI), 45,
+                                      (float)(HOME_ALT + CIRCLE_ALT), 0);
+        break;
+    case MAVLINK_MSG_ID_MISSION_CURRENT:
+        mavlink_msg_mission_current_pack_chan(ARDUPILOT_SIM_SYSTEM_ID, ARDUPILOT_SIM_COMPONENT_ID, ARDUPILOT_SIM_CHANNEL, &msg,
+                                              mission_current);
+        break;
+    default:
+        return;
+    }
+
+    send(MAVLinkFrame(msg), true, now);
+}
+
+void ArduPilotSimulator::handle(const MAVLinkFrame& frame, uint64_t now)
+{
+    const mavlink_message_t& msg = frame.get_message();
+
+    switch (msg.msgid) {
+    case MAVLINK_MSG_ID_COMMAND_LONG: {
+        mavlink_command_long_t command;
+        mavlink_msg_command_long_decode(&msg, &command);
+
+        float params[7] = { command.param1, command.param2, command.param3, command.param4,
+                            command.param5, command.param6, command.param7 };
+        handle_command(command.command, params);
+        break;
+    }
+    case MAVLINK_MSG_ID_COMMAND_INT: {
+        mavlink_command_int_t command;
+        mavlink_msg_command_int_decode(&msg, &command);
+
+        float params[7] = { command.param1, command.param2, command.param3, command.param4,
+                            (float)command.x, (float)command.y, command.z };
+        handle_command(command.command, params);
+        break;
+    }
+    case MAVLINK_MSG_ID_REQUEST_DATA_STREAM: {
+        mavlink_request_data_stream_t request;
+        mavlink_msg_request_data_stream_decode(&msg, &request);
+
+        double rate = request.start_stop ? request.req_message_rate : 0;
+
+        switch (request.req_stream_id) {
+        case MAV_DATA_STREAM_ALL:
+            for (size_t i = 0; i < streams.size(); i++) {
+                if (streams[i].msgid != MAVLINK_MSG_ID_HEARTBEAT) {
+                    set_message_rate(streams[i].msgid, rate);
+                }
+            }
+            break;
+        case MAV_DATA_STREAM_EXTENDED_STATUS:
+            set_message_rate(MAVLINK_MSG_ID_SYS_STATUS, rate);
+            set_message_rate(MAVLINK_MSG_ID_GPS_RAW_INT, rate);
+            set_message_rate(MAVLINK_MSG_ID_MISSION_CURRENT, rate);
+            break;
+        case MAV_DATA_STREAM_POSITION:
+            set_message_rate(MAVLINK_MSG_ID_GLOBAL_POSITION_INT, rate);
+            break;
+        case MAV_DATA_STREAM_EXTRA1:
+            set_message_rate(MAVLINK_MSG_ID_ATTITUDE, rate);
+            break;
+        case MAV_DATA_STREAM_EXTRA2:
+            set_message_rate(MAVLINK_MSG_ID_VFR_HUD, rate);
+            break;
+        }
+        break;
+    }
+    case MAVLINK_MSG_ID_PARAM_REQUEST_LIST:
+        for (size_t i = 0; i < params.size(); i++) {
+            send_param(i);
+        }
+        break;
+    case MAVLINK_MSG_ID_PARAM_REQUEST_READ: {
+        mavlink_param_request_read_t request;
+        mavlink_msg_param_request_read_decode(&msg, &request);
+
+        char id[MAVLINK_MSG_PARAM_VALUE_FIELD_PARAM_ID_LEN + 1] = {};
+        memcpy(id, request.param_id, MAVLINK_MSG_PARAM_VALUE_FIELD_PARAM_ID_LEN);
+
+        int index = request.param_index >= 0 ? request.param_index : find_param(id);
+
+        if (index >= 0 && (size_t)index < params.size()) {
+            send_param(index);
+        }
+        break;
+    }
+    case MAVLINK_MSG_ID_PARAM_SET: {
+        mavlink_param_set_t param_set;
+        mavlink_msg_param_set_decode(&msg, &param_set);
+
+        char id[MAVLINK_MSG_PARAM_VALUE_FIELD_PARAM_ID_LEN + 1] = {};
+        memcpy(id, param_set.param_id, MAVLINK_MSG_PARAM_VALUE_FIELD_PARAM_ID_LEN);
+
+        // Like ArduPilot, unknown parameters are ignored
+        int index = find_param(id);
+
+        if (index >= 0) {
+            params[index].value = param_set.param_value;
+            send_param(index);
+        }
+        break;
+    }
+    case MAVLINK_MSG_ID_MISSION_COUNT: {
+        mavlink_mission_count_t count;
+        mavlink_msg_mission_count_decode(&msg, &count);
+
+        if (count.count > ARDUPILOT_SIM_MAX_MISSION_ITEMS) {
+            send_mission_ack(msg.sysid, msg.compid, MAV_MISSION_NO_SPACE);
+            break;
+        }
+
+        mission.clear();
+
+        if (count.count == 0) {
+            send_mission_ack(msg.sysid, msg.compid, MAV_MISSION_ACCEPTED);
+            break;
+        }
+
+        mission.resize(count.count);
+        mission_upload = true;
+        mission_count = count.count;
+        mission_seq = 0;
+        mission_sysid = msg.sysid;
+        mission_compid = msg.compid;
+        mission_int = false;
+        mission_retries = 0;
+        request_mission_item(now);
+        break;
+    }
+    case MAVLINK_MSG_ID_MISSION_ITEM: {
+        mavlink_mission_item_t item;
+        mavlink_msg_mission_item_decode(&msg, &item);
+
+        mavlink_mission_item_int_t item_int;
+        item_int.param1 = item.param1;
+        item_int.param2 = item.param2;
+        item_int.param3 = item.param3;
+        item_int.param4 = item.param4;
+        item_int.x = (int32_t)lround(item.x * 1e7);
+        item_int.y = (int32_t)lround(item.y * 1e7);
+        item_int.z = item.z;
+        item_int.seq = item.seq;
+        item_int.command = item.command;
+        item_int.target_system = item.target_system;
+        item_int.target_component = item.target_component;
+        item_int.frame = item.frame;
+        item_int.current = item.current;
+        item_int.autocontinue = item.autocontinue;
+
+        handle_mission_item(item_int, now);
+        break;
+    }
+    case MAVLINK_MSG_ID_MISSION_ITEM_INT: {
+        mavlink_mission_item_int_t item;
+        mavlink_msg_mission_item_int_decode(&msg, &item);
+
+        mission_int = true;
+        handle_mission_item(item, now);
+        break;
+    }
+    case MAVLINK_MSG_ID_MISSION_REQUEST_LIST: {
+        mavlink_message_t count;
+        mavlink_msg_mission_count_pack_chan(ARDUPILOT_SIM_SYSTEM_ID, ARDUPILOT_SIM_COMPONENT_ID, ARDUPILOT_SIM_CHANNEL, &count,
+                                            msg.sysid, msg.compid, (uint16_t)mission.size());
+        respond(count);
+        break;
+    }
+    case MAVLINK_MSG_ID_MISSION_REQUEST:
+        send_mission_item(msg.sysid, msg.compid, mavlink_msg_mission_request_get_seq(&msg), false);
+        break;
+    case MAVLINK_MSG_ID_MISSION_REQUEST_INT:
+        send_mission_item(msg.sysid, msg.compid, mavlink_msg_mission_request_int_get_seq(&msg), true);
+        break;
+    case MAVLINK_MSG_ID_MISSION_CLEAR_ALL:
+        mission.clear();
+        mission_upload = false;
+        send_mission_ack(msg.sysid, msg.compid, MAV_MISSION_ACCEPTED);
+        break;
+    case MAVLINK_MSG_ID_MISSION_SET_CURRENT: {
+        mission_current = mavlink_msg_mission_set_current_get_seq(&msg);
+
+        mavlink_message_t current;
+        mavlink_msg_mission_current_pack_chan(ARDUPILOT_SIM_SYSTEM_ID, ARDUPILOT_SIM_COMPONENT_ID, ARDUPILOT_SIM_CHANNEL, &current,
+                                              mission_current);
+        respond(current);
+        break;
+    }
+    }
+}
+
+void ArduPilotSimulator::handle_command(uint16_t command, const float* params)
+{
+    uint8_t result = MAV_RESULT_ACCEPTED;
+    mavlink_message_t msg;
+
+    switch (command) {
+    case MAV_CMD_REQUEST_AUTOPILOT_CAPABILITIES: {
+        uint8_t custom_version[8] = {};
+        mavlink_msg_autopilot_version_pack_chan(ARDUPILOT_SIM_SYSTEM_ID, ARDUPILOT_SIM_COMPONENT_ID, ARDUPILOT_SIM_CHANNEL, &msg,
+                                                MAV_PROTOCOL_CAPABILITY_MISSION_FLOAT | MAV_PROTOCOL_CAPABILITY_PARAM_FLOAT |
+                                                MAV_PROTOCOL_CAPABILITY_MISSION_INT | MAV_PROTOCOL_CAPABILITY_COMMAND_INT |
+                                                MAV_PROTOCOL_CAPABILITY_SET_POSITION_TARGET_GLOBAL_INT,
+                                                ARDUPILOT_SIM_VERSION, 0, 0, 0,
+                                                custom_version, custom_version, custom_version, 0, 0, 1);
+        respond(msg);
+        break;
+    }
+    case MAV_CMD_SET_MESSAGE_INTERVAL:
+        if (params[1] < 0) {
+            result = set_message_rate((uint8_t)params[0], 0) ? MAV_RESULT_ACCEPTED : MAV_RESULT_UNSUPPORTED;
+        } else if (params[1] > 0) {
+            result = set_message_rate((uint8_t)params[0], 1e6 / params[1]) ? MAV_RESULT_ACCEPTED : MAV_RESULT_UNSUPPORTED;
+        }
+        break;
+    }
+
+    mavlink_msg_command_ack_pack_chan(ARDUPILOT_SIM_SYSTEM_ID, ARDUPILOT_SIM_COMPONENT_ID, ARDUPILOT_SIM_CHANNEL, &msg,
+                                      command, result);
+    respond(msg);
+}
+
+void ArduPilotSimulator::handle_mission_item(const mavlink_mission_item_int_t& item, uint64_t now)
+{
+    if (!mission_upload) {
+        send_mission_ack(mission_sysid, mission_compid, MAV_MISSION_ERROR);
+        return;
+    }
+
+    if (item.seq != mission_seq) {
+        // Out of order item, request the expected one again
+        request_mission_item(now);
+        return;
+    }
+
+    mission[mission_seq++] = item;
+    mission_retries = 0;
+
+    if (mission_seq < mission_count) {
+        request_mission_item(now);
+        return;
+    }
+
+    mission_upload = false;
+    mission_uploads++;
+    send_mission_ack(mission_sysid, mission_compid, MAV_MISSION_ACCEPTED);
+}
+
+void ArduPilotSimulator::request_mission_item(uint64_t now)
+{
+    mavlink_message_t msg;
+
+    if (mission_int) {
+        mavlink_msg_mission_request_int_pack_chan(ARDUPILOT_SIM_SYSTEM_ID, ARDUPILOT_SIM_COMPONENT_ID, ARDUPILOT_SIM_CHANNEL, &msg,
+                                                  mission_sysid, mission_compid, mission_seq);
+    } else {
+        mavlink_msg_mission_request_pack_chan(ARDUPILOT_SIM_SYSTEM_ID, ARDUPILOT_SIM_COMPONENT_ID, ARDUPILOT_SIM_CHANNEL, &msg,
+                                              mission_sysid, mission_compid, mission_seq);
+    }
+
+    mission_request_time = now;
+    respond(msg);
+}
+
+void ArduPilotSimulator::send_param(int index)
+{
+    mavlink_message_t msg;
+    mavlink_msg_param_value_pack_chan(ARDUPILOT_SIM_SYSTEM_ID, ARDUPILOT_SIM_COMPONENT_ID, ARDUPILOT_SIM_CHANNEL, &msg,
+                                      params[index].id, params[index].value, MAV_PARAM_TYPE_REAL32,
+                                      (uint16_t)params.size(), (uint16_t)index);
+    respond(msg);
+}
+
+void ArduPilotSimulator::send_mission_item(uint8_t sysid, uint8_t compid, uint16_t seq, bool item_int)
+{
+    if (seq >= mission.size()) {
+        send_mission_ack(sysid, compid, MAV_MISSION_INVALID_SEQUENCE);
+        return;
+    }
+
+    const mavlink_mission_item_int_t& item = mission[seq];
+    mavlink_message_t msg;
+
+    if (item_int) {
+        mavlink_msg_mission_item_int_pack_chan(ARDUPILOT_SIM_SYSTEM_ID, ARDUPILOT_SIM_COMPONENT_ID, ARDUPILOT_SIM_CHANNEL, &msg,
+                                               sysid, compid, seq, item.frame, item.command, seq == mission_current,
+                                               item.autocontinue, item.param1, item.param2, item.param3, item.param4,
+                                               item.x, item.y, item.z);
+    } else {
+        mavlink_msg_mission_item_pack_chan(ARDUPILOT_SIM_SYSTEM_ID, ARDUPILOT_SIM_COMPONENT_ID, ARDUPILOT_SIM_CHANNEL, &msg,
+                                           sysid, compid, seq, item.frame, item.command, seq == mission_current,
+                                           item.autocontinue, item.param1, item.param2, item.param3, item.param4,
+                                           item.x / 1e7f, item.y / 1e7f, item.z);
+    }
+
+    respond(msg);
+}
+
+void ArduPilotSimulator::send_mission_ack(uint8_t sysid, uint8_t compid, uint8_t type)
+{
+    mavlink_message_t msg;
+    mavlink_msg_mission_ack_pack_chan(ARDUPILOT_SIM_SYSTEM_ID, ARDUPILOT_SIM_COMPONENT_ID, ARDUPILOT_SIM_CHANNEL, &msg,
+                                      sysid, compid, type);
+    respond(msg);
+}
+
+int ArduPilotSimulator::find_param(const char* id) const
+{
+    for (size_t i = 0; i < params.size(); i++) {
+        if (strncmp(params[i].id, id, MAVLINK_MSG_PARAM_VALUE_FIELD_PARAM_ID_LEN) == 0) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+void ArduPilotSimulator::respond(const mavlink_message_t& msg)
+{
+    Response response;
+    response.time = Clock::now() + latency;
+    response.frame = MAVLinkFrame(msg);
+    responses.push_back(response);
+}
+
+bool ArduPilotSimulator::send(const MAVLinkFrame& frame, bool throttle, uint64_t now)
+{
+    if (baud_rate > 0) {
+        // 10 bits per byte on the wire
+        double rate = baud_rate / 10.0;
+
+        tokens += Clock::to_seconds(now - tokens_time) * rate;
+        tokens_time = now;
+
+        if (tokens > rate * MAX_BURST) {
+            tokens = rate * MAX_BURST;
+        }
+
+        if (throttle && tokens < frame.size()) {
+            frames_throttled++;
+            return false;
+        }
+
+        tokens -= frame.size();
+    }
+
+    if (!pty.write(frame.data(), frame.size())) {
+        return false;
+    }
+
+    frames_sent++;
+    bytes_sent += frame.size();
+    return true;
+}
@@ -0,0 +1,208 @@
+/*
+ ArduPilotSimulator.h
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef ARDUPILOTSIMULATOR_H_
+#define ARDUPILOTSIMULATOR_H_
+
+#include <stdint.h>
+#include <atomic>
+#include <deque>
+#include <string>
+#include <vector>
+#include "mavlink.h"
+#include "MAVLinkParser.h"
+#include "PseudoTerminal.h"
+
+#define ARDUPILOT_SIM_SYSTEM_ID         1
+#define ARDUPILOT_SIM_COMPONENT_ID      1
+#define ARDUPILOT_SIM_CHANNEL           MAVLINK_COMM_1
+#define ARDUPILOT_SIM_VERSION           0x03050100  // 3.5.1 official
+
+#define ARDUPILOT_SIM_DEFAULT_BAUD_RATE 57600
+#define ARDUPILOT_SIM_DEFAULT_PARAMS    400
+#define ARDUPILOT_SIM_MISSION_TIMEOUT   1000        // milliseconds between mission item requests
+#define ARDUPILOT_SIM_MISSION_RETRIES   5
+#define ARDUPILOT_SIM_MAX_MISSION_ITEMS 718
+
+/**
+ * Simulates ArduPilot autopilot on a pseudo terminal.
+ *
+ * The simulator streams HEARTBEAT, SYS_STATUS, GPS_RAW_INT, ATTITUDE,
+ * GLOBAL_POSITION_INT, VFR_HUD and MISSION_CURRENT messages of a vehicle
+ * circling around its home position at configurable rates. The stream is
+ * limited to the bandwidth of the configured baud rate, the messages that
+ * do not fit are skipped and counted.
+ *
+ * The simulator answers COMMAND_LONG, COMMAND_INT, the parameter protocol
+ * and the mission protocol. The responses are delayed by the configured
+ * latency and the requests and responses are lost with the configured
+ * probabilities.
+ *
+ * run() must be called from a single thread. The statistics can be read
+ * from any thread.
+ */
+class ArduPilotSimulator {
+    struct Stream {
+        uint8_t  msgid;
+        double   rate;       // Hz, 0 if disabled
+        uint64_t next_time;
+    };
+
+    struct Param {
+        char  id[MAVLINK_MSG_PARAM_VALUE_FIELD_PARAM_ID_LEN + 1];
+        float value;
+    };
+
+    struct Response {
+        uint64_t     time;
+        MAVLinkFrame frame;
+    };
+
+    PseudoTerminal                          pty;
+    MAVLinkParser                           parser;
+    std::vector<Stream>                     streams;
+    std::vector<Param>                      params;
+    std::vector<mavlink_mission_item_int_t> mission;
+    std::deque<Response>                    responses;   // ordered by time
+
+    int                     baud_rate;
+    uint64_t                latency;
+    std::atomic<int>        loss_rate;   // per million requests
+    std::atomic<int>        response_loss_rate; // per million responses
+    unsigned int            random_seed;
+    uint64_t                start_time;
+    double                  tokens;      // bytes the link can send now
+    uint64_t                tokens_time;
+
+    // Mission upload state
+    bool                    mission_upload;
+    uint16_t                mission_count;
+    uint16_t                mission_seq;
+    uint8_t                 mission_sysid;
+    uint8_t                 mission_compid;
+    bool                    mission_int;
+    uint64_t                mission_request_time;
+    int                     mission_retries;
+    uint16_t                mission_current;
+
+public:
+    std::atomic<uint64_t>   frames_sent;
+    std::atomic<uint64_t>   bytes_sent;
+    std::atomic<uint64_t>   frames_throttled;  // stream messages skipped because of the baud rate
+    std::atomic<uint64_t>   frames_received;
+    std::atomic<uint64_t>   requests_lost;
+    std::atomic<uint64_t>   responses_lost;
+    std::atomic<uint64_t>   mission_uploads;
+
+    ArduPilotSimulator();
+
+    /**
+     * Creates the pseudo terminal.
+     *
+     * link_path - symbolic link to the device, not created if empty
+     *
+     * Returns true on success.
+     */
+    bool open(const std::string& link_path);
+
+    /**
+     * Closes the pseudo terminal.
+     */
+    void close();
+
+    /**
+     * Returns the path of the simulated serial device.
+     */
+    inline const std::string& get_path() const { return pty.get_path(); }
+
+    /**
+     * Sets the baud rate that limits the stream bandwidth, 0 for unlimited.
+     */
+    void set_baud_rate(int baud_rate);
+
+    /**
+     * Sets the rate in Hz of the message stream. Returns false for unsupported messages.
+     */
+    bool set_message_rate(uint8_t msgid, double rate);
+
+    /**
+     * Multiplies the rates of all streams except HEARTBEAT by the factor.
+     */
+    void scale_message_rates(double factor);
+
+    /**
+     * Sets the delay of the responses in milliseconds.
+     */
+    void set_latency(int ms);
+
+    /**
+     * Sets the probability of losing a request from 0 to 1.
+     */
+    void set_loss(double rate);
+
+    /**
+     * Sets the probability of losing a response from 0 to 1.
+     */
+    void set_response_loss(double rate);
+
+    /**
+     * Sets the number of parameters.
+     */
+    void set_param_count(size_t count);
+
+    /**
+     * Returns the number of mission items.
+     */
+    inline size_t get_mission_size() const { return mission.size(); }
+
+    /**
+     * Returns the mission item.
+     */
+    inline const mavlink_mission_item_int_t& get_mission_item(size_t seq) const { return mission[seq]; }
+
+    /**
+     * Returns the value of the parameter or NAN if the parameter does not exist.
+     */
+    float get_param(const char* id) const;
+
+    /**
+     * Sends the stream messages and responses that are due and processes
+     * the requests received, waiting no longer than the timeout in milliseconds.
+     */
+    void run(int timeout);
+
+private:
+    void send_streams(uint64_t now);
+    void send_stream_message(uint8_t msgid, uint64_t now);
+    void handle(const MAVLinkFrame& frame, uint64_t now);
+    void handle_command(uint16_t command, const float* params);
+    void handle_mission_item(const mavlink_mission_item_int_t& item, uint64_t now);
+    void request_mission_item(uint64_t now);
+    void send_param(int index);
+    void send_mission_item(uint8_t sysid, uint8_t compid, uint16_t seq, bool item_int);
+    void send_mission_ack(uint8_t sysid, uint8_t compid, uint8_t type);
+    int  find_param(const char* id) const;
+    void respond(const mavlink_message_t& msg);
+    bool send(const MAVLinkFrame& frame, bool throttle, uint64_t now);
+};
+
+#endif /* ARDUPILOTSIMULATOR_H_ */
@@ -0,0 +1,135 @@
+/*
+ ArduPilotSimulatorMain.cc
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/*
+ * ArduPilot simulator on a pseudo terminal.
+ *
+ * Usage: ardupilot_simulator [options]
+ *
+ * Point autopilot serial of radioroom.conf to the link created with -l option.
+ * The link statistics are printed on exit.
+ */
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string>
+#include "ArduPilotSimulator.h"
+
+#define RUN_INTERVAL 100 // milliseconds
+
+static volatile sig_atomic_t running = 1;
+
+static void handle_signal(int sig)
+{
+    (void)sig;
+    running = 0;
+}
+
+static void print_help()
+{
+    printf("Usage: ardupilot_simulator [options]\n");
+    printf("options:\n");
+    printf("    -l <path>         Create symbolic link to the simulated serial device.\n");
+    printf("    -b <baud rate>    Baud rate limiting the stream bandwidth, 0 for unlimited (default %d).\n",
+           ARDUPILOT_SIM_DEFAULT_BAUD_RATE);
+    printf("    -m <msgid>:<Hz>   Rate of message stream, can be repeated.\n");
+    printf("    -s <factor>       Multiply the rates of all streams except HEARTBEAT.\n");
+    printf("    -d <ms>           Latency of the responses (default 0).\n");
+    printf("    -L <rate>         Fraction of lost requests from 0 to 1 (default 0).\n");
+    printf("    -R <rate>         Fraction of lost responses from 0 to 1 (default 0).\n");
+    printf("    -p <count>        Number of parameters (default %d).\n", ARDUPILOT_SIM_DEFAULT_PARAMS);
+    printf("    -h                Print this help and exit.\n");
+}
+
+int main(int argc, char** argv)
+{
+    ArduPilotSimulator simulator;
+    std::string link_path;
+    unsigned int msgid;
+    double rate;
+
+    int c;
+    while ((c = getopt(argc, argv, "l:b:m:s:d:L:R:p:h")) != -1) {
+        switch (c) {
+        case 'l':
+            link_path = optarg;
+            break;
+        case 'b':
+            simulator.set_baud_rate(atoi(optarg));
+            break;
+        case 'm':
+            if (sscanf(optarg, "%u:%lf", &msgid, &rate) != 2 || msgid > 255 ||
+                !simulator.set_message_rate((uint8_t)msgid, rate)) {
+                fprintf(stderr, "Invalid or unsupported message rate '%s'.\n", optarg);
+                return EXIT_FAILURE;
+            }
+            break;
+        case 's':
+            simulator.scale_message_rates(atof(optarg));
+            break;
+        case 'd':
+            simulator.set_latency(atoi(optarg));
+            break;
+        case 'L':
+            simulator.set_loss(atof(optarg));
+            break;
+        case 'R':
+            simulator.set_response_loss(atof(optarg));
+            break;
+        case 'p':
+            simulator.set_param_count(atoi(optarg));
+            break;
+        case 'h':
+            print_help();
+            return EXIT_SUCCESS;
+        default:
+            print_help();
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (!simulator.open(link_path)) {
+        return EXIT_FAILURE;
+    }
+
+    printf("ArduPilot simulator is running on '%s'.\n", simulator.get_path().data());
+    fflush(stdout);
+
+    signal(SIGINT, handle_signal);
+    signal(SIGTERM, handle_signal);
+
+    while (running) {
+        simulator.run(RUN_INTERVAL);
+    }
+
+    simulator.close();
+
+    printf("Frames sent: %llu (%llu bytes), throttled: %llu, received: %llu, lost: %llu/%llu, mission uploads: %llu\n",
+           (unsigned long long)simulator.frames_sent.load(), (unsigned long long)simulator.bytes_sent.load(),
+           (unsigned long long)simulator.frames_throttled.load(), (unsigned long long)simulator.frames_received.load(),
+           (unsigned long long)simulator.requests_lost.load(), (unsigned long long)simulator.responses_lost.load(),
+           (unsigned long long)simulator.mission_uploads.load());
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,134 @@
+/*
+ ArduPilotSimulatorTest.cc
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/*
+ * Connects MAVLinkSerial to ArduPilot simulator and exercises autopilot
+ * detection, the telemetry stream, commands, parameters and mission upload.
+ *
+ * Returns 0 if all the checks passed.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <atomic>
+#include <thread>
+#include "ArduPilotSimulator.h"
+#include "Clock.h"
+#include "MAVLinkSerial.h"
+#include "TestUtil.h"
+
+#define RUN_INTERVAL        10      // milliseconds
+#define STREAM_TIME         1       // seconds
+#define COMMANDS            20
+#define MISSION_ITEMS       20
+
+int main()
+{
+    ArduPilotSimulator simulator;
+
+    if (!simulator.open("")) {
+        return 1;
+    }
+
+    std::atomic<bool> running(true);
+
+    std::thread simulator_thread([&]() {
+        while (running) {
+            simulator.run(RUN_INTERVAL);
+        }
+    });
+
+    MAVLinkSerial autopilot;
+    CHECK(autopilot.init(simulator.get_path(), ARDUPILOT_SIM_DEFAULT_BAUD_RATE, vector<string>()));
+
+    // Telemetry stream
+    int counts[256] = {};
+    mavlink_message_t msg;
+
+    for (uint64_t deadline = Clock::now() + STREAM_TIME * NSEC_PER_SEC; Clock::now() < deadline;) {
+        if (autopilot.receive_message(msg)) {
+            counts[msg.msgid]++;
+        }
+    }
+
+    printf("Received in %d s: %d HEARTBEAT, %d GPS_RAW_INT, %d ATTITUDE\n", STREAM_TIME,
+           counts[MAVLINK_MSG_ID_HEARTBEAT], counts[MAVLINK_MSG_ID_GPS_RAW_INT], counts[MAVLINK_MSG_ID_ATTITUDE]);
+
+    CHECK(counts[MAVLINK_MSG_ID_HEARTBEAT] >= 1);
+    CHECK(counts[MAVLINK_MSG_ID_GPS_RAW_INT] >= 4);
+    CHECK(counts[MAVLINK_MSG_ID_ATTITUDE] >= 8);
+
+    // Command ACK latency
+    mavlink_message_t ack;
+    uint64_t start = Clock::now();
+
+    for (int i = 0; i < COMMANDS; i++) {
+        mavlink_msg_command_long_pack(SYSTEM_ID, COMPONENT_ID, &msg, ARDUPILOT_SYSTEM_ID, ARDUPILOT_COMPONENT_ID,
+                                      MAV_CMD_COMPONENT_ARM_DISARM, 0, 1, 0, 0, 0, 0, 0, 0);
+        CHECK(autopilot.send_receive_message(msg, ack));
+        CHECK(ack.msgid == MAVLINK_MSG_ID_COMMAND_ACK &&
+              mavlink_msg_command_ack_get_result(&ack) == MAV_RESULT_ACCEPTED);
+    }
+
+    printf("COMMAND_ACK latency: %.3f ms\n", Clock::to_seconds(Clock::now() - start) * 1000 / COMMANDS);
+
+    // Parameters
+    mavlink_msg_param_set_pack(SYSTEM_ID, COMPONENT_ID, &msg, ARDUPILOT_SYSTEM_ID, ARDUPILOT_COMPONENT_ID,
+                               "RTL_ALT", 3000, MAV_PARAM_TYPE_REAL32);
+    CHECK(autopilot.send_receive_message(msg, ack));
+    CHECK(ack.msgid == MAVLINK_MSG_ID_PARAM_VALUE && mavlink_msg_param_value_get_param_value(&ack) == 3000);
+
+    // Mission upload
+    mavlink_msg_mission_count_pack(SYSTEM_ID, COMPONENT_ID, &msg, ARDUPILOT_SYSTEM_ID, ARDUPILOT_COMPONENT_ID,
+                                   MISSION_ITEMS);
+    CHECK(autopilot.send_message(msg));
+
+    bool requested = false;
+
+    for (uint64_t deadline = Clock::now() + NSEC_PER_SEC; Clock::now() < deadline && !requested;) {
+        requested = autopilot.receive_message(ack) && ack.msgid == MAVLINK_MSG_ID_MISSION_REQUEST &&
+                    mavlink_msg_mission_request_get_seq(&ack) == 0;
+    }
+
+    CHECK(requested);
+
+    for (int i = 0; i < MISSION_ITEMS; i++) {
+        mavlink_msg_mission_item_pack(SYSTEM_ID, COMPONENT_ID, &msg, ARDUPILOT_SYSTEM_ID, ARDUPILOT_COMPONENT_ID,
+                                      i, MAV_FRAME_GLOBAL_RELATIVE_ALT, MAV_CMD_NAV_WAYPOINT, 0, 1,
+                                      0, 0, 0, 0, 47.4f + i * 0.001f, 8.5f, 100);
+        CHECK(autopilot.send_receive_message(msg, ack));
+        CHECK(ack.msgid == MAVLINK_MSG_ID_MISSION_ACK && mavlink_msg_mission_ack_get_type(&ack) == MAV_MISSION_ACCEPTED);
+    }
+
+    running = false;
+    simulator_thread.join();
+    autopilot.close();
+
+    CHECK(simulator.get_param("RTL_ALT") == 3000);
+    CHECK(simulator.mission_uploads == 1);
+    CHECK(simulator.get_mission_size() == MISSION_ITEMS);
+    CHECK(simulator.get_mission_size() == MISSION_ITEMS &&
+          abs(simulator.get_mission_item(MISSION_ITEMS - 1).x - (int32_t)lround((47.4f + (MISSION_ITEMS - 1) * 0.001f) * 1e7)) < 10);
+    CHECK(simulator.frames_throttled == 0);
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,169 @@
+/*
+ ISBDCreditBudgetTest.cc
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+/*
+ * Checks the report period, report size and event reports allowed by the
+ * ISBD credit budget, the spent credits kept in the credit file across
+ * restarts, and the windows following the wall time of a simulated clock.
+ *
+ * Returns 0 if all the checks passed.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "Clock.h"
+#include "ISBDCreditBudget.h"
+#include "IridiumSBD.h"
+#include "TestUtil.h"
+
+#define HOUR_START          1499997600  // 2017-07-14 02:00:00 UTC
+#define DAY_START           1499990400  // 2017-07-14
+#define MONTH_START         1498867200  // 2017-07-01
+#define MONTH_END           1501545600  // 2017-08-01
+#define REPORT_PERIOD       30.0        // seconds
+
+int main()
+{
+    time_t now = HOUR_START + 1800;
+
+    CHECK(ISBDCreditBudget::window_start(ISBD_BUDGET_HOUR, now) == HOUR_START);
+    CHECK(ISBDCreditBudget::window_end(ISBD_BUDGET_HOUR, now) == HOUR_START + 3600);
+    CHECK(ISBDCreditBudget::window_start(ISBD_BUDGET_DAY, now) == DAY_START);
+    CHECK(ISBDCreditBudget::window_start(ISBD_BUDGET_MONTH, now) == MONTH_START);
+    CHECK(ISBDCreditBudget::window_end(ISBD_BUDGET_MONTH, now) == MONTH_END);
+    CHECK(ISBDCreditBudget::window_end(ISBD_BUDGET_MONTH, 1513296000) == 1514764800); // December
+
+    CHECK(ISBDCreditBudget::credits(0) == 0);
+    CHECK(ISBDCreditBudget::credits(50) == 1);
+    CHECK(ISBDCreditBudget::credits(51) == 2);
+
+    // No budget does not change the reports
+    ISBDCreditBudget unlimited;
+    CHECK(!unlimited.is_limited());
+    CHECK(unlimited.get_remaining(now) == -1);
+    CHECK(unlimited.get_report_period(REPORT_PERIOD, 3, now) == REPORT_PERIOD);
+    CHECK(unlimited.get_report_size(REPORT_PERIOD, now) == ISBD_MAX_MO_MGS_SIZE);
+    CHECK(unlimited.allows_event(REPORT_PERIOD, 3, now));
+
+    // 60 credits in the half hour left allow a one-credit report every 30 seconds
+    ISBDCreditBudget budget;
+    budget.set_budget(ISBD_BUDGET_HOUR, 60);
+    CHECK(budget.is_limited());
+    CHECK(budget.get_report_period(REPORT_PERIOD, 1, now) == REPORT_PERIOD);
+    CHECK(budget.get_report_size(REPORT_PERIOD, now) == ISBD_CREDIT_SIZE);
+    CHECK(!budget.allows_event(REPORT_PERIOD, 1, now));
+
+    // Reports of 2 credits are sent half as often
+    CHECK(budget.get_report_period(REPORT_PERIOD, 2, now) == 2 * REPORT_PERIOD);
+    CHECK(budget.get_report_size(2 * REPORT_PERIOD, now) == 2 * ISBD_CREDIT_SIZE);
+
+    // Spare credits allow event reports
+    CHECK(budget.allows_event(2 * REPORT_PERIOD, 1, now));
+
+    // Tighter day budget limits the rate
+    budget.set_budget(ISBD_BUDGET_DAY, 60);
+    double day_left = DAY_START + 86400 - now;
+    CHECK(fabs(budget.get_report_period(REPORT_PERIOD, 1, now) - day_left / 60) < 1e-6);
+
+    // Spent budget stops the reports until the window ends
+    budget.set_budget(ISBD_BUDGET_DAY, 0);
+    budget.spend(60, now);
+    CHECK(budget.get_spent(ISBD_BUDGET_HOUR, now) == 60);
+    CHECK(budget.get_remaining(now) == 0);
+    CHECK(budget.get_report_period(REPORT_PERIOD, 1, now) == 1800);
+    CHECK(!budget.allows_event(REPORT_PERIOD, 1, now));
+
+    CHECK(budget.get_spent(ISBD_BUDGET_HOUR, now + 1800) == 0);
+    CHECK(budget.get_remaining(now + 1800) == 60);
+    CHECK(budget.get_spent(ISBD_BUDGET_DAY, now + 1800) == 60);
+
+    // 60 credits spent in the first 2.5 hours of the day
+    CHECK(fabs(budget.get_burn_rate(now) - 24) < 1e-6);
+
+    // The spent credits are kept across restarts
+    char path[] = "/tmp/radioroom-credits-XXXXXX";
+    int fd = mkstemp(path);
+
+    if (fd < 0) {
+        return 1;
+    }
+
+    ::close(fd);
+    unlink(path);
+
+    ISBDCreditBudget kept;
+    kept.set_budget(ISBD_BUDGET_MONTH, 1000);
+    CHECK(kept.open(path, now));
+    kept.spend(5, now);
+    kept.spend(7, now + 10);
+
+    ISBDCreditBudget restarted;
+    restarted.set_budget(ISBD_BUDGET_MONTH, 1000);
+    CHECK(restarted.open(path, now + 20));
+    CHECK(restarted.get_spent(ISBD_BUDGET_HOUR, now + 20) == 12);
+    CHECK(restarted.get_remaining(now + 20) == 988);
+
+    // Only the counters of the current windows are loaded
+    ISBDCreditBudget next_hour;
+    CHECK(next_hour.open(path, now + 3600));
+    CHECK(next_hour.get_spent(ISBD_BUDGET_HOUR, now + 3600) == 0);
+    CHECK(next_hour.get_spent(ISBD_BUDGET_DAY, now + 3600) == 12);
+
+    ISBDCreditBudget next_month;
+    CHECK(next_month.open(path, MONTH_END));
+    CHECK(next_month.get_spent(ISBD_BUDGET_MONTH, MONTH_END) == 0);
+
+    // Invalid file starts with no credits spent
+    FILE* file = fopen(path, "w");
+    CHECK(file != NULL && fputs("garbage\n", file) >= 0);
+    fclose(file);
+
+    ISBDCreditBudget invalid;
+    CHECK(!invalid.open(path, now));
+    CHECK(invalid.get_spent(ISBD_BUDGET_MONTH, now) == 0);
+
+    // The windows follow the wall time of the simulated clock
+    SimulatedClock simulated_clock(NSEC_PER_SEC);
+    simulated_clock.set_wall_time(now);
+    Clock::set_source(&simulated_clock);
+
+    ISBDCreditBudget simulated;
+    simulated.set_budget(ISBD_BUDGET_HOUR, 10);
+    simulated.spend(4, Clock::wall_time());
+    CHECK(Clock::wall_time() == now);
+    CHECK(simulated.get_remaining(Clock::wall_time()) == 6);
+
+    Clock::sleep(3600 * NSEC_PER_SEC);
+
+    CHECK(Clock::wall_time() == now + 3600);
+    CHECK(simulated.get_spent(ISBD_BUDGET_HOUR, Clock::wall_time()) == 0);
+    CHECK(simulated.get_remaining(Clock::wall_time()) == 10);
+
+    Clock::set_source(NULL);
+
+    unlink(path);
+
+    return failures == 0 ? 0 : 1;
+}
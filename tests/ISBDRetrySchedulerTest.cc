@@ -0,0 +1,144 @@
+/*
+ ISBDRetrySchedulerTest.cc
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+/*
+ * Feeds signal quality readings and SBDIX MO status codes to the SBD retry
+ * scheduler on the simulated clock and checks its decisions.
+ *
+ * Returns 0 if all the checks passed.
+ */
+
+#include <stdio.h>
+#include "Clock.h"
+#include "ISBDRetryScheduler.h"
+#include "TestUtil.h"
+
+#define CSQ_INTERVAL        10  // seconds
+#define SBDIX_INTERVAL      30  // seconds
+#define MINIMUM_CSQ         2
+
+static uint64_t seconds(int s)
+{
+    return (uint64_t)s * NSEC_PER_SEC;
+}
+
+int main()
+{
+    SimulatedClock clock(1000 * NSEC_PER_SEC);
+    Clock::set_source(&clock);
+
+    ISBDRetryScheduler scheduler;
+
+    // Blocked sky backs off exponentially up to the maximum
+    scheduler.start_session(CSQ_INTERVAL, SBDIX_INTERVAL, MINIMUM_CSQ);
+
+    uint64_t expected[] = { 10, 20, 40, 80, 80 };
+
+    for (size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); i++) {
+        scheduler.signal_quality(0);
+        CHECK(scheduler.next_delay() == seconds(expected[i]));
+        CHECK(scheduler.get_decision() == ISBD_RETRY_BACKOFF);
+        clock.advance(seconds(expected[i]));
+    }
+
+    // The backoff goes on in the next session
+    scheduler.start_session(CSQ_INTERVAL, SBDIX_INTERVAL, MINIMUM_CSQ);
+    CHECK(scheduler.get_delay() == 0);
+    scheduler.signal_quality(0);
+    CHECK(scheduler.next_delay() == seconds(80));
+    CHECK(scheduler.get_decision() == ISBD_RETRY_BACKOFF);
+    CHECK(scheduler.get_delay() == seconds(80));
+    clock.advance(seconds(80));
+
+    // Rising signal is retried soon
+    scheduler.signal_quality(1);
+    CHECK(scheduler.get_trend() > 0);
+    CHECK(scheduler.next_delay() == seconds(ISBD_RETRY_MIN_INTERVAL));
+    CHECK(scheduler.get_decision() == ISBD_RETRY_RISING);
+
+    clock.advance(seconds(ISBD_RETRY_MIN_INTERVAL));
+
+    // Weak steady signal is retried after the CSQ interval
+    scheduler.signal_quality(1);
+    clock.advance(seconds(ISBD_RETRY_TREND_WINDOW + 1));
+    scheduler.signal_quality(1);
+    CHECK(scheduler.get_trend() == 0);
+    CHECK(scheduler.next_delay() == seconds(CSQ_INTERVAL));
+    CHECK(scheduler.get_decision() == ISBD_RETRY_STEADY);
+
+    // A delivered MO message ends the backoff
+    scheduler.signal_quality(3);
+    scheduler.sbdix(0);
+    CHECK(scheduler.get_delay() == 0);
+
+    scheduler.start_session(CSQ_INTERVAL, SBDIX_INTERVAL, MINIMUM_CSQ);
+    scheduler.signal_quality(0);
+    CHECK(scheduler.next_delay() == seconds(CSQ_INTERVAL));
+    CHECK(scheduler.get_decision() == ISBD_RETRY_BACKOFF);
+
+    // No network service backs off from the SBDIX interval
+    scheduler.signal_quality(3);
+    scheduler.sbdix(0);
+    scheduler.start_session(CSQ_INTERVAL, SBDIX_INTERVAL, MINIMUM_CSQ);
+    scheduler.signal_quality(3);
+    scheduler.sbdix(32);
+    CHECK(scheduler.next_delay() == seconds(SBDIX_INTERVAL));
+    CHECK(scheduler.get_decision() == ISBD_RETRY_BACKOFF);
+
+    scheduler.signal_quality(3);
+    scheduler.sbdix(32);
+    CHECK(scheduler.next_delay() == seconds(2 * SBDIX_INTERVAL));
+
+    // Busy network does not depend on the sky
+    scheduler.signal_quality(3);
+    scheduler.sbdix(35);
+    CHECK(scheduler.next_delay() == seconds(SBDIX_INTERVAL));
+    CHECK(scheduler.get_decision() == ISBD_RETRY_BUSY);
+
+    // Try later defers the retry
+    scheduler.signal_quality(3);
+    scheduler.sbdix(36);
+    CHECK(scheduler.next_delay() == seconds(ISBD_RETRY_DEFER_INTERVAL));
+    CHECK(scheduler.get_decision() == ISBD_RETRY_DEFER);
+
+    // A rising reading after a failed SBDIX does not retry SBDIX again at once
+    scheduler.sbdix(0);
+    scheduler.start_session(CSQ_INTERVAL, SBDIX_INTERVAL, MINIMUM_CSQ);
+    scheduler.signal_quality(2);
+    clock.advance(seconds(1));
+    scheduler.signal_quality(4);
+    scheduler.sbdix(18);
+    CHECK(scheduler.next_delay() == seconds(SBDIX_INTERVAL));
+    CHECK(scheduler.get_decision() == ISBD_RETRY_BACKOFF);
+
+    // Other failures are retried after the SBDIX interval
+    scheduler.start_session(CSQ_INTERVAL, SBDIX_INTERVAL, MINIMUM_CSQ);
+    scheduler.signal_quality(4);
+    scheduler.sbdix(10);
+    CHECK(scheduler.next_delay() == seconds(SBDIX_INTERVAL));
+    CHECK(scheduler.get_decision() == ISBD_RETRY_STEADY);
+
+    Clock::set_source(NULL);
+
+    return failures == 0 ? 0 : 1;
+}
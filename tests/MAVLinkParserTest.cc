@@ -0,0 +1,243 @@
+/*
+ MAVLinkParserTest.cc
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/*
+ * Feeds MAVLink streams to MAVLinkParser in one call and split between calls
+ * at every offset and checks that the same frames are received. Frames of
+ * the messages defined by the dialect are validated, MAVLink 2 frames of
+ * other dialects are delimited and received unchanged, and the parser
+ * resynchronizes after garbage.
+ *
+ * Returns 0 if all the checks passed.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "MAVLinkCRC.h"
+#include "MAVLinkParser.h"
+#include "TestUtil.h"
+
+#define UNKNOWN_MSG_ID  200     // not defined by the dialect
+
+static const uint8_t mavlink_message_crcs[256] = MAVLINK_MESSAGE_CRCS;
+
+static void append(std::vector<uint8_t>& stream, const mavlink_message_t& msg)
+{
+    uint8_t buf[MAVLINK_MAX_PACKET_LEN];
+    uint16_t n = mavlink_msg_to_send_buffer(buf, &msg);
+    stream.insert(stream.end(), buf, buf + n);
+}
+
+/*
+ * Appends a frame with the specified payload length and a checksum valid for
+ * the message ID.
+ */
+static void append_raw(std::vector<uint8_t>& stream, uint8_t msgid, uint8_t len)
+{
+    std::vector<uint8_t> frame(MAVLINK_NUM_HEADER_BYTES + len, 0);
+    frame[0] = MAVLINK_STX;
+    frame[1] = len;
+    frame[2] = 0;
+    frame[3] = 1;
+    frame[4] = 1;
+    frame[5] = msgid;
+
+    for (uint8_t i = 0; i < len; i++) {
+        frame[MAVLINK_NUM_HEADER_BYTES + i] = i;
+    }
+
+    uint16_t crc = MAVLinkCRC::accumulate(frame.data() + 1, frame.size() - 1, X25_INIT_CRC);
+    crc = MAVLinkCRC::accumulate(mavlink_message_crcs[msgid], crc);
+
+    frame.push_back(crc & 0xFF);
+    frame.push_back(crc >> 8);
+
+    stream.insert(stream.end(), frame.begin(), frame.end());
+}
+
+/*
+ * Appends MAVLink 2 frame with the specified payload length. The checksum is
+ * valid for message IDs below 256 if 'valid' is true.
+ */
+static void append_v2(std::vector<uint8_t>& stream, uint32_t msgid, uint8_t len, bool sign, bool valid)
+{
+    std::vector<uint8_t> frame(MAVLINK2_NUM_HEADER_BYTES + len, 0);
+    frame[0] = MAVLINK2_STX;
+    frame[1] = len;
+    frame[2] = sign ? MAVLINK2_IFLAG_SIGNED : 0;
+    frame[3] = 0;
+    frame[4] = 0;
+    frame[5] = 1;
+    frame[6] = 1;
+    frame[7] = msgid & 0xFF;
+    frame[8] = (msgid >> 8) & 0xFF;
+    frame[9] = (msgid >> 16) & 0xFF;
+
+    for (uint8_t i = 0; i < len; i++) {
+        frame[MAVLINK2_NUM_HEADER_BYTES + i] = i + 1;
+    }
+
+    uint16_t crc = MAVLinkCRC::accumulate(frame.data() + 1, frame.size() - 1, X25_INIT_CRC);
+    crc = MAVLinkCRC::accumulate(mavlink_message_crcs[msgid & 0xFF], crc);
+
+    if (!valid) {
+        crc ^= 0x5555;
+    }
+
+    frame.push_back(crc & 0xFF);
+    frame.push_back(crc >> 8);
+
+    if (sign) {
+        frame.insert(frame.end(), MAVLINK2_SIGNATURE_LEN, 0xFE);
+    }
+
+    stream.insert(stream.end(), frame.begin(), frame.end());
+}
+
+/*
+ * Feeds the stream split at the specified offset and returns the frames received.
+ */
+static std::vector<MAVLinkFrame> parse(const std::vector<uint8_t>& stream, size_t split)
+{
+    MAVLinkParser parser;
+    std::vector<MAVLinkFrame> frames;
+
+    parser.feed(stream.data(), split, frames);
+    parser.feed(stream.data() + split, stream.size() - split, frames);
+
+    return frames;
+}
+
+static void test_split(const char* name, const std::vector<uint8_t>& stream, const std::vector<uint32_t>& expected)
+{
+    printf("%s\n", name);
+
+    for (size_t split = 0; split <= stream.size(); split++) {
+        std::vector<MAVLinkFrame> frames = parse(stream, split);
+        std::vector<uint32_t> msgids;
+
+        for (size_t i = 0; i < frames.size(); i++) {
+            msgids.push_back(frames[i].msgid());
+        }
+
+        if (msgids != expected) {
+            printf("split at %lu: %lu frames received, %lu expected\n",
+                   (unsigned long)split, (unsigned long)msgids.size(), (unsigned long)expected.size());
+        }
+
+        CHECK(msgids == expected);
+    }
+}
+
+int main()
+{
+    mavlink_message_t msg;
+
+    std::vector<uint8_t> stream;
+    std::vector<uint32_t> expected;
+
+    mavlink_msg_heartbeat_pack(1, 1, &msg, MAV_TYPE_QUADROTOR, MAV_AUTOPILOT_ARDUPILOTMEGA, 0x81, 4, MAV_STATE_ACTIVE);
+    append(stream, msg);
+    expected.push_back(MAVLINK_MSG_ID_HEARTBEAT);
+
+    mavlink_msg_sys_status_pack(1, 1, &msg, 0, 0, 0, 500, 12000, 100, 80, 0, 0, 0, 0, 0, 0);
+    append(stream, msg);
+    expected.push_back(MAVLINK_MSG_ID_SYS_STATUS);
+
+    test_split("valid frames", stream, expected);
+
+    // A checksum valid for the message ID does not make a frame of the wrong length valid
+    std::vector<uint8_t> wrong_length;
+    append_raw(wrong_length, MAVLINK_MSG_ID_HEARTBEAT, MAVLINK_MSG_ID_HEARTBEAT_LEN + 1);
+    wrong_length.insert(wrong_length.end(), stream.begin(), stream.end());
+
+    test_split("wrong length", wrong_length, expected);
+
+    // Frames of the messages radioroom does not decode are validated as well
+    std::vector<uint8_t> not_decoded;
+    append_raw(not_decoded, MAVLINK_MSG_ID_LOG_DATA, 7);
+    not_decoded.insert(not_decoded.end(), stream.begin(), stream.end());
+
+    test_split("wrong length of message not decoded", not_decoded, expected);
+
+    // MAVLink 1 frames of messages unknown to the dialect are dropped, MAVLink 2 frames are forwarded
+    std::vector<uint8_t> other_dialect;
+    std::vector<uint32_t> other_expected;
+    append_raw(other_dialect, UNKNOWN_MSG_ID, 7);
+    append_v2(other_dialect, UNKNOWN_MSG_ID, 7, false, false);
+    other_expected.push_back(UNKNOWN_MSG_ID);
+    other_dialect.insert(other_dialect.end(), stream.begin(), stream.end());
+    other_expected.insert(other_expected.end(), expected.begin(), expected.end());
+
+    test_split("other dialect", other_dialect, other_expected);
+
+    // A truncated frame followed by a stray STX and an unknown message ID does not swallow the next frames
+    std::vector<uint8_t> garbage;
+    std::vector<uint32_t> garbage_expected;
+    std::vector<uint8_t> heartbeat;
+    mavlink_msg_heartbeat_pack(1, 1, &msg, MAV_TYPE_QUADROTOR, MAV_AUTOPILOT_ARDUPILOTMEGA, 0x81, 4, MAV_STATE_ACTIVE);
+    append(heartbeat, msg);
+    garbage.insert(garbage.end(), heartbeat.begin(), heartbeat.begin() + heartbeat.size() / 2);
+    const uint8_t stray[] = { MAVLINK_STX, 0x40, 0x00, 0x01, 0x01, UNKNOWN_MSG_ID };
+    garbage.insert(garbage.end(), stray, stray + sizeof(stray));
+
+    for (int i = 0; i < 5; i++) {
+        garbage.insert(garbage.end(), heartbeat.begin(), heartbeat.end());
+        garbage_expected.push_back(MAVLINK_MSG_ID_HEARTBEAT);
+    }
+
+    test_split("resync after garbage", garbage, garbage_expected);
+
+    // MAVLink 2 frames
+    std::vector<uint8_t> v2;
+    std::vector<uint32_t> v2_expected;
+    append_v2(v2, MAVLINK_MSG_ID_HEARTBEAT, 7, false, true);
+    v2_expected.push_back(MAVLINK_MSG_ID_HEARTBEAT);
+    append_v2(v2, MAVLINK_MSG_ID_HEARTBEAT, 7, false, false);
+    append_v2(v2, 12915, 40, true, false);
+    v2_expected.push_back(12915);
+    v2.insert(v2.end(), stream.begin(), stream.end());
+    v2_expected.insert(v2_expected.end(), expected.begin(), expected.end());
+    append_v2(v2, MAVLINK_MSG_ID_SYS_STATUS, 20, true, true);
+    v2_expected.push_back(MAVLINK_MSG_ID_SYS_STATUS);
+
+    test_split("MAVLink 2", v2, v2_expected);
+
+    std::vector<MAVLinkFrame> frames = parse(v2, v2.size());
+
+    if (frames.size() == v2_expected.size()) {
+        CHECK(frames[0].v2() && frames[0].sysid() == 1 && frames[0].compid() == 1);
+        CHECK(frames[1].size() == MAVLINK2_NUM_HEADER_BYTES + 40 + MAVLINK_NUM_CHECKSUM_BYTES + MAVLINK2_SIGNATURE_LEN);
+        CHECK(memcmp(frames[1].data(), v2.data() + frames[0].size() * 2, frames[1].size()) == 0);
+
+        // The truncated payload is padded with zeros
+        mavlink_heartbeat_t heartbeat;
+        mavlink_msg_heartbeat_decode(&frames[0].get_message(), &heartbeat);
+        CHECK(frames[0].get_message().msgid == MAVLINK_MSG_ID_HEARTBEAT);
+        CHECK(heartbeat.custom_mode == 0x04030201 && heartbeat.type == 5 && heartbeat.mavlink_version == 0);
+
+        CHECK(frames[1].get_message().len == 0);
+    }
+
+    return failures == 0 ? 0 : 1;
+}
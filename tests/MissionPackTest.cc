@@ -0,0 +1,161 @@
+/*
+ MissionPackTest.cc
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+/*
+ * Packs a survey mission and a mission with non-default commands, frames and
+ * params into ENCAPSULATED_DATA chunks and checks that the chunks fit into
+ * SBD MT messages and unpack into the same mission items in any order.
+ *
+ * Returns 0 if all the checks passed.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "IridiumSBD.h"
+#include "MAVLinkMissionPack.h"
+#include "MAVLinkSerial.h"
+#include "TestUtil.h"
+
+#define SURVEY_ITEMS        700
+#define ITEMS_PER_CHUNK     30      // minimum number of survey items in a chunk
+
+static bool same_item(const mavlink_mission_item_int_t& a, const mavlink_mission_item_int_t& b)
+{
+    return a.seq == b.seq && a.command == b.command && a.frame == b.frame && a.current == b.current &&
+           a.autocontinue == b.autocontinue && a.x == b.x && a.y == b.y && a.z == b.z &&
+           a.param1 == b.param1 && a.param2 == b.param2 && a.param3 == b.param3 && a.param4 == b.param4;
+}
+
+/*
+ * Unpacks the chunks in reverse order and checks the result against items.
+ */
+static void check_unpack(const vector<mavlink_message_t>& msgs, const vector<mavlink_mission_item_int_t>& items)
+{
+    vector<mavlink_mission_item_int_t> unpacked;
+
+    for (size_t i = msgs.size(); i > 0; i--) {
+        uint16_t count = 0;
+        CHECK(MAVLinkMissionPack::unpack(msgs[i - 1], count, unpacked));
+        CHECK(count == items.size());
+    }
+
+    CHECK(unpacked.size() == items.size());
+
+    vector<bool> seen(items.size(), false);
+
+    for (size_t i = 0; i < unpacked.size(); i++) {
+        uint16_t seq = unpacked[i].seq;
+        CHECK(seq < items.size() && !seen[seq]);
+
+        if (seq < items.size()) {
+            seen[seq] = true;
+            CHECK(same_item(unpacked[i], items[seq]));
+        }
+    }
+}
+
+int main()
+{
+    // Survey mission
+    vector<mavlink_mission_item_int_t> survey = make_survey(SURVEY_ITEMS);
+    vector<mavlink_message_t> msgs;
+
+    MAVLinkMissionPack::pack(SYSTEM_ID, COMPONENT_ID, survey, msgs);
+
+    size_t bytes = 0;
+
+    for (size_t i = 0; i < msgs.size(); i++) {
+        uint8_t buf[MAVLINK_MAX_PACKET_LEN];
+        uint16_t len = mavlink_msg_to_send_buffer(buf, &msgs[i]);
+        CHECK(len <= ISBD_MAX_MT_MGS_SIZE);
+        CHECK(mavlink_msg_encapsulated_data_get_seqnr(&msgs[i]) == i);
+        bytes += len;
+    }
+
+    printf("%d survey items packed into %d MT messages, %d bytes\n", SURVEY_ITEMS, (int)msgs.size(), (int)bytes);
+
+    CHECK(msgs.size() <= SURVEY_ITEMS / ITEMS_PER_CHUNK + 1);
+
+    check_unpack(msgs, survey);
+
+    // Non-default commands, frames and params
+    vector<mavlink_mission_item_int_t> mission = make_survey(5);
+
+    mission[0].command = MAV_CMD_NAV_TAKEOFF;
+    mission[0].param1 = 15;
+    mission[0].current = 1;
+    mission[2].command = MAV_CMD_DO_CHANGE_SPEED;
+    mission[2].frame = MAV_FRAME_MISSION;
+    mission[2].param2 = 12.5f;
+    mission[2].param3 = -1;
+    mission[2].x = mission[2].y = 0;
+    mission[2].z = 0;
+    mission[3].z = 120.25f;
+    mission[3].x = -335000000;
+    mission[3].y = -1790000000;
+    mission[4].command = MAV_CMD_NAV_LAND;
+    mission[4].autocontinue = 0;
+    mission[4].param4 = 90;
+
+    msgs.clear();
+    MAVLinkMissionPack::pack(SYSTEM_ID, COMPONENT_ID, mission, msgs);
+
+    CHECK(msgs.size() == 1);
+
+    check_unpack(msgs, mission);
+
+    // Invalid chunks are rejected
+    uint8_t data[MAVLINK_MSG_ENCAPSULATED_DATA_FIELD_DATA_LEN] = { 0xFF };
+    mavlink_message_t invalid;
+    mavlink_msg_encapsulated_data_pack(SYSTEM_ID, COMPONENT_ID, &invalid, 0, data);
+
+    uint16_t count = 0;
+    vector<mavlink_mission_item_int_t> items;
+
+    CHECK(!MAVLinkMissionPack::unpack(invalid, count, items));
+
+    // ENCAPSULATED_DATA of other protocols lacks the magic
+    mavlink_msg_encapsulated_data_get_data(&msgs[0], data);
+    memset(data, 0, MISSION_PACK_MAGIC_LEN);
+    mavlink_msg_encapsulated_data_pack(SYSTEM_ID, COMPONENT_ID, &invalid, 0, data);
+
+    CHECK(!MAVLinkMissionPack::unpack(invalid, count, items));
+
+    memset(data, 0, sizeof(data));
+    memcpy(data, MISSION_PACK_MAGIC, MISSION_PACK_MAGIC_LEN);
+    data[4] = MISSION_PACK_VERSION;
+    data[5] = 2;            // 2 items in the mission
+    data[9] = 3;            // 3 items in the chunk
+    mavlink_msg_encapsulated_data_pack(SYSTEM_ID, COMPONENT_ID, &invalid, 0, data);
+
+    CHECK(!MAVLinkMissionPack::unpack(invalid, count, items));
+
+    data[9] = 1;
+    memset(data + MISSION_PACK_HEADER_LEN, 0x80, sizeof(data) - MISSION_PACK_HEADER_LEN); // truncated varint
+    mavlink_msg_encapsulated_data_pack(SYSTEM_ID, COMPONENT_ID, &invalid, 0, data);
+
+    CHECK(!MAVLinkMissionPack::unpack(invalid, count, items));
+    CHECK(items.empty());
+
+    return failures == 0 ? 0 : 1;
+}
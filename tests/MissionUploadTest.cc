@@ -0,0 +1,157 @@
+/*
+ MissionUploadTest.cc
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/*
+ * Uploads a survey mission to ArduPilot simulator using the request-driven
+ * mission protocol, then a shorter mission with lost requests. Downloads the
+ * mission into the mission cache when the cache sees that it changed.
+ *
+ * Returns 0 if all the checks passed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <thread>
+#include "ArduPilotSimulator.h"
+#include "Clock.h"
+#include "MAVLinkMissionCache.h"
+#include "MAVLinkSerial.h"
+#include "Metrics.h"
+#include "TestUtil.h"
+
+#define RUN_INTERVAL        10      // milliseconds
+#define SURVEY_ITEMS        700
+#define SURVEY_TIME         10      // seconds
+#define LOSSY_ITEMS         50
+#define LOSS_RATE           0.05
+
+static uint8_t upload(MAVLinkSerial& autopilot, const vector<mavlink_mission_item_int_t>& items, double& seconds)
+{
+    mavlink_message_t count, ack;
+    mavlink_msg_mission_count_pack(SYSTEM_ID, COMPONENT_ID, &count, ARDUPILOT_SYSTEM_ID, ARDUPILOT_COMPONENT_ID,
+                                   items.size());
+
+    uint64_t start = Clock::now();
+
+    CHECK(autopilot.send_mission(count, items, ack));
+    CHECK(ack.msgid == MAVLINK_MSG_ID_MISSION_ACK);
+
+    seconds = Clock::to_seconds(Clock::now() - start);
+
+    return mavlink_msg_mission_ack_get_type(&ack);
+}
+
+int main()
+{
+    ArduPilotSimulator simulator;
+
+    if (!simulator.open("")) {
+        return 1;
+    }
+
+    std::atomic<bool> running(true);
+
+    std::thread simulator_thread([&]() {
+        while (running) {
+            simulator.run(RUN_INTERVAL);
+        }
+    });
+
+    MAVLinkSerial autopilot;
+    CHECK(autopilot.init(simulator.get_path(), ARDUPILOT_SIM_DEFAULT_BAUD_RATE, vector<string>()));
+    CHECK(autopilot.get_capabilities() & MAV_PROTOCOL_CAPABILITY_MISSION_INT);
+
+    MAVLinkMissionCache cache;
+    autopilot.add_frame_listener(&cache);
+    cache.update(vector<mavlink_mission_item_int_t>());
+
+    Counter& items_sent = Metrics::counter("mission_items_sent_total", "", "Number of mission items sent to the autopilot.");
+    Counter& items_resent = Metrics::counter("mission_items_resent_total", "", "Number of mission items sent to the autopilot more than once.");
+
+    // Survey mission
+    double seconds;
+    vector<mavlink_mission_item_int_t> survey = make_survey(SURVEY_ITEMS);
+
+    CHECK(upload(autopilot, survey, seconds) == MAV_MISSION_ACCEPTED);
+
+    printf("%d mission items uploaded in %.3f s, %llu items sent\n", SURVEY_ITEMS, seconds,
+           (unsigned long long)items_sent.get());
+
+    CHECK(seconds < SURVEY_TIME);
+    CHECK(items_sent.get() == SURVEY_ITEMS);
+    CHECK(items_resent.get() == 0);
+
+    // MISSION_ACK of the upload shows that the cached mission changed
+    CHECK(cache.is_changed());
+
+    vector<mavlink_mission_item_int_t> downloaded;
+    uint64_t start = Clock::now();
+
+    CHECK(autopilot.receive_mission(downloaded));
+
+    printf("%d mission items downloaded in %.3f s\n", (int)downloaded.size(), Clock::to_seconds(Clock::now() - start));
+
+    CHECK(downloaded.size() == SURVEY_ITEMS);
+
+    for (size_t i = 0; i < downloaded.size() && i < survey.size(); i++) {
+        CHECK(downloaded[i].seq == i && downloaded[i].x == survey[i].x && downloaded[i].y == survey[i].y);
+    }
+
+    cache.update(downloaded);
+    CHECK(cache.is_valid() && !cache.is_changed());
+
+    vector<MAVLinkFrame> frames;
+    cache.get_mission_frames(SYSTEM_ID, COMPONENT_ID, frames);
+    CHECK(frames.size() == SURVEY_ITEMS + 1);
+    CHECK(frames[0].msgid() == MAVLINK_MSG_ID_MISSION_COUNT &&
+          mavlink_msg_mission_count_get_count(&frames[0].get_message()) == SURVEY_ITEMS);
+    CHECK(frames[SURVEY_ITEMS].msgid() == MAVLINK_MSG_ID_MISSION_ITEM_INT &&
+          mavlink_msg_mission_item_int_get_seq(&frames[SURVEY_ITEMS].get_message()) == SURVEY_ITEMS - 1);
+
+    // Lost requests are repeated by the autopilot and only the missing items are sent again
+    simulator.set_loss(LOSS_RATE);
+
+    vector<mavlink_mission_item_int_t> lossy = make_survey(LOSSY_ITEMS);
+
+    CHECK(upload(autopilot, lossy, seconds) == MAV_MISSION_ACCEPTED);
+
+    simulator.set_loss(0);
+
+    printf("%d mission items uploaded in %.3f s with %llu requests lost, %llu items sent again\n", LOSSY_ITEMS,
+           seconds, (unsigned long long)simulator.requests_lost.load(), (unsigned long long)items_resent.get());
+
+    CHECK(items_sent.get() - SURVEY_ITEMS == LOSSY_ITEMS + items_resent.get());
+
+    running = false;
+    simulator_thread.join();
+    autopilot.close();
+
+    CHECK(simulator.mission_uploads == 2);
+    CHECK(simulator.get_mission_size() == LOSSY_ITEMS);
+
+    for (size_t i = 0; i < simulator.get_mission_size() && i < lossy.size(); i++) {
+        CHECK(simulator.get_mission_item(i).x == lossy[i].x && simulator.get_mission_item(i).y == lossy[i].y);
+    }
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,270 @@
+/*
+ OutboxTest.cc
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+/*
+ * Queues responses, alerts and telemetry in the outbox of a channel with
+ * ISBD transmission size and checks the order and the packing of the
+ * transmissions, coalescing of the telemetry and pacing of bulk downloads.
+ *
+ * Returns 0 if all the checks passed.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "MAVLinkOutbox.h"
+#include "Metrics.h"
+#include "TestUtil.h"
+
+#define TRANSMISSION_SIZE   340     // bytes, SBD MO message size
+#define TRACK_FRAMES        6
+#define BULK_FRAMES         30
+
+/**
+ * Channel that records the transmissions.
+ */
+class RecordingChannel : public MAVLinkChannel {
+public:
+    std::vector<std::vector<MAVLinkFrame> > transmissions;
+    bool fail;
+
+    RecordingChannel() : MAVLinkChannel("TEST"), transmissions(), fail(false) {}
+
+    void close() {}
+
+    bool send_message(const mavlink_message_t& msg)
+    {
+        return send_frame(MAVLinkFrame(msg));
+    }
+
+    bool send_frame(const MAVLinkFrame& frame)
+    {
+        return send_frames(std::vector<MAVLinkFrame>(1, frame));
+    }
+
+    bool send_frames(const std::vector<MAVLinkFrame>& frames)
+    {
+        if (fail) {
+            return false;
+        }
+
+        transmissions.push_back(frames);
+        return true;
+    }
+
+    bool receive_message(mavlink_message_t& msg)
+    {
+        (void)msg;
+        return false;
+    }
+
+    bool message_available()
+    {
+        return false;
+    }
+
+    size_t get_transmission_size() const
+    {
+        return TRANSMISSION_SIZE;
+    }
+};
+
+static bool same(const MAVLinkFrame& a, const MAVLinkFrame& b)
+{
+    return a.size() == b.size() && memcmp(a.data(), b.data(), a.size()) == 0;
+}
+
+static MAVLinkFrame report_frame(uint8_t sysid, int32_t latitude)
+{
+    mavlink_message_t msg;
+    mavlink_msg_high_latency_pack(sysid, 1, &msg, 0, 0, 0, 0, 0, 0, 0, 0, latitude, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    return MAVLinkFrame(msg);
+}
+
+static std::vector<MAVLinkFrame> report_frames(uint8_t sysid, int32_t latitude)
+{
+    std::vector<MAVLinkFrame> frames(1, report_frame(sysid, latitude));
+    mavlink_message_t msg;
+    int8_t value[32] = {};
+
+    for (int i = 0; i < TRACK_FRAMES; i++) {
+        mavlink_msg_memory_vect_pack(sysid, 1, &msg, i, 0x81, 1, value);
+        frames.push_back(MAVLinkFrame(msg));
+    }
+
+    return frames;
+}
+
+/*
+ * Returns the number of entries of the priority class dropped from the full queue.
+ */
+static uint64_t dropped(const char* priority)
+{
+    return Metrics::counter("outbox_dropped_total", Metrics::label("channel", "TEST") + "," +
+                            Metrics::label("priority", priority),
+                            "Number of entries dropped because the queue was full.").get();
+}
+
+int main()
+{
+    RecordingChannel channel;
+    MAVLinkOutbox outbox("TEST");
+    mavlink_message_t msg;
+
+    // Only the newest report per msgid and sysid waits in the queue
+    outbox.push_telemetry(report_frames(1, 100));
+    outbox.push_telemetry(report_frames(1, 200));
+    outbox.push_telemetry(report_frames(2, 300));
+    CHECK(outbox.size() == 2);
+
+    // The responses and alerts queued after the reports are sent first
+    mavlink_msg_statustext_pack(1, 1, &msg, MAV_SEVERITY_WARNING, "Low battery");
+    MAVLinkFrame alert(msg);
+    outbox.push(alert);
+
+    mavlink_msg_command_ack_pack(1, 1, &msg, MAV_CMD_NAV_RETURN_TO_LAUNCH, MAV_RESULT_ACCEPTED);
+    MAVLinkFrame command_ack(msg);
+    outbox.push(command_ack);
+
+    CHECK(MAVLinkOutbox::priority(command_ack) == OUTBOX_PRIORITY_ACK);
+    CHECK(MAVLinkOutbox::priority(alert) == OUTBOX_PRIORITY_ALERT);
+    CHECK(MAVLinkOutbox::priority(report_frame(1, 0)) == OUTBOX_PRIORITY_TELEMETRY);
+    CHECK(outbox.size() == 4);
+
+    // Failed transmissions keep the entries
+    channel.fail = true;
+    CHECK(!outbox.send_next(channel));
+    CHECK(outbox.size() == 4);
+    channel.fail = false;
+
+    while (!outbox.empty()) {
+        CHECK(outbox.send_next(channel));
+    }
+
+    printf("%d transmissions\n", (int)channel.transmissions.size());
+
+    CHECK(channel.transmissions.size() == 3);
+
+    for (size_t i = 0; i < channel.transmissions.size(); i++) {
+        size_t size = 0;
+
+        for (size_t j = 0; j < channel.transmissions[i].size(); j++) {
+            size += channel.transmissions[i][j].size();
+        }
+
+        CHECK(size <= TRANSMISSION_SIZE);
+    }
+
+    if (channel.transmissions.size() == 3) {
+        const std::vector<MAVLinkFrame>& first = channel.transmissions[0];
+        CHECK(first.size() == 2 && same(first[0], command_ack) && same(first[1], alert));
+
+        // The report is sent with its track in one transmission
+        const std::vector<MAVLinkFrame>& second = channel.transmissions[1];
+        CHECK(second.size() == TRACK_FRAMES + 1 && second[0].msgid() == MAVLINK_MSG_ID_HIGH_LATENCY &&
+              second[0].sysid() == 1 && mavlink_msg_high_latency_get_latitude(&second[0].get_message()) == 200);
+
+        CHECK(channel.transmissions[2][0].sysid() == 2);
+    }
+
+    // Bulk downloads are sent in parts and the responses queued meanwhile overtake them
+    std::vector<MAVLinkFrame> params;
+
+    for (int i = 0; i < BULK_FRAMES; i++) {
+        mavlink_msg_param_value_pack(1, 1, &msg, "SIM_PARAM", i, MAV_PARAM_TYPE_REAL32, BULK_FRAMES, i);
+        params.push_back(MAVLinkFrame(msg));
+    }
+
+    channel.transmissions.clear();
+    outbox.push_bulk(params);
+    CHECK(outbox.size() == 1);
+
+    CHECK(outbox.send_next(channel));
+    CHECK(channel.transmissions.size() == 1 && channel.transmissions[0].size() == TRANSMISSION_SIZE / params[0].size());
+    CHECK(outbox.size() == 1);
+
+    outbox.push(command_ack);
+    CHECK(outbox.send_next(channel));
+    CHECK(channel.transmissions.size() == 2 && same(channel.transmissions[1][0], command_ack));
+
+    size_t bulk_sent = channel.transmissions[0].size() + channel.transmissions[1].size() - 1;
+
+    while (!outbox.empty()) {
+        CHECK(outbox.send_next(channel));
+        bulk_sent += channel.transmissions.back().size();
+    }
+
+    CHECK(bulk_sent == BULK_FRAMES);
+    CHECK(same(channel.transmissions.back().back(), params.back()));
+
+    // A report delta replaces the keyframe queued for the same vehicle
+    std::vector<MAVLinkFrame> delta = report_frames(1, 0);
+    delta.erase(delta.begin());
+
+    outbox.push_telemetry(report_frames(1, 400));
+    CHECK(outbox.has_report());
+    outbox.push_telemetry(delta);
+    CHECK(outbox.size() == 1 && outbox.has_report());
+
+    channel.transmissions.clear();
+    CHECK(outbox.send_next(channel));
+    CHECK(channel.transmissions.size() == 1 && channel.transmissions[0].size() == delta.size() &&
+          channel.transmissions[0][0].msgid() == MAVLINK_MSG_ID_MEMORY_VECT);
+    CHECK(!outbox.has_report());
+
+    // Responses are not coalesced, the oldest telemetry is dropped when the queue is full
+    outbox.push_telemetry(report_frames(1, 0));
+
+    for (int i = 0; i < OUTBOX_MAX_ENTRIES; i++) {
+        outbox.push(command_ack);
+    }
+
+    CHECK(outbox.size() == OUTBOX_MAX_ENTRIES);
+
+    channel.transmissions.clear();
+    CHECK(outbox.send_next(channel));
+    CHECK(channel.transmissions.size() == 1 && same(channel.transmissions[0][0], command_ack));
+
+    // Telemetry does not evict a queued bulk entry
+    outbox.clear();
+
+    for (int i = 0; i < OUTBOX_MAX_ENTRIES - 1; i++) {
+        outbox.push(command_ack);
+    }
+
+    outbox.push_bulk(params);
+    outbox.push_telemetry(report_frames(1, 0));
+    CHECK(outbox.size() == OUTBOX_MAX_ENTRIES && !outbox.has_report());
+    CHECK(dropped("telemetry") == 2);
+    CHECK(dropped("bulk") == 0);
+
+    // A response evicts the bulk entry and is counted under the priority of the dropped entry
+    outbox.push(command_ack);
+    CHECK(outbox.size() == OUTBOX_MAX_ENTRIES);
+    CHECK(dropped("bulk") == 1);
+    CHECK(dropped("ack") == 0);
+
+    outbox.clear();
+    CHECK(outbox.empty());
+
+    return failures == 0 ? 0 : 1;
+}
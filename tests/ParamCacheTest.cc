@@ -0,0 +1,167 @@
+/*
+ ParamCacheTest.cc
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/*
+ * Loads the parameter table of ArduPilot simulator into the parameter cache,
+ * with and without lost requests, and checks the delta sync of the changed
+ * parameters, also after the table is reloaded.
+ *
+ * Returns 0 if all the checks passed.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <thread>
+#include "ArduPilotSimulator.h"
+#include "Clock.h"
+#include "MAVLinkParamCache.h"
+#include "MAVLinkSerial.h"
+#include "TestUtil.h"
+
+#define RUN_INTERVAL        10      // milliseconds
+#define PARAM_COUNT         1000
+#define LOAD_TIME           5       // seconds
+#define LOSS_RATE           0.05
+
+static bool set_param(MAVLinkSerial& autopilot, const char* id, float value)
+{
+    char param_id[MAVLINK_MSG_PARAM_VALUE_FIELD_PARAM_ID_LEN] = {};
+    memcpy(param_id, id, strnlen(id, sizeof(param_id)));
+
+    mavlink_message_t msg, ack;
+    mavlink_msg_param_set_pack(SYSTEM_ID, COMPONENT_ID, &msg, ARDUPILOT_SYSTEM_ID, ARDUPILOT_COMPONENT_ID,
+                               param_id, value, MAV_PARAM_TYPE_REAL32);
+
+    return autopilot.send_receive_message(msg, ack) && ack.msgid == MAVLINK_MSG_ID_PARAM_VALUE;
+}
+
+int main()
+{
+    ArduPilotSimulator simulator;
+    simulator.set_param_count(PARAM_COUNT);
+
+    if (!simulator.open("")) {
+        return 1;
+    }
+
+    std::atomic<bool> running(true);
+
+    std::thread simulator_thread([&]() {
+        while (running) {
+            simulator.run(RUN_INTERVAL);
+        }
+    });
+
+    MAVLinkSerial autopilot;
+    CHECK(autopilot.init(simulator.get_path(), ARDUPILOT_SIM_DEFAULT_BAUD_RATE, vector<string>()));
+
+    MAVLinkParamCache cache;
+    autopilot.add_frame_listener(&cache);
+
+    // Full table
+    vector<mavlink_param_value_t> params;
+    uint64_t start = Clock::now();
+
+    CHECK(autopilot.receive_params(params));
+
+    double seconds = Clock::to_seconds(Clock::now() - start);
+    printf("%d parameters loaded in %.3f s\n", (int)params.size(), seconds);
+
+    CHECK(params.size() == PARAM_COUNT);
+    CHECK(seconds < LOAD_TIME);
+
+    cache.update(params);
+    CHECK(cache.is_valid() && !cache.is_changed() && cache.size() == PARAM_COUNT);
+
+    mavlink_param_value_t value;
+    CHECK(cache.get_param(-1, "SIM_PARAM999", value) && value.param_value == 999 && value.param_index == 999);
+    CHECK(cache.get_param(999, "", value) && strncmp(value.param_id, "SIM_PARAM999", 16) == 0);
+    CHECK(!cache.get_param(-1, "NO_SUCH_PARAM", value));
+
+    // Delta sync
+    uint32_t hash = cache.get_hash();
+    vector<mavlink_param_value_t> changed;
+
+    CHECK(cache.get_changed_params(hash, changed) && changed.empty());
+
+    CHECK(set_param(autopilot, "SIM_PARAM500", 5000));
+    CHECK(set_param(autopilot, "SIM_PARAM700", 7000));
+    CHECK(set_param(autopilot, "SIM_PARAM700", 7000)); // the same value is not a change
+
+    CHECK(cache.get_param(-1, "SIM_PARAM500", value) && value.param_value == 5000);
+
+    uint32_t new_hash = cache.get_hash();
+    CHECK(new_hash != hash);
+
+    changed.clear();
+    CHECK(cache.get_changed_params(hash, changed) && changed.size() == 2);
+
+    changed.clear();
+    CHECK(cache.get_changed_params(new_hash, changed) && changed.empty());
+
+    changed.clear();
+    CHECK(!cache.get_changed_params(new_hash + 1, changed) && changed.size() == PARAM_COUNT);
+
+    CHECK(MAVLinkParamCache::decode_hash(mavlink_msg_param_value_get_param_value(&cache.get_hash_frame().get_message())) == new_hash);
+
+    // Missing parameters are requested by index
+    simulator.set_loss(LOSS_RATE);
+    simulator.set_response_loss(LOSS_RATE);
+
+    start = Clock::now();
+
+    CHECK(autopilot.receive_params(params));
+
+    simulator.set_loss(0);
+    simulator.set_response_loss(0);
+
+    printf("%d parameters loaded in %.3f s with %llu requests and %llu responses lost\n", (int)params.size(),
+           Clock::to_seconds(Clock::now() - start), (unsigned long long)simulator.requests_lost.load(),
+           (unsigned long long)simulator.responses_lost.load());
+
+    CHECK(simulator.responses_lost > 0);
+
+    CHECK(params.size() == PARAM_COUNT && params[500].param_value == 5000);
+
+    // Reloading the unchanged table keeps the known hashes and the parameter versions
+    cache.update(params);
+
+    changed.clear();
+    CHECK(cache.get_changed_params(new_hash, changed) && changed.empty());
+
+    changed.clear();
+    CHECK(cache.get_changed_params(hash, changed) && changed.size() == 2);
+
+    // A system that holds the table loaded at startup gets no parameters
+    MAVLinkParamCache loaded;
+    loaded.update(params);
+
+    changed.clear();
+    CHECK(loaded.get_changed_params(new_hash, changed) && changed.empty());
+
+    running = false;
+    simulator_thread.join();
+    autopilot.close();
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,151 @@
+/*
+ PseudoTerminal.cc
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "PseudoTerminal.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#define PTY_WRITE_TIMEOUT 1000 // milliseconds
+
+PseudoTerminal::PseudoTerminal() : master_fd(-1), slave_fd(-1), path(), link_path()
+{
+}
+
+PseudoTerminal::~PseudoTerminal()
+{
+    close();
+}
+
+bool PseudoTerminal::open(const std::string& link_path)
+{
+    master_fd = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+
+    if (master_fd < 0 || grantpt(master_fd) < 0 || unlockpt(master_fd) < 0) {
+        fprintf(stderr, "Failed to create pseudo terminal: %s\n", strerror(errno));
+        close();
+        return false;
+    }
+
+    path = ptsname(master_fd);
+
+    slave_fd = ::open(path.data(), O_RDWR | O_NOCTTY | O_CLOEXEC);
+
+    if (slave_fd < 0) {
+        fprintf(stderr, "Failed to open '%s': %s\n", path.data(), strerror(errno));
+        close();
+        return false;
+    }
+
+    // Raw mode from the start, so nothing written before the application
+    // configures the device is altered by the line discipline
+    struct termios tio;
+    tcgetattr(slave_fd, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(slave_fd, TCSANOW, &tio);
+
+    if (!link_path.empty()) {
+        unlink(link_path.data());
+
+        if (symlink(path.data(), link_path.data()) < 0) {
+            fprintf(stderr, "Failed to create link '%s': %s\n", link_path.data(), strerror(errno));
+            close();
+            return false;
+        }
+
+        this->link_path = link_path;
+    }
+
+    return true;
+}
+
+void PseudoTerminal::close()
+{
+    if (!link_path.empty()) {
+        unlink(link_path.data());
+        link_path.clear();
+    }
+
+    if (slave_fd >= 0) {
+        ::close(slave_fd);
+        slave_fd = -1;
+    }
+
+    if (master_fd >= 0) {
+        ::close(master_fd);
+        master_fd = -1;
+    }
+
+    path.clear();
+}
+
+int PseudoTerminal::read(void* buffer, size_t size)
+{
+    ssize_t n = ::read(master_fd, buffer, size);
+
+    if (n < 0) {
+        return (errno == EAGAIN || errno == EINTR) ? 0 : -1;
+    }
+
+    return n;
+}
+
+bool PseudoTerminal::write(const void* buffer, size_t size)
+{
+    const char* data = (const char*)buffer;
+
+    while (size > 0) {
+        ssize_t n = ::write(master_fd, data, size);
+
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            if (errno != EAGAIN) {
+                return false;
+            }
+
+            // The application does not read fast enough
+            struct pollfd pfd;
+            pfd.fd = master_fd;
+            pfd.events = POLLOUT;
+            pfd.revents = 0;
+
+            if (poll(&pfd, 1, PTY_WRITE_TIMEOUT) <= 0) {
+                return false;
+            }
+
+            continue;
+        }
+
+        data += n;
+        size -= n;
+    }
+
+    return true;
+}
@@ -0,0 +1,86 @@
+/*
+ PseudoTerminal.h
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef PSEUDOTERMINAL_H_
+#define PSEUDOTERMINAL_H_
+
+#include <stddef.h>
+#include <string>
+
+/**
+ * Master side of a pseudo terminal used by device emulators.
+ *
+ * The slave side is opened by the application under test as a regular
+ * serial device, so the emulated device looks exactly like a USB or UART
+ * attached one.
+ */
+class PseudoTerminal {
+    int         master_fd;
+    int         slave_fd;   // kept open, so the master does not fail when the application closes the device
+    std::string path;
+    std::string link_path;
+
+public:
+    PseudoTerminal();
+    ~PseudoTerminal();
+
+    /**
+     * Creates the pseudo terminal in raw mode.
+     *
+     * If link_path is not empty, a symbolic link to the slave device is created
+     * at the path, replacing an existing one.
+     *
+     * Returns true on success.
+     */
+    bool open(const std::string& link_path);
+
+    /**
+     * Closes the pseudo terminal and removes the symbolic link.
+     */
+    void close();
+
+    /**
+     * Returns the path of the slave device.
+     */
+    inline const std::string& get_path() const { return path; }
+
+    /**
+     * Returns the master file descriptor.
+     */
+    inline int get_fd() const { return master_fd; }
+
+    /**
+     * Reads up to size bytes without blocking.
+     *
+     * Returns the number of bytes read, 0 if no data is available or -1 on error.
+     */
+    int read(void* buffer, size_t size);
+
+    /**
+     * Writes all the bytes.
+     *
+     * Returns true on success.
+     */
+    bool write(const void* buffer, size_t size);
+};
+
+#endif /* PSEUDOTERMINAL_H_ */
@@ -0,0 +1,520 @@
+/*
+ RadioRoomBench.cc
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/*
+ * Benchmarks the hot paths of radioroom.
+ *
+ * Usage: radioroom_bench [-t <ms>] [stream file]
+ *
+ * The stream file contains raw bytes received from the autopilot, for example
+ * captured with 'cat /dev/ttyACM0 > stream.bin'. If the file is not specified,
+ * a synthetic stream with the message mix of ArduPilot's default telemetry
+ * streams is used.
+ *
+ * The results are printed to stdout in JSON Lines format, one object per
+ * benchmark case:
+ *
+ * {"version":"UV Radio Room 2.1.0","benchmark":"mavlink_parse_char","case":"stream",
+ *  "ops":1234,"bytes":5678,"seconds":0.2,"ns_per_op":162.1,"mb_per_s":27.3}
+ *
+ * ops are frames for the parsers, messages for the logger and HIGH_LATENCY
+ * updates, reports for HIGH_LATENCY encoding, AT commands for IridiumSBD and
+ * read calls for Serial.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <atomic>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+#include "build.h"
+#include "mavlink.h"
+#include "Clock.h"
+#include "IridiumSBD.h"
+#include "MAVLinkHandler.h"
+#include "MAVLinkLogger.h"
+#include "MAVLinkParser.h"
+#include "PseudoTerminal.h"
+#include "Serial.h"
+
+#define SYNTHETIC_STREAM_SECONDS 600
+#define CHUNK_SIZE               256    // bytes per read from serial
+#define DEFAULT_MIN_TIME         200    // milliseconds per benchmark case
+#define LOG_BATCH_SIZE           256    // messages logged before the logging thread wakes up
+#define LOG_BATCHES              100
+#define LOG_DRAIN_TIME           (5 * NSEC_PER_MSEC)
+#define PTY_WRITE_SIZE           4096
+
+/**
+ * Work done by a batch of a benchmark case.
+ */
+struct BatchResult {
+    uint64_t ops;
+    uint64_t bytes;
+};
+
+static uint64_t min_time = DEFAULT_MIN_TIME * NSEC_PER_MSEC;
+
+static void report(const char* benchmark, const std::string& name, uint64_t ops, uint64_t bytes, uint64_t time)
+{
+    double seconds = Clock::to_seconds(time);
+
+    printf("{\"version\":\"%s\",\"benchmark\":\"%s\",\"case\":\"%s\",\"ops\":%llu,\"bytes\":%llu,"
+           "\"seconds\":%.6f,\"ns_per_op\":%.1f,\"mb_per_s\":%.3f}\n",
+           RADIO_ROOM_VERSION, benchmark, name.data(), (unsigned long long)ops, (unsigned long long)bytes,
+           seconds, ops > 0 ? (double)time / ops : 0.0, seconds > 0 ? bytes / seconds / (1024 * 1024) : 0.0);
+    fflush(stdout);
+}
+
+/*
+ * Repeats the batch until the minimum benchmark time elapses and reports the totals.
+ */
+template <typename Batch>
+static void bench(const char* benchmark, const std::string& name, Batch batch)
+{
+    uint64_t ops = 0;
+    uint64_t bytes = 0;
+    uint64_t start = Clock::now();
+    uint64_t time;
+
+    do {
+        BatchResult result = batch();
+        ops += result.ops;
+        bytes += result.bytes;
+        time = Clock::now() - start;
+    } while (time < min_time);
+
+    report(benchmark, name, ops, bytes, time);
+}
+
+static void append(std::vector<uint8_t>& stream, const mavlink_message_t& msg)
+{
+    uint8_t buf[MAVLINK_MAX_PACKET_LEN];
+
+    uint16_t n = mavlink_msg_to_send_buffer(buf, &msg);
+    stream.insert(stream.end(), buf, buf + n);
+}
+
+/*
+ * Generates the stream of ArduPilot telemetry: 1Hz HEARTBEAT, SYS_STATUS and
+ * MISSION_CURRENT, 5Hz GPS_RAW_INT and NAV_CONTROLLER_OUTPUT, 10Hz ATTITUDE,
+ * GLOBAL_POSITION_INT and VFR_HUD. Every 100th frame is followed by a few
+ * bytes of line noise.
+ */
+static void generate_stream(std::vector<uint8_t>& stream)
+{
+    mavlink_message_t msg;
+
+    for (int t = 0; t < SYNTHETIC_STREAM_SECONDS * 10; t++) {
+        if (t % 10 == 0) {
+            mavlink_msg_heartbeat_pack(1, 1, &msg, MAV_TYPE_QUADROTOR, MAV_AUTOPILOT_ARDUPILOTMEGA, 0x81, 4, MAV_STATE_ACTIVE);
+            append(stream, msg);
+            mavlink_msg_sys_status_pack(1, 1, &msg, 0, 0, 0, 500, 12100, 1500, 87, 0, 0, 0, 0, 0, 0);
+            append(stream, msg);
+            mavlink_msg_mission_current_pack(1, 1, &msg, t / 100);
+            append(stream, msg);
+        }
+
+        if (t % 2 == 0) {
+            mavlink_msg_gps_raw_int_pack(1, 1, &msg, t * 100000ULL, 3, 473977418 + t, 85455939 - t, 500000, 120, 150, 50, 9000, 12);
+            append(stream, msg);
+            mavlink_msg_nav_controller_output_pack(1, 1, &msg, 0.0f, 0.0f, 90, 90, 150, 0.0f, 0.0f, 0.0f);
+            append(stream, msg);
+        }
+
+        mavlink_msg_attitude_pack(1, 1, &msg, t * 100, 0.01f * t, -0.02f, 1.5f, 0.0f, 0.0f, 0.1f);
+        append(stream, msg);
+        mavlink_msg_global_position_int_pack(1, 1, &msg, t * 100, 473977418 + t, 85455939 - t, 500000, 20000, 50, 50, 0, 9000);
+        append(stream, msg);
+        mavlink_msg_vfr_hud_pack(1, 1, &msg, 5.0f, 5.2f, 90, 50, 20.0f, 0.1f);
+        append(stream, msg);
+
+        if (t % 20 == 0) {
+            stream.push_back(0x00);
+            stream.push_back(MAVLINK_STX);
+            stream.push_back(0x13);
+        }
+    }
+}
+
+static bool load_stream(const char* path, std::vector<uint8_t>& stream)
+{
+    FILE* file = fopen(path, "rb");
+
+    if (file == NULL) {
+        return false;
+    }
+
+    uint8_t buf[4096];
+    size_t n;
+
+    while ((n = fread(buf, 1, sizeof(buf), file)) > 0) {
+        stream.insert(stream.end(), buf, buf + n);
+    }
+
+    fclose(file);
+
+    return !stream.empty();
+}
+
+static void bench_parsers(const std::vector<uint8_t>& stream)
+{
+    bench("mavlink_parse_char", "stream", [&]() {
+        BatchResult result = { 0, stream.size() };
+        mavlink_message_t msg;
+        mavlink_status_t status;
+
+        for (size_t i = 0; i < stream.size(); i++) {
+            if (mavlink_parse_char(MAVLINK_COMM_0, stream[i], &msg, &status)) {
+                result.ops++;
+            }
+        }
+
+        return result;
+    });
+
+    MAVLinkParser parser;
+    std::vector<MAVLinkFrame> frames;
+    frames.reserve(CHUNK_SIZE);
+
+    bench("MAVLinkParser::feed", "stream", [&]() {
+        BatchResult result = { 0, stream.size() };
+
+        for (size_t i = 0; i < stream.size(); i += CHUNK_SIZE) {
+            size_t n = stream.size() - i < CHUNK_SIZE ? stream.size() - i : CHUNK_SIZE;
+            frames.clear();
+            result.ops += parser.feed(stream.data() + i, n, frames);
+        }
+
+        return result;
+    });
+}
+
+/*
+ * The log mask of the logger enables the messages, while the syslog mask
+ * discards them, so the cost of checking, queuing and formatting the messages
+ * is measured without flooding the system log.
+ */
+static void bench_logger(const std::map<uint8_t, mavlink_message_t>& messages)
+{
+    for (std::map<uint8_t, mavlink_message_t>::const_iterator it = messages.begin(); it != messages.end(); ++it) {
+        const mavlink_message_t& msg = it->second;
+        char name[32];
+
+        // Priority is masked out
+        MAVLinkLogger::set_log_mask(LOG_UPTO(LOG_INFO));
+
+        snprintf(name, sizeof(name), "msgid_%u_filtered", msg.msgid);
+        bench("MAVLinkLogger::log", name, [&]() {
+            for (int i = 0; i < LOG_BATCH_SIZE; i++) {
+                MAVLinkLogger::log(LOG_DEBUG, "MAV >>", msg);
+            }
+
+            BatchResult result = { LOG_BATCH_SIZE, 0 };
+            return result;
+        });
+
+        MAVLinkLogger::set_log_mask(LOG_UPTO(LOG_DEBUG));
+        setlogmask(LOG_MASK(LOG_EMERG));
+
+        // Formatted and written synchronously
+        snprintf(name, sizeof(name), "msgid_%u_sync", msg.msgid);
+        bench("MAVLinkLogger::log", name, [&]() {
+            for (int i = 0; i < LOG_BATCH_SIZE; i++) {
+                MAVLinkLogger::log(LOG_DEBUG, "MAV >>", msg);
+            }
+
+            BatchResult result = { LOG_BATCH_SIZE, 0 };
+            return result;
+        });
+
+        // Queued for the logging thread, which is given time to drain the ring between the batches
+        if (!MAVLinkLogger::start()) {
+            fprintf(stderr, "Failed to start logging thread.\n");
+            continue;
+        }
+
+        unsigned long dropped = MAVLinkLogger::get_dropped_count();
+        uint64_t time = 0;
+
+        for (int batch = 0; batch < LOG_BATCHES; batch++) {
+            uint64_t start = Clock::now();
+
+            for (int i = 0; i < LOG_BATCH_SIZE; i++) {
+                MAVLinkLogger::log(LOG_DEBUG, "MAV >>", msg);
+            }
+
+            time += Clock::now() - start;
+
+            Clock::sleep(LOG_DRAIN_TIME);
+        }
+
+        MAVLinkLogger::stop();
+
+        snprintf(name, sizeof(name), "msgid_%u_queued", msg.msgid);
+        report("MAVLinkLogger::log", name, LOG_BATCHES * LOG_BATCH_SIZE, 0, time);
+
+        if (MAVLinkLogger::get_dropped_count() != dropped) {
+            fprintf(stderr, "MAVLinkLogger dropped %lu messages of %s.\n",
+                    MAVLinkLogger::get_dropped_count() - dropped, name);
+        }
+    }
+
+    MAVLinkLogger::set_log_mask(LOG_UPTO(LOG_INFO));
+}
+
+static void bench_high_latency(const std::vector<mavlink_message_t>& messages)
+{
+    mavlink_high_latency_t high_latency;
+    uint16_t mask = 0;
+
+    memset(&high_latency, 0, sizeof(high_latency));
+
+    bench("MAVLinkHandler::update_high_latency_msg", "stream", [&]() {
+        BatchResult result = { messages.size(), 0 };
+
+        for (size_t i = 0; i < messages.size(); i++) {
+            MAVLinkHandler::update_high_latency_msg(messages[i], high_latency, mask);
+        }
+
+        return result;
+    });
+
+    bench("mavlink_msg_high_latency_encode", "report", [&]() {
+        mavlink_message_t msg;
+        uint8_t buf[MAVLINK_MAX_PACKET_LEN];
+        BatchResult result = { CHUNK_SIZE, 0 };
+
+        for (int i = 0; i < CHUNK_SIZE; i++) {
+            high_latency.wp_num = i;
+            mavlink_msg_high_latency_encode(1, 1, &msg, &high_latency);
+            result.bytes += mavlink_msg_to_send_buffer(buf, &msg);
+        }
+
+        return result;
+    });
+}
+
+/**
+ * Transceiver that answers every AT command with the same canned bytes.
+ */
+class CannedModem : public Serial {
+    std::string response;
+    std::string pending;
+    size_t      pos;
+
+public:
+    CannedModem(const std::string& response) :
+        response(response), pending(), pos(0)
+    {
+    }
+
+    int open(const string& path, int baud_rate)
+    {
+        (void)path;
+        (void)baud_rate;
+        return 0;
+    }
+
+    int close()
+    {
+        return 0;
+    }
+
+    int read(void* buffer, size_t size)
+    {
+        size_t n = pending.size() - pos < size ? pending.size() - pos : size;
+        memcpy(buffer, pending.data() + pos, n);
+        pos += n;
+        return n;
+    }
+
+    int available()
+    {
+        return pending.size() - pos;
+    }
+
+    int write(const void* buffer, size_t n)
+    {
+        // Echo the command followed by the response
+        pending.assign((const char*)buffer, n);
+        pending += response;
+        pos = 0;
+        return n;
+    }
+};
+
+static void bench_at_response(const char* name, const std::string& response)
+{
+    CannedModem modem(response);
+    IridiumSBD isbd(modem);
+    bool failed = false;
+
+    bench("IridiumSBD::waitForATResponse", name, [&]() {
+        BatchResult result = { CHUNK_SIZE, 0 };
+
+        for (int i = 0; i < CHUNK_SIZE; i++) {
+            int quality = -1;
+
+            if (isbd.getSignalQuality(quality) != ISBD_SUCCESS || quality != 4) {
+                failed = true;
+            }
+
+            result.bytes += strlen("AT+CSQ\r") + response.size();
+        }
+
+        return result;
+    });
+
+    if (failed) {
+        fprintf(stderr, "Unexpected response to AT+CSQ in %s.\n", name);
+    }
+}
+
+static void bench_serial_read(const std::vector<uint8_t>& stream, const char* name, size_t read_size)
+{
+    PseudoTerminal pty;
+
+    if (!pty.open("")) {
+        fprintf(stderr, "Failed to create pseudo terminal.\n");
+        return;
+    }
+
+    Serial serial;
+
+    if (serial.open(pty.get_path(), 115200) < 0) {
+        fprintf(stderr, "Failed to open '%s'.\n", pty.get_path().data());
+        pty.close();
+        return;
+    }
+
+    std::atomic<bool> running(true);
+    std::atomic<bool> writing(true);
+
+    std::thread writer([&]() {
+        for (size_t i = 0; running; i = (i + PTY_WRITE_SIZE) % (stream.size() - PTY_WRITE_SIZE)) {
+            pty.write(stream.data() + i, PTY_WRITE_SIZE);
+        }
+
+        writing = false;
+    });
+
+    uint8_t buf[PTY_WRITE_SIZE];
+
+    bench("Serial::read", name, [&]() {
+        BatchResult result = { CHUNK_SIZE, 0 };
+
+        for (int i = 0; i < CHUNK_SIZE; i++) {
+            int n = read_size == 1 ? (serial.read() >= 0 ? 1 : 0) : serial.read(buf, read_size);
+
+            if (n > 0) {
+                result.bytes += n;
+            }
+        }
+
+        return result;
+    });
+
+    // Unblock the writer
+    running = false;
+
+    while (writing) {
+        serial.read(buf, sizeof(buf));
+    }
+
+    writer.join();
+    serial.close();
+    pty.close();
+}
+
+static void print_help()
+{
+    printf("Usage: radioroom_bench [options] [stream file]\n");
+    printf("options:\n");
+    printf("    -t <ms>    Minimum time of each benchmark case (default %d).\n", DEFAULT_MIN_TIME);
+    printf("    -h         Print this help and exit.\n");
+}
+
+int main(int argc, char** argv)
+{
+    int c;
+    while ((c = getopt(argc, argv, "t:h")) != -1) {
+        switch (c) {
+        case 't':
+            min_time = atoi(optarg) * NSEC_PER_MSEC;
+            break;
+        case 'h':
+            print_help();
+            return EXIT_SUCCESS;
+        default:
+            print_help();
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::vector<uint8_t> stream;
+
+    if (optind < argc) {
+        if (!load_stream(argv[optind], stream)) {
+            fprintf(stderr, "Failed to read stream file '%s'.\n", argv[optind]);
+            return EXIT_FAILURE;
+        }
+    } else {
+        generate_stream(stream);
+    }
+
+    if (stream.size() < 2 * PTY_WRITE_SIZE) {
+        fprintf(stderr, "Stream is shorter than %d bytes.\n", 2 * PTY_WRITE_SIZE);
+        return EXIT_FAILURE;
+    }
+
+    // Decode the stream on a separate channel to keep the parser benchmark state clean
+    std::vector<mavlink_message_t> messages;
+    std::map<uint8_t, mavlink_message_t> first_messages;
+    mavlink_message_t msg;
+    mavlink_status_t status;
+
+    for (size_t i = 0; i < stream.size(); i++) {
+        if (mavlink_parse_char(MAVLINK_COMM_1, stream[i], &msg, &status)) {
+            messages.push_back(msg);
+            first_messages.insert(std::make_pair(msg.msgid, msg));
+        }
+    }
+
+    bench_parsers(stream);
+    bench_logger(first_messages);
+    bench_high_latency(messages);
+
+    bench_at_response("csq", "\r\n+CSQ:4\r\n\r\nOK\r\n");
+    bench_at_response("csq_unsolicited", "\r\n+CIEV:0,4\r\nSBDRING\r\n+CIEV:1,1\r\n+CSQ:4\r\n\r\nOK\r\n");
+
+    bench_serial_read(stream, "byte", 1);
+    bench_serial_read(stream, "chunk_64", 64);
+    bench_serial_read(stream, "chunk_256", CHUNK_SIZE);
+    bench_serial_read(stream, "chunk_4096", PTY_WRITE_SIZE);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,227 @@
+/*
+ ReportCodecTest.cc
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+/*
+ * Encodes a sequence of HIGH_LATENCY reports of a slowly moving vehicle and
+ * its track with some of the SBD sessions failing, decodes the delivered
+ * reports and track samples on the ground and checks that they match the
+ * originals and that the deltas save credits.
+ *
+ * Returns 0 if all the checks passed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Clock.h"
+#include "MAVLinkFrame.h"
+#include "MAVLinkISBDChannel.h"
+#include "MAVLinkParser.h"
+#include "MAVLinkReportCodec.h"
+#include "MAVLinkSerial.h"
+#include "MAVLinkTrack.h"
+#include "TestUtil.h"
+
+#define REPORT_COUNT        100
+#define KEYFRAME_INTERVAL   10
+#define FAILED_SESSIONS     7       // every 7th SBD session fails
+#define REPORT_PERIOD       60      // seconds
+#define SAMPLES_PER_REPORT  4
+
+static void make_report(int t, mavlink_message_t& msg)
+{
+    mavlink_high_latency_t report;
+    memset(&report, 0, sizeof(report));
+
+    report.custom_mode = 10;
+    report.base_mode = MAV_MODE_FLAG_CUSTOM_MODE_ENABLED | MAV_MODE_FLAG_SAFETY_ARMED;
+    report.landed_state = MAV_LANDED_STATE_IN_AIR;
+    report.latitude = 473977418 + t * 37;
+    report.longitude = 85455939 - t * 52;
+    report.roll = (t % 5) - 2;
+    report.pitch = -(t % 3);
+    report.heading = (35990 + t * 5) % 36000;   // wraps around north
+    report.altitude_amsl = 500 + t / 10;
+    report.altitude_sp = 100;
+    report.wp_distance = 2000 - t * 10;
+    report.groundspeed = 12;
+    report.airspeed = 13;
+    report.gps_nsat = 12;
+    report.gps_fix_type = GPS_FIX_TYPE_3D_FIX;
+    report.battery_remaining = 100 - t / 5;
+    report.temperature = 25;
+    report.wp_num = 1 + t / 20;
+
+    mavlink_msg_high_latency_encode(ARDUPILOT_SYSTEM_ID, ARDUPILOT_COMPONENT_ID, &msg, &report);
+}
+
+static uint64_t report_time(int t)
+{
+    return (uint64_t)(t + 1) * REPORT_PERIOD * NSEC_PER_SEC;
+}
+
+/**
+ * Samples the track between the reports t - 1 and t.
+ */
+static void make_samples(int t, MAVLinkTrack& track, vector<TrackSample>& sent)
+{
+    for (int i = 1; i <= SAMPLES_PER_REPORT; i++) {
+        TrackSample sample;
+        sample.time = report_time(t) - (uint64_t)(SAMPLES_PER_REPORT - i + 1) * REPORT_PERIOD / SAMPLES_PER_REPORT * NSEC_PER_SEC / 2;
+        sample.latitude = 473977418 + t * 37 - (SAMPLES_PER_REPORT - i) * 9;
+        sample.longitude = 85455939 - t * 52 + (SAMPLES_PER_REPORT - i) * 13;
+        sample.altitude = 500 + t / 10;
+        sample.heading = ((35990 + t * 5) % 36000) / 100;
+        sample.groundspeed = 12;
+
+        track.add_sample(sample);
+        sent.push_back(sample);
+    }
+}
+
+int main()
+{
+    MAVLinkReportCodec encoder, decoder;
+    MAVLinkTrack track;
+    MAVLinkParser parser;
+    encoder.set_keyframe_interval(KEYFRAME_INTERVAL);
+
+    size_t keyframes = 0, deltas = 0, keyframe_credits = 0, delta_credits = 0;
+    vector<TrackSample> sent;
+
+    for (int t = 0; t < REPORT_COUNT; t++) {
+        mavlink_message_t report;
+        make_report(t, report);
+        make_samples(t, track, sent);
+
+        vector<MAVLinkFrame> frames;
+        encoder.encode(report, report_time(t), track, frames);
+
+        CHECK(!frames.empty());
+
+        size_t size = 0;
+
+        for (size_t i = 0; i < frames.size(); i++) {
+            size += frames[i].size();
+        }
+
+        if (frames[0].msgid() == MAVLINK_MSG_ID_HIGH_LATENCY) {
+            keyframes++;
+            keyframe_credits += ISBDCreditBudget::credits(size);
+        } else {
+            CHECK(frames[0].msgid() == MAVLINK_MSG_ID_MEMORY_VECT);
+            deltas++;
+            delta_credits += ISBDCreditBudget::credits(size);
+        }
+
+        if (t % FAILED_SESSIONS == FAILED_SESSIONS - 1) {
+            continue; // the report is not delivered to the ground
+        }
+
+        encoder.acknowledge();
+        track.clear();
+
+        // The ground parses the serialized frames
+        vector<MAVLinkFrame> received;
+
+        for (size_t i = 0; i < frames.size(); i++) {
+            parser.feed(frames[i].data(), frames[i].size(), received);
+        }
+
+        CHECK(received.size() == frames.size());
+
+        mavlink_message_t decoded;
+        vector<TrackSample> samples;
+        CHECK(!received.empty() && decoder.decode(received[0].get_message(), report_time(t), decoded, samples));
+        CHECK(decoded.msgid == MAVLINK_MSG_ID_HIGH_LATENCY && decoded.sysid == ARDUPILOT_SYSTEM_ID);
+        CHECK(memcmp(_MAV_PAYLOAD(&decoded), _MAV_PAYLOAD(&report), MAVLINK_MSG_ID_HIGH_LATENCY_LEN) == 0);
+
+        mavlink_high_latency_t high_latency;
+        mavlink_msg_high_latency_decode(&decoded, &high_latency);
+
+        vector<mavlink_message_t> msgs;
+
+        for (size_t i = 1; i < received.size(); i++) {
+            msgs.push_back(received[i].get_message());
+        }
+
+        CHECK(MAVLinkTrack::unpack(high_latency, report_time(t), msgs, samples));
+        CHECK(samples.size() == sent.size());
+
+        // Newest samples first
+        for (size_t i = 0; i < samples.size() && i < sent.size(); i++) {
+            const TrackSample& expected = sent[sent.size() - 1 - i];
+            CHECK(labs(samples[i].latitude - expected.latitude) < TRACK_LATLON_SCALE);
+            CHECK(labs(samples[i].longitude - expected.longitude) < TRACK_LATLON_SCALE);
+            CHECK(samples[i].altitude == expected.altitude && samples[i].heading == expected.heading);
+            CHECK(samples[i].time >= expected.time && samples[i].time - expected.time < NSEC_PER_SEC);
+        }
+
+        sent.clear();
+    }
+
+    printf("%d reports with %d track samples each: %d keyframes of %.1f credits, %d deltas of %.1f credits on average\n",
+           REPORT_COUNT, SAMPLES_PER_REPORT, (int)keyframes, keyframes > 0 ? (double)keyframe_credits / keyframes : 0.0,
+           (int)deltas, deltas > 0 ? (double)delta_credits / deltas : 0.0);
+
+    CHECK(keyframes >= REPORT_COUNT / KEYFRAME_INTERVAL && keyframes < 2 * REPORT_COUNT / KEYFRAME_INTERVAL);
+    CHECK(deltas > 0 && delta_credits * keyframes < keyframe_credits * deltas);
+
+    // A delta against an unknown base is rejected
+    MAVLinkReportCodec ground;
+    MAVLinkTrack empty;
+    mavlink_message_t report, decoded;
+    vector<MAVLinkFrame> frames;
+    vector<TrackSample> samples;
+    make_report(REPORT_COUNT, report);
+    encoder.encode(report, report_time(REPORT_COUNT), empty, frames);
+
+    CHECK(frames.size() == 1 && frames[0].msgid() == MAVLINK_MSG_ID_MEMORY_VECT);
+    CHECK(!ground.decode(frames[0].get_message(), 0, decoded, samples));
+
+    make_report(0, report);
+    CHECK(ground.decode(report, 0, decoded, samples));
+    CHECK(!ground.decode(frames[0].get_message(), 0, decoded, samples));
+
+    // A report with too many changes is sent as a keyframe
+    mavlink_high_latency_t jump;
+    memset(&jump, 0xA5, sizeof(jump));
+    mavlink_msg_high_latency_encode(ARDUPILOT_SYSTEM_ID, ARDUPILOT_COMPONENT_ID, &report, &jump);
+    frames.clear();
+    encoder.encode(report, 0, empty, frames);
+
+    CHECK(frames.size() == 1 && frames[0].msgid() == MAVLINK_MSG_ID_HIGH_LATENCY);
+
+    // Keyframes only if the deltas are disabled
+    MAVLinkReportCodec disabled;
+
+    for (int t = 0; t < 3; t++) {
+        make_report(t, report);
+        frames.clear();
+        disabled.encode(report, 0, empty, frames);
+        disabled.acknowledge();
+        CHECK(frames.size() == 1 && frames[0].msgid() == MAVLINK_MSG_ID_HIGH_LATENCY);
+    }
+
+    return failures == 0 ? 0 : 1;
+}
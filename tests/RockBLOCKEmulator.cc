@@ -0,0 +1,455 @@
+/*
+ RockBLOCKEmulator.cc
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "RockBLOCKEmulator.h"
+#include "Clock.h"
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define IRIDIUM_EPOCH       1399818235  // May 11, 2014, 14:23:55 UTC
+#define IRIDIUM_TICK        90          // milliseconds
+#define FAILURE_RATE_SCALE  1000000
+
+RockBLOCKEmulator::RockBLOCKEmulator() :
+    pty(), socket_fd(-1), socket_path(), line(), echo(true), binary_size(0), binary(),
+    binary_deadline(0), response(), response_time(0), mo_buffer(), mo_flag(false),
+    mt_buffer(), mt_flag(false), momsn(0), mtmsn(0), random_seed(1),
+    signal_indication(false), service_indication(false), reported_quality(-1), reported_service(-1),
+    queue_mutex(), mt_queue(), mo_queue(),
+    signal_quality(ROCKBLOCK_DEFAULT_CSQ),
+    at_latency(ROCKBLOCK_DEFAULT_AT_LATENCY * NSEC_PER_MSEC),
+    sbdix_latency(ROCKBLOCK_DEFAULT_SBDIX_LATENCY * NSEC_PER_MSEC),
+    failure_code(ROCKBLOCK_DEFAULT_FAILURE_CODE), failure_rate(0),
+    sessions(0), failed_sessions(0), mo_messages(0), mo_bytes(0), mt_messages(0),
+    csq_queries(0), msstm_queries(0)
+{
+}
+
+RockBLOCKEmulator::~RockBLOCKEmulator()
+{
+    close();
+}
+
+bool RockBLOCKEmulator::open(const std::string& link_path, const std::string& socket_path)
+{
+    if (!pty.open(link_path)) {
+        return false;
+    }
+
+    if (socket_path.empty()) {
+        return true;
+    }
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+
+    if (socket_path.size() >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Socket path '%s' is too long.\n", socket_path.data());
+        close();
+        return false;
+    }
+
+    strncpy(addr.sun_path, socket_path.data(), sizeof(addr.sun_path) - 1);
+
+    socket_fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+    unlink(socket_path.data());
+
+    if (socket_fd < 0 || bind(socket_fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        fprintf(stderr, "Failed to bind socket '%s': %s\n", socket_path.data(), strerror(errno));
+        close();
+        return false;
+    }
+
+    this->socket_path = socket_path;
+
+    return true;
+}
+
+void RockBLOCKEmulator::close()
+{
+    if (socket_fd >= 0) {
+        ::close(socket_fd);
+        socket_fd = -1;
+    }
+
+    if (!socket_path.empty()) {
+        unlink(socket_path.data());
+        socket_path.clear();
+    }
+
+    pty.close();
+}
+
+void RockBLOCKEmulator::set_signal_quality(int quality)
+{
+    signal_quality = quality < 0 ? 0 : (quality > 5 ? 5 : quality);
+}
+
+void RockBLOCKEmulator::set_at_latency(int ms)
+{
+    at_latency = (uint64_t)ms * NSEC_PER_MSEC;
+}
+
+void RockBLOCKEmulator::set_sbdix_latency(int ms)
+{
+    sbdix_latency = (uint64_t)ms * NSEC_PER_MSEC;
+}
+
+void RockBLOCKEmulator::set_failure(int mo_code, double rate)
+{
+    failure_code = mo_code;
+    failure_rate = (int)(rate * FAILURE_RATE_SCALE);
+}
+
+void RockBLOCKEmulator::queue_mt(const std::string& message)
+{
+    std::lock_guard<std::mutex> lock(queue_mutex);
+    mt_queue.push_back(message);
+}
+
+bool RockBLOCKEmulator::pop_mo(std::string& message)
+{
+    std::lock_guard<std::mutex> lock(queue_mutex);
+
+    if (mo_queue.empty()) {
+        return false;
+    }
+
+    message = mo_queue.front();
+    mo_queue.pop_front();
+    return true;
+}
+
+void RockBLOCKEmulator::run(int timeout)
+{
+    uint64_t now = Clock::now();
+    uint64_t wait = (uint64_t)timeout * NSEC_PER_MSEC;
+
+    if (!response.empty()) {
+        wait = response_time > now ? (response_time - now < wait ? response_time - now : wait) : 0;
+    } else if (binary_size > 0) {
+        wait = binary_deadline > now ? (binary_deadline - now < wait ? binary_deadline - now : wait) : 0;
+    }
+
+    // Like the real transceiver, the commands are not processed until the
+    // response to the previous command is sent
+    struct pollfd fds[2];
+    int nfds = 0;
+
+    fds[nfds].fd = pty.get_fd();
+    fds[nfds].events = response.empty() ? POLLIN : 0;
+    fds[nfds].revents = 0;
+    nfds++;
+
+    if (socket_fd >= 0) {
+        fds[nfds].fd = socket_fd;
+        fds[nfds].events = POLLIN;
+        fds[nfds].revents = 0;
+        nfds++;
+    }
+
+    poll(fds, nfds, (int)((wait + NSEC_PER_MSEC - 1) / NSEC_PER_MSEC));
+
+    if (socket_fd >= 0 && (fds[1].revents & POLLIN)) {
+        receive_mt();
+    }
+
+    if (fds[0].revents & POLLIN) {
+        char buffer[512];
+        int n = pty.read(buffer, sizeof(buffer));
+
+        if (n > 0) {
+            receive(buffer, n);
+        }
+    }
+
+    now = Clock::now();
+
+    if (binary_size > 0 && now >= binary_deadline) {
+        binary_size = 0;
+        respond("\r\n1\r\n\r\nOK\r\n", 0);
+    }
+
+    if (!response.empty() && now >= response_time) {
+        pty.write(response.data(), response.size());
+        response.clear();
+    }
+
+    if (response.empty() && binary_size == 0) {
+        indicate();
+    }
+}
+
+void RockBLOCKEmulator::receive_mt()
+{
+    char buffer[ROCKBLOCK_MAX_MT_SIZE + 1];
+    ssize_t n;
+
+    while ((n = recv(socket_fd, buffer, sizeof(buffer), MSG_TRUNC)) >= 0) {
+        if (n > ROCKBLOCK_MAX_MT_SIZE) {
+            fprintf(stderr, "MT message of %d bytes exceeds %d bytes.\n", (int)n, ROCKBLOCK_MAX_MT_SIZE);
+            continue;
+        }
+
+        queue_mt(std::string(buffer, n));
+    }
+}
+
+void RockBLOCKEmulator::receive(const char* data, size_t size)
+{
+    for (size_t i = 0; i < size; i++) {
+        if (binary_size > 0) {
+            binary += data[i];
+
+            if (binary.size() < binary_size) {
+                continue;
+            }
+
+            uint16_t checksum = 0;
+
+            for (size_t j = 0; j + 2 < binary.size(); j++) {
+                checksum += (uint8_t)binary[j];
+            }
+
+            binary_size = 0;
+
+            if ((uint8_t)binary[binary.size() - 2] == (checksum >> 8) &&
+                (uint8_t)binary[binary.size() - 1] == (checksum & 0xFF)) {
+                mo_buffer = binary.substr(0, binary.size() - 2);
+                mo_flag = true;
+                respond("\r\n0\r\n\r\nOK\r\n", at_latency);
+            } else {
+                respond("\r\n2\r\n\r\nOK\r\n", at_latency);
+            }
+        } else if (data[i] == '\r') {
+            command(line);
+            line.clear();
+        } else if (data[i] != '\n') {
+            line += data[i];
+        }
+    }
+}
+
+void RockBLOCKEmulator::command(const std::string& cmd)
+{
+    char buff[64];
+
+    if (cmd.empty()) {
+        return;
+    }
+
+    if (cmd == "ATE0" || cmd == "ATE1") {
+        echo = cmd[3] == '1';
+        respond_ok(cmd, "");
+    } else if (cmd == "AT" || cmd == "AT&D0" || cmd == "AT&K0" || cmd == "AT*F" ||
+               cmd.compare(0, 9, "AT+SBDMTA") == 0) {
+        respond_ok(cmd, "");
+    } else if (cmd.compare(0, 8, "AT+CIER=") == 0) {
+        int mode = 0, sigind = 0, svcind = 0;
+        sscanf(cmd.data() + 8, "%d,%d,%d", &mode, &sigind, &svcind);
+
+        // The current values are reported right after enabling the indications
+        signal_indication = mode == 1 && sigind == 1;
+        service_indication = mode == 1 && svcind == 1;
+        reported_quality = -1;
+        reported_service = -1;
+        respond_ok(cmd, "");
+    } else if (cmd == "AT+CGMM") {
+        respond_ok(cmd, ROCKBLOCK_MODEL);
+    } else if (cmd == "AT+CGSN") {
+        respond_ok(cmd, ROCKBLOCK_IMEI);
+    } else if (cmd == "AT+CSQ" || cmd == "AT+CSQF") {
+        csq_queries++;
+        snprintf(buff, sizeof(buff), "+CSQ:%d", signal_quality.load());
+        respond_ok(cmd, buff);
+    } else if (cmd == "AT-MSSTM") {
+        msstm_queries++;
+
+        if (signal_quality > 0) {
+            uint64_t ms = ((uint64_t)time(NULL) - IRIDIUM_EPOCH) * 1000;
+            snprintf(buff, sizeof(buff), "-MSSTM: %08x", (unsigned int)(ms / IRIDIUM_TICK));
+            respond_ok(cmd, buff);
+        } else {
+            respond_ok(cmd, "-MSSTM: no network service");
+        }
+    } else if (cmd == "AT+CRIS") {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        snprintf(buff, sizeof(buff), "+CRIS:000,%03d", mt_queue.empty() ? 0 : 1);
+        respond_ok(cmd, buff);
+    } else if (cmd == "AT+SBDSX") {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        snprintf(buff, sizeof(buff), "+SBDSX: %d, %u, %d, %u, %d, %u", mo_flag ? 1 : 0, momsn,
+                 mt_flag ? 1 : 0, mtmsn, mt_queue.empty() ? 0 : 1, (unsigned int)mt_queue.size());
+        respond_ok(cmd, buff);
+    } else if (cmd.compare(0, 9, "AT+SBDWB=") == 0) {
+        size_t size = atoi(cmd.data() + 9);
+        std::string prefix = echo ? cmd + "\r" : "";
+
+        if (size < 1 || size > ROCKBLOCK_MAX_MO_SIZE) {
+            respond(prefix + "\r\n3\r\n\r\nOK\r\n", at_latency);
+        } else {
+            binary.clear();
+            binary_size = size + 2;
+            binary_deadline = Clock::now() + ROCKBLOCK_SBDWB_TIMEOUT * NSEC_PER_SEC;
+            respond(prefix + "\r\nREADY\r\n", at_latency);
+        }
+    } else if (cmd.compare(0, 9, "AT+SBDWT=") == 0) {
+        mo_buffer = cmd.substr(9);
+        mo_flag = true;
+        respond_ok(cmd, "");
+    } else if (cmd == "AT+SBDD0" || cmd == "AT+SBDD1" || cmd == "AT+SBDD2") {
+        if (cmd[7] != '1') {
+            mo_buffer.clear();
+            mo_flag = false;
+        }
+
+        if (cmd[7] != '0') {
+            mt_buffer.clear();
+            mt_flag = false;
+        }
+
+        respond_ok(cmd, "0");
+    } else if (cmd == "AT+SBDIX" || cmd == "AT+SBDIXA") {
+        sbdix(cmd);
+    } else if (cmd == "AT+SBDRB") {
+        std::string data = echo ? cmd + "\r" : "";
+        uint16_t checksum = 0;
+
+        data += (char)(mt_buffer.size() >> 8);
+        data += (char)(mt_buffer.size() & 0xFF);
+
+        for (size_t i = 0; i < mt_buffer.size(); i++) {
+            checksum += (uint8_t)mt_buffer[i];
+        }
+
+        data += mt_buffer;
+        data += (char)(checksum >> 8);
+        data += (char)(checksum & 0xFF);
+        data += "\r\nOK\r\n";
+        respond(data, at_latency);
+    } else if (cmd == "AT+SBDRT") {
+        respond_ok(cmd, "+SBDRT:\r\n" + mt_buffer);
+    } else {
+        respond((echo ? cmd + "\r" : "") + "\r\nERROR\r\n", at_latency);
+    }
+}
+
+void RockBLOCKEmulator::sbdix(const std::string& cmd)
+{
+    char buff[64];
+    int mo_code = 0;
+    int mt_code = 0;
+    size_t mt_queued;
+
+    sessions++;
+
+    if (signal_quality == 0) {
+        mo_code = 32;
+    } else if (failure_rate > 0 && rand_r(&random_seed) % FAILURE_RATE_SCALE < failure_rate) {
+        mo_code = failure_code;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+
+        if (mo_code == 0) {
+            if (mo_flag) {
+                momsn++;
+                mo_queue.push_back(mo_buffer);
+                mo_messages++;
+                mo_bytes += mo_buffer.size();
+            }
+
+            if (!mt_queue.empty()) {
+                mt_buffer = mt_queue.front();
+                mt_queue.pop_front();
+                mt_flag = true;
+                mt_code = 1;
+                mtmsn++;
+                mt_messages++;
+            }
+        } else {
+            failed_sessions++;
+            mt_code = 2;
+        }
+
+        mt_queued = mt_queue.size();
+    }
+
+    snprintf(buff, sizeof(buff), "+SBDIX: %d, %u, %d, %u, %u, %u", mo_code, momsn, mt_code, mtmsn,
+             mt_code == 1 ? (unsigned int)mt_buffer.size() : 0, (unsigned int)mt_queued);
+
+    respond((echo ? cmd + "\r" : std::string()) + "\r\n" + buff + "\r\n\r\nOK\r\n",
+            at_latency + sbdix_latency);
+}
+
+void RockBLOCKEmulator::indicate()
+{
+    char buff[32];
+    std::string text;
+    int quality = signal_quality;
+    int service = quality > 0 ? 1 : 0;
+
+    if (signal_indication && quality != reported_quality) {
+        snprintf(buff, sizeof(buff), "+CIEV:0,%d\r\n", quality);
+        text += buff;
+        reported_quality = quality;
+    }
+
+    if (service_indication && service != reported_service) {
+        snprintf(buff, sizeof(buff), "+CIEV:1,%d\r\n", service);
+        text += buff;
+        reported_service = service;
+    }
+
+    if (!text.empty()) {
+        pty.write(text.data(), text.size());
+    }
+}
+
+void RockBLOCKEmulator::respond(const std::string& text, uint64_t latency)
+{
+    response = text;
+    response_time = Clock::now() + latency;
+}
+
+void RockBLOCKEmulator::respond_ok(const std::string& cmd, const std::string& text)
+{
+    std::string data = echo ? cmd + "\r" : "";
+
+    if (!text.empty()) {
+        data += "\r\n" + text + "\r\n";
+    }
+
+    data += "\r\nOK\r\n";
+
+    respond(data, at_latency);
+}
@@ -0,0 +1,176 @@
+/*
+ RockBLOCKEmulator.h
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef ROCKBLOCKEMULATOR_H_
+#define ROCKBLOCKEMULATOR_H_
+
+#include <stdint.h>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <string>
+#include "PseudoTerminal.h"
+
+#define ROCKBLOCK_MAX_MO_SIZE           340
+#define ROCKBLOCK_MAX_MT_SIZE           270
+#define ROCKBLOCK_SBDWB_TIMEOUT         60      // seconds
+#define ROCKBLOCK_MODEL                 "IRIDIUM 9600 Family SBD Transceiver"
+#define ROCKBLOCK_IMEI                  "300234010753370"
+
+#define ROCKBLOCK_DEFAULT_CSQ           5
+#define ROCKBLOCK_DEFAULT_AT_LATENCY    10      // milliseconds
+#define ROCKBLOCK_DEFAULT_SBDIX_LATENCY 5000    // milliseconds
+#define ROCKBLOCK_DEFAULT_FAILURE_CODE  32      // no network service
+
+/**
+ * Emulates RockBLOCK Iridium SBD transceiver on a pseudo terminal.
+ *
+ * The emulator implements the AT commands used by IridiumSBD class with
+ * mobile originated (MO) and mobile terminated (MT) message queues. Signal
+ * quality, latencies of the responses and SBDIX failures are configurable,
+ * so sessions and retries can be exercised without the hardware and
+ * without spending credits. Signal quality and network service changes are
+ * reported with +CIEV when enabled by AT+CIER.
+ *
+ * MT messages are queued by queue_mt() or by sending datagrams to the
+ * Unix socket, one message per datagram.
+ *
+ * run() must be called from a single thread. The settings, queue_mt(),
+ * pop_mo() and the statistics can be used from any thread.
+ */
+class RockBLOCKEmulator {
+    PseudoTerminal          pty;
+    int                     socket_fd;
+    std::string             socket_path;
+
+    std::string             line;           // command being received
+    bool                    echo;
+    size_t                  binary_size;    // bytes of SBDWB message and checksum expected
+    std::string             binary;
+    uint64_t                binary_deadline;
+    std::string             response;       // response waiting for the latency to expire
+    uint64_t                response_time;
+
+    std::string             mo_buffer;
+    bool                    mo_flag;
+    std::string             mt_buffer;
+    bool                    mt_flag;
+    uint16_t                momsn;
+    uint16_t                mtmsn;
+    unsigned int            random_seed;
+    bool                    signal_indication;  // +CIEV enabled by AT+CIER
+    bool                    service_indication;
+    int                     reported_quality;   // last signal quality reported by +CIEV, -1 if none
+    int                     reported_service;
+
+    std::mutex              queue_mutex;
+    std::deque<std::string> mt_queue;
+    std::deque<std::string> mo_queue;
+
+    std::atomic<int>        signal_quality;
+    std::atomic<uint64_t>   at_latency;
+    std::atomic<uint64_t>   sbdix_latency;
+    std::atomic<int>        failure_code;
+    std::atomic<int>        failure_rate;   // per million sessions
+
+public:
+    std::atomic<int>        sessions;       // SBDIX commands
+    std::atomic<int>        failed_sessions;
+    std::atomic<int>        mo_messages;
+    std::atomic<uint64_t>   mo_bytes;
+    std::atomic<int>        mt_messages;
+    std::atomic<int>        csq_queries;    // AT+CSQ commands
+    std::atomic<int>        msstm_queries;  // AT-MSSTM commands
+
+    RockBLOCKEmulator();
+    ~RockBLOCKEmulator();
+
+    /**
+     * Creates the pseudo terminal and the MT injection socket.
+     *
+     * link_path - symbolic link to the device, not created if empty
+     * socket_path - Unix datagram socket for MT messages, not created if empty
+     *
+     * Returns true on success.
+     */
+    bool open(const std::string& link_path, const std::string& socket_path);
+
+    /**
+     * Closes the pseudo terminal and the socket.
+     */
+    void close();
+
+    /**
+     * Returns the path of the emulated serial device.
+     */
+    inline const std::string& get_path() const { return pty.get_path(); }
+
+    /**
+     * Sets signal quality reported by AT+CSQ and +CIEV from 0 to 5.
+     * SBDIX sessions fail with code 32 when the signal quality is 0.
+     */
+    void set_signal_quality(int quality);
+
+    /**
+     * Sets time in milliseconds between an AT command and its response.
+     */
+    void set_at_latency(int ms);
+
+    /**
+     * Sets time in milliseconds between AT+SBDIX and its response.
+     */
+    void set_sbdix_latency(int ms);
+
+    /**
+     * Makes the specified fraction of SBDIX sessions fail with the MO status code.
+     */
+    void set_failure(int mo_code, double rate);
+
+    /**
+     * Queues MT message for the next sessions.
+     */
+    void queue_mt(const std::string& message);
+
+    /**
+     * Retrieves the oldest MO message delivered by SBDIX.
+     *
+     * Returns false if there are no MO messages.
+     */
+    bool pop_mo(std::string& message);
+
+    /**
+     * Processes the commands and MT datagrams received and sends the responses
+     * that are due, waiting for I/O no longer than the timeout in milliseconds.
+     */
+    void run(int timeout);
+
+private:
+    void receive_mt();
+    void receive(const char* data, size_t size);
+    void command(const std::string& cmd);
+    void sbdix(const std::string& cmd);
+    void indicate();
+    void respond(const std::string& text, uint64_t latency);
+    void respond_ok(const std::string& cmd, const std::string& text);
+};
+
+#endif /* ROCKBLOCKEMULATOR_H_ */
@@ -0,0 +1,158 @@
+/*
+ RockBLOCKEmulatorMain.cc
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/*
+ * RockBLOCK emulator on a pseudo terminal.
+ *
+ * Usage: rockblock_emulator [options]
+ *
+ * Point isbd serial of radioroom.conf to the link created with -l option.
+ * MT messages are injected by sending datagrams to the socket created with
+ * -s option, for example:
+ *
+ *   printf 'hello' | socat - UNIX-SENDTO:/tmp/rockblock.sock
+ *
+ * The session statistics are printed on exit.
+ */
+
+#include <ctype.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string>
+#include "RockBLOCKEmulator.h"
+
+#define RUN_INTERVAL 100 // milliseconds
+
+static volatile sig_atomic_t running = 1;
+
+static void handle_signal(int sig)
+{
+    (void)sig;
+    running = 0;
+}
+
+static void print_help()
+{
+    printf("Usage: rockblock_emulator [options]\n");
+    printf("options:\n");
+    printf("    -l <path>     Create symbolic link to the emulated serial device.\n");
+    printf("    -s <path>     Unix datagram socket for MT messages.\n");
+    printf("    -q <0-5>      Signal quality (default %d).\n", ROCKBLOCK_DEFAULT_CSQ);
+    printf("    -a <ms>       AT command response latency (default %d).\n", ROCKBLOCK_DEFAULT_AT_LATENCY);
+    printf("    -x <ms>       SBDIX session latency (default %d).\n", ROCKBLOCK_DEFAULT_SBDIX_LATENCY);
+    printf("    -f <code>     MO status code of failed SBDIX sessions (default %d).\n", ROCKBLOCK_DEFAULT_FAILURE_CODE);
+    printf("    -r <rate>     Fraction of failed SBDIX sessions from 0 to 1 (default 0).\n");
+    printf("    -v            Print MO messages.\n");
+    printf("    -h            Print this help and exit.\n");
+}
+
+static void print_message(const std::string& message)
+{
+    printf("MO %d bytes: ", (int)message.size());
+
+    for (size_t i = 0; i < message.size(); i++) {
+        printf("%02x", (uint8_t)message[i]);
+    }
+
+    printf("\n");
+}
+
+int main(int argc, char** argv)
+{
+    RockBLOCKEmulator emulator;
+    std::string link_path;
+    std::string socket_path;
+    int failure_code = ROCKBLOCK_DEFAULT_FAILURE_CODE;
+    double failure_rate = 0;
+    bool verbose = false;
+
+    int c;
+    while ((c = getopt(argc, argv, "l:s:q:a:x:f:r:vh")) != -1) {
+        switch (c) {
+        case 'l':
+            link_path = optarg;
+            break;
+        case 's':
+            socket_path = optarg;
+            break;
+        case 'q':
+            emulator.set_signal_quality(atoi(optarg));
+            break;
+        case 'a':
+            emulator.set_at_latency(atoi(optarg));
+            break;
+        case 'x':
+            emulator.set_sbdix_latency(atoi(optarg));
+            break;
+        case 'f':
+            failure_code = atoi(optarg);
+            break;
+        case 'r':
+            failure_rate = atof(optarg);
+            break;
+        case 'v':
+            verbose = true;
+            break;
+        case 'h':
+            print_help();
+            return EXIT_SUCCESS;
+        default:
+            print_help();
+            return EXIT_FAILURE;
+        }
+    }
+
+    emulator.set_failure(failure_code, failure_rate);
+
+    if (!emulator.open(link_path, socket_path)) {
+        return EXIT_FAILURE;
+    }
+
+    printf("RockBLOCK emulator is running on '%s'.\n", emulator.get_path().data());
+    fflush(stdout);
+
+    signal(SIGINT, handle_signal);
+    signal(SIGTERM, handle_signal);
+
+    while (running) {
+        emulator.run(RUN_INTERVAL);
+
+        std::string message;
+
+        while (emulator.pop_mo(message)) {
+            if (verbose) {
+                print_message(message);
+                fflush(stdout);
+            }
+        }
+    }
+
+    emulator.close();
+
+    printf("SBDIX sessions: %d, failed: %d, MO messages: %d (%llu bytes), MT messages: %d\n",
+           emulator.sessions.load(), emulator.failed_sessions.load(), emulator.mo_messages.load(),
+           (unsigned long long)emulator.mo_bytes.load(), emulator.mt_messages.load());
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,205 @@
+/*
+ RockBLOCKEmulatorTest.cc
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/*
+ * Runs IridiumSBD sessions over a serial device against RockBLOCK emulator.
+ *
+ * Returns 0 if all the checks passed.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include "Clock.h"
+#include "IridiumSBD.h"
+#include "MAVLinkISBDChannel.h"
+#include "RockBLOCKEmulator.h"
+#include "TestUtil.h"
+
+#define RUN_INTERVAL    10      // milliseconds
+#define SESSIONS        10
+#define BATCH_FRAMES    20
+#define INDICATION_WAIT 100     // milliseconds
+#define AT_TIMEOUT      1000    // milliseconds
+
+/*
+ * Sends AT command to the emulator and returns the response received until
+ * the final result code or the timeout.
+ */
+static std::string at_command(Serial& serial, const std::string& cmd)
+{
+    std::string request = cmd + "\r";
+    serial.write(request.data(), request.size());
+
+    std::string response;
+    uint64_t deadline = Clock::now() + AT_TIMEOUT * NSEC_PER_MSEC;
+
+    while (Clock::now() < deadline &&
+           response.find("OK\r\n") == std::string::npos && response.find("ERROR\r\n") == std::string::npos) {
+        char buffer[64];
+        int n = serial.available() > 0 ? serial.read(buffer, sizeof(buffer)) : 0;
+
+        if (n > 0) {
+            response.append(buffer, n);
+        } else {
+            Clock::sleep(NSEC_PER_MSEC);
+        }
+    }
+
+    return response;
+}
+
+int main()
+{
+    RockBLOCKEmulator emulator;
+
+    emulator.set_at_latency(1);
+    emulator.set_sbdix_latency(5);
+
+    if (!emulator.open("", "")) {
+        return 1;
+    }
+
+    std::atomic<bool> running(true);
+
+    std::thread emulator_thread([&]() {
+        while (running) {
+            emulator.run(RUN_INTERVAL);
+        }
+    });
+
+    Serial serial;
+    CHECK(serial.open(emulator.get_path(), 19200) == 0);
+
+    // Ring alerts are enabled by AT+SBDMTA=<mode>
+    CHECK(at_command(serial, "AT+SBDMTA=1").find("\r\nOK\r\n") != std::string::npos);
+    CHECK(at_command(serial, "AT+SBDMT").find("\r\nERROR\r\n") != std::string::npos);
+
+    IridiumSBD isbd(serial);
+
+    char model[64];
+    CHECK(isbd.getTransceiverModel(model, sizeof(model)) == ISBD_SUCCESS);
+    CHECK(strstr(model, "IRIDIUM") != NULL);
+
+    int quality = -1;
+    CHECK(isbd.getSignalQuality(quality) == ISBD_SUCCESS);
+    CHECK(quality == ROCKBLOCK_DEFAULT_CSQ);
+
+    for (int i = 0; i < SESSIONS; i++) {
+        char text[16];
+        snprintf(text, sizeof(text), "MT%d", i);
+        emulator.queue_mt(text);
+    }
+
+    for (int i = 0; i < SESSIONS; i++) {
+        uint8_t mo[32];
+        uint8_t mt[ISBD_MAX_MT_MGS_SIZE];
+        size_t mt_size = sizeof(mt);
+
+        int mo_size = snprintf((char*)mo, sizeof(mo), "MO%d", i);
+
+        CHECK(isbd.sendReceiveSBDBinary(mo, mo_size, mt, mt_size) == ISBD_SUCCESS);
+
+        char expected[16];
+        snprintf(expected, sizeof(expected), "MT%d", i);
+        CHECK(mt_size == strlen(expected) && memcmp(mt, expected, mt_size) == 0);
+        CHECK(isbd.getWaitingMessageCount() == SESSIONS - i - 1);
+
+        std::string message;
+        CHECK(emulator.pop_mo(message) && message == std::string((char*)mo, mo_size));
+    }
+
+    // The signal quality and network service are cached, so AT+CSQ and AT-MSSTM are not repeated
+    printf("AT+CSQ commands: %d, AT-MSSTM commands: %d\n", emulator.csq_queries.load(), emulator.msstm_queries.load());
+
+    CHECK(emulator.csq_queries == 1);
+    CHECK(emulator.msstm_queries <= 1);
+
+    // Signal quality changes are reported by +CIEV between the sessions
+    emulator.set_signal_quality(3);
+    Clock::sleep(INDICATION_WAIT * NSEC_PER_MSEC);
+
+    uint8_t report[] = { 4, 5, 6 };
+    size_t report_mt_size = 0;
+    CHECK(isbd.sendReceiveSBDBinary(report, sizeof(report), NULL, report_mt_size) == ISBD_SUCCESS);
+    CHECK(isbd.getCachedSignalQuality(quality) && quality == 3);
+    CHECK(emulator.csq_queries == 1);
+
+    std::string report_message;
+    CHECK(emulator.pop_mo(report_message) && report_message.size() == sizeof(report));
+
+    // Fatal failures are not retried
+    emulator.set_failure(12, 1.0);
+
+    uint8_t mo[] = { 1, 2, 3 };
+    size_t mt_size = 0;
+    CHECK(isbd.sendReceiveSBDBinary(mo, sizeof(mo), NULL, mt_size) == ISBD_SBDIX_FATAL_ERROR);
+
+    emulator.set_failure(12, 0);
+    serial.close();
+
+    // Frames are packed into as few MO messages as fit
+    MAVLinkISBDChannel channel;
+    CHECK(channel.init(emulator.get_path(), 19200, vector<string>()));
+
+    vector<MAVLinkFrame> frames;
+    mavlink_message_t msg;
+
+    for (int i = 0; i < BATCH_FRAMES; i++) {
+        mavlink_msg_mission_item_int_pack(1, 0, &msg, 255, 1, i, MAV_FRAME_GLOBAL_RELATIVE_ALT, MAV_CMD_NAV_WAYPOINT,
+                                          0, 1, 0, 0, 0, 0, 474000000 + i, 85000000, 100);
+        frames.push_back(MAVLinkFrame(msg));
+    }
+
+    int frames_per_mo = ISBD_MAX_MO_MGS_SIZE / frames[0].size();
+    int batch_mo_messages = (BATCH_FRAMES + frames_per_mo - 1) / frames_per_mo;
+
+    CHECK(channel.send_frames(frames));
+
+    int received_frames = 0;
+    std::string message;
+
+    while (emulator.pop_mo(message)) {
+        CHECK(message.size() <= ISBD_MAX_MO_MGS_SIZE);
+        received_frames += message.size() / frames[0].size();
+    }
+
+    CHECK(received_frames == BATCH_FRAMES);
+
+    channel.close();
+
+    running = false;
+    emulator_thread.join();
+
+    printf("SBDIX sessions: %d, failed: %d, MO messages: %d, MT messages: %d\n",
+           emulator.sessions.load(), emulator.failed_sessions.load(),
+           emulator.mo_messages.load(), emulator.mt_messages.load());
+
+    CHECK(emulator.sessions == SESSIONS + 2 + batch_mo_messages);
+    CHECK(emulator.failed_sessions == 1);
+    CHECK(emulator.mo_messages == SESSIONS + 1 + batch_mo_messages);
+    CHECK(emulator.mt_messages == SESSIONS);
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,640 @@
+/*
+ SimulationTest.cc
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/*
+ * Regression test of ISBD sessions against a scripted transceiver on the
+ * simulated clock and of the whole daemon against the simulated autopilot.
+ *
+ * The first scenario flies an hour long flight with a report every minute, a
+ * signal outage and periodic mobile terminated messages. All the AT command
+ * timeouts, retry intervals and report periods run on SimulatedClock, so the
+ * scenario completes in milliseconds.
+ *
+ * The second scenario runs MAVLinkHandler's ISBD reports on the simulated clock
+ * through a long signal outage and checks that the sessions abandoned with no
+ * signal back off instead of retrying at the fixed report retry interval.
+ *
+ * The third scenario runs MAVLinkHandler on the timer wheel the way radioroom
+ * does, with MAVLinkSerial connected to ArduPilot simulator and the ISBD channel
+ * connected to RockBLOCK emulator. The ground decodes the reports delivered by
+ * the MO messages and the responses to the commands sent in MT messages.
+ *
+ * Returns 0 if all the checks passed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <deque>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ArduPilotSimulator.h"
+#include "Clock.h"
+#include "IridiumSBD.h"
+#include "MAVLinkHandler.h"
+#include "MAVLinkParser.h"
+#include "MAVLinkReportCodec.h"
+#include "RockBLOCKEmulator.h"
+#include "Stopwatch.h"
+#include "TestUtil.h"
+#include "TimerWheel.h"
+
+#define FLIGHT_DURATION     3600    // seconds
+#define REPORT_PERIOD       60      // seconds
+#define OUTAGE_START        1200    // seconds
+#define OUTAGE_END          1500    // seconds
+#define MT_PERIOD           600     // seconds
+#define MT_OFFSET           30      // seconds
+#define SBDIX_LATENCY       5       // seconds
+#define MODEM_READ_TIMEOUT  250     // milliseconds
+#define MAX_WALL_TIME       10      // seconds
+
+#define BACKOFF_DURATION    1200    // seconds
+#define BACKOFF_OUTAGE_END  900     // seconds, the outage starts with the scenario
+#define AUTOPILOT_READ_TIMEOUT 10   // milliseconds
+
+#define DAEMON_TIMEOUT      30      // seconds the daemon runs at most waiting for the responses
+#define DAEMON_REPORT_PERIOD 1.0    // seconds
+#define LOOP_INTERVAL       (100 * NSEC_PER_MSEC)
+#define ROUTE_INTERVAL      (10 * NSEC_PER_MSEC)
+#define RUN_INTERVAL        10      // milliseconds
+#define EMULATOR_SBDIX_LATENCY 100  // milliseconds
+#define PARAM_COUNT         20
+#define KEYFRAME_INTERVAL   3
+#define TRACK_SAMPLE_PERIOD 0.25    // seconds
+#define HOME_LATITUDE       473977420   // 1E-7 degrees, home of the simulated vehicle
+#define MAX_DISTANCE        100000      // 1E-7 degrees
+
+/**
+ * Scripted Iridium transceiver that answers AT commands the way RockBLOCK does.
+ *
+ * Responses become readable after the configured latency of the simulated time.
+ * Reads with no data wait like the real serial device does.
+ */
+class SimulatedModem : public Serial {
+    uint64_t                start_time;
+    uint64_t                outage_start;   // nanoseconds since start_time
+    uint64_t                outage_end;
+    std::string             line;
+    std::string             response;
+    uint64_t                response_time;
+    size_t                  binary_size;    // bytes of SBDWB data and checksum expected
+    std::deque<std::string> mt_queue;
+    uint16_t                mo_msn;
+    uint16_t                mt_msn;
+    std::string             mt_message;
+
+public:
+    int mo_messages;
+    int sbdix_sessions;
+    std::vector<uint64_t> mo_write_times;   // times the sessions wrote MO messages
+
+    SimulatedModem(uint64_t start_time, int outage_start = OUTAGE_START, int outage_end = OUTAGE_END) :
+        start_time(start_time), outage_start(outage_start * NSEC_PER_SEC), outage_end(outage_end * NSEC_PER_SEC),
+        line(), response(), response_time(0), binary_size(0), mt_queue(), mo_msn(0), mt_msn(0), mt_message(),
+        mo_messages(0), sbdix_sessions(0), mo_write_times()
+    {
+    }
+
+    int open(const string& path, int baud_rate)
+    {
+        (void)path;
+        (void)baud_rate;
+        return 0;
+    }
+
+    int close()
+    {
+        return 0;
+    }
+
+    void queue_mt(const std::string& message)
+    {
+        mt_queue.push_back(message);
+    }
+
+    int read(void* buffer, size_t size)
+    {
+        uint64_t now = Clock::now();
+
+        if (response.empty() || now < response_time) {
+            uint64_t wait = MODEM_READ_TIMEOUT * NSEC_PER_MSEC;
+
+            if (!response.empty() && response_time - now < wait) {
+                wait = response_time - now;
+            }
+
+            Clock::sleep(wait);
+            return 0;
+        }
+
+        size_t n = response.size() < size ? response.size() : size;
+        memcpy(buffer, response.data(), n);
+        response.erase(0, n);
+        return n;
+    }
+
+    int available()
+    {
+        return Clock::now() < response_time ? 0 : response.size();
+    }
+
+    int write(const void* buffer, size_t n)
+    {
+        const char* data = (const char*)buffer;
+
+        for (size_t i = 0; i < n; i++) {
+            if (binary_size > 0) {
+                if (--binary_size == 0) {
+                    mo_messages++;
+                    respond("\r\n0\r\n\r\nOK\r\n", 0);
+                }
+            } else if (data[i] == '\r') {
+                command(line);
+                line.clear();
+            } else {
+                line += data[i];
+            }
+        }
+
+        return n;
+    }
+
+private:
+    int signal_quality()
+    {
+        uint64_t t = Clock::now() - start_time;
+
+        if (t >= outage_start && t < outage_end) {
+            return 0;
+        }
+
+        return 4;
+    }
+
+    void respond(const std::string& text, int latency)
+    {
+        // Writes flush the input like Serial::write does
+        response = text;
+        response_time = Clock::now() + latency * NSEC_PER_SEC;
+    }
+
+    void command(const std::string& cmd)
+    {
+        char buff[64];
+        std::string echo = cmd + "\r";
+
+        if (cmd == "AT+CSQ") {
+            snprintf(buff, sizeof(buff), "\r\n+CSQ:%d\r\n\r\nOK\r\n", signal_quality());
+            respond(echo + buff, 0);
+        } else if (cmd == "AT-MSSTM") {
+            respond(echo + (signal_quality() > 0 ? "\r\n-MSSTM: 0a1b2c3d\r\n\r\nOK\r\n" :
+                                                   "\r\n-MSSTM: no network service\r\n\r\nOK\r\n"), 0);
+        } else if (cmd.compare(0, 9, "AT+SBDWB=") == 0) {
+            binary_size = atoi(cmd.data() + 9) + 2;
+            mo_write_times.push_back(Clock::now());
+            respond(echo + "\r\nREADY\r\n", 0);
+        } else if (cmd == "AT+SBDIX") {
+            sbdix_sessions++;
+
+            int mo_code = signal_quality() > 0 ? 0 : 32;
+            int mt_code = 0;
+            int mt_len = 0;
+
+            if (mo_code == 0) {
+                mo_msn++;
+
+                if (!mt_queue.empty()) {
+                    mt_message = mt_queue.front();
+                    mt_queue.pop_front();
+                    mt_code = 1;
+                    mt_len = mt_message.size();
+                    mt_msn++;
+                }
+            }
+
+            snprintf(buff, sizeof(buff), "\r\n+SBDIX: %d, %u, %d, %u, %d, %u\r\n\r\nOK\r\n",
+                     mo_code, mo_msn, mt_code, mt_msn, mt_len, (unsigned int)mt_queue.size());
+            respond(echo + buff, SBDIX_LATENCY);
+        } else if (cmd == "AT+SBDRB") {
+            std::string data = echo;
+            uint16_t checksum = 0;
+
+            data += (char)(mt_message.size() >> 8);
+            data += (char)(mt_message.size() & 0xFF);
+
+            for (size_t i = 0; i < mt_message.size(); i++) {
+                data += mt_message[i];
+                checksum += (uint8_t)mt_message[i];
+            }
+
+            data += (char)(checksum >> 8);
+            data += (char)(checksum & 0xFF);
+            data += "OK\r\n";
+            respond(data, 0);
+        } else {
+            respond(echo + "\r\nOK\r\n", 0);
+        }
+    }
+};
+
+/**
+ * Autopilot that sends a heartbeat every second of the simulated time.
+ *
+ * Reads with no heartbeat due wait like the real serial device does.
+ */
+class SimulatedAutopilot : public Serial {
+    uint64_t heartbeat_time;
+
+public:
+    SimulatedAutopilot() : heartbeat_time(0)
+    {
+    }
+
+    int open(const string& path, int baud_rate)
+    {
+        (void)path;
+        (void)baud_rate;
+        return 0;
+    }
+
+    int close()
+    {
+        return 0;
+    }
+
+    int read(void* buffer, size_t size)
+    {
+        uint64_t now = Clock::now();
+
+        if (now < heartbeat_time) {
+            uint64_t wait = AUTOPILOT_READ_TIMEOUT * NSEC_PER_MSEC;
+            Clock::sleep(heartbeat_time - now < wait ? heartbeat_time - now : wait);
+            return 0;
+        }
+
+        mavlink_message_t msg;
+        mavlink_msg_heartbeat_pack(ARDUPILOT_SYSTEM_ID, ARDUPILOT_COMPONENT_ID, &msg, MAV_TYPE_QUADROTOR,
+                                   MAV_AUTOPILOT_ARDUPILOTMEGA, 0, 0, MAV_STATE_ACTIVE);
+        MAVLinkFrame frame(msg);
+
+        if (frame.size() > size) {
+            return 0;
+        }
+
+        memcpy(buffer, frame.data(), frame.size());
+        heartbeat_time = now + NSEC_PER_SEC;
+        return frame.size();
+    }
+
+    int available()
+    {
+        return 0;
+    }
+
+    int write(const void* buffer, size_t n)
+    {
+        (void)buffer;
+        return n;
+    }
+};
+
+/*
+ * Flies the scenario of ISBD sessions on the simulated clock.
+ */
+static void simulate_sessions()
+{
+    MonotonicClock wall_clock;
+    uint64_t wall_start = wall_clock.now();
+
+    SimulatedClock clock(1000 * NSEC_PER_SEC);
+    Clock::set_source(&clock);
+
+    uint64_t start = Clock::now();
+    uint64_t end = start + FLIGHT_DURATION * NSEC_PER_SEC;
+
+    SimulatedModem modem(start);
+    IridiumSBD isbd(modem);
+    TimerWheel timers;
+    Stopwatch flight_time;
+
+    int reports = 0;
+    int delivered = 0;
+    int timeouts = 0;
+    int errors = 0;
+    int mt_sent = 0;
+    int mt_received = 0;
+
+    isbd.begin();
+
+    timers.schedule_periodic(REPORT_PERIOD * NSEC_PER_SEC, [&]() {
+        uint8_t report[40];
+        uint8_t mt[ISBD_MAX_MT_MGS_SIZE];
+        size_t mt_size = sizeof(mt);
+
+        memset(report, reports, sizeof(report));
+        reports++;
+
+        int ret = isbd.sendReceiveSBDBinary(report, sizeof(report), mt, mt_size);
+
+        if (ret == ISBD_SUCCESS) {
+            delivered++;
+
+            if (mt_size > 0) {
+                char expected[32];
+                snprintf(expected, sizeof(expected), "MT%d", mt_received);
+                CHECK(mt_size == strlen(expected) && memcmp(mt, expected, mt_size) == 0);
+                mt_received++;
+            }
+        } else if (ret == ISBD_SENDRECEIVE_TIMEOUT) {
+            timeouts++;
+        } else {
+            errors++;
+        }
+    });
+
+    timers.schedule(MT_OFFSET * NSEC_PER_SEC, [&]() {
+        timers.schedule_periodic(MT_PERIOD * NSEC_PER_SEC, [&]() {
+            char message[32];
+            snprintf(message, sizeof(message), "MT%d", mt_sent++);
+            modem.queue_mt(message);
+        });
+    });
+
+    while (timers.next_expiration() <= end) {
+        Clock::sleep_until(timers.next_expiration());
+        timers.advance();
+    }
+
+    double simulated_time = flight_time.elapsed_time();
+
+    Clock::set_source(NULL);
+
+    double wall_time = Clock::to_seconds(wall_clock.now() - wall_start);
+
+    printf("Simulated %.0f s in %.3f s: %d reports, %d delivered, %d timeouts, %d errors, "
+           "%d SBDIX sessions, %d MT messages received.\n",
+           simulated_time, wall_time, reports, delivered, timeouts, errors,
+           modem.sbdix_sessions, mt_received);
+
+    int outage_reports = (OUTAGE_END - OUTAGE_START) / REPORT_PERIOD;
+
+    CHECK(reports == FLIGHT_DURATION / REPORT_PERIOD);
+    CHECK(delivered == reports - outage_reports);
+    CHECK(timeouts == outage_reports);
+    CHECK(errors == 0);
+    CHECK(modem.mo_messages == reports);
+    CHECK(mt_received == mt_sent);
+    CHECK(mt_received == (FLIGHT_DURATION - MT_OFFSET) / MT_PERIOD);
+    CHECK(simulated_time >= FLIGHT_DURATION);
+    CHECK(wall_time < MAX_WALL_TIME);
+}
+
+/*
+ * Runs the ISBD reports of the daemon through the signal outage on the
+ * simulated clock.
+ */
+static void simulate_backoff()
+{
+    SimulatedClock clock(1000 * NSEC_PER_SEC);
+    Clock::set_source(&clock);
+
+    uint64_t start = Clock::now();
+
+    SimulatedModem modem(start, 0, BACKOFF_OUTAGE_END);
+    SimulatedAutopilot autopilot;
+
+    config.set_auto_detect_serials(false);
+    config.set_isbd_enabled(true);
+    config.set_isbd_report_period(REPORT_PERIOD);
+
+    MAVLinkHandler handler;
+    TimerWheel timers;
+
+    CHECK(handler.init(&autopilot, &modem));
+
+    handler.start(timers);
+
+    uint64_t end = start + BACKOFF_DURATION * NSEC_PER_SEC;
+
+    while (timers.next_expiration() <= end) {
+        Clock::sleep_until(timers.next_expiration());
+        timers.advance();
+    }
+
+    handler.close();
+
+    Clock::set_source(NULL);
+
+    // Spacing of the sessions abandoned in the outage
+    vector<double> gaps;
+
+    for (size_t i = 1; i < modem.mo_write_times.size(); i++) {
+        if (modem.mo_write_times[i] - start >= BACKOFF_OUTAGE_END * NSEC_PER_SEC) {
+            break;
+        }
+
+        gaps.push_back(Clock::to_seconds(modem.mo_write_times[i] - modem.mo_write_times[i - 1]));
+    }
+
+    printf("Outage of %d s: %u sessions, %d SBDIX sessions, session spacing",
+           BACKOFF_OUTAGE_END, (unsigned int)modem.mo_write_times.size(), modem.sbdix_sessions);
+
+    for (size_t i = 0; i < gaps.size(); i++) {
+        printf(" %.0f", gaps[i]);
+    }
+
+    printf(" s.\n");
+
+    CHECK(gaps.size() >= 4);
+
+    for (size_t i = 0; i < gaps.size(); i++) {
+        CHECK(gaps[i] > ISBD_DEFAULT_SENDRECEIVE_TIME);
+        CHECK(i == 0 || gaps[i] >= gaps[i - 1]);
+    }
+
+    CHECK(!gaps.empty() && gaps.back() >= ISBD_DEFAULT_CSQ_INTERVAL_USB * ISBD_RETRY_MAX_BACKOFF);
+
+    // The report is delivered once the signal is back
+    CHECK(modem.sbdix_sessions > 0);
+}
+
+static void append_frame(std::string& message, const mavlink_message_t& msg)
+{
+    MAVLinkFrame frame(msg);
+    message.append((const char*)frame.data(), frame.size());
+}
+
+/*
+ * Runs the daemon against the simulated autopilot and transceiver on the
+ * monotonic clock until the ground receives the reports and the responses
+ * to the MT message.
+ */
+static void simulate_daemon()
+{
+    ArduPilotSimulator autopilot;
+    RockBLOCKEmulator transceiver;
+
+    autopilot.set_param_count(PARAM_COUNT);
+    transceiver.set_at_latency(1);
+    transceiver.set_sbdix_latency(EMULATOR_SBDIX_LATENCY);
+
+    bool opened = autopilot.open("") && transceiver.open("", "");
+    CHECK(opened);
+
+    if (!opened) {
+        return;
+    }
+
+    std::atomic<bool> running(true);
+
+    std::thread autopilot_thread([&]() {
+        while (running) {
+            autopilot.run(RUN_INTERVAL);
+        }
+    });
+
+    std::thread transceiver_thread([&]() {
+        while (running) {
+            transceiver.run(RUN_INTERVAL);
+        }
+    });
+
+    config.set_auto_detect_serials(false);
+    config.set_autopilot_serial(autopilot.get_path());
+    config.set_isbd_enabled(true);
+    config.set_isbd_serial(transceiver.get_path());
+    config.set_isbd_report_period(DAEMON_REPORT_PERIOD);
+    config.set_isbd_report_keyframe_interval(KEYFRAME_INTERVAL);
+    config.set_isbd_track_sample_period(TRACK_SAMPLE_PERIOD);
+
+    // The ground arms the vehicle and reads a parameter in the first MT message
+    std::string mt;
+    mavlink_message_t msg;
+
+    mavlink_msg_command_long_pack(SYSTEM_ID, COMPONENT_ID, &msg, ARDUPILOT_SYSTEM_ID, ARDUPILOT_COMPONENT_ID,
+                                  MAV_CMD_COMPONENT_ARM_DISARM, 0, 1, 0, 0, 0, 0, 0, 0);
+    append_frame(mt, msg);
+    mavlink_msg_param_request_read_pack(SYSTEM_ID, COMPONENT_ID, &msg, ARDUPILOT_SYSTEM_ID, ARDUPILOT_COMPONENT_ID, "", 0);
+    append_frame(mt, msg);
+    transceiver.queue_mt(mt);
+
+    MAVLinkHandler handler;
+    TimerWheel timers;
+
+    CHECK(handler.init());
+
+    timers.schedule_periodic(LOOP_INTERVAL, [&]() {
+        handler.loop();
+    });
+
+    if (handler.needs_route()) {
+        timers.schedule_periodic(ROUTE_INTERVAL, [&]() {
+            handler.route();
+        });
+    }
+
+    handler.start(timers);
+
+    // The ground decodes the MO messages as they are delivered
+    MAVLinkParser parser;
+    MAVLinkReportCodec ground;
+    int reports = 0;
+    int deltas = 0;
+    int command_acks = 0;
+    int param_values = 0;
+
+    auto receive_mo = [&]() {
+        std::string mo;
+
+        while (transceiver.pop_mo(mo)) {
+            vector<MAVLinkFrame> frames;
+            parser.feed((const uint8_t*)mo.data(), mo.size(), frames);
+
+            for (size_t i = 0; i < frames.size(); i++) {
+                const mavlink_message_t& frame_msg = frames[i].get_message();
+                mavlink_message_t report;
+                vector<TrackSample> samples;
+
+                if (ground.decode(frame_msg, Clock::now(), report, samples)) {
+                    reports++;
+
+                    if (frame_msg.msgid == MAVLINK_MSG_ID_MEMORY_VECT) {
+                        deltas++;
+                    }
+
+                    CHECK(labs(mavlink_msg_high_latency_get_latitude(&report) - HOME_LATITUDE) < MAX_DISTANCE);
+                } else if (frame_msg.msgid == MAVLINK_MSG_ID_COMMAND_ACK) {
+                    command_acks++;
+                    CHECK(mavlink_msg_command_ack_get_command(&frame_msg) == MAV_CMD_COMPONENT_ARM_DISARM);
+                    CHECK(mavlink_msg_command_ack_get_result(&frame_msg) == MAV_RESULT_ACCEPTED);
+                } else if (frame_msg.msgid == MAVLINK_MSG_ID_PARAM_VALUE) {
+                    param_values++;
+                    CHECK(mavlink_msg_param_value_get_param_index(&frame_msg) == 0);
+                    CHECK(mavlink_msg_param_value_get_param_count(&frame_msg) == PARAM_COUNT);
+                }
+            }
+        }
+    };
+
+    // The responses to the MT message follow the reports by a few sessions,
+    // which takes longer when the machine is loaded.
+    Stopwatch run_time;
+    uint64_t deadline = Clock::now() + DAEMON_TIMEOUT * NSEC_PER_SEC;
+
+    while (timers.next_expiration() <= deadline &&
+           (reports < 2 || deltas == 0 || command_acks == 0 || param_values == 0)) {
+        Clock::sleep_until(timers.next_expiration());
+        timers.advance();
+        receive_mo();
+    }
+
+    handler.close();
+
+    running = false;
+    autopilot_thread.join();
+    transceiver_thread.join();
+
+    receive_mo();
+
+    printf("Daemon ran %.1f s: %d SBDIX sessions, %d reports, %d deltas, %d COMMAND_ACK, %d PARAM_VALUE, "
+           "%llu autopilot frames sent.\n",
+           run_time.elapsed_time(), transceiver.sessions.load(), reports, deltas, command_acks, param_values,
+           (unsigned long long)autopilot.frames_sent.load());
+
+    CHECK(reports >= 2);
+    CHECK(deltas > 0);
+    CHECK(command_acks == 1);
+    CHECK(param_values == 1);
+    CHECK(transceiver.mt_messages == 1);
+}
+
+int main()
+{
+    simulate_sessions();
+    simulate_backoff();
+    simulate_daemon();
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,64 @@
+/*
+ TestUtil.h
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef TESTUTIL_H_
+#define TESTUTIL_H_
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "mavlink.h"
+
+/**
+ * Number of failed checks. The tests return 0 if no check failed.
+ */
+static int failures = 0;
+
+/**
+ * Prints the failed condition and counts the failure without stopping the test.
+ */
+#define CHECK(cond) do { if (!(cond)) { printf("FAILED: %s (line %d)\n", #cond, __LINE__); failures++; } } while (0)
+
+/**
+ * Returns a survey mission of the specified number of waypoints flying
+ * 20 waypoint long legs back and forth.
+ */
+static inline std::vector<mavlink_mission_item_int_t> make_survey(size_t count)
+{
+    std::vector<mavlink_mission_item_int_t> items(count);
+
+    for (size_t i = 0; i < count; i++) {
+        mavlink_mission_item_int_t& item = items[i];
+        memset(&item, 0, sizeof(item));
+        item.seq = i;
+        item.frame = MAV_FRAME_GLOBAL_RELATIVE_ALT;
+        item.command = MAV_CMD_NAV_WAYPOINT;
+        item.autocontinue = 1;
+        item.x = 474000000 + (int32_t)(i / 20) * 1000;
+        item.y = 85000000 + (int32_t)((i / 20) % 2 ? 19 - i % 20 : i % 20) * 1000;
+        item.z = 100;
+    }
+
+    return items;
+}
+
+#endif /* TESTUTIL_H_ */
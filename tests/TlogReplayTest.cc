@@ -0,0 +1,279 @@
+/*
+ TlogReplayTest.cc
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/*
+ * Replays a generated .tlog file through MAVLinkSerial as fast as possible on
+ * the simulated clock and at 100x speed on the scaled clock, and a file with
+ * MAVLink 1 and MAVLink 2 records on the simulated clock.
+ *
+ * Returns 0 if all the checks passed.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "Clock.h"
+#include "MAVLinkCRC.h"
+#include "MAVLinkParser.h"
+#include "MAVLinkSerial.h"
+#include "MAVLinkTlog.h"
+#include "MAVLinkTlogReplay.h"
+#include "TestUtil.h"
+
+#define TLOG_DURATION       60          // seconds
+#define TLOG_START_TIME     1500000000  // seconds since the epoch
+#define FRAMES_PER_SECOND   12          // autopilot frames
+#define REPLAY_SPEED        100
+#define MAX_WALL_LAG        0.05        // seconds of scheduling delay tolerated on the scaled clock
+
+static void write_record(FILE* file, uint64_t timestamp, const mavlink_message_t& msg)
+{
+    uint8_t buf[TLOG_TIMESTAMP_SIZE + MAVLINK_MAX_PACKET_LEN];
+
+    for (int i = TLOG_TIMESTAMP_SIZE - 1; i >= 0; i--) {
+        buf[i] = timestamp & 0xFF;
+        timestamp >>= 8;
+    }
+
+    uint16_t n = mavlink_msg_to_send_buffer(buf + TLOG_TIMESTAMP_SIZE, &msg);
+    fwrite(buf, 1, TLOG_TIMESTAMP_SIZE + n, file);
+}
+
+/*
+ * Writes the message as a signed MAVLink 2 frame.
+ */
+static void write_v2_record(FILE* file, uint64_t timestamp, const mavlink_message_t& msg)
+{
+    static const uint8_t crcs[256] = MAVLINK_MESSAGE_CRCS;
+
+    uint8_t buf[TLOG_TIMESTAMP_SIZE + MAVLINK_FRAME_MAX_LEN];
+
+    for (int i = TLOG_TIMESTAMP_SIZE - 1; i >= 0; i--) {
+        buf[i] = timestamp & 0xFF;
+        timestamp >>= 8;
+    }
+
+    uint8_t* frame = buf + TLOG_TIMESTAMP_SIZE;
+    frame[0] = MAVLINK2_STX;
+    frame[1] = msg.len;
+    frame[2] = MAVLINK2_IFLAG_SIGNED;
+    frame[3] = 0;
+    frame[4] = msg.seq;
+    frame[5] = msg.sysid;
+    frame[6] = msg.compid;
+    frame[7] = msg.msgid;
+    frame[8] = 0;
+    frame[9] = 0;
+    memcpy(frame + MAVLINK2_NUM_HEADER_BYTES, _MAV_PAYLOAD(&msg), msg.len);
+
+    size_t n = MAVLINK2_NUM_HEADER_BYTES + msg.len;
+    uint16_t crc = MAVLinkCRC::accumulate(frame + 1, n - 1, X25_INIT_CRC);
+    crc = MAVLinkCRC::accumulate(crcs[msg.msgid], crc);
+    frame[n++] = crc & 0xFF;
+    frame[n++] = crc >> 8;
+    memset(frame + n, 0xFE, MAVLINK2_SIGNATURE_LEN);
+    n += MAVLINK2_SIGNATURE_LEN;
+
+    fwrite(buf, 1, TLOG_TIMESTAMP_SIZE + n, file);
+}
+
+/*
+ * Writes 1Hz HEARTBEAT and GPS_RAW_INT and 10Hz ATTITUDE of the autopilot
+ * and 1Hz HEARTBEAT of a ground station.
+ */
+static bool write_tlog(const char* path)
+{
+    FILE* file = fopen(path, "wb");
+
+    if (file == NULL) {
+        return false;
+    }
+
+    mavlink_message_t msg;
+
+    for (int t = 0; t < TLOG_DURATION * 10; t++) {
+        uint64_t timestamp = TLOG_START_TIME * 1000000ULL + t * 100000ULL;
+
+        if (t % 10 == 0) {
+            mavlink_msg_heartbeat_pack(1, 1, &msg, MAV_TYPE_QUADROTOR, MAV_AUTOPILOT_ARDUPILOTMEGA, 0x81, 4, MAV_STATE_ACTIVE);
+            write_record(file, timestamp, msg);
+            mavlink_msg_gps_raw_int_pack(1, 1, &msg, t * 100000ULL, 3, 473977418 + t, 85455939 - t, 500000, 120, 150, 50, 9000, 12);
+            write_record(file, timestamp, msg);
+            mavlink_msg_heartbeat_pack(SYSTEM_ID, COMPONENT_ID, &msg, MAV_TYPE_GCS, MAV_AUTOPILOT_INVALID, 0, 0, 0);
+            write_record(file, timestamp, msg);
+        }
+
+        mavlink_msg_attitude_pack(1, 1, &msg, t * 100, 0.01f * t, -0.02f, 1.5f, 0.0f, 0.0f, 0.1f);
+        write_record(file, timestamp, msg);
+    }
+
+    fclose(file);
+
+    return true;
+}
+
+/*
+ * Replays the file on the current clock and returns the number of frames received.
+ */
+static int replay_tlog(const char* path, MAVLinkTlogReplay& replay)
+{
+    if (replay.open(path, 0) < 0) {
+        return 0;
+    }
+
+    MAVLinkSerial autopilot;
+    CHECK(autopilot.init(replay));
+
+    int frames = 0;
+    mavlink_message_t msg;
+    uint64_t deadline = Clock::now() + TLOG_DURATION * 2 * NSEC_PER_SEC;
+
+    while (!replay.finished() && Clock::now() < deadline) {
+        if (autopilot.receive_message(msg)) {
+            CHECK(msg.sysid == 1);
+            frames++;
+        }
+    }
+
+    CHECK(replay.finished());
+
+    return frames;
+}
+
+int main()
+{
+    char path[] = "/tmp/radioroom-replay-XXXXXX";
+    int fd = mkstemp(path);
+
+    if (fd < 0) {
+        return 1;
+    }
+
+    ::close(fd);
+
+    CHECK(write_tlog(path));
+
+    const uint64_t autopilot_frames = TLOG_DURATION * FRAMES_PER_SECOND;
+    const uint64_t gcs_frames = TLOG_DURATION;
+
+    MonotonicClock wall_clock;
+    uint64_t wall_start = wall_clock.now();
+
+    SimulatedClock simulated_clock(NSEC_PER_SEC);
+    ScaledClock scaled_clock(REPLAY_SPEED);
+    ClockSource* clocks[] = { &simulated_clock, &scaled_clock };
+
+    for (size_t i = 0; i < sizeof(clocks) / sizeof(clocks[0]); i++) {
+        Clock::set_source(clocks[i]);
+
+        MAVLinkTlogReplay replay;
+        uint64_t start = Clock::now();
+        uint64_t wall_time = wall_clock.now();
+
+        int frames = replay_tlog(path, replay);
+
+        double elapsed = Clock::to_seconds(Clock::now() - start);
+
+        printf("%s clock: %d frames received in %.3f s of replayed time, %.3f s of wall time, max lag %.3f s\n",
+               i == 0 ? "Simulated" : "Scaled", frames, elapsed, Clock::to_seconds(wall_clock.now() - wall_time),
+               replay.get_max_lag());
+
+        CHECK(replay.get_frames() == autopilot_frames);
+        CHECK(replay.get_skipped_frames() == gcs_frames);
+        CHECK(frames > 0 && (uint64_t)frames <= autopilot_frames);
+        CHECK(fabs(replay.get_span() - (TLOG_DURATION - 0.1)) < 1e-6);
+        CHECK(elapsed >= TLOG_DURATION - 0.1 && elapsed < TLOG_DURATION + 1);
+        CHECK(replay.get_mean_lag() < 1);
+        CHECK(replay.get_max_lag() < MAX_WALL_LAG * REPLAY_SPEED);
+        CHECK(replay.get_written_bytes() > 0); // autopilot version requests
+    }
+
+    Clock::set_source(NULL);
+
+    CHECK(Clock::to_seconds(wall_clock.now() - wall_start) < (double)TLOG_DURATION / REPLAY_SPEED + 1);
+
+    // Invalid records end the replay
+    FILE* file = fopen(path, "ab");
+    CHECK(file != NULL && fwrite("\0\0\0\0\0\0\0\0garbage", 1, 15, file) == 15);
+    fclose(file);
+
+    Clock::set_source(&simulated_clock);
+
+    MAVLinkTlogReplay invalid;
+    CHECK(invalid.open(path, 0) == 0);
+
+    uint8_t buf[1024];
+    for (uint64_t deadline = Clock::now() + TLOG_DURATION * 2 * NSEC_PER_SEC; !invalid.finished() && Clock::now() < deadline;) {
+        invalid.read(buf, sizeof(buf));
+    }
+
+    Clock::set_source(NULL);
+
+    CHECK(invalid.finished());
+    CHECK(invalid.get_frames() == autopilot_frames);
+    CHECK(invalid.get_v2_frames() == 0);
+
+    // MAVLink 2 records are replayed and counted
+    file = fopen(path, "wb");
+    CHECK(file != NULL);
+
+    mavlink_message_t msg;
+    mavlink_msg_heartbeat_pack(1, 1, &msg, MAV_TYPE_QUADROTOR, MAV_AUTOPILOT_ARDUPILOTMEGA, 0x81, 4, MAV_STATE_ACTIVE);
+    write_record(file, TLOG_START_TIME * 1000000ULL, msg);
+    mavlink_msg_attitude_pack(1, 1, &msg, 100, 0.01f, -0.02f, 1.5f, 0.0f, 0.0f, 0.1f);
+    write_v2_record(file, TLOG_START_TIME * 1000000ULL + 100000ULL, msg);
+    fclose(file);
+
+    Clock::set_source(&simulated_clock);
+
+    MAVLinkTlogReplay mixed;
+    CHECK(mixed.open(path, 0) == 0);
+
+    MAVLinkParser parser;
+    std::vector<MAVLinkFrame> frames;
+
+    for (uint64_t deadline = Clock::now() + 2 * NSEC_PER_SEC; !mixed.finished() && Clock::now() < deadline;) {
+        int n = mixed.read(buf, sizeof(buf));
+        parser.feed(buf, n, frames);
+    }
+
+    Clock::set_source(NULL);
+
+    CHECK(mixed.finished());
+    CHECK(mixed.get_frames() == 2);
+    CHECK(mixed.get_v2_frames() == 1);
+    CHECK(frames.size() == 2);
+
+    if (frames.size() == 2) {
+        CHECK(!frames[0].v2() && frames[0].msgid() == MAVLINK_MSG_ID_HEARTBEAT);
+        CHECK(frames[1].v2() && frames[1].msgid() == MAVLINK_MSG_ID_ATTITUDE);
+
+        msg = frames[1].get_message();
+        CHECK(mavlink_msg_attitude_get_yaw(&msg) == 1.5f);
+    }
+
+    unlink(path);
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,164 @@
+/*
+ TrackTest.cc
+
+ This file is a part of UV Radio Room project.
+
+ (C) Copyright 2018 Envirover.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+/*
+ * Samples GPS_RAW_INT stream of a vehicle flying a circle on the simulated
+ * clock, packs the track with a HIGH_LATENCY report into one SBD MO message
+ * and checks the unpacked track samples.
+ *
+ * Returns 0 if all the checks passed.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "Clock.h"
+#include "IridiumSBD.h"
+#include "MAVLinkSerial.h"
+#include "MAVLinkTrack.h"
+#include "TestUtil.h"
+
+#define REPORT_PERIOD       60      // seconds
+#define SAMPLE_PERIOD       6       // seconds
+#define GPS_RATE            2       // Hz
+#define HIGH_LATENCY_SIZE   48      // bytes of HIGH_LATENCY frame
+
+static void gps_raw_int(double t, mavlink_message_t& msg)
+{
+    // 1 km circle at 15 m/s
+    double angle = t * 15 / 1000;
+    int32_t lat = 473977418 + (int32_t)(1000 * sin(angle) * 90);
+    int32_t lon = 85455939 + (int32_t)(1000 * cos(angle) * 132);
+    uint16_t cog = (uint16_t)fmod(angle * 18000 / M_PI + 36000, 36000);
+
+    mavlink_msg_gps_raw_int_pack(ARDUPILOT_SYSTEM_ID, ARDUPILOT_COMPONENT_ID, &msg, t * 1000000, GPS_FIX_TYPE_3D_FIX,
+                                 lat, lon, (500 + (int)t / 10) * 1000, 120, 150, 1500, cog, 12);
+}
+
+int main()
+{
+    SimulatedClock clock(NSEC_PER_SEC);
+    Clock::set_source(&clock);
+
+    MAVLinkTrack track;
+    track.set_sample_period(SAMPLE_PERIOD);
+
+    // Flying for two report periods without delivered reports
+    mavlink_message_t msg;
+    vector<TrackSample> sent;
+
+    for (int i = 0; i < 2 * REPORT_PERIOD * GPS_RATE; i++) {
+        gps_raw_int((double)i / GPS_RATE, msg);
+
+        size_t size = track.size();
+        track.frame_received(MAVLinkFrame(msg));
+
+        if (track.size() > size) {
+            TrackSample sample;
+            sample.time = Clock::now();
+            sample.latitude = mavlink_msg_gps_raw_int_get_lat(&msg);
+            sample.longitude = mavlink_msg_gps_raw_int_get_lon(&msg);
+            sample.altitude = mavlink_msg_gps_raw_int_get_alt(&msg) / 1000;
+            sample.heading = mavlink_msg_gps_raw_int_get_cog(&msg) / 100;
+            sample.groundspeed = mavlink_msg_gps_raw_int_get_vel(&msg) / 100;
+            sent.push_back(sample);
+        }
+
+        clock.advance(NSEC_PER_SEC / GPS_RATE);
+    }
+
+    CHECK(track.size() == 2 * REPORT_PERIOD / SAMPLE_PERIOD);
+
+    // Report composed from the last position
+    mavlink_high_latency_t report;
+    memset(&report, 0, sizeof(report));
+    report.latitude = mavlink_msg_gps_raw_int_get_lat(&msg);
+    report.longitude = mavlink_msg_gps_raw_int_get_lon(&msg);
+    report.altitude_amsl = mavlink_msg_gps_raw_int_get_alt(&msg) / 1000;
+    report.heading = mavlink_msg_gps_raw_int_get_cog(&msg);
+    report.groundspeed = 15;
+
+    uint64_t report_time = Clock::now();
+    vector<MAVLinkFrame> frames;
+    track.pack(ARDUPILOT_SYSTEM_ID, ARDUPILOT_COMPONENT_ID, report, report_time, frames);
+
+    size_t bytes = HIGH_LATENCY_SIZE;
+    vector<mavlink_message_t> msgs;
+
+    for (size_t i = 0; i < frames.size(); i++) {
+        bytes += frames[i].size();
+        msgs.push_back(frames[i].get_message());
+    }
+
+    printf("%d track samples packed into %d frames, %d bytes with the report\n", (int)track.size(),
+           (int)frames.size(), (int)bytes);
+
+    CHECK(!frames.empty() && frames.size() <= TRACK_MAX_FRAMES);
+    CHECK(bytes <= ISBD_MAX_MO_MGS_SIZE);
+
+    vector<TrackSample> samples;
+    CHECK(MAVLinkTrack::unpack(report, report_time, msgs, samples));
+    CHECK(samples.size() == sent.size());
+
+    // Newest samples first
+    for (size_t i = 0; i < samples.size() && i < sent.size(); i++) {
+        const TrackSample& expected = sent[sent.size() - 1 - i];
+        CHECK(labs(samples[i].latitude - expected.latitude) < TRACK_LATLON_SCALE);
+        CHECK(labs(samples[i].longitude - expected.longitude) < TRACK_LATLON_SCALE);
+        CHECK(samples[i].altitude == expected.altitude);
+        CHECK(samples[i].heading == expected.heading);
+        CHECK(samples[i].groundspeed == expected.groundspeed);
+        CHECK(samples[i].time <= expected.time && expected.time - samples[i].time < NSEC_PER_SEC);
+    }
+
+    // The oldest samples are dropped when the ring buffer is full
+    for (int i = 0; i < 2 * TRACK_MAX_SAMPLES; i++) {
+        clock.advance(SAMPLE_PERIOD * NSEC_PER_SEC);
+        track.frame_received(MAVLinkFrame(msg));
+    }
+
+    CHECK(track.size() == TRACK_MAX_SAMPLES);
+
+    frames.clear();
+    track.pack(ARDUPILOT_SYSTEM_ID, ARDUPILOT_COMPONENT_ID, report, Clock::now(), frames);
+
+    CHECK(frames.size() <= TRACK_MAX_FRAMES);
+
+    track.clear();
+    CHECK(track.size() == 0);
+
+    // Samples without GPS fix are skipped
+    mavlink_msg_gps_raw_int_pack(ARDUPILOT_SYSTEM_ID, ARDUPILOT_COMPONENT_ID, &msg, 0, GPS_FIX_TYPE_NO_FIX,
+                                 0, 0, 0, 0, 0, 0, 0, 0);
+    track.frame_received(MAVLinkFrame(msg));
+    CHECK(track.size() == 0);
+
+    // Invalid messages are rejected
+    msgs.assign(1, msg);
+    samples.clear();
+    CHECK(!MAVLinkTrack::unpack(report, report_time, msgs, samples));
+
+    Clock::set_source(NULL);
+
+    return failures == 0 ? 0 : 1;
+}